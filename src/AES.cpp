@@ -0,0 +1,308 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include "AES.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AES_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+// only when the compiler already targets the crypto extension,
+// since not every compiler lets it be enabled per function
+#define AES_ARM64
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+namespace melonDS
+{
+
+// the counter is a 128-bit big-endian number, kept as two halves here
+static void LoadCounter(const AES_ctx* ctx, u64& hi, u64& lo)
+{
+    u64 tmp;
+    memcpy(&tmp, &ctx->Iv[0], 8); hi = __builtin_bswap64(tmp);
+    memcpy(&tmp, &ctx->Iv[8], 8); lo = __builtin_bswap64(tmp);
+}
+
+static void StoreCounter(AES_ctx* ctx, u64 hi, u64 lo)
+{
+    u64 tmp;
+    tmp = __builtin_bswap64(hi); memcpy(&ctx->Iv[0], &tmp, 8);
+    tmp = __builtin_bswap64(lo); memcpy(&ctx->Iv[8], &tmp, 8);
+}
+
+static void IncrementCounter(u64& hi, u64& lo)
+{
+    if (++lo == 0) hi++;
+}
+
+static void CounterBlock(u8* block, u64 hi, u64 lo)
+{
+    u64 tmp;
+    tmp = __builtin_bswap64(hi); memcpy(&block[0], &tmp, 8);
+    tmp = __builtin_bswap64(lo); memcpy(&block[8], &tmp, 8);
+}
+
+
+// software fallback
+
+static void CTR_Generic(AES_ctx* ctx, u8* buf, u32 len, bool reversed)
+{
+    u64 hi, lo;
+    LoadCounter(ctx, hi, lo);
+
+    for (u32 i = 0; i < len; i += 16)
+    {
+        u8 ks[16];
+        CounterBlock(ks, hi, lo);
+        AES_ECB_encrypt(ctx, ks);
+        IncrementCounter(hi, lo);
+
+        u32 n = (len - i) < 16 ? (len - i) : 16;
+        for (u32 j = 0; j < n; j++)
+            buf[i+j] ^= ks[reversed ? (15-j) : j];
+    }
+
+    StoreCounter(ctx, hi, lo);
+}
+
+
+#ifdef AES_X86
+
+#define AESNI_TARGET __attribute__((target("aes,ssse3")))
+
+static bool DetectAcceleration()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    // AES-NI, and SSSE3 for byte shuffles
+    return (ecx & (1<<25)) && (ecx & (1<<9));
+}
+
+AESNI_TARGET static inline __m128i EncryptBlock_AESNI(const __m128i* rk, __m128i block)
+{
+    block = _mm_xor_si128(block, rk[0]);
+    for (int r = 1; r < 10; r++)
+        block = _mm_aesenc_si128(block, rk[r]);
+    return _mm_aesenclast_si128(block, rk[10]);
+}
+
+AESNI_TARGET static void EncryptBlock_Accel(const AES_ctx* ctx, u8* block)
+{
+    __m128i rk[11];
+    for (int r = 0; r < 11; r++)
+        rk[r] = _mm_loadu_si128((const __m128i*)&ctx->RoundKey[r*16]);
+
+    __m128i data = _mm_loadu_si128((const __m128i*)block);
+    _mm_storeu_si128((__m128i*)block, EncryptBlock_AESNI(rk, data));
+}
+
+AESNI_TARGET static void CTR_Accel(AES_ctx* ctx, u8* buf, u32 len, bool reversed)
+{
+    __m128i rk[11];
+    for (int r = 0; r < 11; r++)
+        rk[r] = _mm_loadu_si128((const __m128i*)&ctx->RoundKey[r*16]);
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    u64 hi, lo;
+    LoadCounter(ctx, hi, lo);
+
+    auto counter = [&]()
+    {
+        __m128i ret = _mm_set_epi64x((s64)__builtin_bswap64(lo), (s64)__builtin_bswap64(hi));
+        IncrementCounter(hi, lo);
+        return ret;
+    };
+
+    u32 i = 0;
+
+    // four blocks at a time, so their rounds can overlap
+    for (; i + 64 <= len; i += 64)
+    {
+        __m128i ks[4];
+        for (int b = 0; b < 4; b++)
+            ks[b] = _mm_xor_si128(counter(), rk[0]);
+        for (int r = 1; r < 10; r++)
+        {
+            for (int b = 0; b < 4; b++)
+                ks[b] = _mm_aesenc_si128(ks[b], rk[r]);
+        }
+        for (int b = 0; b < 4; b++)
+        {
+            ks[b] = _mm_aesenclast_si128(ks[b], rk[10]);
+            if (reversed)
+                ks[b] = _mm_shuffle_epi8(ks[b], reverse);
+
+            __m128i* p = (__m128i*)&buf[i + b*16];
+            _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), ks[b]));
+        }
+    }
+
+    for (; i < len; i += 16)
+    {
+        __m128i ks = EncryptBlock_AESNI(rk, counter());
+        if (reversed)
+            ks = _mm_shuffle_epi8(ks, reverse);
+
+        if (len - i >= 16)
+        {
+            __m128i* p = (__m128i*)&buf[i];
+            _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), ks));
+        }
+        else
+        {
+            u8 tmp[16];
+            _mm_storeu_si128((__m128i*)tmp, ks);
+            for (u32 j = 0; j < len - i; j++)
+                buf[i+j] ^= tmp[j];
+        }
+    }
+
+    StoreCounter(ctx, hi, lo);
+}
+
+#elif defined(AES_ARM64)
+
+static bool DetectAcceleration()
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#else
+    // the compiler was told the extension is there
+    return true;
+#endif
+}
+
+static inline uint8x16_t EncryptBlock_ARMv8(const uint8x16_t* rk, uint8x16_t block)
+{
+    for (int r = 0; r < 9; r++)
+        block = vaesmcq_u8(vaeseq_u8(block, rk[r]));
+    return veorq_u8(vaeseq_u8(block, rk[9]), rk[10]);
+}
+
+static inline uint8x16_t Reverse128(uint8x16_t val)
+{
+    val = vrev64q_u8(val);
+    return vextq_u8(val, val, 8);
+}
+
+static void EncryptBlock_Accel(const AES_ctx* ctx, u8* block)
+{
+    uint8x16_t rk[11];
+    for (int r = 0; r < 11; r++)
+        rk[r] = vld1q_u8(&ctx->RoundKey[r*16]);
+
+    vst1q_u8(block, EncryptBlock_ARMv8(rk, vld1q_u8(block)));
+}
+
+static void CTR_Accel(AES_ctx* ctx, u8* buf, u32 len, bool reversed)
+{
+    uint8x16_t rk[11];
+    for (int r = 0; r < 11; r++)
+        rk[r] = vld1q_u8(&ctx->RoundKey[r*16]);
+
+    u64 hi, lo;
+    LoadCounter(ctx, hi, lo);
+
+    for (u32 i = 0; i < len; i += 16)
+    {
+        u8 ctr[16];
+        CounterBlock(ctr, hi, lo);
+        IncrementCounter(hi, lo);
+
+        uint8x16_t ks = EncryptBlock_ARMv8(rk, vld1q_u8(ctr));
+        if (reversed)
+            ks = Reverse128(ks);
+
+        if (len - i >= 16)
+        {
+            vst1q_u8(&buf[i], veorq_u8(vld1q_u8(&buf[i]), ks));
+        }
+        else
+        {
+            u8 tmp[16];
+            vst1q_u8(tmp, ks);
+            for (u32 j = 0; j < len - i; j++)
+                buf[i+j] ^= tmp[j];
+        }
+    }
+
+    StoreCounter(ctx, hi, lo);
+}
+
+#else
+
+static bool DetectAcceleration()
+{
+    return false;
+}
+
+static void EncryptBlock_Accel(const AES_ctx* ctx, u8* block)
+{
+    AES_ECB_encrypt(ctx, block);
+}
+
+static void CTR_Accel(AES_ctx* ctx, u8* buf, u32 len, bool reversed)
+{
+    CTR_Generic(ctx, buf, len, reversed);
+}
+
+#endif
+
+
+bool AES_IsAccelerated() noexcept
+{
+    static const bool accelerated = DetectAcceleration();
+    return accelerated;
+}
+
+void AES_EncryptBlock(const AES_ctx* ctx, u8* block) noexcept
+{
+    if (AES_IsAccelerated())
+        EncryptBlock_Accel(ctx, block);
+    else
+        AES_ECB_encrypt(ctx, block);
+}
+
+void AES_CTR_Xcrypt(AES_ctx* ctx, u8* buf, u32 len) noexcept
+{
+    if (AES_IsAccelerated())
+        CTR_Accel(ctx, buf, len, false);
+    else
+        CTR_Generic(ctx, buf, len, false);
+}
+
+void AES_CTR_XcryptReversed(AES_ctx* ctx, u8* buf, u32 len) noexcept
+{
+    if (AES_IsAccelerated())
+        CTR_Accel(ctx, buf, len, true);
+    else
+        CTR_Generic(ctx, buf, len, true);
+}
+
+}
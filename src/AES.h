@@ -0,0 +1,47 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef AES_H
+#define AES_H
+
+#include "types.h"
+#include "tiny-AES-c/aes.hpp"
+
+// Bulk AES-128 operations on top of tiny-AES contexts.
+// Keys are still set up with AES_init_ctx_iv and friends; these use the
+// CPU's AES instructions (AES-NI or the ARMv8 crypto extension) when they
+// are available, and fall back to tiny-AES otherwise.
+
+namespace melonDS
+{
+/// @return Whether AES instructions are used on this CPU.
+bool AES_IsAccelerated() noexcept;
+
+/// Encrypts a single block in place. Same as AES_ECB_encrypt.
+void AES_EncryptBlock(const AES_ctx* ctx, u8* block) noexcept;
+
+/// Encrypts or decrypts a buffer in CTR mode, advancing the counter in \c ctx.
+/// Same as AES_CTR_xcrypt_buffer.
+void AES_CTR_Xcrypt(AES_ctx* ctx, u8* buf, u32 len) noexcept;
+
+/// Same as AES_CTR_Xcrypt, for data whose 16-byte blocks are each stored
+/// byte-reversed, like the DSi does. \c len must be a multiple of 16.
+void AES_CTR_XcryptReversed(AES_ctx* ctx, u8* buf, u32 len) noexcept;
+}
+
+#endif // AES_H
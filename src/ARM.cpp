@@ -377,7 +377,7 @@ void ARMv4::JumpTo(u32 addr, bool restorecpsr)
 
         NextInstr[0] = CodeRead16(addr);
         NextInstr[1] = CodeRead16(addr+2);
-        Cycles += NDS.ARM7MemTimings[CodeCycles][0] + NDS.ARM7MemTimings[CodeCycles][1];
+        Cycles += NDS.GetARM7MemTimings(CodeCycles)[0] + NDS.GetARM7MemTimings(CodeCycles)[1];
 
         CPSR |= 0x20;
     }
@@ -390,7 +390,7 @@ void ARMv4::JumpTo(u32 addr, bool restorecpsr)
 
         NextInstr[0] = CodeRead32(addr);
         NextInstr[1] = CodeRead32(addr+4);
-        Cycles += NDS.ARM7MemTimings[CodeCycles][2] + NDS.ARM7MemTimings[CodeCycles][3];
+        Cycles += NDS.GetARM7MemTimings(CodeCycles)[2] + NDS.GetARM7MemTimings(CodeCycles)[3];
 
         CPSR &= ~0x20;
     }
@@ -1116,7 +1116,7 @@ void ARMv4::DataRead8(u32 addr, u32* val)
 {
     *val = BusRead8(addr);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][0];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[0];
 }
 
 void ARMv4::DataRead16(u32 addr, u32* val)
@@ -1125,7 +1125,7 @@ void ARMv4::DataRead16(u32 addr, u32* val)
 
     *val = BusRead16(addr);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][0];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[0];
 }
 
 void ARMv4::DataRead32(u32 addr, u32* val)
@@ -1134,7 +1134,7 @@ void ARMv4::DataRead32(u32 addr, u32* val)
 
     *val = BusRead32(addr);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][2];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[2];
 }
 
 void ARMv4::DataRead32S(u32 addr, u32* val)
@@ -1142,14 +1142,14 @@ void ARMv4::DataRead32S(u32 addr, u32* val)
     addr &= ~3;
 
     *val = BusRead32(addr);
-    DataCycles += NDS.ARM7MemTimings[addr >> 15][3];
+    DataCycles += NDS.GetARM7MemTimings(addr >> 15)[3];
 }
 
 void ARMv4::DataWrite8(u32 addr, u8 val)
 {
     BusWrite8(addr, val);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][0];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[0];
 }
 
 void ARMv4::DataWrite16(u32 addr, u16 val)
@@ -1158,7 +1158,7 @@ void ARMv4::DataWrite16(u32 addr, u16 val)
 
     BusWrite16(addr, val);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][0];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[0];
 }
 
 void ARMv4::DataWrite32(u32 addr, u32 val)
@@ -1167,7 +1167,7 @@ void ARMv4::DataWrite32(u32 addr, u32 val)
 
     BusWrite32(addr, val);
     DataRegion = addr;
-    DataCycles = NDS.ARM7MemTimings[addr >> 15][2];
+    DataCycles = NDS.GetARM7MemTimings(addr >> 15)[2];
 }
 
 void ARMv4::DataWrite32S(u32 addr, u32 val)
@@ -1175,26 +1175,26 @@ void ARMv4::DataWrite32S(u32 addr, u32 val)
     addr &= ~3;
 
     BusWrite32(addr, val);
-    DataCycles += NDS.ARM7MemTimings[addr >> 15][3];
+    DataCycles += NDS.GetARM7MemTimings(addr >> 15)[3];
 }
 
 
 void ARMv4::AddCycles_C()
 {
     // code only. this code fetch is sequential.
-    Cycles += NDS.ARM7MemTimings[CodeCycles][(CPSR&0x20)?1:3];
+    Cycles += NDS.GetARM7MemTimings(CodeCycles)[(CPSR&0x20)?1:3];
 }
 
 void ARMv4::AddCycles_CI(s32 num)
 {
     // code+internal. results in a nonseq code fetch.
-    Cycles += NDS.ARM7MemTimings[CodeCycles][(CPSR&0x20)?0:2] + num;
+    Cycles += NDS.GetARM7MemTimings(CodeCycles)[(CPSR&0x20)?0:2] + num;
 }
 
 void ARMv4::AddCycles_CDI()
 {
     // LDR/LDM cycles.
-    s32 numC = NDS.ARM7MemTimings[CodeCycles][(CPSR&0x20)?0:2];
+    s32 numC = NDS.GetARM7MemTimings(CodeCycles)[(CPSR&0x20)?0:2];
     s32 numD = DataCycles;
 
     if ((DataRegion >> 24) == 0x02) // mainRAM
@@ -1221,7 +1221,7 @@ void ARMv4::AddCycles_CDI()
 void ARMv4::AddCycles_CD()
 {
     // TODO: max gain should be 5c when writing to mainRAM
-    s32 numC = NDS.ARM7MemTimings[CodeCycles][(CPSR&0x20)?0:2];
+    s32 numC = NDS.GetARM7MemTimings(CodeCycles)[(CPSR&0x20)?0:2];
     s32 numD = DataCycles;
 
     if ((DataRegion >> 24) == 0x02)
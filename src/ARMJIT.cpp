@@ -43,6 +43,7 @@
 #include "Wifi.h"
 #include "NDSCart.h"
 #include "Platform.h"
+#include "Utils.h"
 #include "ARMJIT_x64/ARMJIT_Offsets.h"
 
 namespace melonDS
@@ -103,11 +104,11 @@ T SlowRead9(u32 addr, ARMv5* cpu)
     else if ((addr & cpu->DTCMMask) == cpu->DTCMBase)
         val = *(T*)&cpu->DTCM[addr & 0x3FFF];
     else if (std::is_same<T, u32>::value)
-        val = NDS::Current->ARM9Read32(addr);
+        val = cpu->NDS.ARM9Read32(addr);
     else if (std::is_same<T, u16>::value)
-        val = NDS::Current->ARM9Read16(addr);
+        val = cpu->NDS.ARM9Read16(addr);
     else
-        val = NDS::Current->ARM9Read8(addr);
+        val = cpu->NDS.ARM9Read8(addr);
 
     if (std::is_same<T, u32>::value)
         return ROR(val, offset << 3);
@@ -116,18 +117,18 @@ T SlowRead9(u32 addr, ARMv5* cpu)
 }
 
 template <typename T, int ConsoleType>
-T SlowRead7(u32 addr)
+T SlowRead7(u32 addr, ARMv4* cpu)
 {
     u32 offset = addr & 0x3;
     addr &= ~(sizeof(T) - 1);
 
     T val;
     if (std::is_same<T, u32>::value)
-        val = NDS::Current->ARM7Read32(addr);
+        val = cpu->NDS.ARM7Read32(addr);
     else if (std::is_same<T, u16>::value)
-        val = NDS::Current->ARM7Read16(addr);
+        val = cpu->NDS.ARM7Read16(addr);
     else
-        val = NDS::Current->ARM7Read8(addr);
+        val = cpu->NDS.ARM7Read8(addr);
 
     if (std::is_same<T, u32>::value)
         return ROR(val, offset << 3);
@@ -151,29 +152,29 @@ void SlowWrite9(u32 addr, ARMv5* cpu, u32 val)
     }
     else if (std::is_same<T, u32>::value)
     {
-        NDS::Current->ARM9Write32(addr, val);
+        cpu->NDS.ARM9Write32(addr, val);
     }
     else if (std::is_same<T, u16>::value)
     {
-        NDS::Current->ARM9Write16(addr, val);
+        cpu->NDS.ARM9Write16(addr, val);
     }
     else
     {
-        NDS::Current->ARM9Write8(addr, val);
+        cpu->NDS.ARM9Write8(addr, val);
     }
 }
 
 template <typename T, int ConsoleType>
-void SlowWrite7(u32 addr, u32 val)
+void SlowWrite7(u32 addr, ARMv4* cpu, u32 val)
 {
     addr &= ~(sizeof(T) - 1);
 
     if (std::is_same<T, u32>::value)
-        NDS::Current->ARM7Write32(addr, val);
+        cpu->NDS.ARM7Write32(addr, val);
     else if (std::is_same<T, u16>::value)
-        NDS::Current->ARM7Write16(addr, val);
+        cpu->NDS.ARM7Write16(addr, val);
     else
-        NDS::Current->ARM7Write8(addr, val);
+        cpu->NDS.ARM7Write8(addr, val);
 }
 
 template <bool Write, int ConsoleType>
@@ -191,15 +192,15 @@ void SlowBlockTransfer9(u32 addr, u64* data, u32 num, ARMv5* cpu)
 }
 
 template <bool Write, int ConsoleType>
-void SlowBlockTransfer7(u32 addr, u64* data, u32 num)
+void SlowBlockTransfer7(u32 addr, u64* data, u32 num, ARMv4* cpu)
 {
     addr &= ~0x3;
     for (u32 i = 0; i < num; i++)
     {
         if (Write)
-            SlowWrite7<u32, ConsoleType>(addr, data[i]);
+            SlowWrite7<u32, ConsoleType>(addr, cpu, data[i]);
         else
-            data[i] = SlowRead7<u32, ConsoleType>(addr);
+            data[i] = SlowRead7<u32, ConsoleType>(addr, cpu);
         addr += 4;
     }
 }
@@ -213,26 +214,51 @@ void SlowBlockTransfer7(u32 addr, u64* data, u32 num)
     template u16 SlowRead9<u16, consoleType>(u32, ARMv5*); \
     template u8 SlowRead9<u8, consoleType>(u32, ARMv5*); \
     \
-    template void SlowWrite7<u32, consoleType>(u32, u32); \
-    template void SlowWrite7<u16, consoleType>(u32, u32); \
-    template void SlowWrite7<u8, consoleType>(u32, u32); \
+    template void SlowWrite7<u32, consoleType>(u32, ARMv4*, u32); \
+    template void SlowWrite7<u16, consoleType>(u32, ARMv4*, u32); \
+    template void SlowWrite7<u8, consoleType>(u32, ARMv4*, u32); \
     \
-    template u32 SlowRead7<u32, consoleType>(u32); \
-    template u16 SlowRead7<u16, consoleType>(u32); \
-    template u8 SlowRead7<u8, consoleType>(u32); \
+    template u32 SlowRead7<u32, consoleType>(u32, ARMv4*); \
+    template u16 SlowRead7<u16, consoleType>(u32, ARMv4*); \
+    template u8 SlowRead7<u8, consoleType>(u32, ARMv4*); \
     \
     template void SlowBlockTransfer9<false, consoleType>(u32, u64*, u32, ARMv5*); \
     template void SlowBlockTransfer9<true, consoleType>(u32, u64*, u32, ARMv5*); \
-    template void SlowBlockTransfer7<false, consoleType>(u32 addr, u64* data, u32 num); \
-    template void SlowBlockTransfer7<true, consoleType>(u32 addr, u64* data, u32 num); \
+    template void SlowBlockTransfer7<false, consoleType>(u32, u64*, u32, ARMv4*); \
+    template void SlowBlockTransfer7<true, consoleType>(u32, u64*, u32, ARMv4*); \
 
 INSTANTIATE_SLOWMEM(0)
 INSTANTIATE_SLOWMEM(1)
 
+void ARMJIT::InitFastBlockLookup() noexcept
+{
+    for (int i = 0; i < ARMJIT_Memory::memregions_Count; i++)
+        FastBlockLookupSize += CodeRegionSizes[i] * sizeof(u64) / 2;
+
+    FastBlockLookup = AllocateLazyMemory(FastBlockLookupSize);
+    if (!FastBlockLookup)
+    {
+        Log(LogLevel::Error, "Failed to allocate JIT block lookup tables!\n");
+        return;
+    }
+
+    u32 offset = 0;
+    for (int i = 0; i < ARMJIT_Memory::memregions_Count; i++)
+    {
+        if (CodeRegionSizes[i])
+        {
+            FastBlockLookupRegions[i] = (u64*)(FastBlockLookup + offset);
+            offset += CodeRegionSizes[i] * sizeof(u64) / 2;
+        }
+    }
+}
+
 ARMJIT::~ARMJIT() noexcept
 {
     JitEnableWrite();
     ResetBlockCache();
+
+    FreeLazyMemory(FastBlockLookup, FastBlockLookupSize);
 }
 
 void ARMJIT::Reset() noexcept
@@ -557,8 +583,7 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
             JIT_DEBUGPRINT("switching out block %x %x %x\n", localAddr, blockAddr, existingBlockIt->second->StartAddr);
 
             u64* entry = &FastBlockLookupRegions[localAddr >> 27][(localAddr & 0x7FFFFFF) / 2];
-            *entry = ((u64)blockAddr | cpu->Num) << 32;
-            *entry |= JITCompiler.SubEntryOffset(existingBlockIt->second->EntryPoint);
+            *entry = FastBlockLookupEntry(blockAddr | cpu->Num, JITCompiler.SubEntryOffset(existingBlockIt->second->EntryPoint));
             return;
         }
 
@@ -932,8 +957,7 @@ void ARMJIT::CompileBlock(ARM* cpu) noexcept
         JitBlocks7[blockAddr] = block;
 
     u64* entry = &FastBlockLookupRegions[(localAddr >> 27)][(localAddr & 0x7FFFFFF) / 2];
-    *entry = ((u64)blockAddr | cpu->Num) << 32;
-    *entry |= JITCompiler.SubEntryOffset(block->EntryPoint);
+    *entry = FastBlockLookupEntry(blockAddr | cpu->Num, JITCompiler.SubEntryOffset(block->EntryPoint));
 }
 
 void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
@@ -1013,7 +1037,7 @@ void ARMJIT::InvalidateByAddr(u32 localAddr) noexcept
             }
         }
 
-        FastBlockLookupRegions[block->StartAddrLocal >> 27][(block->StartAddrLocal & 0x7FFFFFF) / 2] = (u64)UINT32_MAX << 32;
+        FastBlockLookupRegions[block->StartAddrLocal >> 27][(block->StartAddrLocal & 0x7FFFFFF) / 2] = 0;
         if (block->Num == 0)
             JitBlocks9.erase(block->StartAddr);
         else
@@ -1067,7 +1091,7 @@ void ARMJIT::CheckAndInvalidateWVRAM(int bank) noexcept
 JitBlockEntry ARMJIT::LookUpBlock(u32 num, u64* entries, u32 offset, u32 addr) noexcept
 {
     u64* entry = &entries[offset / 2];
-    if (*entry >> 32 == (addr | num))
+    if (FastBlockLookupTag(*entry) == (addr | num))
         return JITCompiler.AddEntryOffset((u32)*entry);
     return NULL;
 }
@@ -1120,11 +1144,8 @@ void ARMJIT::ResetBlockCache() noexcept
     Memory.Reset();
 
     InvalidLiterals.Clear();
-    for (int i = 0; i < ARMJIT_Memory::memregions_Count; i++)
-    {
-        if (FastBlockLookupRegions[i])
-            memset(FastBlockLookupRegions[i], 0xFF, CodeRegionSizes[i] * sizeof(u64) / 2);
-    }
+    if (FastBlockLookup)
+        ResetLazyMemory(FastBlockLookup, FastBlockLookupSize);
     for (auto it = RestoreCandidates.begin(); it != RestoreCandidates.end(); it++)
         delete it->second;
     RestoreCandidates.clear();
@@ -52,7 +52,9 @@ public:
         LiteralOptimizations(jit.has_value() ? jit->LiteralOptimizations : false),
         BranchOptimizations(jit.has_value() ? jit->BranchOptimizations : false),
         FastMemory(jit.has_value() ? jit->FastMemory : false)
-    {}
+    {
+        InitFastBlockLookup();
+    }
     ~ARMJIT() noexcept;
     void InvalidateByAddr(u32) noexcept;
     void CheckAndInvalidateWVRAM(int) noexcept;
@@ -86,6 +88,7 @@ public:
     friend class ARMJIT_Memory;
     void blockSanityCheck(u32 num, u32 blockAddr, JitBlockEntry entry) noexcept;
     void RetireJitBlock(JitBlock* block) noexcept;
+    void InitFastBlockLookup() noexcept;
 
     int GetMaxBlockSize() const noexcept { return MaxBlockSize; }
     bool LiteralOptimizationsEnabled() const noexcept { return LiteralOptimizations; }
@@ -119,20 +122,6 @@ public:
     AddressRange CodeIndexNWRAM_B[NWRAMSize / 512] {};
     AddressRange CodeIndexNWRAM_C[NWRAMSize / 512] {};
 
-    u64 FastBlockLookupITCM[ITCMPhysicalSize / 2] {};
-    u64 FastBlockLookupMainRAM[MainRAMMaxSize / 2] {};
-    u64 FastBlockLookupSWRAM[SharedWRAMSize / 2] {};
-    u64 FastBlockLookupVRAM[0x100000 / 2] {};
-    u64 FastBlockLookupARM9BIOS[ARM9BIOSSize / 2] {};
-    u64 FastBlockLookupARM7BIOS[ARM7BIOSSize / 2] {};
-    u64 FastBlockLookupARM7WRAM[ARM7WRAMSize / 2] {};
-    u64 FastBlockLookupARM7WVRAM[0x40000 / 2] {};
-    u64 FastBlockLookupBIOS9DSi[0x10000 / 2] {};
-    u64 FastBlockLookupBIOS7DSi[0x10000 / 2] {};
-    u64 FastBlockLookupNWRAM_A[NWRAMSize / 2] {};
-    u64 FastBlockLookupNWRAM_B[NWRAMSize / 2] {};
-    u64 FastBlockLookupNWRAM_C[NWRAMSize / 2] {};
-
     AddressRange* const CodeMemRegions[ARMJIT_Memory::memregions_Count] =
     {
         NULL,
@@ -155,27 +144,25 @@ public:
         CodeIndexNWRAM_C
     };
 
-    u64* const FastBlockLookupRegions[ARMJIT_Memory::memregions_Count] =
+    /*
+        The fast block lookup tables map every halfword of executable memory
+        to the block starting there. Together they cover more than 64 MB,
+        of which games only ever execute a tiny fraction, so they all live
+        in one lazily committed allocation. An all zero entry is empty,
+        which is why the address tag is stored inverted.
+    */
+    u8* FastBlockLookup = nullptr;
+    u32 FastBlockLookupSize = 0;
+    u64* FastBlockLookupRegions[ARMJIT_Memory::memregions_Count] {};
+
+    static u64 FastBlockLookupEntry(u32 tag, u32 entryOffset) noexcept
     {
-        NULL,
-        FastBlockLookupITCM,
-        NULL,
-        FastBlockLookupARM9BIOS,
-        FastBlockLookupMainRAM,
-        FastBlockLookupSWRAM,
-        NULL,
-        FastBlockLookupVRAM,
-        FastBlockLookupARM7BIOS,
-        FastBlockLookupARM7WRAM,
-        NULL,
-        NULL,
-        FastBlockLookupARM7WVRAM,
-        FastBlockLookupBIOS9DSi,
-        FastBlockLookupBIOS7DSi,
-        FastBlockLookupNWRAM_A,
-        FastBlockLookupNWRAM_B,
-        FastBlockLookupNWRAM_C
-    };
+        return ((u64)~tag << 32) | entryOffset;
+    }
+    static u32 FastBlockLookupTag(u64 entry) noexcept
+    {
+        return ~(u32)(entry >> 32);
+    }
 };
 }
 
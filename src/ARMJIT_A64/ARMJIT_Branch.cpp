@@ -133,7 +133,7 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
             u32 compileTimePC = CurCPU->R[15];
             CurCPU->R[15] = newPC;
 
-            cycles += NDS.ARM7MemTimings[codeCycles][0] + NDS.ARM7MemTimings[codeCycles][1];
+            cycles += NDS.GetARM7MemTimings(codeCycles)[0] + NDS.GetARM7MemTimings(codeCycles)[1];
 
             CurCPU->R[15] = compileTimePC;
         }
@@ -145,7 +145,7 @@ void Compiler::Comp_JumpTo(u32 addr, bool forceNonConstantCycles)
             u32 compileTimePC = CurCPU->R[15];
             CurCPU->R[15] = newPC;
 
-            cycles += NDS.ARM7MemTimings[codeCycles][2] + NDS.ARM7MemTimings[codeCycles][3];
+            cycles += NDS.GetARM7MemTimings(codeCycles)[2] + NDS.GetARM7MemTimings(codeCycles)[3];
 
             CurCPU->R[15] = compileTimePC;
         }
@@ -236,8 +236,10 @@ void* Compiler::Gen_JumpTo7(int kind)
     LSR(W1, W0, 15);
     STR(INDEX_UNSIGNED, W1, RCPU, offsetof(ARM, CodeCycles));
 
-    MOVP2R(X2, NDS.ARM7MemTimings);
-    LDR(W3, X2, ArithOption(W1, true));
+    MOVP2R(X2, NDS.ARM7MemTimingIndex);
+    LDRB(W3, X2, ArithOption(W1));
+    MOVP2R(X2, NDS.ARM7MemTimingTable);
+    LDR(W3, X2, ArithOption(W3, true));
 
     FixupBranch switchToThumb;
     if (kind == 0)
@@ -274,6 +274,8 @@ public:
     void* JitRWBase;
     void* JitRWStart;
     void* JitRXStart;
+#else
+    u8* JitMem {};
 #endif
 
     void* ReadBanked, *WriteBanked;
@@ -232,9 +232,10 @@ void Compiler::Comp_MemAccess(int rd, int rn, Op2 offset, int size, int flags)
 
         if (func)
         {
+            MOVP2R(X1, &NDS);
             if (flags & memop_Store)
-                MOV(W1, rdMapped);
-            QuickCallFunction(X2, (void (*)())func);
+                MOV(W2, rdMapped);
+            QuickCallFunction(X3, (void (*)())func);
 
             PopRegs(false, false);
 
@@ -289,9 +290,10 @@ void Compiler::Comp_MemAccess(int rd, int rn, Op2 offset, int size, int flags)
             }
             else
             {
+                MOV(X1, RCPU);
                 if (flags & memop_Store)
                 {
-                    MOV(W1, rdMapped);
+                    MOV(W2, rdMapped);
                     switch (size | NDS.ConsoleType)
                     {
                     case 32: QuickCallFunction(X3, SlowWrite7<u32, 0>); break;
@@ -678,9 +680,9 @@ s32 Compiler::Comp_MemAccessBlock(int rn, BitSet16 regs, bool store, bool preinc
     ADD(X1, SP, 0);
     MOVI2R(W2, regsCount);
 
+    MOV(X3, RCPU);
     if (Num == 0)
     {
-        MOV(X3, RCPU);
         switch ((u32)store * 2 | NDS.ConsoleType)
         {
         case 0: QuickCallFunction(X4, SlowBlockTransfer9<false, 0>); break;
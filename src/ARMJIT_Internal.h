@@ -32,6 +32,7 @@ namespace melonDS
 {
 class ARM;
 class ARMv5;
+class ARMv4;
 
 // here lands everything which doesn't fit into ARMJIT.h
 // where it would be included by pretty much everything
@@ -97,11 +98,11 @@ inline bool PageContainsCode(const AddressRange* range)
 
 template <typename T, int ConsoleType> T SlowRead9(u32 addr, ARMv5* cpu);
 template <typename T, int ConsoleType> void SlowWrite9(u32 addr, ARMv5* cpu, u32 val);
-template <typename T, int ConsoleType> T SlowRead7(u32 addr);
-template <typename T, int ConsoleType> void SlowWrite7(u32 addr, u32 val);
+template <typename T, int ConsoleType> T SlowRead7(u32 addr, ARMv4* cpu);
+template <typename T, int ConsoleType> void SlowWrite7(u32 addr, ARMv4* cpu, u32 val);
 
 template <bool Write, int ConsoleType> void SlowBlockTransfer9(u32 addr, u64* data, u32 num, ARMv5* cpu);
-template <bool Write, int ConsoleType> void SlowBlockTransfer7(u32 addr, u64* data, u32 num);
+template <bool Write, int ConsoleType> void SlowBlockTransfer7(u32 addr, u64* data, u32 num, ARMv4* cpu);
 
 }
 
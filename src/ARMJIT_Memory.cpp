@@ -48,6 +48,8 @@
 #include "SPU.h"
 
 #include <stdlib.h>
+#include <atomic>
+#include <mutex>
 
 /*
     We're handling fastmem here.
@@ -107,6 +109,47 @@ using Platform::LogLevel;
 #define ASHMEM_DEVICE "/dev/ashmem"
 #endif
 
+const u64 AddrSpaceSize = 0x100000000;
+
+/*
+    Every NDS instance has its own fastmem areas, but there's only one
+    fault handler for the whole process. So every instance registers itself
+    here and the fault handler looks for the instance which owns the faulting
+    address.
+
+    This is accessed from within the fault handler, so it's a plain fixed size
+    table of atomics. The lock is only used to serialise (un)registration.
+*/
+constexpr int MaxFastMemInstances = 256;
+static std::atomic<ARMJIT_Memory*> FastMemInstances[MaxFastMemInstances] {};
+static std::mutex FastMemInstancesLock;
+static int FastMemInstancesCount = 0;
+
+ARMJIT_Memory* ARMJIT_Memory::FindFaultingInstance(u8* faultAddr, FaultDescription& faultDesc) noexcept
+{
+    for (int i = 0; i < MaxFastMemInstances; i++)
+    {
+        ARMJIT_Memory* memory = FastMemInstances[i].load(std::memory_order_acquire);
+        if (!memory)
+            continue;
+
+        u8* fastMem9 = (u8*)memory->FastMem9Start;
+        u8* fastMem7 = (u8*)memory->FastMem7Start;
+        if (faultAddr >= fastMem9 && faultAddr < fastMem9 + AddrSpaceSize)
+        {
+            faultDesc.EmulatedFaultAddr = faultAddr - fastMem9;
+            return memory;
+        }
+        if (faultAddr >= fastMem7 && faultAddr < fastMem7 + AddrSpaceSize)
+        {
+            faultDesc.EmulatedFaultAddr = faultAddr - fastMem7;
+            return memory;
+        }
+    }
+
+    return nullptr;
+}
+
 #if defined(__SWITCH__)
 // with LTO the symbols seem to be not properly overriden
 // if they're somewhere else
@@ -159,12 +202,14 @@ LONG ARMJIT_Memory::ExceptionHandler(EXCEPTION_POINTERS* exceptionInfo)
         return EXCEPTION_CONTINUE_SEARCH;
     }
 
-    u8* curArea = (u8*)(NDS::Current->CurCPU == 0 ? NDS::Current->JIT.Memory.FastMem9Start : NDS::Current->JIT.Memory.FastMem7Start);
     FaultDescription desc {};
-    desc.EmulatedFaultAddr = (u8*)exceptionInfo->ExceptionRecord->ExceptionInformation[1] - curArea;
+    ARMJIT_Memory* memory = FindFaultingInstance((u8*)exceptionInfo->ExceptionRecord->ExceptionInformation[1], desc);
+    if (!memory)
+        return EXCEPTION_CONTINUE_SEARCH;
+
     desc.FaultPC = (u8*)exceptionInfo->ContextRecord->CONTEXT_PC;
 
-    if (FaultHandler(desc, *NDS::Current))
+    if (FaultHandler(desc, memory->NDS))
     {
         exceptionInfo->ContextRecord->CONTEXT_PC = (u64)desc.FaultPC;
         return EXCEPTION_CONTINUE_EXECUTION;
@@ -194,12 +239,10 @@ void ARMJIT_Memory::SigsegvHandler(int sig, siginfo_t* info, void* rawContext)
     ucontext_t* context = (ucontext_t*)rawContext;
 
     FaultDescription desc {};
-    u8* curArea = (u8*)(NDS::Current->CurCPU == 0 ? NDS::Current->JIT.Memory.FastMem9Start : NDS::Current->JIT.Memory.FastMem7Start);
-
-    desc.EmulatedFaultAddr = (u8*)info->si_addr - curArea;
+    ARMJIT_Memory* memory = FindFaultingInstance((u8*)info->si_addr, desc);
     desc.FaultPC = (u8*)context->CONTEXT_PC;
 
-    if (FaultHandler(desc, *NDS::Current))
+    if (memory && FaultHandler(desc, memory->NDS))
     {
         context->CONTEXT_PC = (u64)desc.FaultPC;
         return;
@@ -253,6 +296,14 @@ const u32 OffsetsPerRegion[ARMJIT_Memory::memregions_Count] =
     MemBlockNWRAM_COffset
 };
 
+#if !defined(__SWITCH__) && !defined(_WIN32)
+#ifdef MAP_NORESERVE
+const int FastMemReserveFlags = MAP_NORESERVE;
+#else
+const int FastMemReserveFlags = 0;
+#endif
+#endif
+
 enum
 {
     memstate_Unmapped,
@@ -288,7 +339,8 @@ bool ARMJIT_Memory::UnmapFromRange(u32 addr, u32 num, u32 offset, u32 size) noex
 #elif defined(_WIN32)
     return UnmapViewOfFile(dst);
 #else
-    return munmap(dst, size) == 0;
+    // don't give the range back to the OS, just make it inaccessible again
+    return mmap(dst, size, PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_FIXED | FastMemReserveFlags, -1, 0) != MAP_FAILED;
 #endif
 }
 
@@ -624,6 +676,70 @@ bool ARMJIT_Memory::MapAtAddress(u32 addr) noexcept
     return true;
 }
 
+#if defined(_WIN32)
+static LPVOID ExceptionHandlerHandle = nullptr;
+#endif
+
+void ARMJIT_Memory::RegisterFaultHandler() noexcept
+{
+    std::lock_guard<std::mutex> lock(FastMemInstancesLock);
+
+    int slot = 0;
+    while (slot < MaxFastMemInstances && FastMemInstances[slot].load(std::memory_order_relaxed))
+        slot++;
+    if (slot == MaxFastMemInstances)
+    {
+        Log(LogLevel::Error, "Too many JIT instances, fastmem faults can't be handled!\n");
+        return;
+    }
+    FastMemInstances[slot].store(this, std::memory_order_release);
+
+    if (FastMemInstancesCount++ > 0)
+        return;
+
+#if defined(_WIN32)
+    ExceptionHandlerHandle = AddVectoredExceptionHandler(1, ExceptionHandler);
+#elif !defined(__SWITCH__)
+    struct sigaction sa;
+    sa.sa_handler = nullptr;
+    sa.sa_sigaction = &SigsegvHandler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, &OldSaSegv);
+#ifdef __APPLE__
+    sigaction(SIGBUS, &sa, &OldSaBus);
+#endif
+#endif
+}
+
+void ARMJIT_Memory::UnregisterFaultHandler() noexcept
+{
+    std::lock_guard<std::mutex> lock(FastMemInstancesLock);
+
+    int slot = 0;
+    while (slot < MaxFastMemInstances && FastMemInstances[slot].load(std::memory_order_relaxed) != this)
+        slot++;
+    if (slot == MaxFastMemInstances)
+        return;
+    FastMemInstances[slot].store(nullptr, std::memory_order_release);
+
+    if (--FastMemInstancesCount > 0)
+        return;
+
+#if defined(_WIN32)
+    if (ExceptionHandlerHandle)
+    {
+        RemoveVectoredExceptionHandler(ExceptionHandlerHandle);
+        ExceptionHandlerHandle = nullptr;
+    }
+#elif !defined(__SWITCH__)
+    sigaction(SIGSEGV, &OldSaSegv, nullptr);
+#ifdef __APPLE__
+    sigaction(SIGBUS, &OldSaBus, nullptr);
+#endif
+#endif
+}
+
 bool ARMJIT_Memory::FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds)
 {
     if (nds.JIT.JITCompiler.IsJITFault(faultDesc.FaultPC))
@@ -643,8 +759,6 @@ bool ARMJIT_Memory::FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds)
     return false;
 }
 
-const u64 AddrSpaceSize = 0x100000000;
-
 ARMJIT_Memory::ARMJIT_Memory(melonDS::NDS& nds) : NDS(nds)
 {
 #if defined(__SWITCH__)
@@ -671,8 +785,6 @@ ARMJIT_Memory::ARMJIT_Memory(melonDS::NDS& nds) : NDS(nds)
 
     u8* basePtr = MemoryBaseCodeMem;
 #elif defined(_WIN32)
-    ExceptionHandlerHandle = AddVectoredExceptionHandler(1, ExceptionHandler);
-
     MemoryFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, MemoryTotalSize, NULL);
 
     MemoryBase = (u8*)VirtualAlloc(NULL, AddrSpaceSize*4, MEM_RESERVE, PAGE_READWRITE);
@@ -693,8 +805,13 @@ ARMJIT_Memory::ARMJIT_Memory(melonDS::NDS& nds) : NDS(nds)
     // The idea was to give the OS more freedom where to position the buffers,
     // but something was bad about this so instead we take this vmem eating monster
     // which seems to work better.
-    MemoryBase = (u8*)mmap(NULL, AddrSpaceSize*4, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
-    munmap(MemoryBase, AddrSpaceSize*4);
+    // The whole range stays reserved as long as we live, otherwise other
+    // instances might get their memory allocated inside our fastmem areas.
+    MemoryBase = (u8*)mmap(NULL, AddrSpaceSize*4, PROT_NONE, MAP_ANON | MAP_PRIVATE | FastMemReserveFlags, -1, 0);
+    if (MemoryBase == MAP_FAILED)
+    {
+        Log(LogLevel::Error, "Failed to reserve address space for fastmem! (%s)", strerror(errno));
+    }
     FastMem9Start = MemoryBase;
     FastMem7Start = MemoryBase + AddrSpaceSize;
     MemoryBase = MemoryBase + AddrSpaceSize*2;
@@ -716,8 +833,11 @@ ARMJIT_Memory::ARMJIT_Memory(melonDS::NDS& nds) : NDS(nds)
         MemoryFile = fd;
     }
 #else
-    char fastmemPidName[snprintf(NULL, 0, "/melondsfastmem%d", getpid()) + 1];
-    sprintf(fastmemPidName, "/melondsfastmem%d", getpid());
+    // every instance needs its own memory file
+    static std::atomic<u32> memoryFileCounter = 0;
+    u32 memoryFileNum = memoryFileCounter++;
+    char fastmemPidName[snprintf(NULL, 0, "/melondsfastmem%d_%u", getpid(), memoryFileNum) + 1];
+    sprintf(fastmemPidName, "/melondsfastmem%d_%u", getpid(), memoryFileNum);
     MemoryFile = shm_open(fastmemPidName, O_RDWR | O_CREAT | O_EXCL, 0600);
     if (MemoryFile == -1)
     {
@@ -730,24 +850,18 @@ ARMJIT_Memory::ARMJIT_Memory(melonDS::NDS& nds) : NDS(nds)
         Log(LogLevel::Error, "Failed to allocate memory using ftruncate! (%s)", strerror(errno));
     }
 
-    struct sigaction sa;
-    sa.sa_handler = nullptr;
-    sa.sa_sigaction = &SigsegvHandler;
-    sa.sa_flags = SA_SIGINFO;
-    sigemptyset(&sa.sa_mask);
-    sigaction(SIGSEGV, &sa, &OldSaSegv);
-#ifdef __APPLE__
-    sigaction(SIGBUS, &sa, &OldSaBus);
-#endif
-
     mmap(MemoryBase, MemoryTotalSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, MemoryFile, 0);
 
     u8* basePtr = MemoryBase;
 #endif
+
+    RegisterFaultHandler();
 }
 
 ARMJIT_Memory::~ARMJIT_Memory() noexcept
 {
+    UnregisterFaultHandler();
+
 #if defined(__SWITCH__)
     virtmemLock();
     if (FastMem9Reservation)
@@ -778,20 +892,11 @@ ARMJIT_Memory::~ARMJIT_Memory() noexcept
         CloseHandle(MemoryFile);
         MemoryFile = INVALID_HANDLE_VALUE;
     }
-
-    if (ExceptionHandlerHandle)
-    {
-        RemoveVectoredExceptionHandler(ExceptionHandlerHandle);
-        ExceptionHandlerHandle = nullptr;
-    }
 #else
-    sigaction(SIGSEGV, &OldSaSegv, nullptr);
-#ifdef __APPLE__
-    sigaction(SIGBUS, &OldSaBus, nullptr);
-#endif
     if (MemoryBase)
     {
-        munmap(MemoryBase, MemoryTotalSize);
+        // this also releases the reservation of the fastmem areas
+        munmap(FastMem9Start, AddrSpaceSize*4);
         MemoryBase = nullptr;
         FastMem9Start = nullptr;
         FastMem7Start = nullptr;
@@ -814,6 +919,60 @@ ARMJIT_Memory::~ARMJIT_Memory() noexcept
 #endif
 }
 
+#ifndef __SWITCH__
+u8* ARMJIT_Memory::AllocateCodeMemory(u32 size, const void* nearAddr) noexcept
+{
+    // The generated code calls into melonDS with relative calls
+    // (which on x64 only reach +-2 GB), so we look for free space
+    // close to nearAddr, starting right next to it.
+    const u64 maxDistance = 0x70000000;
+    const u64 step = 0x1000000;
+    u64 base = (u64)nearAddr & ~(u64)0xFFFF;
+
+    for (u64 distance = step; distance < maxDistance; distance += step)
+    {
+        for (int dir = 0; dir < 2; dir++)
+        {
+            u64 hint = dir == 0 ? base - distance - size : base + distance;
+            if (dir == 0 && base < distance + size)
+                continue;
+#if defined(_WIN32)
+            u8* mem = (u8*)VirtualAlloc((void*)hint, size, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+            if (!mem)
+                continue;
+#else
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(__APPLE__) && defined(__aarch64__)
+            flags |= MAP_JIT;
+#endif
+            u8* mem = (u8*)mmap((void*)hint, size, PROT_READ | PROT_WRITE | PROT_EXEC, flags, -1, 0);
+            if (mem == MAP_FAILED)
+                continue;
+#endif
+            u64 memDistance = (u64)mem > base ? (u64)mem + size - base : base - (u64)mem;
+            if (memDistance < maxDistance)
+                return mem;
+
+            FreeCodeMemory(mem, size);
+        }
+    }
+
+    Log(LogLevel::Error, "Failed to allocate JIT code memory!\n");
+    return nullptr;
+}
+
+void ARMJIT_Memory::FreeCodeMemory(u8* mem, u32 size) noexcept
+{
+    if (!mem)
+        return;
+#if defined(_WIN32)
+    VirtualFree(mem, 0, MEM_RELEASE);
+#else
+    munmap(mem, size);
+#endif
+}
+#endif
+
 void ARMJIT_Memory::Reset() noexcept
 {
     for (int region = 0; region < memregions_Count; region++)
@@ -1191,135 +1350,135 @@ u32 WifiRead32(u32 addr)
 }*/
 
 template <typename T>
-void VRAMWrite(u32 addr, T val)
+void VRAMWrite(u32 addr, melonDS::NDS* nds, T val)
 {
     switch (addr & 0x00E00000)
     {
-    case 0x00000000: NDS::Current->GPU.WriteVRAM_ABG<T>(addr, val); return;
-    case 0x00200000: NDS::Current->GPU.WriteVRAM_BBG<T>(addr, val); return;
-    case 0x00400000: NDS::Current->GPU.WriteVRAM_AOBJ<T>(addr, val); return;
-    case 0x00600000: NDS::Current->GPU.WriteVRAM_BOBJ<T>(addr, val); return;
-    default: NDS::Current->GPU.WriteVRAM_LCDC<T>(addr, val); return;
+    case 0x00000000: nds->GPU.WriteVRAM_ABG<T>(addr, val); return;
+    case 0x00200000: nds->GPU.WriteVRAM_BBG<T>(addr, val); return;
+    case 0x00400000: nds->GPU.WriteVRAM_AOBJ<T>(addr, val); return;
+    case 0x00600000: nds->GPU.WriteVRAM_BOBJ<T>(addr, val); return;
+    default: nds->GPU.WriteVRAM_LCDC<T>(addr, val); return;
     }
 }
 template <typename T>
-T VRAMRead(u32 addr)
+T VRAMRead(u32 addr, melonDS::NDS* nds)
 {
     switch (addr & 0x00E00000)
     {
-    case 0x00000000: return NDS::Current->GPU.ReadVRAM_ABG<T>(addr);
-    case 0x00200000: return NDS::Current->GPU.ReadVRAM_BBG<T>(addr);
-    case 0x00400000: return NDS::Current->GPU.ReadVRAM_AOBJ<T>(addr);
-    case 0x00600000: return NDS::Current->GPU.ReadVRAM_BOBJ<T>(addr);
-    default: return NDS::Current->GPU.ReadVRAM_LCDC<T>(addr);
+    case 0x00000000: return nds->GPU.ReadVRAM_ABG<T>(addr);
+    case 0x00200000: return nds->GPU.ReadVRAM_BBG<T>(addr);
+    case 0x00400000: return nds->GPU.ReadVRAM_AOBJ<T>(addr);
+    case 0x00600000: return nds->GPU.ReadVRAM_BOBJ<T>(addr);
+    default: return nds->GPU.ReadVRAM_LCDC<T>(addr);
     }
 }
 
-static u8 GPU3D_Read8(u32 addr) noexcept
+static u8 GPU3D_Read8(u32 addr, melonDS::NDS* nds) noexcept
 {
-    return NDS::Current->GPU.GPU3D.Read8(addr);
+    return nds->GPU.GPU3D.Read8(addr);
 }
 
-static u16 GPU3D_Read16(u32 addr) noexcept
+static u16 GPU3D_Read16(u32 addr, melonDS::NDS* nds) noexcept
 {
-    return NDS::Current->GPU.GPU3D.Read16(addr);
+    return nds->GPU.GPU3D.Read16(addr);
 }
 
-static u32 GPU3D_Read32(u32 addr) noexcept
+static u32 GPU3D_Read32(u32 addr, melonDS::NDS* nds) noexcept
 {
-    return NDS::Current->GPU.GPU3D.Read32(addr);
+    return nds->GPU.GPU3D.Read32(addr);
 }
 
-static void GPU3D_Write8(u32 addr, u8 val) noexcept
+static void GPU3D_Write8(u32 addr, melonDS::NDS* nds, u8 val) noexcept
 {
-    NDS::Current->GPU.GPU3D.Write8(addr, val);
+    nds->GPU.GPU3D.Write8(addr, val);
 }
 
-static void GPU3D_Write16(u32 addr, u16 val) noexcept
+static void GPU3D_Write16(u32 addr, melonDS::NDS* nds, u16 val) noexcept
 {
-    NDS::Current->GPU.GPU3D.Write16(addr, val);
+    nds->GPU.GPU3D.Write16(addr, val);
 }
 
-static void GPU3D_Write32(u32 addr, u32 val) noexcept
+static void GPU3D_Write32(u32 addr, melonDS::NDS* nds, u32 val) noexcept
 {
-    NDS::Current->GPU.GPU3D.Write32(addr, val);
+    nds->GPU.GPU3D.Write32(addr, val);
 }
 
 template<class T>
-static T GPU_ReadVRAM_ARM7(u32 addr) noexcept
+static T GPU_ReadVRAM_ARM7(u32 addr, melonDS::NDS* nds) noexcept
 {
-    return NDS::Current->GPU.ReadVRAM_ARM7<T>(addr);
+    return nds->GPU.ReadVRAM_ARM7<T>(addr);
 }
 
 template<class T>
-static void GPU_WriteVRAM_ARM7(u32 addr, T val) noexcept
+static void GPU_WriteVRAM_ARM7(u32 addr, melonDS::NDS* nds, T val) noexcept
 {
-    NDS::Current->GPU.WriteVRAM_ARM7<T>(addr, val);
+    nds->GPU.WriteVRAM_ARM7<T>(addr, val);
 }
 
-u32 NDSCartSlot_ReadROMData()
-{ // TODO: Add a NDS* parameter, when NDS* is eventually implemented
-    return NDS::Current->NDSCartSlot.ReadROMData();
+static u32 NDSCartSlot_ReadROMData(u32 addr, melonDS::NDS* nds)
+{
+    return nds->NDSCartSlot.ReadROMData();
 }
 
-static u8 NDS_ARM9IORead8(u32 addr)
+static u8 NDS_ARM9IORead8(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM9IORead8(addr);
+    return nds->ARM9IORead8(addr);
 }
 
-static u16 NDS_ARM9IORead16(u32 addr)
+static u16 NDS_ARM9IORead16(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM9IORead16(addr);
+    return nds->ARM9IORead16(addr);
 }
 
-static u32 NDS_ARM9IORead32(u32 addr)
+static u32 NDS_ARM9IORead32(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM9IORead32(addr);
+    return nds->ARM9IORead32(addr);
 }
 
-static void NDS_ARM9IOWrite8(u32 addr, u8 val)
+static void NDS_ARM9IOWrite8(u32 addr, melonDS::NDS* nds, u8 val)
 {
-    NDS::Current->ARM9IOWrite8(addr, val);
+    nds->ARM9IOWrite8(addr, val);
 }
 
-static void NDS_ARM9IOWrite16(u32 addr, u16 val)
+static void NDS_ARM9IOWrite16(u32 addr, melonDS::NDS* nds, u16 val)
 {
-    NDS::Current->ARM9IOWrite16(addr, val);
+    nds->ARM9IOWrite16(addr, val);
 }
 
-static void NDS_ARM9IOWrite32(u32 addr, u32 val)
+static void NDS_ARM9IOWrite32(u32 addr, melonDS::NDS* nds, u32 val)
 {
-    NDS::Current->ARM9IOWrite32(addr, val);
+    nds->ARM9IOWrite32(addr, val);
 }
 
-static u8 NDS_ARM7IORead8(u32 addr)
+static u8 NDS_ARM7IORead8(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM7IORead8(addr);
+    return nds->ARM7IORead8(addr);
 }
 
-static u16 NDS_ARM7IORead16(u32 addr)
+static u16 NDS_ARM7IORead16(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM7IORead16(addr);
+    return nds->ARM7IORead16(addr);
 }
 
-static u32 NDS_ARM7IORead32(u32 addr)
+static u32 NDS_ARM7IORead32(u32 addr, melonDS::NDS* nds)
 {
-    return NDS::Current->ARM7IORead32(addr);
+    return nds->ARM7IORead32(addr);
 }
 
-static void NDS_ARM7IOWrite8(u32 addr, u8 val)
+static void NDS_ARM7IOWrite8(u32 addr, melonDS::NDS* nds, u8 val)
 {
-    NDS::Current->ARM7IOWrite8(addr, val);
+    nds->ARM7IOWrite8(addr, val);
 }
 
-static void NDS_ARM7IOWrite16(u32 addr, u16 val)
+static void NDS_ARM7IOWrite16(u32 addr, melonDS::NDS* nds, u16 val)
 {
-    NDS::Current->ARM7IOWrite16(addr, val);
+    nds->ARM7IOWrite16(addr, val);
 }
 
-static void NDS_ARM7IOWrite32(u32 addr, u32 val)
+static void NDS_ARM7IOWrite32(u32 addr, melonDS::NDS* nds, u32 val)
 {
-    NDS::Current->ARM7IOWrite32(addr, val);
+    nds->ARM7IOWrite32(addr, val);
 }
 
 void* ARMJIT_Memory::GetFuncForAddr(ARM* cpu, u32 addr, bool store, int size) const noexcept
@@ -1360,7 +1519,7 @@ void* ARMJIT_Memory::GetFuncForAddr(ARM* cpu, u32 addr, bool store, int size) co
             case 32: return (void*)NDS_ARM9IORead32;
             case 33: return (void*)NDS_ARM9IOWrite32;
             }
-            // NDS::Current will delegate to the DSi versions of these methods
+            // these will delegate to the DSi versions of the methods
             // if it's really a DSi
             break;
         case 0x06000000:
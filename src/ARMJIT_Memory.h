@@ -137,6 +137,14 @@ public:
     bool IsFastmemCompatible(int region) const noexcept;
     void* GetFuncForAddr(ARM* cpu, u32 addr, bool store, int size) const noexcept;
     bool MapAtAddress(u32 addr) noexcept;
+
+#ifndef __SWITCH__
+    // Allocates executable memory for the JIT's generated code.
+    // It's placed close to nearAddr if possible, so the generated code
+    // can reach functions in melonDS with relative calls.
+    static u8* AllocateCodeMemory(u32 size, const void* nearAddr) noexcept;
+    static void FreeCodeMemory(u8* mem, u32 size) noexcept;
+#endif
 private:
     friend class Compiler;
     struct Mapping
@@ -154,6 +162,9 @@ private:
         u8* FaultPC;
     };
     static bool FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds);
+    static ARMJIT_Memory* FindFaultingInstance(u8* faultAddr, FaultDescription& faultDesc) noexcept;
+    void RegisterFaultHandler() noexcept;
+    void UnregisterFaultHandler() noexcept;
     bool MapIntoRange(u32 addr, u32 num, u32 offset, u32 size) noexcept;
     bool UnmapFromRange(u32 addr, u32 num, u32 offset, u32 size) noexcept;
     void SetCodeProtectionRange(u32 addr, u32 size, u32 num, int protection) noexcept;
@@ -168,7 +179,6 @@ private:
 #elif defined(_WIN32)
     static LONG ExceptionHandler(EXCEPTION_POINTERS* exceptionInfo);
     HANDLE MemoryFile = INVALID_HANDLE_VALUE;
-    LPVOID ExceptionHandlerHandle = nullptr;
 #else
     static void SigsegvHandler(int sig, siginfo_t* info, void* rawContext);
     int MemoryFile = -1;
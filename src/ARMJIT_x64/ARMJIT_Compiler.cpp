@@ -229,39 +229,15 @@ void Compiler::A_Comp_MSR()
     }
 }
 
-/*
-    We'll repurpose this .bss memory
-
- */
-u8 CodeMemory[1024 * 1024 * 32];
+const u32 CodeMemoryTotalSize = 1024 * 1024 * 32;
 
 Compiler::Compiler(melonDS::NDS& nds) : XEmitter(), NDS(nds)
 {
-    {
-    #ifdef _WIN32
-        SYSTEM_INFO sysInfo;
-        GetSystemInfo(&sysInfo);
-
-        u64 pageSize = (u64)sysInfo.dwPageSize;
-    #else
-        u64 pageSize = sysconf(_SC_PAGE_SIZE);
-    #endif
-
-        u8* pageAligned = (u8*)(((u64)CodeMemory & ~(pageSize - 1)) + pageSize);
-        u64 alignedSize = (((u64)CodeMemory + sizeof(CodeMemory)) & ~(pageSize - 1)) - (u64)pageAligned;
-
-    #ifdef _WIN32
-        DWORD dummy;
-        VirtualProtect(pageAligned, alignedSize, PAGE_EXECUTE_READWRITE, &dummy);
-    #elif defined(__APPLE__)
-        pageAligned = (u8*)mmap(NULL, 1024*1024*32, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS ,-1, 0);
-    #else
-        mprotect(pageAligned, alignedSize, PROT_EXEC | PROT_READ | PROT_WRITE);
-    #endif
-
-        ResetStart = pageAligned;
-        CodeMemSize = alignedSize;
-    }
+    CodeMemory = ARMJIT_Memory::AllocateCodeMemory(CodeMemoryTotalSize, (const void*)&ARM_Dispatch);
+    assert(CodeMemory);
+
+    ResetStart = CodeMemory;
+    CodeMemSize = CodeMemoryTotalSize;
 
     Reset();
 
@@ -374,16 +350,9 @@ Compiler::Compiler(melonDS::NDS& nds) : XEmitter(), NDS(nds)
                     PatchedStoreFuncs[consoleType][num][size][reg] = GetWritableCodePtr();
                     if (RSCRATCH3 != ABI_PARAM1)
                         MOV(32, R(ABI_PARAM1), R(RSCRATCH3));
-                    if (num == 0)
-                    {
-                        MOV(64, R(ABI_PARAM2), R(RCPU));
-                        if (rdMapped != ABI_PARAM3)
-                            MOV(32, R(ABI_PARAM3), R(rdMapped));
-                    }
-                    else
-                    {
-                        MOV(32, R(ABI_PARAM2), R(rdMapped));
-                    }
+                    MOV(64, R(ABI_PARAM2), R(RCPU));
+                    if (rdMapped != ABI_PARAM3)
+                        MOV(32, R(ABI_PARAM3), R(rdMapped));
                     ABI_PushRegistersAndAdjustStack(CallerSavedPushRegs, 8);
                     if (consoleType == 0)
                     {
@@ -421,8 +390,7 @@ Compiler::Compiler(melonDS::NDS& nds) : XEmitter(), NDS(nds)
                         PatchedLoadFuncs[consoleType][num][size][signextend][reg] = GetWritableCodePtr();
                         if (RSCRATCH3 != ABI_PARAM1)
                             MOV(32, R(ABI_PARAM1), R(RSCRATCH3));
-                        if (num == 0)
-                            MOV(64, R(ABI_PARAM2), R(RCPU));
+                        MOV(64, R(ABI_PARAM2), R(RCPU));
                         ABI_PushRegistersAndAdjustStack(CallerSavedPushRegs, 8);
                         if (consoleType == 0)
                         {
@@ -475,6 +443,11 @@ Compiler::Compiler(melonDS::NDS& nds) : XEmitter(), NDS(nds)
     FarSize = (ResetStart + CodeMemSize) - FarStart;
 }
 
+Compiler::~Compiler()
+{
+    ARMJIT_Memory::FreeCodeMemory(CodeMemory, CodeMemoryTotalSize);
+}
+
 void Compiler::LoadCPSR()
 {
     assert(!CPSRDirty);
@@ -864,7 +837,7 @@ JitBlockEntry Compiler::CompileBlock(ARM* cpu, bool thumb, FetchedInstr instrs[]
 void Compiler::Comp_AddCycles_C(bool forceNonConstant)
 {
     s32 cycles = Num ?
-        NDS.ARM7MemTimings[CurInstr.CodeCycles][Thumb ? 1 : 3]
+        NDS.GetARM7MemTimings(CurInstr.CodeCycles)[Thumb ? 1 : 3]
         : ((R15 & 0x2) ? 0 : CurInstr.CodeCycles);
 
     if ((!Thumb && CurInstr.Cond() < 0xE) || forceNonConstant)
@@ -876,7 +849,7 @@ void Compiler::Comp_AddCycles_C(bool forceNonConstant)
 void Compiler::Comp_AddCycles_CI(u32 i)
 {
     s32 cycles = (Num ?
-        NDS.ARM7MemTimings[CurInstr.CodeCycles][Thumb ? 0 : 2]
+        NDS.GetARM7MemTimings(CurInstr.CodeCycles)[Thumb ? 0 : 2]
         : ((R15 & 0x2) ? 0 : CurInstr.CodeCycles)) + i;
 
     if (!Thumb && CurInstr.Cond() < 0xE)
@@ -888,7 +861,7 @@ void Compiler::Comp_AddCycles_CI(u32 i)
 void Compiler::Comp_AddCycles_CI(Gen::X64Reg i, int add)
 {
     s32 cycles = Num ?
-        NDS.ARM7MemTimings[CurInstr.CodeCycles][Thumb ? 0 : 2]
+        NDS.GetARM7MemTimings(CurInstr.CodeCycles)[Thumb ? 0 : 2]
         : ((R15 & 0x2) ? 0 : CurInstr.CodeCycles);
 
     if (!Thumb && CurInstr.Cond() < 0xE)
@@ -913,7 +886,7 @@ void Compiler::Comp_AddCycles_CDI()
 
         s32 cycles;
 
-        s32 numC = NDS.ARM7MemTimings[CurInstr.CodeCycles][Thumb ? 0 : 2];
+        s32 numC = NDS.GetARM7MemTimings(CurInstr.CodeCycles)[Thumb ? 0 : 2];
         s32 numD = CurInstr.DataCycles;
 
         if ((CurInstr.DataRegion >> 24) == 0x02) // mainRAM
@@ -958,7 +931,7 @@ void Compiler::Comp_AddCycles_CD()
     }
     else
     {
-        s32 numC = NDS.ARM7MemTimings[CurInstr.CodeCycles][Thumb ? 0 : 2];
+        s32 numC = NDS.GetARM7MemTimings(CurInstr.CodeCycles)[Thumb ? 0 : 2];
         s32 numD = CurInstr.DataCycles;
 
         if ((CurInstr.DataRegion >> 4) == 0x02)
@@ -84,6 +84,7 @@ class Compiler : public Gen::XEmitter
 {
 public:
     explicit Compiler(melonDS::NDS& nds);
+    ~Compiler() override;
 
     void Reset();
 
@@ -256,6 +257,7 @@ public:
 
     std::unordered_map<u8*, LoadStorePatch> LoadStorePatches {};
 
+    u8* CodeMemory {};
     u8* ResetStart {};
     u32 CodeMemSize {};
 
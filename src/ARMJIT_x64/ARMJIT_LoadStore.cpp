@@ -275,10 +275,11 @@ void Compiler::Comp_MemAccess(int rd, int rn, const Op2& op2, int size, int flag
         {
             AND(32, R(RSCRATCH3), Imm8(addressMask));
 
+            if (flags & memop_Store)
+                MOV(32, R(ABI_PARAM3), rdMapped);
+            MOV(64, R(ABI_PARAM2), ImmPtr(&NDS));
             if (ABI_PARAM1 != RSCRATCH3)
                 MOV(32, R(ABI_PARAM1), R(RSCRATCH3));
-            if (flags & memop_Store)
-                MOV(32, R(ABI_PARAM2), rdMapped);
 
             ABI_CallFunction((void (*)())func);
 
@@ -339,12 +340,14 @@ void Compiler::Comp_MemAccess(int rd, int rn, const Op2& op2, int size, int flag
             }
             else
             {
+                if (flags & memop_Store)
+                    MOV(32, R(ABI_PARAM3), rdMapped);
+
+                MOV(64, R(ABI_PARAM2), R(RCPU));
                 if (ABI_PARAM1 != RSCRATCH3)
                     MOV(32, R(ABI_PARAM1), R(RSCRATCH3));
                 if (flags & memop_Store)
                 {
-                    MOV(32, R(ABI_PARAM2), rdMapped);
-
                     switch (size | NDS.ConsoleType)
                     {
                     case 32: CALL((void*)&SlowWrite7<u32, 0>); break;
@@ -521,8 +524,7 @@ s32 Compiler::Comp_MemAccessBlock(int rn, BitSet16 regs, bool store, bool preinc
         else
             LEA(64, ABI_PARAM2, MDisp(RSP, allocOffset));
 
-        if (Num == 0)
-            MOV(64, R(ABI_PARAM4), R(RCPU));
+        MOV(64, R(ABI_PARAM4), R(RCPU));
 
         switch (Num * 2 | NDS.ConsoleType)
         {
@@ -625,8 +627,7 @@ s32 Compiler::Comp_MemAccessBlock(int rn, BitSet16 regs, bool store, bool preinc
             MOV(64, R(ABI_PARAM2), R(RSP));
 
         MOV(32, R(ABI_PARAM3), Imm32(regsCount));
-        if (Num == 0)
-            MOV(64, R(ABI_PARAM4), R(RCPU));
+        MOV(64, R(ABI_PARAM4), R(RCPU));
 
         switch (Num * 2 | NDS.ConsoleType)
         {
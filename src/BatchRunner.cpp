@@ -0,0 +1,314 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <thread>
+
+#include "BatchRunner.h"
+#include "NDS.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+BatchRunner::BatchRunner(int numthreads) noexcept
+{
+    if (numthreads <= 0)
+        numthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    TaskSema = Platform::Semaphore_Create();
+    DoneSema = Platform::Semaphore_Create();
+    DoneLock = Platform::Mutex_Create();
+
+    StartWorkers(numthreads);
+}
+
+BatchRunner::~BatchRunner() noexcept
+{
+    StopWorkers();
+
+    Platform::Semaphore_Free(TaskSema);
+    Platform::Semaphore_Free(DoneSema);
+    Platform::Mutex_Free(DoneLock);
+}
+
+void BatchRunner::StartWorkers(int num) noexcept
+{
+    StopFlag = false;
+    Platform::Semaphore_Reset(TaskSema);
+
+    Workers.resize(num);
+    for (int i = 0; i < num; i++)
+    {
+        Workers[i] = std::make_unique<Worker>();
+        Workers[i]->QueueLock = Platform::Mutex_Create();
+    }
+
+    // only start the threads once the worker list is complete,
+    // since they will look through it when stealing tasks
+    for (int i = 0; i < num; i++)
+        Workers[i]->Thread = Platform::Thread_Create([this, i]() { WorkerFunc(i); });
+}
+
+void BatchRunner::StopWorkers() noexcept
+{
+    StopFlag = true;
+    Platform::Semaphore_Post(TaskSema, (int)Workers.size());
+
+    for (auto& worker : Workers)
+    {
+        Platform::Thread_Wait(worker->Thread);
+        Platform::Thread_Free(worker->Thread);
+        Platform::Mutex_Free(worker->QueueLock);
+    }
+
+    Workers.clear();
+}
+
+int BatchRunner::AddInstance(NDS* nds) noexcept
+{
+    Instance inst {};
+    inst.NDS = nds;
+    inst.AudioBuffer = std::make_unique<s16[]>(AudioBufferSamples * 2);
+
+    // reuse the slot of a removed instance if there is one
+    for (size_t i = 0; i < Instances.size(); i++)
+    {
+        if (!Instances[i].NDS)
+        {
+            Instances[i] = std::move(inst);
+            return (int)i;
+        }
+    }
+
+    Instances.push_back(std::move(inst));
+    return (int)Instances.size() - 1;
+}
+
+void BatchRunner::RemoveInstance(int inst) noexcept
+{
+    if (inst < 0 || inst >= (int)Instances.size())
+        return;
+
+    Instances[inst] = {};
+}
+
+int BatchRunner::GetNumInstances() const noexcept
+{
+    int ret = 0;
+    for (const Instance& inst : Instances)
+    {
+        if (inst.NDS) ret++;
+    }
+    return ret;
+}
+
+void BatchRunner::PushTask(int worker, int inst) noexcept
+{
+    Worker& w = *Workers[worker];
+    Platform::Mutex_Lock(w.QueueLock);
+    w.Queue.push_back(inst);
+    Platform::Mutex_Unlock(w.QueueLock);
+
+    Platform::Semaphore_Post(TaskSema);
+}
+
+bool BatchRunner::PopTask(int worker, int& inst) noexcept
+{
+    // our own queue first, newest task first since its instance
+    // is the one most likely to still be warm in this core's cache
+    Worker& self = *Workers[worker];
+    Platform::Mutex_Lock(self.QueueLock);
+    if (!self.Queue.empty())
+    {
+        inst = self.Queue.back();
+        self.Queue.pop_back();
+        Platform::Mutex_Unlock(self.QueueLock);
+        return true;
+    }
+    Platform::Mutex_Unlock(self.QueueLock);
+
+    // then steal the oldest task from another worker
+    int num = (int)Workers.size();
+    for (int i = 1; i < num; i++)
+    {
+        Worker& victim = *Workers[(worker + i) % num];
+        Platform::Mutex_Lock(victim.QueueLock);
+        if (!victim.Queue.empty())
+        {
+            inst = victim.Queue.front();
+            victim.Queue.pop_front();
+            Platform::Mutex_Unlock(victim.QueueLock);
+            return true;
+        }
+        Platform::Mutex_Unlock(victim.QueueLock);
+    }
+
+    return false;
+}
+
+void BatchRunner::WorkerFunc(int id) noexcept
+{
+    for (;;)
+    {
+        Platform::Semaphore_Wait(TaskSema);
+        if (StopFlag) break;
+
+        // the semaphore count matches the number of queued tasks,
+        // so there is always a task for us somewhere. We may still
+        // miss it if another worker grabs it from under us while
+        // we're looking through the queues, in which case their
+        // own semaphore count is left for us.
+        int inst;
+        while (!PopTask(id, inst))
+            std::this_thread::yield();
+
+        RunTask(id, inst);
+    }
+}
+
+void BatchRunner::RunTask(int worker, int inst) noexcept
+{
+    Instance& cur = Instances[inst];
+    NDS& nds = *cur.NDS;
+
+    u64 start = Platform::GetUSCount();
+    u32 scanlines = nds.RunFrame();
+    cur.BusyTime += Platform::GetUSCount() - start;
+    cur.Frames++;
+
+    if (Callback)
+    {
+        BatchFrameOutput output;
+        output.Instance = inst;
+        output.FrameNum = cur.Frames;
+        output.Scanlines = scanlines;
+
+        int frontbuf = nds.GPU.FrontBuffer;
+        output.TopScreen = nds.GPU.Framebuffer[frontbuf][0].get();
+        output.BottomScreen = nds.GPU.Framebuffer[frontbuf][1].get();
+
+        output.Audio = cur.AudioBuffer.get();
+        output.AudioSamples = nds.SPU.ReadOutput(cur.AudioBuffer.get(), AudioBufferSamples);
+
+        Callback(nds, output);
+    }
+
+    cur.FramesLeft--;
+    if (cur.FramesLeft > 0 && !Lockstep)
+    {
+        // keep the instance on this worker, unless someone steals it
+        PushTask(worker, inst);
+        return;
+    }
+
+    Platform::Mutex_Lock(DoneLock);
+    bool done = (--TasksRemaining == 0);
+    Platform::Mutex_Unlock(DoneLock);
+
+    if (done)
+        Platform::Semaphore_Post(DoneSema);
+}
+
+void BatchRunner::RunFrames(u32 frames) noexcept
+{
+    if (frames == 0) return;
+
+    std::vector<int> active;
+    for (size_t i = 0; i < Instances.size(); i++)
+    {
+        if (Instances[i].NDS)
+            active.push_back((int)i);
+    }
+    if (active.empty()) return;
+
+    if (Lockstep && (int)Workers.size() < (int)active.size())
+    {
+        // every instance needs to be running at once for LocalMP
+        // exchanges to complete, so make sure there are enough workers
+        Log(LogLevel::Info, "BatchRunner: raising worker count from %d to %d for lockstep mode\n",
+            (int)Workers.size(), (int)active.size());
+
+        StopWorkers();
+        StartWorkers((int)active.size());
+    }
+
+    u64 start = Platform::GetUSCount();
+    int numworkers = (int)Workers.size();
+
+    for (int inst : active)
+        Instances[inst].FramesLeft = frames;
+
+    // in lockstep mode, each round runs one frame of every instance
+    // and acts as a barrier; otherwise there's a single round in which
+    // tasks requeue themselves until their instance is done
+    u32 rounds = Lockstep ? frames : 1;
+    for (u32 r = 0; r < rounds; r++)
+    {
+        Platform::Semaphore_Reset(DoneSema);
+        TasksRemaining = (int)active.size();
+
+        for (size_t i = 0; i < active.size(); i++)
+            PushTask(i % numworkers, active[i]);
+
+        Platform::Semaphore_Wait(DoneSema);
+    }
+
+    WallTime += Platform::GetUSCount() - start;
+}
+
+BatchStats BatchRunner::GetStats() const noexcept
+{
+    BatchStats ret {};
+    ret.WallTime = WallTime;
+
+    for (size_t i = 0; i < Instances.size(); i++)
+    {
+        const Instance& inst = Instances[i];
+        if (!inst.NDS) continue;
+
+        BatchInstanceStats stats {};
+        stats.Instance = (int)i;
+        stats.Frames = inst.Frames;
+        stats.BusyTime = inst.BusyTime;
+        if (inst.BusyTime)
+            stats.FPS = (inst.Frames * 1000000.0) / inst.BusyTime;
+
+        ret.Instances.push_back(stats);
+        ret.Frames += inst.Frames;
+    }
+
+    if (WallTime)
+        ret.FPS = (ret.Frames * 1000000.0) / WallTime;
+
+    return ret;
+}
+
+void BatchRunner::ResetStats() noexcept
+{
+    for (Instance& inst : Instances)
+    {
+        inst.Frames = 0;
+        inst.BusyTime = 0;
+    }
+
+    WallTime = 0;
+}
+
+}
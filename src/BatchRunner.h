@@ -0,0 +1,173 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+class NDS;
+
+/// Output of a single emulated frame, handed to the frame callback.
+/// The pointers are only valid for the duration of the callback.
+struct BatchFrameOutput
+{
+    /// Index of the instance within the runner.
+    int Instance;
+
+    /// Number of frames this instance has completed so far, including this one.
+    u64 FrameNum;
+
+    /// Number of scanlines run, as returned by NDS::RunFrame.
+    u32 Scanlines;
+
+    /// Top and bottom screens, 256x192 pixels each.
+    const u32* TopScreen;
+    const u32* BottomScreen;
+
+    /// Interleaved stereo samples produced during this frame.
+    const s16* Audio;
+    int AudioSamples;
+};
+
+/// Per-instance timing statistics.
+struct BatchInstanceStats
+{
+    /// Index of the instance within the runner.
+    int Instance;
+    u64 Frames;
+    /// Time spent inside NDS::RunFrame, in microseconds.
+    u64 BusyTime;
+    /// Frames per second, based on BusyTime.
+    double FPS;
+};
+
+struct BatchStats
+{
+    /// One entry per instance currently in the runner.
+    std::vector<BatchInstanceStats> Instances;
+    u64 Frames;
+    /// Wall clock time spent inside RunFrames, in microseconds.
+    u64 WallTime;
+    /// Total frames per second across all instances, based on WallTime.
+    double FPS;
+};
+
+/// Steps many independent NDS instances on a pool of worker threads.
+///
+/// Each instance is advanced one RunFrame at a time. A given instance only
+/// ever runs on one worker at a time, but it may migrate between workers
+/// from one frame to the next: idle workers steal queued frames from busy
+/// ones, so instances of uneven cost still keep every worker busy.
+///
+/// In lockstep mode, every instance completes frame N before any instance
+/// starts frame N+1. This is needed for instances which talk to each other
+/// through LocalMP, whose exchanges block until all participants respond.
+/// For the same reason, lockstep mode runs with at least one worker per
+/// instance.
+class BatchRunner
+{
+public:
+    using FrameCallback = std::function<void(NDS& nds, const BatchFrameOutput& output)>;
+
+    /// @param numthreads Number of worker threads to start.
+    /// If 0, one worker is started per hardware thread.
+    explicit BatchRunner(int numthreads = 0) noexcept;
+    ~BatchRunner() noexcept;
+    BatchRunner(const BatchRunner&) = delete;
+    BatchRunner& operator=(const BatchRunner&) = delete;
+
+    /// Adds an instance to the batch. The instance must be started
+    /// (NDS::Start) beforehand and must outlive the runner,
+    /// or be removed with RemoveInstance.
+    /// @return The index of the instance within the runner.
+    /// Indices stay valid when other instances are removed.
+    /// @note Instances may only be added or removed while RunFrames
+    /// isn't running, and not from within the frame callback.
+    int AddInstance(NDS* nds) noexcept;
+    void RemoveInstance(int inst) noexcept;
+    [[nodiscard]] int GetNumInstances() const noexcept;
+    [[nodiscard]] int GetNumThreads() const noexcept { return (int)Workers.size(); }
+
+    /// Sets the function called on the worker thread after each frame.
+    /// When set, the audio output of each instance is drained after every
+    /// frame and passed to the callback.
+    void SetFrameCallback(FrameCallback&& callback) noexcept { Callback = std::move(callback); }
+
+    void SetLockstep(bool lockstep) noexcept { Lockstep = lockstep; }
+    [[nodiscard]] bool IsLockstep() const noexcept { return Lockstep; }
+
+    /// Runs every instance for the given number of frames,
+    /// returning once all of them are done.
+    void RunFrames(u32 frames) noexcept;
+
+    [[nodiscard]] BatchStats GetStats() const noexcept;
+    void ResetStats() noexcept;
+
+private:
+    static constexpr int AudioBufferSamples = 4096;
+
+    struct Instance
+    {
+        melonDS::NDS* NDS;
+        u32 FramesLeft;
+        u64 Frames;
+        u64 BusyTime;
+        std::unique_ptr<s16[]> AudioBuffer;
+    };
+
+    struct Worker
+    {
+        Platform::Thread* Thread;
+        Platform::Mutex* QueueLock;
+        std::deque<int> Queue;
+    };
+
+    void StartWorkers(int num) noexcept;
+    void StopWorkers() noexcept;
+    void WorkerFunc(int id) noexcept;
+    void PushTask(int worker, int inst) noexcept;
+    bool PopTask(int worker, int& inst) noexcept;
+    void RunTask(int worker, int inst) noexcept;
+
+    std::vector<Instance> Instances;
+    std::vector<std::unique_ptr<Worker>> Workers;
+
+    // counts the tasks sitting in the worker queues
+    Platform::Semaphore* TaskSema;
+    Platform::Semaphore* DoneSema;
+    Platform::Mutex* DoneLock;
+    int TasksRemaining = 0;
+    bool Lockstep = false;
+    bool StopFlag = false;
+
+    FrameCallback Callback;
+
+    u64 WallTime = 0;
+};
+
+}
+#endif // BATCHRUNNER_H
@@ -299,7 +299,7 @@ void ARMv5::UpdateRegionTimings(u32 addrstart, u32 addrend)
     for (u32 i = addrstart; i < addrend; i++)
     {
         u8 pu = PU_Map[i];
-        u8* bustimings = NDS.ARM9MemTimings[i >> 2];
+        const u8* bustimings = NDS.GetARM9MemTimings(i >> 2);
 
         if (pu & 0x40)
         {
@@ -398,8 +398,8 @@ void ARMv5::ICacheLookup(u32 addr)
     ICacheTags[line] = tag;
 
     // ouch :/
-    //printf("cache miss %08X: %d/%d\n", addr, NDS::ARM9MemTimings[addr >> 14][2], NDS::ARM9MemTimings[addr >> 14][3]);
-    CodeCycles = (NDS.ARM9MemTimings[addr >> 14][2] + (NDS.ARM9MemTimings[addr >> 14][3] * 7)) << NDS.ARM9ClockShift;
+    //printf("cache miss %08X: %d/%d\n", addr, NDS::GetARM9MemTimings(addr >> 14)[2], NDS::GetARM9MemTimings(addr >> 14)[3]);
+    CodeCycles = (NDS.GetARM9MemTimings(addr >> 14)[2] + (NDS.GetARM9MemTimings(addr >> 14)[3] * 7)) << NDS.ARM9ClockShift;
     CurICacheLine = ptr;
 }
 
@@ -16,8 +16,22 @@
     with melonDS. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <string.h>
 #include "CRC32.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC32_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32_ARM64
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
 // http://www.codeproject.com/KB/recipes/crc32_large.aspx
 
 namespace melonDS
@@ -36,33 +50,249 @@ constexpr u32 _reflect(u32 refl, char ch)
 	return value;
 }
 
-constexpr auto GetCRC32Table()
+// table N gives the CRC of a byte followed by N zero bytes,
+// so that 16 bytes can be looked up at once (slicing-by-16)
+constexpr auto GetCRC32Tables()
 {
-    std::array<u32, 256> Crc32Table { 0 };
+    std::array<std::array<u32, 256>, 16> Crc32Table {};
 	u32 polynomial = 0x04C11DB7;
 
 	for (int i = 0; i < 0x100; i++)
     {
-        Crc32Table[i] = _reflect(i, 8) << 24;
+        u32 val = _reflect(i, 8) << 24;
 
         for (int j = 0; j < 8; j++)
-            Crc32Table[i] = (Crc32Table[i] << 1) ^ (Crc32Table[i] & (1 << 31) ? polynomial : 0);
+            val = (val << 1) ^ (val & (1 << 31) ? polynomial : 0);
 
-        Crc32Table[i] = _reflect(Crc32Table[i],  32);
+        Crc32Table[0][i] = _reflect(val,  32);
     }
+
+    for (int t = 1; t < 16; t++)
+    {
+        for (int i = 0; i < 0x100; i++)
+        {
+            u32 prev = Crc32Table[t-1][i];
+            Crc32Table[t][i] = (prev >> 8) ^ Crc32Table[0][prev & 0xFF];
+        }
+    }
+
     return Crc32Table;
 }
 
-u32 CRC32(const u8 *data, int len, u32 start)
+static constexpr auto Crc32Table = GetCRC32Tables();
+
+static u32 Update_Generic(u32 crc, const u8* data, size_t len)
+{
+    while (len >= 16)
+    {
+        u32 a, b, c, d;
+        memcpy(&a, &data[0], 4);
+        memcpy(&b, &data[4], 4);
+        memcpy(&c, &data[8], 4);
+        memcpy(&d, &data[12], 4);
+        a ^= crc;
+
+        crc = Crc32Table[15][a & 0xFF] ^ Crc32Table[14][(a >> 8) & 0xFF] ^
+              Crc32Table[13][(a >> 16) & 0xFF] ^ Crc32Table[12][a >> 24] ^
+              Crc32Table[11][b & 0xFF] ^ Crc32Table[10][(b >> 8) & 0xFF] ^
+              Crc32Table[9][(b >> 16) & 0xFF] ^ Crc32Table[8][b >> 24] ^
+              Crc32Table[7][c & 0xFF] ^ Crc32Table[6][(c >> 8) & 0xFF] ^
+              Crc32Table[5][(c >> 16) & 0xFF] ^ Crc32Table[4][c >> 24] ^
+              Crc32Table[3][d & 0xFF] ^ Crc32Table[2][(d >> 8) & 0xFF] ^
+              Crc32Table[1][(d >> 16) & 0xFF] ^ Crc32Table[0][d >> 24];
+
+        data += 16;
+        len -= 16;
+    }
+
+    while (len--)
+        crc = (crc >> 8) ^ Crc32Table[0][(crc & 0xFF) ^ *data++];
+
+    return crc;
+}
+
+#ifdef CRC32_X86
+
+#define CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+
+static bool DetectAcceleration()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    return (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+}
+
+// folds the data 64 bytes at a time with carry-less multiplies,
+// then reduces the result to 32 bits. See Intel's "Fast CRC Computation
+// for Generic Polynomials Using PCLMULQDQ Instruction".
+// len must be a multiple of 16, and at least 64.
+CLMUL_TARGET static u32 Fold_CLMUL(u32 crc, const u8* data, size_t len)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163CD6124);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i*)&data[0]);
+    x2 = _mm_loadu_si128((const __m128i*)&data[16]);
+    x3 = _mm_loadu_si128((const __m128i*)&data[32]);
+    x4 = _mm_loadu_si128((const __m128i*)&data[48]);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+    data += 64;
+    len -= 64;
+
+    x0 = k1k2;
+    while (len >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)&data[0]));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)&data[16]));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)&data[32]));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)&data[48]));
+
+        data += 64;
+        len -= 64;
+    }
+
+    // fold the four lanes into one
+    x0 = k3k4;
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (len >= 16)
+    {
+        x2 = _mm_loadu_si128((const __m128i*)data);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        len -= 16;
+    }
+
+    // 128 bits down to 64
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = k5k0;
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction down to 32 bits
+    x0 = poly;
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return _mm_extract_epi32(x1, 1);
+}
+
+static u32 Update_Accel(u32 crc, const u8* data, size_t len)
+{
+    if (len >= 64)
+    {
+        size_t foldlen = len & ~(size_t)0xF;
+        crc = Fold_CLMUL(crc, data, foldlen);
+        data += foldlen;
+        len -= foldlen;
+    }
+
+    return Update_Generic(crc, data, len);
+}
+
+#elif defined(CRC32_ARM64)
+
+static bool DetectAcceleration()
 {
-    auto Crc32Table = GetCRC32Table();
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    // the compiler was told the target supports it
+    return true;
+#endif
+}
 
-	u32 crc = start ^ 0xFFFFFFFF;
+static u32 Update_Accel(u32 crc, const u8* data, size_t len)
+{
+    while (len >= 8)
+    {
+        u64 val;
+        memcpy(&val, data, 8);
+        crc = __crc32d(crc, val);
+        data += 8;
+        len -= 8;
+    }
 
-	while (len--)
-        crc = (crc >> 8) ^ Crc32Table[(crc & 0xFF) ^ *data++];
+    while (len--)
+        crc = __crc32b(crc, *data++);
 
-	return (crc ^ 0xFFFFFFFF);
+    return crc;
 }
 
-}
\ No newline at end of file
+#else
+
+static bool DetectAcceleration()
+{
+    return false;
+}
+
+static u32 Update_Accel(u32 crc, const u8* data, size_t len)
+{
+    return Update_Generic(crc, data, len);
+}
+
+#endif
+
+static u32 Update(u32 crc, const u8* data, size_t len)
+{
+    static const bool accelerated = DetectAcceleration();
+
+    if (accelerated)
+        return Update_Accel(crc, data, len);
+    else
+        return Update_Generic(crc, data, len);
+}
+
+u32 CRC32(const u8 *data, int len, u32 start)
+{
+    if (len <= 0) return start;
+
+    return Update(start ^ 0xFFFFFFFF, data, len) ^ 0xFFFFFFFF;
+}
+
+void CRC32Stream::Update(const u8* data, size_t len)
+{
+    State = melonDS::Update(State, data, len);
+}
+
+}
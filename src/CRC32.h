@@ -20,12 +20,26 @@
 #define CRC32_H
 
 #include <array>
+#include <stddef.h>
 
 #include "types.h"
 
 namespace melonDS
 {
 u32 CRC32(const u8* data, int len, u32 start=0);
+
+/// Computes a CRC32 over data fed to it piece by piece.
+/// Gives the same result as CRC32() over all of the data at once.
+class CRC32Stream
+{
+public:
+    void Update(const u8* data, size_t len);
+    void Reset() { State = 0xFFFFFFFF; }
+    [[nodiscard]] u32 GetValue() const { return State ^ 0xFFFFFFFF; }
+
+private:
+    u32 State = 0xFFFFFFFF;
+};
 }
 
 #endif // CRC32_H
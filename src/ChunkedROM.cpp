@@ -0,0 +1,190 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include <string.h>
+
+#include "ChunkedROM.h"
+#include "Utils.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+ChunkedROM::ChunkedROM(u32 length, u32 chunksize, ChunkReader&& reader, u32 cachesize) noexcept :
+    Length(length),
+    ChunkSize(chunksize),
+    Reader(std::move(reader))
+{
+    Lock = Platform::Mutex_Create();
+
+    if (length == 0 || chunksize == 0 || (chunksize & (ChunkAlign - 1)))
+    {
+        Log(LogLevel::Error, "ChunkedROM: invalid chunk size %08X for length %08X\n", chunksize, length);
+        PaddedLength = AllocLength = NumChunks = MaxCachedChunks = 0;
+        return;
+    }
+
+    PaddedLength = 1;
+    while (PaddedLength < length)
+        PaddedLength <<= 1;
+    AllocLength = std::max(PaddedLength, ChunkAlign);
+
+    NumChunks = (u32)(((u64)length + chunksize - 1) / chunksize);
+    MaxCachedChunks = std::max(cachesize / chunksize, 2u);
+
+    Data = AllocateLazyMemory(AllocLength);
+    if (!Data)
+    {
+        Log(LogLevel::Error, "ChunkedROM: failed to allocate %08X bytes\n", AllocLength);
+        return;
+    }
+
+    ChunkState.resize(NumChunks, Chunk_Absent);
+    LRUPos.resize(NumChunks);
+}
+
+ChunkedROM::~ChunkedROM() noexcept
+{
+    if (Data)
+        FreeLazyMemory(Data, AllocLength);
+
+    Platform::Mutex_Free(Lock);
+}
+
+u32 ChunkedROM::GetChunkLength(u32 chunk) const noexcept
+{
+    u32 start = chunk * ChunkSize;
+    return std::min(ChunkSize, Length - start);
+}
+
+bool ChunkedROM::LoadChunk(u32 chunk) noexcept
+{
+    if (ChunkState[chunk] != Chunk_Absent)
+    {
+        NumHits++;
+        if (ChunkState[chunk] == Chunk_Cached)
+            LRU.splice(LRU.begin(), LRU, LRUPos[chunk]);
+
+        return true;
+    }
+
+    NumMisses++;
+    if (LRU.size() >= MaxCachedChunks)
+        EvictChunk(LRU.back());
+
+    if (!Reader(chunk, &Data[chunk * ChunkSize], GetChunkLength(chunk)))
+    {
+        Log(LogLevel::Error, "ChunkedROM: failed to decompress chunk %d\n", chunk);
+
+        // don't leave half a chunk behind; the next read will try again
+        EvictChunk(chunk);
+        return false;
+    }
+
+    ChunkState[chunk] = Chunk_Cached;
+    LRU.push_front(chunk);
+    LRUPos[chunk] = LRU.begin();
+    return true;
+}
+
+void ChunkedROM::EvictChunk(u32 chunk) noexcept
+{
+    if (ChunkState[chunk] == Chunk_Cached)
+        LRU.erase(LRUPos[chunk]);
+
+    // the last chunk may end partway through a page,
+    // the rest of which is padding that's zero anyway
+    u32 start = chunk * ChunkSize;
+    u32 len = (GetChunkLength(chunk) + ChunkAlign - 1) & ~(ChunkAlign - 1);
+    ResetLazyMemory(&Data[start], len);
+
+    ChunkState[chunk] = Chunk_Absent;
+}
+
+void ChunkedROM::Read(u32 addr, u32 len, u8* out) noexcept
+{
+    if (!Data)
+    {
+        memset(out, 0, len);
+        return;
+    }
+
+    if (addr >= AllocLength)
+    {
+        memset(out, 0, len);
+        return;
+    }
+    if (len > AllocLength - addr)
+    {
+        u32 over = len - (AllocLength - addr);
+        memset(&out[len - over], 0, over);
+        len -= over;
+    }
+
+    Platform::Mutex_Lock(Lock);
+
+    // copy one chunk at a time, so that a read spanning more chunks
+    // than the cache holds can't evict a chunk before it's been copied
+    while (len > 0)
+    {
+        u32 chunk = addr / ChunkSize;
+        u32 chunkend = (chunk + 1) * ChunkSize;
+        u32 curlen = std::min(len, chunkend - addr);
+
+        if (chunk < NumChunks)
+            LoadChunk(chunk);
+
+        memcpy(out, &Data[addr], curlen);
+
+        addr += curlen;
+        out += curlen;
+        len -= curlen;
+    }
+
+    Platform::Mutex_Unlock(Lock);
+}
+
+void ChunkedROM::Pin(u32 addr, u32 len) noexcept
+{
+    if (!Data || len == 0 || addr >= Length)
+        return;
+
+    len = std::min(len, Length - addr);
+    u32 first = addr / ChunkSize;
+    u32 last = (addr + len - 1) / ChunkSize;
+
+    Platform::Mutex_Lock(Lock);
+
+    for (u32 chunk = first; chunk <= last; chunk++)
+    {
+        if (ChunkState[chunk] == Chunk_Pinned)
+            continue;
+
+        if (!LoadChunk(chunk))
+            continue;
+
+        LRU.erase(LRUPos[chunk]);
+        ChunkState[chunk] = Chunk_Pinned;
+    }
+
+    Platform::Mutex_Unlock(Lock);
+}
+
+}
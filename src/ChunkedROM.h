@@ -0,0 +1,118 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef CHUNKEDROM_H
+#define CHUNKEDROM_H
+
+#include <functional>
+#include <list>
+#include <vector>
+
+#include "types.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+/// ROM data stored as independently compressed chunks,
+/// which are only decompressed once something reads them.
+///
+/// The decompressed data lives at its final address in a buffer
+/// padded to a power of 2, whose pages only take up memory once written.
+/// Recently used chunks are kept around up to a given budget,
+/// after which the least recently used one is dropped again.
+///
+/// Pinned chunks are never dropped, so they can be accessed directly
+/// through GetData(); anything else must go through Read().
+class ChunkedROM
+{
+public:
+    /// Decompresses the given chunk into \c out, which is \c len bytes long.
+    /// Called with the cache locked, so it only runs on one thread at a time.
+    /// @return \c false if the chunk couldn't be decompressed.
+    using ChunkReader = std::function<bool(u32 chunk, u8* out, u32 len)>;
+
+    /// Chunk sizes must be a multiple of this,
+    /// so that chunks can be dropped a page at a time.
+    static constexpr u32 ChunkAlign = 0x4000;
+    static constexpr u32 DefaultCacheSize = 16 * 1024 * 1024;
+
+    /// @param length Length of the decompressed ROM.
+    /// @param chunksize Decompressed size of every chunk but the last.
+    /// Must be a nonzero multiple of ChunkAlign.
+    /// @param reader Function that decompresses a chunk.
+    /// @param cachesize How much decompressed data to keep around,
+    /// not counting pinned chunks. At least two chunks are always kept.
+    ChunkedROM(u32 length, u32 chunksize, ChunkReader&& reader, u32 cachesize = DefaultCacheSize) noexcept;
+    ~ChunkedROM() noexcept;
+    ChunkedROM(const ChunkedROM&) = delete;
+    ChunkedROM& operator=(const ChunkedROM&) = delete;
+
+    [[nodiscard]] bool IsValid() const noexcept { return Data != nullptr; }
+
+    /// @return The length of the ROM, padded to a power of 2.
+    [[nodiscard]] u32 GetLength() const noexcept { return PaddedLength; }
+    /// @return The length of the ROM before padding.
+    [[nodiscard]] u32 GetDataLength() const noexcept { return Length; }
+    [[nodiscard]] u32 GetChunkSize() const noexcept { return ChunkSize; }
+
+    /// @return The decompressed data. Only pinned ranges are safe to access.
+    [[nodiscard]] u8* GetData() const noexcept { return Data; }
+
+    /// Copies a range of the ROM to \c out, decompressing it if needed.
+    /// Addresses past the end of the ROM read as zero.
+    void Read(u32 addr, u32 len, u8* out) noexcept;
+
+    /// Decompresses a range of the ROM and keeps it in memory for good.
+    void Pin(u32 addr, u32 len) noexcept;
+
+    [[nodiscard]] u64 GetNumHits() const noexcept { return NumHits; }
+    [[nodiscard]] u64 GetNumMisses() const noexcept { return NumMisses; }
+
+private:
+    enum : u8
+    {
+        Chunk_Absent = 0,
+        Chunk_Cached,
+        Chunk_Pinned,
+    };
+
+    bool LoadChunk(u32 chunk) noexcept;
+    void EvictChunk(u32 chunk) noexcept;
+    u32 GetChunkLength(u32 chunk) const noexcept;
+
+    u8* Data = nullptr;
+    u32 Length;
+    u32 PaddedLength;
+    u32 AllocLength;
+    u32 ChunkSize;
+    u32 NumChunks;
+    u32 MaxCachedChunks;
+    ChunkReader Reader;
+
+    Platform::Mutex* Lock;
+    std::vector<u8> ChunkState;
+    // cached (but not pinned) chunks, most recently used first
+    std::list<u32> LRU;
+    std::vector<std::list<u32>::iterator> LRUPos;
+
+    u64 NumHits = 0;
+    u64 NumMisses = 0;
+};
+
+}
+#endif // CHUNKEDROM_H
@@ -17,6 +17,7 @@
 */
 
 #include <stdio.h>
+#include <algorithm>
 #include "NDS.h"
 #include "DSi.h"
 #include "DMA.h"
@@ -201,14 +202,14 @@ u32 DMA::UnitTimings9_16(bool burststart)
     u32 src_id = CurSrcAddr >> 14;
     u32 dst_id = CurDstAddr >> 14;
 
-    u32 src_rgn = NDS.ARM9Regions[src_id];
-    u32 dst_rgn = NDS.ARM9Regions[dst_id];
+    u32 src_rgn = NDS.GetARM9Region(src_id);
+    u32 dst_rgn = NDS.GetARM9Region(dst_id);
 
     u32 src_n, src_s, dst_n, dst_s;
-    src_n = NDS.ARM9MemTimings[src_id][4];
-    src_s = NDS.ARM9MemTimings[src_id][5];
-    dst_n = NDS.ARM9MemTimings[dst_id][4];
-    dst_s = NDS.ARM9MemTimings[dst_id][5];
+    src_n = NDS.GetARM9MemTimings(src_id)[4];
+    src_s = NDS.GetARM9MemTimings(src_id)[5];
+    dst_n = NDS.GetARM9MemTimings(dst_id)[4];
+    dst_s = NDS.GetARM9MemTimings(dst_id)[5];
 
     if (src_rgn == Mem9_MainRAM)
     {
@@ -287,14 +288,14 @@ u32 DMA::UnitTimings9_32(bool burststart)
     u32 src_id = CurSrcAddr >> 14;
     u32 dst_id = CurDstAddr >> 14;
 
-    u32 src_rgn = NDS.ARM9Regions[src_id];
-    u32 dst_rgn = NDS.ARM9Regions[dst_id];
+    u32 src_rgn = NDS.GetARM9Region(src_id);
+    u32 dst_rgn = NDS.GetARM9Region(dst_id);
 
     u32 src_n, src_s, dst_n, dst_s;
-    src_n = NDS.ARM9MemTimings[src_id][6];
-    src_s = NDS.ARM9MemTimings[src_id][7];
-    dst_n = NDS.ARM9MemTimings[dst_id][6];
-    dst_s = NDS.ARM9MemTimings[dst_id][7];
+    src_n = NDS.GetARM9MemTimings(src_id)[6];
+    src_s = NDS.GetARM9MemTimings(src_id)[7];
+    dst_n = NDS.GetARM9MemTimings(dst_id)[6];
+    dst_s = NDS.GetARM9MemTimings(dst_id)[7];
 
     if (src_rgn == Mem9_MainRAM)
     {
@@ -379,14 +380,14 @@ u32 DMA::UnitTimings7_16(bool burststart)
     u32 src_id = CurSrcAddr >> 15;
     u32 dst_id = CurDstAddr >> 15;
 
-    u32 src_rgn = NDS.ARM7Regions[src_id];
-    u32 dst_rgn = NDS.ARM7Regions[dst_id];
+    u32 src_rgn = NDS.GetARM7Region(src_id);
+    u32 dst_rgn = NDS.GetARM7Region(dst_id);
 
     u32 src_n, src_s, dst_n, dst_s;
-    src_n = NDS.ARM7MemTimings[src_id][0];
-    src_s = NDS.ARM7MemTimings[src_id][1];
-    dst_n = NDS.ARM7MemTimings[dst_id][0];
-    dst_s = NDS.ARM7MemTimings[dst_id][1];
+    src_n = NDS.GetARM7MemTimings(src_id)[0];
+    src_s = NDS.GetARM7MemTimings(src_id)[1];
+    dst_n = NDS.GetARM7MemTimings(dst_id)[0];
+    dst_s = NDS.GetARM7MemTimings(dst_id)[1];
 
     if (src_rgn == Mem7_MainRAM)
     {
@@ -465,14 +466,14 @@ u32 DMA::UnitTimings7_32(bool burststart)
     u32 src_id = CurSrcAddr >> 15;
     u32 dst_id = CurDstAddr >> 15;
 
-    u32 src_rgn = NDS.ARM7Regions[src_id];
-    u32 dst_rgn = NDS.ARM7Regions[dst_id];
+    u32 src_rgn = NDS.GetARM7Region(src_id);
+    u32 dst_rgn = NDS.GetARM7Region(dst_id);
 
     u32 src_n, src_s, dst_n, dst_s;
-    src_n = NDS.ARM7MemTimings[src_id][2];
-    src_s = NDS.ARM7MemTimings[src_id][3];
-    dst_n = NDS.ARM7MemTimings[dst_id][2];
-    dst_s = NDS.ARM7MemTimings[dst_id][3];
+    src_n = NDS.GetARM7MemTimings(src_id)[2];
+    src_s = NDS.GetARM7MemTimings(src_id)[3];
+    dst_n = NDS.GetARM7MemTimings(dst_id)[2];
+    dst_s = NDS.GetARM7MemTimings(dst_id)[3];
 
     if (src_rgn == Mem7_MainRAM)
     {
@@ -550,6 +551,140 @@ u32 DMA::UnitTimings7_32(bool burststart)
     }
 }
 
+// Fast path for transfers between memory where accesses have no side
+// effects besides the data itself and its dirty tracking: main RAM, and
+// on the ARM9 also palette, VRAM and OAM. Those accesses can't stall the
+// DMA either, so the timing of the whole run is worked out first, then
+// the units are copied without going through the generic memory handlers.
+
+bool DMA::IsDirectRange(u32 start, u32 end) const noexcept
+{
+    // start and end are the first and last unit, in either order
+    if ((start >> 24) != (end >> 24)) return false;
+
+    switch (start >> 24)
+    {
+    case 0x02:
+        // the DSi has a read hack in there
+        if (NDS.ConsoleType == 1)
+        {
+            u32 lo = std::min(start, end), hi = std::max(start, end);
+            if (lo <= 0x02FE71B3 && hi >= 0x02FE71B0) return false;
+        }
+        return true;
+
+    case 0x05:
+    case 0x07:
+        // both engines need to be powered on, otherwise accesses are dropped
+        return CPU == 0 && (NDS.PowerControl9 & 0x202) == 0x202;
+
+    case 0x06:
+        return CPU == 0 && (start & 0x00E00000) == (end & 0x00E00000);
+    }
+
+    return false;
+}
+
+bool DMA::CanRunDirect(u32 unitshift) const noexcept
+{
+    s32 span = (s32)(IterCount - 1) << unitshift;
+
+    return IsDirectRange(CurSrcAddr, CurSrcAddr + (SrcAddrInc * span)) &&
+           IsDirectRange(CurDstAddr, CurDstAddr + (DstAddrInc * span));
+}
+
+template <typename T>
+T DMA::ReadDirect(u32 addr) const noexcept
+{
+    addr &= ~(sizeof(T)-1);
+
+    switch (addr >> 24)
+    {
+    case 0x02: return *(T*)&NDS.MainRAM[addr & NDS.MainRAMMask];
+    case 0x05: return NDS.GPU.ReadPalette<T>(addr);
+    case 0x06:
+        switch (addr & 0x00E00000)
+        {
+        case 0x00000000: return NDS.GPU.ReadVRAM_ABG<T>(addr);
+        case 0x00200000: return NDS.GPU.ReadVRAM_BBG<T>(addr);
+        case 0x00400000: return NDS.GPU.ReadVRAM_AOBJ<T>(addr);
+        case 0x00600000: return NDS.GPU.ReadVRAM_BOBJ<T>(addr);
+        default:         return NDS.GPU.ReadVRAM_LCDC<T>(addr);
+        }
+    default:   return NDS.GPU.ReadOAM<T>(addr & 0x7FF);
+    }
+}
+
+template <u32 cpu, typename T>
+void DMA::WriteDirect(u32 addr, T val)
+{
+    addr &= ~(sizeof(T)-1);
+
+    switch (addr >> 24)
+    {
+    case 0x02:
+        NDS.JIT.CheckAndInvalidate<cpu, ARMJIT_Memory::memregion_MainRAM>(addr);
+        *(T*)&NDS.MainRAM[addr & NDS.MainRAMMask] = val;
+        return;
+
+    case 0x05:
+        NDS.GPU.WritePalette<T>(addr, val);
+        return;
+
+    case 0x06:
+        NDS.JIT.CheckAndInvalidate<cpu, ARMJIT_Memory::memregion_VRAM>(addr);
+        switch (addr & 0x00E00000)
+        {
+        case 0x00000000: NDS.GPU.WriteVRAM_ABG<T>(addr, val); return;
+        case 0x00200000: NDS.GPU.WriteVRAM_BBG<T>(addr, val); return;
+        case 0x00400000: NDS.GPU.WriteVRAM_AOBJ<T>(addr, val); return;
+        case 0x00600000: NDS.GPU.WriteVRAM_BOBJ<T>(addr, val); return;
+        default:         NDS.GPU.WriteVRAM_LCDC<T>(addr, val); return;
+        }
+
+    default:
+        NDS.GPU.WriteOAM<T>(addr, val);
+        return;
+    }
+}
+
+template <u32 cpu, typename T>
+void DMA::RunDirect(bool burststart)
+{
+    constexpr u32 unitshift = (sizeof(T) == 4) ? 2 : 1;
+    u32 srcaddr = CurSrcAddr;
+    u32 dstaddr = CurDstAddr;
+    u32 num = 0;
+
+    while (IterCount > 0 && !Stall)
+    {
+        if (cpu == 0)
+        {
+            u32 unit = (sizeof(T) == 4) ? UnitTimings9_32(burststart) : UnitTimings9_16(burststart);
+            NDS.ARM9Timestamp += (unit << NDS.ARM9ClockShift);
+        }
+        else
+            NDS.ARM7Timestamp += (sizeof(T) == 4) ? UnitTimings7_32(burststart) : UnitTimings7_16(burststart);
+        burststart = false;
+
+        CurSrcAddr += SrcAddrInc<<unitshift;
+        CurDstAddr += DstAddrInc<<unitshift;
+        IterCount--;
+        RemCount--;
+        num++;
+
+        if (cpu == 0 ? (NDS.ARM9Timestamp >= NDS.ARM9Target) : (NDS.ARM7Timestamp >= NDS.ARM7Target)) break;
+    }
+
+    for (u32 i = 0; i < num; i++)
+    {
+        WriteDirect<cpu, T>(dstaddr, ReadDirect<T>(srcaddr));
+
+        srcaddr += SrcAddrInc<<unitshift;
+        dstaddr += DstAddrInc<<unitshift;
+    }
+}
+
 void DMA::Run9()
 {
     if (NDS.ARM9Timestamp >= NDS.ARM9Target) return;
@@ -560,7 +695,15 @@ void DMA::Run9()
     bool burststart = (Running == 2);
     Running = 1;
 
-    if (!(Cnt & (1<<26)))
+    if (!(Cnt & (1<<26)) && CanRunDirect(1))
+    {
+        RunDirect<0, u16>(burststart);
+    }
+    else if ((Cnt & (1<<26)) && CanRunDirect(2))
+    {
+        RunDirect<0, u32>(burststart);
+    }
+    else if (!(Cnt & (1<<26)))
     {
         while (IterCount > 0 && !Stall)
         {
@@ -633,7 +776,15 @@ void DMA::Run7()
     bool burststart = (Running == 2);
     Running = 1;
 
-    if (!(Cnt & (1<<26)))
+    if (!(Cnt & (1<<26)) && CanRunDirect(1))
+    {
+        RunDirect<1, u16>(burststart);
+    }
+    else if ((Cnt & (1<<26)) && CanRunDirect(2))
+    {
+        RunDirect<1, u32>(burststart);
+    }
+    else if (!(Cnt & (1<<26)))
     {
         while (IterCount > 0 && !Stall)
         {
@@ -693,6 +844,35 @@ void DMA::Run7()
     NDS.ResumeCPU(1, 1<<Num);
 }
 
+bool DMA::BulkTransferToRAM(u32 srcaddr, const u32* data, u32 num)
+{
+    if (!(Cnt & 0x80000000)) return false;
+    if (Running || InProgress) return false;
+
+    // 32-bit, repeating, one unit per request, no IRQ
+    if ((Cnt & 0x46000000) != 0x06000000) return false;
+    if ((Cnt & CountMask) != 1) return false;
+
+    // fixed source, incrementing destination
+    if (SrcAddrInc != 0 || CurSrcAddr != srcaddr) return false;
+    if ((Cnt & 0x00600000) != 0) return false;
+
+    u32 dstend = CurDstAddr + ((num - 1) << 2);
+    if ((CurDstAddr >> 24) != 0x02 || (dstend >> 24) != 0x02) return false;
+
+    for (u32 i = 0; i < num; i++)
+    {
+        if (CPU == 0)
+            NDS.ARM9Write32(CurDstAddr, data[i]);
+        else
+            NDS.ARM7Write32(CurDstAddr, data[i]);
+
+        CurDstAddr += 4;
+    }
+
+    return true;
+}
+
 void DMA::Run()
 {
     if (!Running) return;
@@ -73,6 +73,13 @@ public:
         if (Executing) Stall = true;
     }
 
+    /// Performs a whole series of requests at once, if this DMA is set to
+    /// copy one word from a fixed I/O register to the next word of main RAM
+    /// on each request, without raising IRQs. This is how cart transfers are
+    /// normally serviced, one request per word.
+    /// @return false if the DMA isn't set up that way, in which case nothing is done.
+    bool BulkTransferToRAM(u32 srcaddr, const u32* data, u32 num);
+
     u32 SrcAddr {};
     u32 DstAddr {};
     u32 Cnt {};
@@ -99,6 +106,12 @@ private:
 
     bool IsGXFIFODMA {};
 
+    bool IsDirectRange(u32 start, u32 end) const noexcept;
+    bool CanRunDirect(u32 unitshift) const noexcept;
+    template <u32 cpu, typename T> void RunDirect(bool burststart);
+    template <typename T> T ReadDirect(u32 addr) const noexcept;
+    template <u32 cpu, typename T> void WriteDirect(u32 addr, T val);
+
     u32 MRAMBurstCount {};
     std::array<u8, 256> MRAMBurstTable;
 };
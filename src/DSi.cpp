@@ -20,6 +20,7 @@
 #include <assert.h>
 #include <string.h>
 #include <inttypes.h>
+#include <algorithm>
 #include "Args.h"
 #include "NDS.h"
 #include "DSi.h"
@@ -41,7 +42,7 @@
 #include "DSi_DSP.h"
 #include "DSi_Camera.h"
 
-#include "tiny-AES-c/aes.hpp"
+#include "AES.h"
 
 namespace melonDS
 {
@@ -183,6 +184,7 @@ void DSi::Stop(Platform::StopReason reason)
 {
     NDS::Stop(reason);
     CamModule.Stop();
+    SDMMC.FlushCache();
 }
 
 void DSi::SetNDSCart(std::unique_ptr<NDSCart::CartCommon>&& cart)
@@ -385,9 +387,7 @@ void DSi::DecryptModcryptArea(u32 offset, u32 size, const u8* iv)
         data[2] = ARM9Read32(binaryaddr+i+8);
         data[3] = ARM9Read32(binaryaddr+i+12);
 
-        Bswap128(tmp, data);
-        AES_CTR_xcrypt_buffer(&ctx, tmp, sizeof(tmp));
-        Bswap128(data, tmp);
+        AES_CTR_XcryptReversed(&ctx, (u8*)data, sizeof(data));
 
         ARM9Write32(binaryaddr+i,    data[0]);
         ARM9Write32(binaryaddr+i+4,  data[1]);
@@ -599,10 +599,15 @@ void DSi::SetupDirectBoot()
         }
     }
 
-    for (u32 i = arm9start; i < header.ARM9Size; i+=4)
+    // the ARM9 binary is read through the cart, as it may have been patched
+    for (u32 i = arm9start; i < header.ARM9Size; i+=0x200)
     {
-        u32 tmp = *(u32*)&cartrom[header.ARM9ROMOffset+i];
-        ARM9Write32(header.ARM9RAMAddress+i, tmp);
+        u32 tmp[0x200/4];
+        u32 len = std::min(header.ARM9Size - i + 3, 0x200u) & ~3;
+        NDSCartSlot.GetCart()->CopyROM(header.ARM9ROMOffset+i, len, (u8*)tmp);
+
+        for (u32 j = 0; j < len; j+=4)
+            ARM9Write32(header.ARM9RAMAddress+i+j, tmp[j>>2]);
     }
 
     for (u32 i = 0; i < header.ARM7Size; i+=4)
@@ -855,21 +860,17 @@ bool DSi::LoadNAND()
 
         AES_init_ctx_iv(&ctx, boot2key, boot2iv);
 
+        // decrypt the whole binary in one go
+        u32 len9 = (bootparams[3] + 0xF) & ~0xF;
+        std::vector<u32> data9(len9 >> 2);
         FileSeek(nand, bootparams[0], FileSeekOrigin::Start);
+        FileRead(data9.data(), len9, 1, nand);
+        AES_CTR_XcryptReversed(&ctx, (u8*)data9.data(), len9);
+
         dstaddr = bootparams[2];
-        for (u32 i = 0; i < bootparams[3]; i += 16)
+        for (u32 i = 0; i < (len9 >> 2); i++)
         {
-            u32 data[4];
-            FileRead(data, 16, 1, nand);
-
-            Bswap128(tmp, data);
-            AES_CTR_xcrypt_buffer(&ctx, tmp, 16);
-            Bswap128(data, tmp);
-
-            ARM9Write32(dstaddr, data[0]); dstaddr += 4;
-            ARM9Write32(dstaddr, data[1]); dstaddr += 4;
-            ARM9Write32(dstaddr, data[2]); dstaddr += 4;
-            ARM9Write32(dstaddr, data[3]); dstaddr += 4;
+            ARM9Write32(dstaddr, data9[i]); dstaddr += 4;
         }
 
         *(u32*)&tmp[0] = bootparams[7];
@@ -880,21 +881,17 @@ bool DSi::LoadNAND()
 
         AES_init_ctx_iv(&ctx, boot2key, boot2iv);
 
+        // decrypt the whole binary in one go
+        u32 len7 = (bootparams[7] + 0xF) & ~0xF;
+        std::vector<u32> data7(len7 >> 2);
         FileSeek(nand, bootparams[4], FileSeekOrigin::Start);
+        FileRead(data7.data(), len7, 1, nand);
+        AES_CTR_XcryptReversed(&ctx, (u8*)data7.data(), len7);
+
         dstaddr = bootparams[6];
-        for (u32 i = 0; i < bootparams[7]; i += 16)
+        for (u32 i = 0; i < (len7 >> 2); i++)
         {
-            u32 data[4];
-            FileRead(data, 16, 1, nand);
-
-            Bswap128(tmp, data);
-            AES_CTR_xcrypt_buffer(&ctx, tmp, 16);
-            Bswap128(data, tmp);
-
-            ARM7Write32(dstaddr, data[0]); dstaddr += 4;
-            ARM7Write32(dstaddr, data[1]); dstaddr += 4;
-            ARM7Write32(dstaddr, data[2]); dstaddr += 4;
-            ARM7Write32(dstaddr, data[3]); dstaddr += 4;
+            ARM7Write32(dstaddr, data7[i]); dstaddr += 4;
         }
     }
 
@@ -1041,6 +1038,14 @@ void DSi::CheckDMAs(u32 cpu, u32 mode)
 
     CheckNDMAs(cpu, NDMAModes[mode]);
 }
+
+bool DSi::BulkTransferDMAs(u32 cpu, u32 mode, u32 srcaddr, const u32* data, u32 num)
+{
+    // NDMAs don't take the fast path
+    if (NDMAsInMode(cpu, NDMAModes[mode])) return false;
+
+    return NDS::BulkTransferDMAs(cpu, mode, srcaddr, data, num);
+}
 // new WRAM mapping
 // TODO: find out what happens upon overlapping slots!!
 
@@ -2697,14 +2702,14 @@ u8 DSi::ARM7IORead8(u32 addr)
     case 0x04004500: return I2C.ReadData();
     case 0x04004501: return I2C.ReadCnt();
 
-    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() & 0xFF;
-    case 0x04004D01: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 8) & 0xFF;
-    case 0x04004D02: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 16) & 0xFF;
-    case 0x04004D03: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 24) & 0xFF;
-    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 32) & 0xFF;
-    case 0x04004D05: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 40) & 0xFF;
-    case 0x04004D06: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 48) & 0xFF;
-    case 0x04004D07: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() >> 56;
+    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() & 0xFF;
+    case 0x04004D01: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 8) & 0xFF;
+    case 0x04004D02: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 16) & 0xFF;
+    case 0x04004D03: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 24) & 0xFF;
+    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 32) & 0xFF;
+    case 0x04004D05: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 40) & 0xFF;
+    case 0x04004D06: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 48) & 0xFF;
+    case 0x04004D07: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() >> 56;
     case 0x04004D08: return 0;
 
     case 0x4004700: return DSP.ReadSNDExCnt() & 0xFF;
@@ -2745,10 +2750,10 @@ u16 DSi::ARM7IORead16(u32 addr)
     CASE_READ16_32BIT(0x0400405C, MBK[1][7])
     CASE_READ16_32BIT(0x04004060, MBK[1][8])
 
-    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() & 0xFFFF;
-    case 0x04004D02: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 16) & 0xFFFF;
-    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return (SDMMC.GetNAND()->GetConsoleID() >> 32) & 0xFFFF;
-    case 0x04004D06: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() >> 48;
+    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() & 0xFFFF;
+    case 0x04004D02: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 16) & 0xFFFF;
+    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return (GetConsoleID() >> 32) & 0xFFFF;
+    case 0x04004D06: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() >> 48;
     case 0x04004D08: return 0;
 
     case 0x4004700: return DSP.ReadSNDExCnt();
@@ -2825,8 +2830,8 @@ u32 DSi::ARM7IORead32(u32 addr)
     case 0x04004400: return AES.ReadCnt();
     case 0x0400440C: return AES.ReadOutputFIFO();
 
-    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() & 0xFFFFFFFF;
-    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return SDMMC.GetNAND()->GetConsoleID() >> 32;
+    case 0x04004D00: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() & 0xFFFFFFFF;
+    case 0x04004D04: if (SCFG_BIOS & (1<<10)) return 0; return GetConsoleID() >> 32;
     case 0x04004D08: return 0;
 
     case 0x4004700:
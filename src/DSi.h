@@ -159,6 +159,7 @@ public:
     bool DMAsRunning(u32 cpu) const override;
     void StopDMAs(u32 cpu, u32 mode) override;
     void CheckDMAs(u32 cpu, u32 mode) override;
+    bool BulkTransferDMAs(u32 cpu, u32 mode, u32 srcaddr, const u32* data, u32 num) override;
     u16 SCFG_Clock7;
     u32 SCFG_MC;
     u16 SCFG_RST;
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "DSi.h"
 #include "DSi_NAND.h"
 #include "DSi_AES.h"
@@ -78,7 +79,7 @@ void DSi_AES::Reset()
     OutputMACDue = false;
 
     // initialize keys
-    u64 consoleid = DSi.SDMMC.GetNAND()->GetConsoleID();
+    u64 consoleid = DSi.GetConsoleID();
 
     // slot 0: modcrypt
     *(u32*)&KeyX[0][0] = 0x746E694E;
@@ -151,7 +152,7 @@ void DSi_AES::ProcessBlock_CCM_Extra()
     Bswap128(data_rev, data);
 
     for (int i = 0; i < 16; i++) CurMAC[i] ^= data_rev[i];
-    AES_ECB_encrypt(&Ctx, CurMAC);
+    AES_EncryptBlock(&Ctx, CurMAC);
 }
 
 void DSi_AES::ProcessBlock_CCM_Decrypt()
@@ -168,9 +169,9 @@ void DSi_AES::ProcessBlock_CCM_Decrypt()
 
     Bswap128(data_rev, data);
 
-    AES_CTR_xcrypt_buffer(&Ctx, data_rev, 16);
+    AES_CTR_Xcrypt(&Ctx, data_rev, 16);
     for (int i = 0; i < 16; i++) CurMAC[i] ^= data_rev[i];
-    AES_ECB_encrypt(&Ctx, CurMAC);
+    AES_EncryptBlock(&Ctx, CurMAC);
 
     Bswap128(data, data_rev);
 
@@ -197,8 +198,8 @@ void DSi_AES::ProcessBlock_CCM_Encrypt()
     Bswap128(data_rev, data);
 
     for (int i = 0; i < 16; i++) CurMAC[i] ^= data_rev[i];
-    AES_CTR_xcrypt_buffer(&Ctx, data_rev, 16);
-    AES_ECB_encrypt(&Ctx, CurMAC);
+    AES_CTR_Xcrypt(&Ctx, data_rev, 16);
+    AES_EncryptBlock(&Ctx, CurMAC);
 
     Bswap128(data, data_rev);
 
@@ -210,28 +211,19 @@ void DSi_AES::ProcessBlock_CCM_Encrypt()
     OutputFIFO.Write(*(u32*)&data[12]);
 }
 
-void DSi_AES::ProcessBlock_CTR()
+void DSi_AES::ProcessBlocks_CTR(u32 num)
 {
-    u8 data[16];
-    u8 data_rev[16];
-
-    *(u32*)&data[0] = InputFIFO.Read();
-    *(u32*)&data[4] = InputFIFO.Read();
-    *(u32*)&data[8] = InputFIFO.Read();
-    *(u32*)&data[12] = InputFIFO.Read();
-
-    //printf("AES-CTR: "); _printhex2(data, 16);
+    // CTR blocks don't depend on each other, so everything
+    // that's in the FIFO can be done at once
+    u32 data[16];
 
-    Bswap128(data_rev, data);
-    AES_CTR_xcrypt_buffer(&Ctx, data_rev, 16);
-    Bswap128(data, data_rev);
+    for (u32 i = 0; i < num*4; i++)
+        data[i] = InputFIFO.Read();
 
-    //printf(" -> "); _printhex(data, 16);
+    AES_CTR_XcryptReversed(&Ctx, (u8*)data, num*16);
 
-    OutputFIFO.Write(*(u32*)&data[0]);
-    OutputFIFO.Write(*(u32*)&data[4]);
-    OutputFIFO.Write(*(u32*)&data[8]);
-    OutputFIFO.Write(*(u32*)&data[12]);
+    for (u32 i = 0; i < num*4; i++)
+        OutputFIFO.Write(data[i]);
 }
 
 
@@ -306,7 +298,7 @@ void DSi_AES::WriteCnt(u32 val)
                 iv[15] = RemBlocks << 4;
 
                 memcpy(CurMAC, iv, 16);
-                AES_ECB_encrypt(&Ctx, CurMAC);
+                AES_EncryptBlock(&Ctx, CurMAC);
             }
             else
             {
@@ -412,17 +404,26 @@ void DSi_AES::Update()
 
     if (RemExtra == 0)
     {
-        while (InputFIFO.Level() >= 4 && OutputFIFO.Level() <= 12 && RemBlocks > 0)
+        if (AESMode >= 2)
         {
-            switch (AESMode)
+            u32 num = std::min({InputFIFO.Level() >> 2, (16 - OutputFIFO.Level()) >> 2, RemBlocks});
+            if (num > 0)
             {
-            case 0: ProcessBlock_CCM_Decrypt(); break;
-            case 1: ProcessBlock_CCM_Encrypt(); break;
-            case 2:
-            case 3: ProcessBlock_CTR(); break;
+                ProcessBlocks_CTR(num);
+                RemBlocks -= num;
             }
+        }
+        else
+        {
+            while (InputFIFO.Level() >= 4 && OutputFIFO.Level() <= 12 && RemBlocks > 0)
+            {
+                if (AESMode == 0)
+                    ProcessBlock_CCM_Decrypt();
+                else
+                    ProcessBlock_CCM_Encrypt();
 
-            RemBlocks--;
+                RemBlocks--;
+            }
         }
     }
 
@@ -435,7 +436,7 @@ void DSi_AES::Update()
             Ctx.Iv[13] = 0x00;
             Ctx.Iv[14] = 0x00;
             Ctx.Iv[15] = 0x00;
-            AES_CTR_xcrypt_buffer(&Ctx, CurMAC, 16);
+            AES_CTR_Xcrypt(&Ctx, CurMAC, 16);
 
             //printf("FINAL MAC: "); _printhexR(CurMAC, 16);
             //printf("INPUT MAC: "); _printhex(MAC, 16);
@@ -451,7 +452,7 @@ void DSi_AES::Update()
             Ctx.Iv[13] = 0x00;
             Ctx.Iv[14] = 0x00;
             Ctx.Iv[15] = 0x00;
-            AES_CTR_xcrypt_buffer(&Ctx, CurMAC, 16);
+            AES_CTR_Xcrypt(&Ctx, CurMAC, 16);
 
             Bswap128(OutputMAC, CurMAC);
 
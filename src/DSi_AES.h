@@ -22,7 +22,7 @@
 #include "types.h"
 #include "Savestate.h"
 #include "FIFO.h"
-#include "tiny-AES-c/aes.hpp"
+#include "AES.h"
 
 namespace melonDS
 {
@@ -109,7 +109,7 @@ private:
     void ProcessBlock_CCM_Extra();
     void ProcessBlock_CCM_Decrypt();
     void ProcessBlock_CCM_Encrypt();
-    void ProcessBlock_CTR();
+    void ProcessBlocks_CTR(u32 num);
 };
 
 }
@@ -26,7 +26,7 @@
 #include "Platform.h"
 
 #include "sha1/sha1.hpp"
-#include "tiny-AES-c/aes.hpp"
+#include "AES.h"
 
 #include "fatfs/ff.h"
 
@@ -219,13 +219,7 @@ u32 NANDImage::ReadFATBlock(u64 addr, u32 len, u8* buf)
     u32 res = FileRead(buf, len, 1, CurFile);
     if (!res) return 0;
 
-    for (u32 i = 0; i < len; i += 16)
-    {
-        u8 tmp[16];
-        Bswap128(tmp, &buf[i]);
-        AES_CTR_xcrypt_buffer(&ctx, tmp, sizeof(tmp));
-        Bswap128(&buf[i], tmp);
-    }
+    AES_CTR_XcryptReversed(&ctx, buf, len);
 
     return len;
 }
@@ -237,37 +231,71 @@ u32 NANDImage::WriteFATBlock(u64 addr, u32 len, const u8* buf)
     AES_ctx ctx;
     SetupFATCrypto(&ctx, ctr);
 
+    std::vector<u8> tempbuf(buf, buf + len);
+    AES_CTR_XcryptReversed(&ctx, tempbuf.data(), len);
+
     FileSeek(CurFile, addr, FileSeekOrigin::Start);
+    u32 res = FileWrite(tempbuf.data(), len, 1, CurFile);
+    if (!res) return 0;
 
-    for (u32 s = 0; s < len; s += 0x200)
-    {
-        u8 tempbuf[0x200];
+    return len;
+}
 
-        for (u32 i = 0; i < 0x200; i += 16)
-        {
-            u8 tmp[16];
-            Bswap128(tmp, &buf[s+i]);
-            AES_CTR_xcrypt_buffer(&ctx, tmp, sizeof(tmp));
-            Bswap128(&tempbuf[i], tmp);
-        }
 
-        u32 res = FileWrite(tempbuf, sizeof(tempbuf), 1, CurFile);
-        if (!res) return 0;
+void NANDMount::CacheSector(LBA_t sector, const u8* data)
+{
+    if (SectorLRU.size() >= SectorCacheSize)
+    {
+        // recycle the least recently used entry
+        SectorMap.erase(SectorLRU.back().Sector);
+        SectorLRU.splice(SectorLRU.begin(), SectorLRU, std::prev(SectorLRU.end()));
     }
+    else
+        SectorLRU.emplace_front();
 
-    return len;
+    CachedSector& entry = SectorLRU.front();
+    entry.Sector = sector;
+    memcpy(entry.Data, data, sizeof(entry.Data));
+    SectorMap[sector] = SectorLRU.begin();
 }
 
-
 UINT NANDMount::FF_ReadNAND(BYTE* buf, LBA_t sector, UINT num)
 {
     // TODO: allow selecting other partitions?
     u64 baseaddr = 0x10EE00;
 
-    u64 blockaddr = baseaddr + (sector * 0x200ULL);
+    UINT i = 0;
+    while (i < num)
+    {
+        auto it = SectorMap.find(sector + i);
+        if (it != SectorMap.end())
+        {
+            memcpy(&buf[i * 0x200], it->second->Data, 0x200);
+            SectorLRU.splice(SectorLRU.begin(), SectorLRU, it->second);
+            i++;
+            continue;
+        }
 
-    u32 res = Image->ReadFATBlock(blockaddr, num*0x200, buf);
-    return res >> 9;
+        // read and decrypt the whole run of uncached sectors at once
+        UINT run = 1;
+        while ((i + run) < num && !SectorMap.count(sector + i + run))
+            run++;
+
+        u64 blockaddr = baseaddr + ((sector + i) * 0x200ULL);
+        u32 res = Image->ReadFATBlock(blockaddr, run*0x200, &buf[i * 0x200]);
+        if (res != run*0x200)
+            return i;
+
+        if (run <= SectorCacheMaxRun)
+        {
+            for (UINT j = 0; j < run; j++)
+                CacheSector(sector + i + j, &buf[(i + j) * 0x200]);
+        }
+
+        i += run;
+    }
+
+    return num;
 }
 
 UINT NANDMount::FF_WriteNAND(const BYTE* buf, LBA_t sector, UINT num)
@@ -275,6 +303,16 @@ UINT NANDMount::FF_WriteNAND(const BYTE* buf, LBA_t sector, UINT num)
     // TODO: allow selecting other partitions?
     u64 baseaddr = 0x10EE00;
 
+    for (UINT i = 0; i < num; i++)
+    {
+        auto it = SectorMap.find(sector + i);
+        if (it != SectorMap.end())
+        {
+            SectorLRU.erase(it->second);
+            SectorMap.erase(it);
+        }
+    }
+
     u64 blockaddr = baseaddr + (sector * 0x200ULL);
 
     u32 res = Image->WriteFATBlock(blockaddr, num*0x200, buf);
@@ -303,8 +341,10 @@ bool NANDImage::ESEncrypt(u8* data, u32 len) const
     mac[14] = (blklen >> 8) & 0xFF;
     mac[15] = blklen & 0xFF;
 
-    AES_ECB_encrypt(&ctx, mac);
+    AES_EncryptBlock(&ctx, mac);
 
+    // the MAC is over the plaintext, and the counter mode part
+    // doesn't depend on it, so it can be done on the whole buffer after
     u32 coarselen = len & ~0xF;
     for (u32 i = 0; i < coarselen; i += 16)
     {
@@ -313,12 +353,11 @@ bool NANDImage::ESEncrypt(u8* data, u32 len) const
         Bswap128(tmp, &data[i]);
 
         for (int i = 0; i < 16; i++) mac[i] ^= tmp[i];
-        AES_CTR_xcrypt_buffer(&ctx, tmp, 16);
-        AES_ECB_encrypt(&ctx, mac);
-
-        Bswap128(&data[i], tmp);
+        AES_EncryptBlock(&ctx, mac);
     }
 
+    AES_CTR_XcryptReversed(&ctx, data, coarselen);
+
     u32 remlen = len - coarselen;
     if (remlen)
     {
@@ -329,8 +368,8 @@ bool NANDImage::ESEncrypt(u8* data, u32 len) const
             rem[15-i] = data[coarselen+i];
 
         for (int i = 0; i < 16; i++) mac[i] ^= rem[i];
-        AES_CTR_xcrypt_buffer(&ctx, rem, sizeof(rem));
-        AES_ECB_encrypt(&ctx, mac);
+        AES_CTR_Xcrypt(&ctx, rem, sizeof(rem));
+        AES_EncryptBlock(&ctx, mac);
 
         for (int i = 0; i < remlen; i++)
             data[coarselen+i] = rem[15-i];
@@ -339,7 +378,7 @@ bool NANDImage::ESEncrypt(u8* data, u32 len) const
     ctx.Iv[13] = 0x00;
     ctx.Iv[14] = 0x00;
     ctx.Iv[15] = 0x00;
-    AES_CTR_xcrypt_buffer(&ctx, mac, sizeof(mac));
+    AES_CTR_Xcrypt(&ctx, mac, sizeof(mac));
 
     Bswap128(&data[len], mac);
 
@@ -357,7 +396,7 @@ bool NANDImage::ESEncrypt(u8* data, u32 len) const
     footer[0] = len & 0xFF;
 
     AES_ctx_set_iv(&ctx, iv);
-    AES_CTR_xcrypt_buffer(&ctx, footer, sizeof(footer));
+    AES_CTR_Xcrypt(&ctx, footer, sizeof(footer));
 
     data[len+0x10] = footer[15];
     data[len+0x1D] = footer[2];
@@ -388,20 +427,19 @@ bool NANDImage::ESDecrypt(u8* data, u32 len) const
     mac[14] = (blklen >> 8) & 0xFF;
     mac[15] = blklen & 0xFF;
 
-    AES_ECB_encrypt(&ctx, mac);
+    AES_EncryptBlock(&ctx, mac);
 
     u32 coarselen = len & ~0xF;
+    AES_CTR_XcryptReversed(&ctx, data, coarselen);
+
     for (u32 i = 0; i < coarselen; i += 16)
     {
         u8 tmp[16];
 
         Bswap128(tmp, &data[i]);
 
-        AES_CTR_xcrypt_buffer(&ctx, tmp, sizeof(tmp));
         for (int i = 0; i < 16; i++) mac[i] ^= tmp[i];
-        AES_ECB_encrypt(&ctx, mac);
-
-        Bswap128(&data[i], tmp);
+        AES_EncryptBlock(&ctx, mac);
     }
 
     u32 remlen = len - coarselen;
@@ -416,15 +454,15 @@ bool NANDImage::ESDecrypt(u8* data, u32 len) const
 
         memset(rem, 0, 16);
         AES_ctx_set_iv(&ctx, iv);
-        AES_CTR_xcrypt_buffer(&ctx, rem, 16);
+        AES_CTR_Xcrypt(&ctx, rem, 16);
 
         for (int i = 0; i < remlen; i++)
             rem[15-i] = data[coarselen+i];
 
         AES_ctx_set_iv(&ctx, iv);
-        AES_CTR_xcrypt_buffer(&ctx, rem, 16);
+        AES_CTR_Xcrypt(&ctx, rem, 16);
         for (int i = 0; i < 16; i++) mac[i] ^= rem[i];
-        AES_ECB_encrypt(&ctx, mac);
+        AES_EncryptBlock(&ctx, mac);
 
         for (int i = 0; i < remlen; i++)
             data[coarselen+i] = rem[15-i];
@@ -433,7 +471,7 @@ bool NANDImage::ESDecrypt(u8* data, u32 len) const
     ctx.Iv[13] = 0x00;
     ctx.Iv[14] = 0x00;
     ctx.Iv[15] = 0x00;
-    AES_CTR_xcrypt_buffer(&ctx, mac, 16);
+    AES_CTR_Xcrypt(&ctx, mac, 16);
 
     u8 footer[16];
 
@@ -446,7 +484,7 @@ bool NANDImage::ESDecrypt(u8* data, u32 len) const
     Bswap128(footer, &data[len+0x10]);
 
     AES_ctx_set_iv(&ctx, iv);
-    AES_CTR_xcrypt_buffer(&ctx, footer, sizeof(footer));
+    AES_CTR_Xcrypt(&ctx, footer, sizeof(footer));
 
     data[len+0x10] = footer[15];
     data[len+0x1D] = footer[2];
@@ -25,7 +25,9 @@
 #include "DSi_TMD.h"
 #include "SPI_Firmware.h"
 #include <array>
+#include <list>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -128,9 +130,27 @@ private:
     bool InitTitleFileStructure(const NDSHeader& header, const DSi_TMD::TitleMetadata& tmd, bool readonly);
     UINT FF_ReadNAND(BYTE* buf, LBA_t sector, UINT num);
     UINT FF_WriteNAND(const BYTE* buf, LBA_t sector, UINT num);
+    void CacheSector(LBA_t sector, const u8* data);
 
     NANDImage* Image;
 
+    // FATFS goes back to the same FAT and directory sectors over and over,
+    // so the most recently read sectors are kept around already decrypted.
+    // Reads longer than SectorCacheMaxRun (file contents, mostly) aren't
+    // cached, so that they don't push those sectors out.
+    static constexpr u32 SectorCacheSize = 256;
+    static constexpr u32 SectorCacheMaxRun = 8;
+
+    struct CachedSector
+    {
+        LBA_t Sector;
+        u8 Data[0x200];
+    };
+
+    // most recently used first
+    std::list<CachedSector> SectorLRU;
+    std::unordered_map<LBA_t, std::list<CachedSector>::iterator> SectorMap;
+
     // We keep a pointer to CurFS because fatfs maintains a global pointer to it;
     // therefore if we embed the FATFS directly in the object,
     // we can't give it move semantics.
@@ -215,11 +215,11 @@ void DSi_NDMA::Run9()
 
     if ((CurSrcAddr >> 24) == 0x02 && (CurDstAddr >> 24) == 0x02)
     {
-        unitcycles = DSi.ARM9MemTimings[CurSrcAddr >> 14][2] + DSi.ARM9MemTimings[CurDstAddr >> 14][2];
+        unitcycles = DSi.GetARM9MemTimings(CurSrcAddr >> 14)[2] + DSi.GetARM9MemTimings(CurDstAddr >> 14)[2];
     }
     else
     {
-        unitcycles = DSi.ARM9MemTimings[CurSrcAddr >> 14][3] + DSi.ARM9MemTimings[CurDstAddr >> 14][3];
+        unitcycles = DSi.GetARM9MemTimings(CurSrcAddr >> 14)[3] + DSi.GetARM9MemTimings(CurDstAddr >> 14)[3];
         if ((CurSrcAddr >> 24) == (CurDstAddr >> 24))
             unitcycles++;
         else if ((CurSrcAddr >> 24) == 0x02)
@@ -228,7 +228,7 @@ void DSi_NDMA::Run9()
         /*if (burststart)
         {
             cycles -= 2;
-            cycles -= (NDS::ARM9MemTimings[CurSrcAddr >> 14][2] + NDS::ARM9MemTimings[CurDstAddr >> 14][2]);
+            cycles -= (NDS::GetARM9MemTimings(CurSrcAddr >> 14)[2] + NDS::GetARM9MemTimings(CurDstAddr >> 14)[2]);
             cycles += unitcycles;
         }*/
     }
@@ -304,11 +304,11 @@ void DSi_NDMA::Run7()
 
     if ((CurSrcAddr >> 24) == 0x02 && (CurDstAddr >> 24) == 0x02)
     {
-        unitcycles = DSi.ARM7MemTimings[CurSrcAddr >> 15][2] + DSi.ARM7MemTimings[CurDstAddr >> 15][2];
+        unitcycles = DSi.GetARM7MemTimings(CurSrcAddr >> 15)[2] + DSi.GetARM7MemTimings(CurDstAddr >> 15)[2];
     }
     else
     {
-        unitcycles = DSi.ARM7MemTimings[CurSrcAddr >> 15][3] + DSi.ARM7MemTimings[CurDstAddr >> 15][3];
+        unitcycles = DSi.GetARM7MemTimings(CurSrcAddr >> 15)[3] + DSi.GetARM7MemTimings(CurDstAddr >> 15)[3];
         if ((CurSrcAddr >> 23) == (CurDstAddr >> 23))
             unitcycles++;
         else if ((CurSrcAddr >> 24) == 0x02)
@@ -317,7 +317,7 @@ void DSi_NDMA::Run7()
         /*if (burststart)
         {
             cycles -= 2;
-            cycles -= (NDS::ARM7MemTimings[CurSrcAddr >> 15][2] + NDS::ARM7MemTimings[CurDstAddr >> 15][2]);
+            cycles -= (NDS::GetARM7MemTimings(CurSrcAddr >> 15)[2] + NDS::GetARM7MemTimings(CurDstAddr >> 15)[2]);
             cycles += unitcycles;
         }*/
     }
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "Args.h"
 #include "DSi.h"
 #include "DSi_SD.h"
@@ -202,6 +203,14 @@ void DSi_SDHost::SetNAND(DSi_NAND::NANDImage&& nand) noexcept
     static_cast<DSi_MMCStorage*>(Ports[1].get())->SetNAND(std::move(nand));
 }
 
+void DSi_SDHost::FlushCache()
+{
+    for (auto& port : Ports)
+    {
+        if (port) port->FlushCache();
+    }
+}
+
 void DSi_SDHost::DoSavestate(Savestate* file)
 {
     file->Section(Num ? "SDIO" : "SDMM");
@@ -822,11 +831,15 @@ DSi_MMCStorage::DSi_MMCStorage(melonDS::DSi& dsi, DSi_SDHost* host, FATStorage&&
 
 // The FATStorage or NANDImage is owned by this object;
 // std::variant's destructor will clean it up.
-DSi_MMCStorage::~DSi_MMCStorage() = default;
+DSi_MMCStorage::~DSi_MMCStorage()
+{
+    FlushCache();
+}
 
 void DSi_MMCStorage::Reset()
 {
     // TODO: reset file access????
+    InvalidateCache();
 
     CSR = 0x00000100; // checkme
 
@@ -853,6 +866,10 @@ void DSi_MMCStorage::DoSavestate(Savestate* file)
 {
     file->Section(holds_alternative<DSi_NAND::NANDImage>(Storage) ? "NAND" : "SDCR");
 
+    // the image isn't part of the savestate, but it should at least be
+    // up to date on disk alongside it
+    FlushCache();
+
     file->VarArray(CID, 16);
     file->VarArray(CSD, 16);
 
@@ -877,6 +894,11 @@ void DSi_MMCStorage::SendCMD(u8 cmd, u32 param)
         return SendACMD(cmd, param);
     }
 
+    // anything other than a data transfer means the card is idle
+    // as far as the image is concerned
+    if (cmd != 17 && cmd != 18 && cmd != 24 && cmd != 25)
+        FlushCache();
+
     switch (cmd)
     {
     case 0: // reset/etc
@@ -1072,17 +1094,7 @@ u32 DSi_MMCStorage::ReadBlock(u64 addr)
     u32 len = BlockSize;
     len = Host->GetTransferrableLen(len);
 
-    u8 data[0x200];
-    if (auto* sd = std::get_if<FATStorage>(&Storage))
-    {
-        sd->ReadSectors((u32)(addr >> 9), 1, data);
-    }
-    else if (auto* nand = std::get_if<DSi_NAND::NANDImage>(&Storage))
-    {
-        FileSeek(nand->GetFile(), addr, FileSeekOrigin::Start);
-        FileRead(&data[addr & 0x1FF], 1, len, nand->GetFile());
-    }
-
+    u8* data = GetCachedBlock(addr >> 9, RWCommand == 18);
     return Host->DataRX(&data[addr & 0x1FF], len);
 }
 
@@ -1092,30 +1104,171 @@ u32 DSi_MMCStorage::WriteBlock(u64 addr)
     len = Host->GetTransferrableLen(len);
 
     u8 data[0x200];
-    if (len < 0x200)
+    u32 offset = addr & 0x1FF;
+    if ((len = Host->DataTX(&data[offset], len)))
     {
-        if (auto* sd = get_if<FATStorage>(&Storage))
+        if (!ReadOnly && !holds_alternative<Nothing>(Storage))
         {
-            sd->ReadSectors((u32)(addr >> 9), 1, data);
-        }
-    }
-    if ((len = Host->DataTX(&data[addr & 0x1FF], len)))
-    {
-        if (!ReadOnly)
-        {
-            if (auto* sd = get_if<FATStorage>(&Storage))
+            u32 copylen = std::min(len, 0x200 - offset);
+            u64 block = addr >> 9;
+
+            // a partial write needs the rest of the block
+            int entry;
+            if (copylen < 0x200)
             {
-                sd->WriteSectors((u32)(addr >> 9), 1, data);
+                GetCachedBlock(block, false);
+                entry = FindCachedBlock(block);
             }
-            else if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
+            else
             {
-                FileSeek(nand->GetFile(), addr, FileSeekOrigin::Start);
-                FileWrite(&data[addr & 0x1FF], 1, len, nand->GetFile());
+                entry = FindCachedBlock(block);
+                if (entry < 0)
+                    entry = AllocCacheEntry(block);
             }
+
+            memcpy(&CacheData[entry][offset], &data[offset], copylen);
+            CacheEntries[entry].Dirty = true;
         }
     }
 
     return len;
 }
 
+int DSi_MMCStorage::FindCachedBlock(u64 block) const noexcept
+{
+    for (u32 i = 0; i < CacheBlocks; i++)
+    {
+        if (CacheEntries[i].Valid && CacheEntries[i].Block == block)
+            return i;
+    }
+
+    return -1;
+}
+
+int DSi_MMCStorage::AllocCacheEntry(u64 block) noexcept
+{
+    int entry = 0;
+    for (u32 i = 0; i < CacheBlocks; i++)
+    {
+        if (!CacheEntries[i].Valid)
+        {
+            entry = i;
+            break;
+        }
+
+        if (CacheEntries[i].LastUse < CacheEntries[entry].LastUse)
+            entry = i;
+    }
+
+    // writing back everything at once keeps the writes in long runs
+    if (CacheEntries[entry].Valid && CacheEntries[entry].Dirty)
+        FlushCache();
+
+    CacheEntries[entry] = {block, ++CacheTick, true, false};
+    return entry;
+}
+
+u8* DSi_MMCStorage::GetCachedBlock(u64 block, bool readahead) noexcept
+{
+    int entry = FindCachedBlock(block);
+    if (entry >= 0)
+    {
+        CacheEntries[entry].LastUse = ++CacheTick;
+        return CacheData[entry];
+    }
+
+    u8 data[ReadAheadBlocks * 0x200];
+    u32 num = readahead ? ReadAheadBlocks : 1;
+    u32 numread = ReadBlocks(block, num, data);
+    if (numread < num)
+        memset(&data[numread * 0x200], 0, (num - numread) * 0x200);
+
+    entry = AllocCacheEntry(block);
+    memcpy(CacheData[entry], data, 0x200);
+
+    // blocks that are already cached may have been written to since
+    for (u32 i = 1; i < numread; i++)
+    {
+        if (FindCachedBlock(block + i) >= 0)
+            continue;
+
+        int ra = AllocCacheEntry(block + i);
+        memcpy(CacheData[ra], &data[i * 0x200], 0x200);
+    }
+
+    // keep the requested block the most recently used,
+    // it's the one that's about to be read
+    CacheEntries[entry].LastUse = ++CacheTick;
+    return CacheData[entry];
+}
+
+void DSi_MMCStorage::FlushCache()
+{
+    int dirty[CacheBlocks];
+    u32 numdirty = 0;
+    for (u32 i = 0; i < CacheBlocks; i++)
+    {
+        if (CacheEntries[i].Valid && CacheEntries[i].Dirty)
+            dirty[numdirty++] = i;
+    }
+    if (numdirty == 0) return;
+
+    std::sort(dirty, dirty + numdirty, [this](int a, int b) { return CacheEntries[a].Block < CacheEntries[b].Block; });
+
+    // gather runs of consecutive blocks so each run is a single write
+    u8 data[CacheBlocks * 0x200];
+    u32 start = 0;
+    while (start < numdirty)
+    {
+        u32 end = start + 1;
+        while (end < numdirty && CacheEntries[dirty[end]].Block == CacheEntries[dirty[start]].Block + (end - start))
+            end++;
+
+        for (u32 i = start; i < end; i++)
+        {
+            memcpy(&data[(i - start) * 0x200], CacheData[dirty[i]], 0x200);
+            CacheEntries[dirty[i]].Dirty = false;
+        }
+
+        WriteBlocks(CacheEntries[dirty[start]].Block, end - start, data);
+        start = end;
+    }
+}
+
+void DSi_MMCStorage::InvalidateCache() noexcept
+{
+    FlushCache();
+
+    for (CacheEntry& entry : CacheEntries)
+        entry.Valid = false;
+}
+
+u32 DSi_MMCStorage::ReadBlocks(u64 block, u32 num, u8* data) noexcept
+{
+    if (auto* sd = std::get_if<FATStorage>(&Storage))
+    {
+        return sd->ReadSectors((u32)block, num, data);
+    }
+    else if (auto* nand = std::get_if<DSi_NAND::NANDImage>(&Storage))
+    {
+        FileSeek(nand->GetFile(), block << 9, FileSeekOrigin::Start);
+        return FileRead(data, 0x200, num, nand->GetFile());
+    }
+
+    return 0;
+}
+
+void DSi_MMCStorage::WriteBlocks(u64 block, u32 num, const u8* data) noexcept
+{
+    if (auto* sd = get_if<FATStorage>(&Storage))
+    {
+        sd->WriteSectors((u32)block, num, data);
+    }
+    else if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
+    {
+        FileSeek(nand->GetFile(), block << 9, FileSeekOrigin::Start);
+        FileWrite(data, 0x200, num, nand->GetFile());
+    }
+}
+
 }
@@ -70,6 +70,9 @@ public:
     void SetSDCard(std::optional<FATStorage>&& sdcard) noexcept;
     void SetNAND(DSi_NAND::NANDImage&& nand) noexcept;
 
+    /// Writes out any data the attached devices are holding back.
+    void FlushCache();
+
     u16 Read(u32 addr);
     void Write(u32 addr, u16 val);
     u16 ReadFIFO16();
@@ -134,6 +137,8 @@ public:
     virtual void SendCMD(u8 cmd, u32 param) = 0;
     virtual void ContinueTransfer() = 0;
 
+    virtual void FlushCache() {}
+
     bool IRQ;
     bool ReadOnly;
 
@@ -149,15 +154,18 @@ public:
     DSi_MMCStorage(melonDS::DSi& dsi, DSi_SDHost* host, FATStorage&& sdcard) noexcept;
     ~DSi_MMCStorage() override;
 
-    [[nodiscard]] FATStorage* GetSDCard() noexcept { return std::get_if<FATStorage>(&Storage); }
+    // whoever gets non-const access may touch the image behind our back,
+    // so the block cache is written out and dropped first
+    [[nodiscard]] FATStorage* GetSDCard() noexcept { InvalidateCache(); return std::get_if<FATStorage>(&Storage); }
     [[nodiscard]] const FATStorage* GetSDCard() const noexcept { return std::get_if<FATStorage>(&Storage); }
-    [[nodiscard]] DSi_NAND::NANDImage* GetNAND() noexcept { return std::get_if<DSi_NAND::NANDImage>(&Storage); }
+    [[nodiscard]] DSi_NAND::NANDImage* GetNAND() noexcept { InvalidateCache(); return std::get_if<DSi_NAND::NANDImage>(&Storage); }
     [[nodiscard]] const DSi_NAND::NANDImage* GetNAND() const noexcept { return std::get_if<DSi_NAND::NANDImage>(&Storage); }
 
-    void SetNAND(DSi_NAND::NANDImage&& nand) noexcept { Storage = std::move(nand); }
-    void SetSDCard(FATStorage&& sdcard) noexcept { Storage = std::move(sdcard); }
+    void SetNAND(DSi_NAND::NANDImage&& nand) noexcept { InvalidateCache(); Storage = std::move(nand); }
+    void SetSDCard(FATStorage&& sdcard) noexcept { InvalidateCache(); Storage = std::move(sdcard); }
     void SetSDCard(std::optional<FATStorage>&& sdcard) noexcept
     {
+        InvalidateCache();
         if (sdcard)
         { // If we're setting a new SD card...
             Storage = std::move(*sdcard);
@@ -171,6 +179,7 @@ public:
 
     void SetStorage(DSiStorage&& storage) noexcept
     {
+        InvalidateCache();
         Storage = std::move(storage);
         storage = Nothing();
         // not sure if a moved-from variant is empty or contains a moved-from object;
@@ -188,7 +197,36 @@ public:
 
     void ContinueTransfer() override;
 
+    void FlushCache() override;
+
 private:
+    // Blocks are cached so that multi-block transfers don't turn into
+    // a file access per block. Reads that are part of a READ_MULTIPLE_BLOCK
+    // fetch the following blocks along with the requested one, and writes
+    // are held back until the card goes idle, then written out in runs
+    // of consecutive blocks.
+    static constexpr u32 CacheBlocks = 64;
+    static constexpr u32 ReadAheadBlocks = 16;
+
+    struct CacheEntry
+    {
+        u64 Block;
+        u64 LastUse;
+        bool Valid;
+        bool Dirty;
+    };
+
+    CacheEntry CacheEntries[CacheBlocks] {};
+    u8 CacheData[CacheBlocks][0x200];
+    u64 CacheTick = 0;
+
+    void InvalidateCache() noexcept;
+    int FindCachedBlock(u64 block) const noexcept;
+    int AllocCacheEntry(u64 block) noexcept;
+    u8* GetCachedBlock(u64 block, bool readahead) noexcept;
+    u32 ReadBlocks(u64 block, u32 num, u8* data) noexcept;
+    void WriteBlocks(u64 block, u32 num, const u8* data) noexcept;
+
     static constexpr u8 DSiSDCardCID[16] = {0xBD, 0x12, 0x34, 0x56, 0x78, 0x03, 0x4D, 0x30, 0x30, 0x46, 0x50, 0x41, 0x00, 0x00, 0x15, 0x00};
     melonDS::DSi& DSi;
     DSiStorage Storage;
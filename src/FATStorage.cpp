@@ -19,12 +19,16 @@
 #include <string.h>
 #include <dirent.h>
 #include <inttypes.h>
+#include <algorithm>
 #include <vector>
 
 #include "FATIO.h"
 #include "FATStorage.h"
 #include "Platform.h"
 
+#define XXH_STATIC_LINKING_ONLY
+#include "xxhash/xxhash.h"
+
 namespace melonDS
 {
 namespace fs = std::filesystem;
@@ -60,6 +64,8 @@ FATStorage::FATStorage(FATStorage&& other) noexcept
     FileSize = other.FileSize;
     DirIndex = std::move(other.DirIndex);
     FileIndex = std::move(other.FileIndex);
+    DirtySectors = std::move(other.DirtySectors);
+    HasDirtySectors = other.HasDirtySectors;
 
     other.File = nullptr;
 }
@@ -82,6 +88,8 @@ FATStorage& FATStorage::operator=(FATStorage&& other) noexcept
         FileSize = other.FileSize;
         DirIndex = std::move(other.DirIndex);
         FileIndex = std::move(other.FileIndex);
+        DirtySectors = std::move(other.DirtySectors);
+        HasDirtySectors = other.HasDirtySectors;
 
         other.File = nullptr;
         other.SourceDir = std::nullopt;
@@ -98,7 +106,7 @@ FATStorage::~FATStorage()
     File = nullptr;
 }
 
-bool FATStorage::InjectFile(const std::string& path, u8* data, u32 len)
+bool FATStorage::InjectFile(const std::string& path, const u8* data, u32 len)
 {
     if (!File) return false;
 
@@ -181,7 +189,9 @@ u32 FATStorage::ReadSectors(u32 start, u32 num, u8* data) const
 u32 FATStorage::WriteSectors(u32 start, u32 num, const u8* data)
 {
     if (ReadOnly) return 0;
-    return WriteSectorsInternal(File, FileSize, start, num, data);
+    u32 res = WriteSectorsInternal(File, FileSize, start, num, data);
+    MarkDirtySectors(start, res);
+    return res;
 }
 
 u64 FATStorage::GetSectorCount() const
@@ -196,10 +206,12 @@ ff_disk_read_cb FATStorage::FF_ReadStorage() const noexcept
     };
 }
 
-ff_disk_write_cb FATStorage::FF_WriteStorage() const noexcept
+ff_disk_write_cb FATStorage::FF_WriteStorage() noexcept
 {
     return [this](const BYTE* buf, LBA_t sector, UINT num) {
-        return WriteSectorsInternal(File, FileSize, sector, num, buf);
+        u32 res = WriteSectorsInternal(File, FileSize, sector, num, buf);
+        MarkDirtySectors(sector, res);
+        return res;
     };
 }
 
@@ -254,11 +266,230 @@ u32 FATStorage::WriteSectorsInternal(FileHandle* file, u64 filelen, u32 start, u
 }
 
 
+void FATStorage::MarkDirtySectors(u32 start, u32 num)
+{
+    // without a source directory, there's nothing to sync
+    if (!SourceDir || !num) return;
+
+    u64 numsectors = FileSize >> 9;
+    if (DirtySectors.size() < ((numsectors + 63) >> 6))
+        DirtySectors.resize((numsectors + 63) >> 6, 0);
+
+    for (u64 i = start; i < (u64)start + num && i < numsectors; i++)
+        DirtySectors[i >> 6] |= (1ULL << (i & 63));
+
+    HasDirtySectors = true;
+}
+
+bool FATStorage::AreSectorsDirty(u64 start, u64 num) const
+{
+    u64 end = std::min(start + num, (u64)DirtySectors.size() << 6);
+    for (u64 i = start; i < end; i++)
+    {
+        if (DirtySectors[i >> 6] & (1ULL << (i & 63)))
+            return true;
+    }
+
+    return false;
+}
+
+bool FATStorage::IsFileDirty(const std::string& path)
+{
+    if (!HasDirtySectors) return false;
+
+    FF_FIL file;
+    FRESULT res = f_open(&file, path.c_str(), FA_OPEN_EXISTING | FA_READ);
+    if (res != FR_OK)
+        return true;
+
+    // get the list of cluster runs making up the file
+    std::vector<DWORD> linkmap(64);
+    linkmap[0] = linkmap.size();
+    file.cltbl = linkmap.data();
+    res = f_lseek(&file, CREATE_LINKMAP);
+    if (res == FR_NOT_ENOUGH_CORE)
+    {
+        linkmap.resize(linkmap[0]);
+        linkmap[0] = linkmap.size();
+        file.cltbl = linkmap.data();
+        res = f_lseek(&file, CREATE_LINKMAP);
+    }
+
+    bool dirty = false;
+    if (res != FR_OK)
+        dirty = true;
+    else
+    {
+        FATFS* fs = file.obj.fs;
+        for (u32 i = 1; linkmap[i]; i += 2)
+        {
+            u64 sector = fs->database + ((u64)fs->csize * (linkmap[i+1] - 2));
+            if (AreSectorsDirty(sector, (u64)fs->csize * linkmap[i]))
+            {
+                dirty = true;
+                break;
+            }
+        }
+    }
+
+    f_close(&file);
+    return dirty;
+}
+
+
 void FATStorage::LoadIndex()
 {
     DirIndex.clear();
     FileIndex.clear();
 
+    if (!LoadBinaryIndex())
+        LoadTextIndex();
+
+    // ensure the indexes are sane
+
+    std::vector<std::string> removelist;
+
+    for (const auto& [key, val] : DirIndex)
+    {
+        std::string path = val.Path;
+
+        if ((path.find("/./") != std::string::npos) ||
+            (path.find("/../") != std::string::npos) ||
+            (path.substr(0,2) == "./") ||
+            (path.substr(0,3) == "../"))
+        {
+            removelist.push_back(key);
+            continue;
+        }
+
+        int sep = path.rfind('/');
+        if (sep == std::string::npos) continue;
+
+        path = path.substr(0, sep);
+        if (DirIndex.count(path) < 1)
+        {
+            removelist.push_back(key);
+        }
+    }
+
+    for (const auto& key : removelist)
+    {
+        DirIndex.erase(key);
+    }
+
+    removelist.clear();
+
+    for (const auto& [key, val] : FileIndex)
+    {
+        std::string path = val.Path;
+
+        if ((path.find("/./") != std::string::npos) ||
+            (path.find("/../") != std::string::npos) ||
+            (path.substr(0,2) == "./") ||
+            (path.substr(0,3) == "../"))
+        {
+            removelist.push_back(key);
+            continue;
+        }
+
+        int sep = path.rfind('/');
+        if (sep == std::string::npos) continue;
+
+        path = path.substr(0, sep);
+        if (DirIndex.count(path) < 1)
+        {
+            removelist.push_back(key);
+        }
+    }
+
+    for (const auto& key : removelist)
+    {
+        FileIndex.erase(key);
+    }
+}
+
+// binary index format:
+// * 'MFSI' magic, version (u32), volume size (u64), directory and file counts (u32)
+// * directories: read-only flag (u8), path length (u16), path
+// * files: read-only flag (u8), size (u64), host last-modified time (s64),
+//   internal last-modified time (u32), XXH3 hash (u64), path length (u16), path
+constexpr u32 IndexMagic = 0x4953464D;
+constexpr u32 IndexVersion = 1;
+
+bool FATStorage::LoadBinaryIndex()
+{
+    FileHandle* f = OpenLocalFile(IndexPath, FileMode::Read);
+    if (!f) return false;
+
+    std::vector<u8> data(FileLength(f));
+    bool ok = data.size() >= 24 && FileRead(data.data(), data.size(), 1, f) == 1;
+    CloseFile(f);
+
+    if (!ok) return false;
+    if (*(u32*)&data[0] != IndexMagic) return false;
+    if (*(u32*)&data[4] != IndexVersion) return false;
+
+    u32 pos = 8;
+    auto read = [&](void* out, u32 len) -> bool
+    {
+        if ((pos + len) > data.size()) return false;
+        memcpy(out, &data[pos], len);
+        pos += len;
+        return true;
+    };
+    auto readpath = [&](std::string& out) -> bool
+    {
+        u16 len;
+        if (!read(&len, 2)) return false;
+        if ((pos + len) > data.size()) return false;
+        out.assign((const char*)&data[pos], len);
+        pos += len;
+        return true;
+    };
+
+    u64 fsize;
+    u32 numdirs, numfiles;
+    if (!read(&fsize, 8) ||
+        !read(&numdirs, 4) ||
+        !read(&numfiles, 4))
+        return false;
+
+    FileSize = fsize;
+
+    for (u32 i = 0; i < numdirs; i++)
+    {
+        DirIndexEntry entry;
+        u8 readonly;
+        if (!read(&readonly, 1) || !readpath(entry.Path))
+            break;
+
+        entry.IsReadOnly = readonly != 0;
+        DirIndex[entry.Path] = entry;
+    }
+
+    for (u32 i = 0; i < numfiles; i++)
+    {
+        FileIndexEntry entry;
+        u8 readonly;
+        if (!read(&readonly, 1) ||
+            !read(&entry.Size, 8) ||
+            !read(&entry.LastModified, 8) ||
+            !read(&entry.LastModifiedInternal, 4) ||
+            !read(&entry.Hash, 8) ||
+            !readpath(entry.Path))
+            break;
+
+        entry.IsReadOnly = readonly != 0;
+        FileIndex[entry.Path] = entry;
+    }
+
+    return true;
+}
+
+void FATStorage::LoadTextIndex()
+{
+    // text index, as written by older versions
+
     FileHandle* f = OpenLocalFile(IndexPath, FileMode::ReadText);
     if (!f) return;
 
@@ -319,100 +550,110 @@ void FATStorage::LoadIndex()
             entry.Size = fsize;
             entry.LastModified = lastmodified;
             entry.LastModifiedInternal = lastmod_internal;
+            entry.Hash = 0;
 
             FileIndex[entry.Path] = entry;
         }
     }
 
     CloseFile(f);
+}
 
-    // ensure the indexes are sane
-
-    std::vector<std::string> removelist;
+void FATStorage::SaveIndex()
+{
+    FileHandle* f = OpenLocalFile(IndexPath, FileMode::Write);
+    if (!f) return;
 
-    for (const auto& [key, val] : DirIndex)
+    std::vector<u8> data;
+    auto write = [&](const void* in, u32 len)
     {
-        std::string path = val.Path;
-
-        if ((path.find("/./") != std::string::npos) ||
-            (path.find("/../") != std::string::npos) ||
-            (path.substr(0,2) == "./") ||
-            (path.substr(0,3) == "../"))
-        {
-            removelist.push_back(key);
-            continue;
-        }
-
-        int sep = path.rfind('/');
-        if (sep == std::string::npos) continue;
+        data.insert(data.end(), (const u8*)in, (const u8*)in + len);
+    };
+    auto writepath = [&](const std::string& path)
+    {
+        u16 len = (u16)std::min<size_t>(path.length(), 0xFFFF);
+        write(&len, 2);
+        write(path.data(), len);
+    };
 
-        path = path.substr(0, sep);
-        if (DirIndex.count(path) < 1)
-        {
-            removelist.push_back(key);
-        }
-    }
+    u32 numdirs = DirIndex.size();
+    u32 numfiles = FileIndex.size();
+    write(&IndexMagic, 4);
+    write(&IndexVersion, 4);
+    write(&FileSize, 8);
+    write(&numdirs, 4);
+    write(&numfiles, 4);
 
-    for (const auto& key : removelist)
+    for (const auto& [key, val] : DirIndex)
     {
-        DirIndex.erase(key);
+        u8 readonly = val.IsReadOnly ? 1 : 0;
+        write(&readonly, 1);
+        writepath(val.Path);
     }
 
-    removelist.clear();
-
     for (const auto& [key, val] : FileIndex)
     {
-        std::string path = val.Path;
+        u8 readonly = val.IsReadOnly ? 1 : 0;
+        write(&readonly, 1);
+        write(&val.Size, 8);
+        write(&val.LastModified, 8);
+        write(&val.LastModifiedInternal, 4);
+        write(&val.Hash, 8);
+        writepath(val.Path);
+    }
 
-        if ((path.find("/./") != std::string::npos) ||
-            (path.find("/../") != std::string::npos) ||
-            (path.substr(0,2) == "./") ||
-            (path.substr(0,3) == "../"))
-        {
-            removelist.push_back(key);
-            continue;
-        }
+    FileWrite(data.data(), data.size(), 1, f);
+    CloseFile(f);
+}
 
-        int sep = path.rfind('/');
-        if (sep == std::string::npos) continue;
 
-        path = path.substr(0, sep);
-        if (DirIndex.count(path) < 1)
-        {
-            removelist.push_back(key);
-        }
-    }
+u64 FATStorage::HashHostFile(fs::path in)
+{
+    FileHandle* fin = Platform::OpenFile(in.u8string(), FileMode::Read);
+    if (!fin)
+        return 0;
 
-    for (const auto& key : removelist)
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+
+    u64 len = FileLength(fin);
+    u8 buf[0x4000];
+    for (u64 i = 0; i < len; i += sizeof(buf))
     {
-        FileIndex.erase(key);
+        u32 blocklen = (u32)std::min<u64>(len - i, sizeof(buf));
+        if (!FileRead(buf, blocklen, 1, fin)) break;
+        XXH3_64bits_update(&state, buf, blocklen);
     }
+
+    CloseFile(fin);
+    return XXH3_64bits_digest(&state);
 }
 
-void FATStorage::SaveIndex()
+u64 FATStorage::HashVolumeFile(const std::string& path)
 {
-    FileHandle* f = OpenLocalFile(IndexPath, FileMode::WriteText);
-    if (!f) return;
-
-    FileWriteFormatted(f, "SIZE %" PRIu64 "\n", FileSize);
+    FF_FIL file;
+    if (f_open(&file, path.c_str(), FA_OPEN_EXISTING | FA_READ) != FR_OK)
+        return 0;
 
-    for (const auto& [key, val] : DirIndex)
-    {
-        FileWriteFormatted(f, "DIR %u %s\n",
-                val.IsReadOnly?1:0, val.Path.c_str());
-    }
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
 
-    for (const auto& [key, val] : FileIndex)
+    u32 len = f_size(&file);
+    u8 buf[0x4000];
+    for (u32 i = 0; i < len; i += sizeof(buf))
     {
-        FileWriteFormatted(f, "FILE %u %" PRIu64 " %" PRId64 " %u %s\n",
-                val.IsReadOnly?1:0, val.Size, val.LastModified, val.LastModifiedInternal, val.Path.c_str());
+        u32 blocklen = std::min<u32>(len - i, sizeof(buf));
+        u32 nread;
+        f_read(&file, buf, blocklen, &nread);
+        XXH3_64bits_update(&state, buf, blocklen);
     }
 
-    CloseFile(f);
+    f_close(&file);
+    return XXH3_64bits_digest(&state);
 }
 
 
-bool FATStorage::ExportFile(const std::string& path, fs::path out)
+bool FATStorage::ExportFile(const std::string& path, fs::path out, u64& hash)
 {
     FF_FIL file;
     FileHandle* fout;
@@ -440,6 +681,9 @@ bool FATStorage::ExportFile(const std::string& path, fs::path out)
         return false;
     }
 
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+
     u8 buf[0x1000];
     for (u32 i = 0; i < len; i += 0x1000)
     {
@@ -452,15 +696,18 @@ bool FATStorage::ExportFile(const std::string& path, fs::path out)
         u32 nread;
         f_read(&file, buf, blocklen, &nread);
         FileWrite(buf, blocklen, 1, fout);
+        XXH3_64bits_update(&state, buf, blocklen);
     }
 
     CloseFile(fout);
     f_close(&file);
 
+    hash = XXH3_64bits_digest(&state);
+
     return true;
 }
 
-void FATStorage::ExportDirectory(const std::string& path, const std::string& outbase, int level)
+void FATStorage::ScanVolume(const std::string& path, int level, std::map<std::string, VolumeEntry>& out)
 {
     if (level >= 32) return;
 
@@ -481,81 +728,23 @@ void FATStorage::ExportDirectory(const std::string& path, const std::string& out
         if (!info.fname[0]) break;
 
         std::string fullpath = path + info.fname;
-        fs::path outpath = fs::u8path(outbase + "/" + fullpath);
 
-        if (info.fattrib & AM_DIR)
-        {
-            if (DirIndex.count(fullpath) < 1)
-            {
-                std::error_code err;
-                fs::create_directory(outpath, err);
-
-                DirIndexEntry entry;
-                entry.Path = fullpath;
-                entry.IsReadOnly = (info.fattrib & AM_RDO) != 0;
-
-                DirIndex[entry.Path] = entry;
-            }
+        VolumeEntry entry;
+        entry.IsDirectory = (info.fattrib & AM_DIR) != 0;
+        entry.IsReadOnly = (info.fattrib & AM_RDO) != 0;
+        entry.Size = info.fsize;
+        entry.LastModifiedInternal = (info.fdate << 16) | info.ftime;
+        out[fullpath] = entry;
 
+        if (entry.IsDirectory)
             subdirlist.push_back(fullpath);
-        }
-        else
-        {
-            bool doexport = false;
-
-            if (FileIndex.count(fullpath) < 1)
-            {
-                doexport = true;
-
-                FileIndexEntry entry;
-                entry.Path = fullpath;
-                entry.IsReadOnly = (info.fattrib & AM_RDO) != 0;
-                entry.Size = info.fsize;
-                entry.LastModifiedInternal = (info.fdate << 16) | info.ftime;
-
-                FileIndex[entry.Path] = entry;
-            }
-            else
-            {
-                u32 lastmod = (info.fdate << 16) | info.ftime;
-
-                FileIndexEntry& entry = FileIndex[fullpath];
-                if ((info.fsize != entry.Size) || (lastmod != entry.LastModifiedInternal))
-                    doexport = true;
-
-                entry.Size = info.fsize;
-                entry.LastModifiedInternal = lastmod;
-            }
-
-            if (doexport)
-            {
-                if (ExportFile("0:/"+fullpath, outpath))
-                {
-                    fs::file_time_type modtime = fs::last_write_time(outpath);
-                    s64 modtime_raw = std::chrono::duration_cast<std::chrono::seconds>(modtime.time_since_epoch()).count();
-
-                    FileIndexEntry& entry = FileIndex[fullpath];
-                    entry.LastModified = modtime_raw;
-                }
-                else
-                {
-                    // ??????
-                }
-            }
-        }
-
-        std::error_code err;
-        fs::permissions(outpath,
-                        fs::perms::owner_read | fs::perms::owner_write,
-                        (info.fattrib & AM_RDO) ? fs::perm_options::remove : fs::perm_options::add,
-                        err);
     }
 
     f_closedir(&dir);
 
     for (auto& entry : subdirlist)
     {
-        ExportDirectory(entry+"/", outbase, level+1);
+        ScanVolume(entry+"/", level+1, out);
     }
 }
 
@@ -637,28 +826,21 @@ void FATStorage::ExportChanges(const std::string& outbase)
     // reflect changes in the FAT volume to the host filesystem
     // * delete directories and files that exist in the index but not in the volume
     // * copy files to the host FS if they exist within the index and their size or
-    //   internal last-modified time is different
+    //   internal last-modified time is different, or if their contents were written
+    //   to and their hash is different
     // * index and copy directories and files that exist in the volume but not in
     //   the index
 
+    std::map<std::string, VolumeEntry> volume;
+    ScanVolume("", 0, volume);
+
     std::vector<std::string> deletelist;
 
     for (const auto& [key, val] : FileIndex)
     {
-        std::string innerpath = "0:/" + val.Path;
-        FF_FILINFO finfo;
-        FRESULT res = f_stat(innerpath.c_str(), &finfo);
-        if (res == FR_OK)
-        {
-            if (finfo.fattrib & AM_DIR)
-            {
-                deletelist.push_back(key);
-            }
-        }
-        else if (res == FR_NO_FILE || res == FR_NO_PATH)
-        {
+        auto it = volume.find(key);
+        if (it == volume.end() || it->second.IsDirectory)
             deletelist.push_back(key);
-        }
     }
 
     for (const auto& key : deletelist)
@@ -679,20 +861,9 @@ void FATStorage::ExportChanges(const std::string& outbase)
 
     for (const auto& [key, val] : DirIndex)
     {
-        std::string innerpath = "0:/" + val.Path;
-        FF_FILINFO finfo;
-        FRESULT res = f_stat(innerpath.c_str(), &finfo);
-        if (res == FR_OK)
-        {
-            if (!(finfo.fattrib & AM_DIR))
-            {
-                deletelist.push_back(key);
-            }
-        }
-        else if (res == FR_NO_FILE || res == FR_NO_PATH)
-        {
+        auto it = volume.find(key);
+        if (it == volume.end() || !it->second.IsDirectory)
             deletelist.push_back(key);
-        }
     }
 
     for (const auto& key : deletelist)
@@ -700,7 +871,95 @@ void FATStorage::ExportChanges(const std::string& outbase)
         DeleteHostDirectory(key, outbase, 0);
     }
 
-    ExportDirectory("", outbase, 0);
+    // parent directories come before their contents, since the map is sorted
+    for (const auto& [path, val] : volume)
+    {
+        fs::path outpath = fs::u8path(outbase + "/" + path);
+        bool attrchanged = false;
+
+        if (val.IsDirectory)
+        {
+            auto it = DirIndex.find(path);
+            if (it == DirIndex.end())
+            {
+                std::error_code err;
+                fs::create_directory(outpath, err);
+
+                DirIndexEntry entry;
+                entry.Path = path;
+                entry.IsReadOnly = val.IsReadOnly;
+
+                DirIndex[entry.Path] = entry;
+                attrchanged = true;
+            }
+            else
+            {
+                attrchanged = it->second.IsReadOnly != val.IsReadOnly;
+                it->second.IsReadOnly = val.IsReadOnly;
+            }
+        }
+        else
+        {
+            bool doexport = false;
+            std::string innerpath = "0:/" + path;
+
+            auto it = FileIndex.find(path);
+            if (it == FileIndex.end())
+            {
+                doexport = true;
+
+                FileIndexEntry entry;
+                entry.Path = path;
+                entry.LastModified = 0;
+                entry.Hash = 0;
+                it = FileIndex.emplace(path, entry).first;
+                attrchanged = true;
+            }
+            else
+            {
+                FileIndexEntry& entry = it->second;
+                if ((val.Size != entry.Size) || (val.LastModifiedInternal != entry.LastModifiedInternal))
+                    doexport = true;
+                else if (IsFileDirty(innerpath))
+                {
+                    // written to in place, without its size or date changing
+                    doexport = (entry.Hash == 0) || (HashVolumeFile(innerpath) != entry.Hash);
+                }
+
+                attrchanged = entry.IsReadOnly != val.IsReadOnly;
+            }
+
+            FileIndexEntry& entry = it->second;
+            entry.IsReadOnly = val.IsReadOnly;
+            entry.Size = val.Size;
+            entry.LastModifiedInternal = val.LastModifiedInternal;
+
+            if (doexport)
+            {
+                if (ExportFile(innerpath, outpath, entry.Hash))
+                {
+                    fs::file_time_type modtime = fs::last_write_time(outpath);
+                    s64 modtime_raw = std::chrono::duration_cast<std::chrono::seconds>(modtime.time_since_epoch()).count();
+
+                    entry.LastModified = modtime_raw;
+                    attrchanged = true;
+                }
+                else
+                {
+                    // ??????
+                }
+            }
+        }
+
+        if (attrchanged)
+        {
+            std::error_code err;
+            fs::permissions(outpath,
+                            fs::perms::owner_read | fs::perms::owner_write,
+                            val.IsReadOnly ? fs::perm_options::remove : fs::perm_options::add,
+                            err);
+        }
+    }
 }
 
 
@@ -845,7 +1104,7 @@ void FATStorage::CleanupDirectory(const std::string& sourcedir, const std::strin
     }
 }
 
-bool FATStorage::ImportFile(const std::string& path, fs::path in)
+bool FATStorage::ImportFile(const std::string& path, fs::path in, u64& hash)
 {
     FF_FIL file;
     FileHandle* fin;
@@ -870,6 +1129,9 @@ bool FATStorage::ImportFile(const std::string& path, fs::path in)
         return false;
     }
 
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+
     u8 buf[0x1000];
     for (u32 i = 0; i < len; i += 0x1000)
     {
@@ -882,11 +1144,14 @@ bool FATStorage::ImportFile(const std::string& path, fs::path in)
         u32 nwrite;
         FileRead(buf, blocklen, 1, fin);
         f_write(&file, buf, blocklen, &nwrite);
+        XXH3_64bits_update(&state, buf, blocklen);
     }
 
     CloseFile(fin);
     f_close(&file);
 
+    hash = XXH3_64bits_digest(&state);
+
     return true;
 }
 
@@ -948,7 +1213,14 @@ bool FATStorage::ImportDirectory(const std::string& sourcedir)
             {
                 FileIndexEntry& chk = FileIndex[innerpath];
                 if (chk.Size != filesize) import = true;
-                if (chk.LastModified != lastmodified_raw) import = true;
+                else if (chk.LastModified != lastmodified_raw)
+                {
+                    // the file may only have been touched (copied over again, checked out...)
+                    if ((chk.Hash == 0) || (HashHostFile(entry.path()) != chk.Hash))
+                        import = true;
+                    else
+                        chk.LastModified = lastmodified_raw;
+                }
             }
 
             if (import)
@@ -960,7 +1232,7 @@ bool FATStorage::ImportDirectory(const std::string& sourcedir)
                 ientry.LastModified = lastmodified_raw;
 
                 innerpath = "0:/" + innerpath;
-                if (ImportFile(innerpath, entry.path()))
+                if (ImportFile(innerpath, entry.path(), ientry.Hash))
                 {
                     FF_FILINFO finfo;
                     f_stat(innerpath.c_str(), &finfo);
@@ -1128,6 +1400,10 @@ bool FATStorage::Load(const std::string& filename, u64 size, const std::optional
 
     ff_disk_close();
 
+    // the volume is now in sync with the source directory
+    DirtySectors.clear();
+    HasDirtySectors = false;
+
     return true;
 }
 
@@ -1138,6 +1414,11 @@ bool FATStorage::Save()
         return true; // Not an error.
     }
 
+    if (!HasDirtySectors)
+    { // Nothing was written to the volume since it was last synced
+        return true;
+    }
+
     ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)(FileSize>>9));
 
     FRESULT res;
@@ -1159,6 +1440,9 @@ bool FATStorage::Save()
 
     ff_disk_close();
 
+    DirtySectors.clear();
+    HasDirtySectors = false;
+
     return true;
 }
 
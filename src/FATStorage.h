@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string>
 #include <map>
+#include <vector>
 #include <optional>
 #include <filesystem>
 
@@ -59,7 +60,7 @@ public:
     FATStorage& operator=(FATStorage&& other) noexcept;
     ~FATStorage();
 
-    bool InjectFile(const std::string& path, u8* data, u32 len);
+    bool InjectFile(const std::string& path, const u8* data, u32 len);
     u32 ReadFile(const std::string& path, u32 start, u32 len, u8* data);
 
     u32 ReadSectors(u32 start, u32 num, u8* data) const;
@@ -78,23 +79,31 @@ private:
     u64 FileSize;
 
     [[nodiscard]] ff_disk_read_cb FF_ReadStorage() const noexcept;
-    [[nodiscard]] ff_disk_write_cb FF_WriteStorage() const noexcept;
+    [[nodiscard]] ff_disk_write_cb FF_WriteStorage() noexcept;
 
     static u32 ReadSectorsInternal(Platform::FileHandle* file, u64 filelen, u32 start, u32 num, u8* data);
     static u32 WriteSectorsInternal(Platform::FileHandle* file, u64 filelen, u32 start, u32 num, const u8* data);
 
+    void MarkDirtySectors(u32 start, u32 num);
+    bool AreSectorsDirty(u64 start, u64 num) const;
+    bool IsFileDirty(const std::string& path);
+
     void LoadIndex();
+    bool LoadBinaryIndex();
+    void LoadTextIndex();
     void SaveIndex();
 
-    bool ExportFile(const std::string& path, std::filesystem::path out);
-    void ExportDirectory(const std::string& path, const std::string& outbase, int level);
+    static u64 HashHostFile(std::filesystem::path in);
+    u64 HashVolumeFile(const std::string& path);
+
+    bool ExportFile(const std::string& path, std::filesystem::path out, u64& hash);
     bool DeleteHostDirectory(const std::string& path, const std::string& outbase, int level);
     void ExportChanges(const std::string& outbase);
 
     bool CanFitFile(u32 len);
     bool DeleteDirectory(const std::string& path, int level);
     void CleanupDirectory(const std::string& sourcedir, const std::string& path, int level);
-    bool ImportFile(const std::string& path, std::filesystem::path in);
+    bool ImportFile(const std::string& path, std::filesystem::path in, u64& hash);
     bool ImportDirectory(const std::string& sourcedir);
     u64 GetDirectorySize(std::filesystem::path sourcedir) const;
 
@@ -115,11 +124,28 @@ private:
         u64 Size;
         s64 LastModified;
         u32 LastModifiedInternal;
+        u64 Hash; // XXH3 of the contents, 0 if unknown
 
     } FileIndexEntry;
 
+    typedef struct
+    {
+        bool IsDirectory;
+        bool IsReadOnly;
+        u64 Size;
+        u32 LastModifiedInternal;
+
+    } VolumeEntry;
+
+    void ScanVolume(const std::string& path, int level, std::map<std::string, VolumeEntry>& out);
+
     std::map<std::string, DirIndexEntry> DirIndex;
     std::map<std::string, FileIndexEntry> FileIndex;
+
+    // sectors written since the volume was last synced with the source directory,
+    // one bit per sector. Only used when syncing with a source directory.
+    std::vector<u64> DirtySectors;
+    bool HasDirtySectors = false;
 };
 
 }
@@ -100,7 +100,7 @@ CartGame::CartGame(const u8* rom, u32 len, const u8* sram, u32 sramlen, void* us
 {
 }
 
-CartGame::CartGame(std::unique_ptr<u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, GBACart::CartType type) :
+CartGame::CartGame(std::shared_ptr<const u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, GBACart::CartType type) :
     CartCommon(type),
     ROM(std::move(rom)),
     ROMLength(len),
@@ -534,7 +534,7 @@ CartGameSolarSensor::CartGameSolarSensor(const u8* rom, u32 len, const u8* sram,
 {
 }
 
-CartGameSolarSensor::CartGameSolarSensor(std::unique_ptr<u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
+CartGameSolarSensor::CartGameSolarSensor(std::shared_ptr<const u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
     CartGame(std::move(rom), len, std::move(sram), sramlen, userdata, CartType::GameSolarSensor)
 {
 }
@@ -779,6 +779,8 @@ std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, void* userda
     return ParseROM(romdata, romlen, nullptr, 0, userdata);
 }
 
+static std::unique_ptr<CartCommon> CreateCart(std::shared_ptr<const u8[]>&& cartrom, u32 cartromsize, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata);
+
 std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata)
 {
     if (romdata == nullptr)
@@ -794,7 +796,32 @@ std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen
     }
 
     auto [cartrom, cartromsize] = PadToPowerOf2(std::move(romdata), romlen);
+    return CreateCart(std::move(cartrom), cartromsize, std::move(sramdata), sramlen, userdata);
+}
+
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata)
+{
+    if (romdata == nullptr)
+    {
+        Log(LogLevel::Error, "GBACart: romdata is null\n");
+        return nullptr;
+    }
 
+    if (romlen == 0)
+    {
+        Log(LogLevel::Error, "GBACart: romlen is zero\n");
+        return nullptr;
+    }
+
+    if ((romlen & (romlen - 1)) == 0)
+        return CreateCart(std::move(romdata), romlen, std::move(sramdata), sramlen, userdata);
+
+    auto [cartrom, cartromsize] = PadToPowerOf2(romdata.get(), romlen);
+    return CreateCart(std::move(cartrom), cartromsize, std::move(sramdata), sramlen, userdata);
+}
+
+static std::unique_ptr<CartCommon> CreateCart(std::shared_ptr<const u8[]>&& cartrom, u32 cartromsize, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata)
+{
     char gamecode[5] = { '\0' };
     memcpy(&gamecode, cartrom.get() + 0xAC, 4);
 
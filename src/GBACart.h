@@ -59,6 +59,10 @@ public:
     [[nodiscard]] virtual const u8* GetROM() const { return nullptr; }
     [[nodiscard]] virtual u32 GetROMLength() const { return 0; }
 
+    /// @return The cart's ROM data, for passing to ParseROM
+    /// to create more carts that share it, or \c nullptr if the cart has no ROM.
+    [[nodiscard]] virtual std::shared_ptr<const u8[]> GetSharedROM() const { return nullptr; }
+
     virtual u8* GetSaveMemory() const;
     virtual u32 GetSaveMemoryLength() const;
     virtual void SetSaveMemory(const u8* savedata, u32 savelen);
@@ -74,7 +78,7 @@ class CartGame : public CartCommon
 {
 public:
     CartGame(const u8* rom, u32 len, const u8* sram, u32 sramlen, void* userdata, GBACart::CartType type = GBACart::CartType::Game);
-    CartGame(std::unique_ptr<u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, GBACart::CartType type = GBACart::CartType::Game);
+    CartGame(std::shared_ptr<const u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, GBACart::CartType type = GBACart::CartType::Game);
     ~CartGame() override;
 
     u32 Checksum() const override;
@@ -91,6 +95,7 @@ public:
 
     [[nodiscard]] const u8* GetROM() const override { return ROM.get(); }
     [[nodiscard]] u32 GetROMLength() const override { return ROMLength; }
+    [[nodiscard]] std::shared_ptr<const u8[]> GetSharedROM() const override { return ROM; }
 
     u8* GetSaveMemory() const override;
     u32 GetSaveMemoryLength() const override;
@@ -107,7 +112,8 @@ protected:
 
     void* UserData;
 
-    std::unique_ptr<u8[]> ROM;
+    // may be shared between multiple carts, never modified
+    std::shared_ptr<const u8[]> ROM;
     u32 ROMLength;
 
     struct
@@ -151,7 +157,7 @@ class CartGameSolarSensor : public CartGame
 {
 public:
     CartGameSolarSensor(const u8* rom, u32 len, const u8* sram, u32 sramlen, void* userdata);
-    CartGameSolarSensor(std::unique_ptr<u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartGameSolarSensor(std::shared_ptr<const u8[]>&& rom, u32 len, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
 
     void Reset() override;
 
@@ -307,6 +313,11 @@ std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, const u8* sr
 /// or \c nullptr if there was an error.
 std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata = nullptr);
 
+/// Like the above, but the returned cart shares \c romdata
+/// with any other carts created from it instead of holding its own copy.
+/// If \c romlen is not a power of two, a padded copy is made instead.
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, std::unique_ptr<u8[]>&& sramdata, u32 sramlen, void* userdata = nullptr);
+
 }
 
 #endif // GBACART_H
@@ -20,6 +20,14 @@
 #include "NDS.h"
 #include "GPU.h"
 
+#if defined(__SSE2__)
+#define GPU_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#define GPU_NEON
+#include <arm_neon.h>
+#endif
+
 #include "ARMJIT.h"
 
 #include "GPU2D_Soft.h"
@@ -189,6 +197,7 @@ void GPU::Reset() noexcept
 
     int backbuf = FrontBuffer ? 0 : 1;
     GPU2D_Renderer->SetFramebuffer(Framebuffer[backbuf][1].get(), Framebuffer[backbuf][0].get());
+    GPU2D_Renderer->ResetLineCache();
 
     ResetVRAMCache();
 
@@ -208,6 +217,7 @@ void GPU::Stop() noexcept
     memset(Framebuffer[0][1].get(), 0, fbsize*4);
     memset(Framebuffer[1][0].get(), 0, fbsize*4);
     memset(Framebuffer[1][1].get(), 0, fbsize*4);
+    GPU2D_Renderer->ResetLineCache();
 
     GPU3D.Stop(*this);
 }
@@ -276,7 +286,12 @@ void GPU::DoSavestate(Savestate* file) noexcept
     GPU3D.DoSavestate(file);
 
     if (!file->Saving)
+    {
         ResetVRAMCache();
+        OAMDirty = 0x3;
+        PaletteDirty = 0xF;
+        GPU2D_Renderer->ResetLineCache();
+    }
 }
 
 void GPU::AssignFramebuffers() noexcept
@@ -321,6 +336,7 @@ void GPU::InitFramebuffers() noexcept
     memset(Framebuffer[1][1].get(), 0, fbsize*4);
 
     AssignFramebuffers();
+    GPU2D_Renderer->ResetLineCache();
 }
 
 
@@ -942,6 +958,7 @@ void GPU::BlankFrame() noexcept
 
     memset(Framebuffer[backbuf][0].get(), 0, fbsize*4);
     memset(Framebuffer[backbuf][1].get(), 0, fbsize*4);
+    GPU2D_Renderer->ResetLineCache();
 
     FrontBuffer = backbuf;
     AssignFramebuffers();
@@ -1141,48 +1158,112 @@ template NonStupidBitField<512*1024/VRAMDirtyGranularity> VRAMTrackingSet<512*10
 
 
 
+// ORs len bytes of src into dst. len is a multiple of VRAMDirtyGranularity.
+static void OrVRAMBlock(u8* dst, const u8* src, u32 len) noexcept
+{
+#if defined(GPU_SSE2)
+    for (u32 i = 0; i < len; i += 64)
+    {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)&dst[i]);
+        __m128i a1 = _mm_loadu_si128((const __m128i*)&dst[i+16]);
+        __m128i a2 = _mm_loadu_si128((const __m128i*)&dst[i+32]);
+        __m128i a3 = _mm_loadu_si128((const __m128i*)&dst[i+48]);
+        __m128i b0 = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)&src[i+16]);
+        __m128i b2 = _mm_loadu_si128((const __m128i*)&src[i+32]);
+        __m128i b3 = _mm_loadu_si128((const __m128i*)&src[i+48]);
+        _mm_storeu_si128((__m128i*)&dst[i],    _mm_or_si128(a0, b0));
+        _mm_storeu_si128((__m128i*)&dst[i+16], _mm_or_si128(a1, b1));
+        _mm_storeu_si128((__m128i*)&dst[i+32], _mm_or_si128(a2, b2));
+        _mm_storeu_si128((__m128i*)&dst[i+48], _mm_or_si128(a3, b3));
+    }
+#elif defined(GPU_NEON)
+    for (u32 i = 0; i < len; i += 64)
+    {
+        uint8x16_t a0 = vld1q_u8(&dst[i]);
+        uint8x16_t a1 = vld1q_u8(&dst[i+16]);
+        uint8x16_t a2 = vld1q_u8(&dst[i+32]);
+        uint8x16_t a3 = vld1q_u8(&dst[i+48]);
+        vst1q_u8(&dst[i],    vorrq_u8(a0, vld1q_u8(&src[i])));
+        vst1q_u8(&dst[i+16], vorrq_u8(a1, vld1q_u8(&src[i+16])));
+        vst1q_u8(&dst[i+32], vorrq_u8(a2, vld1q_u8(&src[i+32])));
+        vst1q_u8(&dst[i+48], vorrq_u8(a3, vld1q_u8(&src[i+48])));
+    }
+#else
+    for (u32 i = 0; i < len; i += 8)
+    {
+        u64 a, b;
+        memcpy(&a, &dst[i], 8);
+        memcpy(&b, &src[i], 8);
+        a |= b;
+        memcpy(&dst[i], &a, 8);
+    }
+#endif
+}
+
+void GPU::FlattenVRAMBlock(u8* dst, u32 mask, u32 offset, u32 len) const noexcept
+{
+    if (!mask)
+    {
+        // unmapped VRAM reads as zero
+        memset(dst, 0, len);
+        return;
+    }
+
+    u32 num = __builtin_ctz(mask);
+    memcpy(dst, &VRAM[num][offset & VRAMMask[num]], len);
+    mask &= ~(1 << num);
+
+    while (mask)
+    {
+        num = __builtin_ctz(mask);
+        mask &= ~(1 << num);
+        OrVRAMBlock(dst, &VRAM[num][offset & VRAMMask[num]], len);
+    }
+}
+
 bool GPU::MakeVRAMFlat_TextureCoherent(NonStupidBitField<512*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<128*1024>(VRAMFlat_Texture, VRAMMap_Texture, dirty, &GPU::ReadVRAM_Texture<u64>);
+    return CopyLinearVRAM<128*1024>(VRAMFlat_Texture, VRAMMap_Texture, dirty);
 }
 bool GPU::MakeVRAMFlat_TexPalCoherent(NonStupidBitField<128*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_TexPal, VRAMMap_TexPal, dirty, &GPU::ReadVRAM_TexPal<u64>);
+    return CopyLinearVRAM<16*1024>(VRAMFlat_TexPal, VRAMMap_TexPal, dirty);
 }
 
 bool GPU::MakeVRAMFlat_ABGCoherent(NonStupidBitField<512*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_ABG, VRAMMap_ABG, dirty, &GPU::ReadVRAM_ABG<u64>);
+    return CopyLinearVRAM<16*1024>(VRAMFlat_ABG, VRAMMap_ABG, dirty);
 }
 bool GPU::MakeVRAMFlat_BBGCoherent(NonStupidBitField<128*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_BBG, VRAMMap_BBG, dirty, &GPU::ReadVRAM_BBG<u64>);
+    return CopyLinearVRAM<16*1024>(VRAMFlat_BBG, VRAMMap_BBG, dirty);
 }
 
 bool GPU::MakeVRAMFlat_AOBJCoherent(NonStupidBitField<256*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_AOBJ, VRAMMap_AOBJ, dirty, &GPU::ReadVRAM_AOBJ<u64>);
+    return CopyLinearVRAM<16*1024>(VRAMFlat_AOBJ, VRAMMap_AOBJ, dirty);
 }
 bool GPU::MakeVRAMFlat_BOBJCoherent(NonStupidBitField<128*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_BOBJ, VRAMMap_BOBJ, dirty, &GPU::ReadVRAM_BOBJ<u64>);
+    return CopyLinearVRAM<16*1024>(VRAMFlat_BOBJ, VRAMMap_BOBJ, dirty);
 }
 
 bool GPU::MakeVRAMFlat_ABGExtPalCoherent(NonStupidBitField<32*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<8*1024>(VRAMFlat_ABGExtPal, VRAMMap_ABGExtPal, dirty, &GPU::ReadVRAM_ABGExtPal<u64>);
+    return CopyLinearVRAM<8*1024>(VRAMFlat_ABGExtPal, VRAMMap_ABGExtPal, dirty);
 }
 bool GPU::MakeVRAMFlat_BBGExtPalCoherent(NonStupidBitField<32*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<8*1024>(VRAMFlat_BBGExtPal, VRAMMap_BBGExtPal, dirty, &GPU::ReadVRAM_BBGExtPal<u64>);
+    return CopyLinearVRAM<8*1024>(VRAMFlat_BBGExtPal, VRAMMap_BBGExtPal, dirty);
 }
 
 bool GPU::MakeVRAMFlat_AOBJExtPalCoherent(NonStupidBitField<8*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<8*1024>(VRAMFlat_AOBJExtPal, &VRAMMap_AOBJExtPal, dirty, &GPU::ReadVRAM_AOBJExtPal<u64>);
+    return CopyLinearVRAM<8*1024>(VRAMFlat_AOBJExtPal, &VRAMMap_AOBJExtPal, dirty);
 }
 bool GPU::MakeVRAMFlat_BOBJExtPalCoherent(NonStupidBitField<8*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<8*1024>(VRAMFlat_BOBJExtPal, &VRAMMap_BOBJExtPal, dirty, &GPU::ReadVRAM_BOBJExtPal<u64>);
+    return CopyLinearVRAM<8*1024>(VRAMFlat_BOBJExtPal, &VRAMMap_BOBJExtPal, dirty);
 }
 }
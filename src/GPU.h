@@ -499,6 +499,23 @@ public:
         OAMDirty |= 1 << (addr / 1024);
     }
 
+    /// Checks whether the OAM of the given engine changed since the last call.
+    bool CheckOAMDirty(u32 num) noexcept
+    {
+        bool dirty = OAMDirty & (1 << num);
+        OAMDirty &= ~(1 << num);
+        return dirty;
+    }
+
+    /// Checks whether the BG or OBJ palette of the given engine changed since the last call.
+    bool CheckPaletteDirty(u32 num) noexcept
+    {
+        u32 mask = 0x3 << (num * 2);
+        bool dirty = PaletteDirty & mask;
+        PaletteDirty &= ~mask;
+        return dirty;
+    }
+
     void SetPowerCnt(u32 val) noexcept;
 
     void StartFrame() noexcept;
@@ -638,8 +655,8 @@ private:
         u32 mask = VRAMMap_AOBJExtPal;
 
         T ret = 0;
-        if (mask & (1<<4)) ret |= *(T*)&VRAM_F[addr & 0x1FFF];
-        if (mask & (1<<5)) ret |= *(T*)&VRAM_G[addr & 0x1FFF];
+        if (mask & (1<<5)) ret |= *(T*)&VRAM_F[addr & 0x1FFF];
+        if (mask & (1<<6)) ret |= *(T*)&VRAM_G[addr & 0x1FFF];
 
         return ret;
     }
@@ -655,31 +672,54 @@ private:
         return ret;
     }
 
+    // fills len bytes of a flat VRAM copy, at the given offset,
+    // from the banks in a mapping mask. Overlapping banks are ORed together.
+    void FlattenVRAMBlock(u8* dst, u32 mask, u32 offset, u32 len) const noexcept;
+
     template <u32 MappingGranularity, u32 Size>
-    constexpr bool CopyLinearVRAM(u8* flat, const u32* mappings, NonStupidBitField<Size>& dirty, u64 (GPU::* const slowAccess)(u32) const noexcept) noexcept
+    bool CopyLinearVRAM(u8* flat, const u32* mappings, NonStupidBitField<Size>& dirty) noexcept
     {
         const u32 VRAMBitsPerMapping = MappingGranularity / VRAMDirtyGranularity;
+        const u32 DataLength = NonStupidBitField<Size>::DataLength;
 
         bool change = false;
 
-        typename NonStupidBitField<Size>::Iterator it = dirty.Begin();
-        while (it != dirty.End())
+        // copy runs of consecutive dirty granules at once, split up
+        // only where they cross into another mapping block
+        u32 i = 0;
+        while (i < Size)
         {
-            u32 offset = *it * VRAMDirtyGranularity;
-            u8* dst = flat + offset;
-            u8* fastAccess = GetUniqueBankPtr(mappings[*it / VRAMBitsPerMapping], offset);
-            if (fastAccess)
+            u32 word = i >> 6;
+            u64 bits = dirty.Data[word] & (~0ULL << (i & 0x3F));
+            if (!bits)
             {
-                memcpy(dst, fastAccess, VRAMDirtyGranularity);
+                i = (word + 1) << 6;
+                continue;
             }
-            else
+
+            u32 start = (word << 6) | __builtin_ctzll(bits);
+            if (start >= Size) break;
+
+            u64 clean = ~dirty.Data[word] & (~0ULL << (start & 0x3F));
+            while (!clean && ++word < DataLength)
+                clean = ~dirty.Data[word];
+
+            u32 end = (word < DataLength) ? ((word << 6) | __builtin_ctzll(clean)) : Size;
+            if (end > Size) end = Size;
+
+            for (u32 g = start; g < end;)
             {
-                for (u32 i = 0; i < VRAMDirtyGranularity; i += 8)
-                    *(u64*)&dst[i] = (this->*slowAccess)(offset + i);
+                u32 blockend = std::min(end, (g / VRAMBitsPerMapping + 1) * VRAMBitsPerMapping);
+                u32 offset = g * VRAMDirtyGranularity;
+
+                FlattenVRAMBlock(flat + offset, mappings[g / VRAMBitsPerMapping], offset, (blockend - g) * VRAMDirtyGranularity);
+                g = blockend;
             }
+
             change = true;
-            it++;
+            i = end;
         }
+
         return change;
     }
 
@@ -141,6 +141,10 @@ public:
         Framebuffer[0] = unitA;
         Framebuffer[1] = unitB;
     }
+
+    /// Forgets any scanlines kept from previous frames.
+    /// Needs to be called whenever the framebuffers are cleared or reallocated.
+    virtual void ResetLineCache() {}
 protected:
     u32* Framebuffer[2];
 
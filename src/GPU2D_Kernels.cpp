@@ -0,0 +1,1096 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include "GPU2D_Kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GPU2D_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+// NEON is always there on AArch64
+#define GPU2D_NEON
+#include <arm_neon.h>
+#endif
+
+namespace melonDS
+{
+namespace GPU2D
+{
+
+// reference implementations
+
+static void Composite_Generic(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    for (int i = 0; i < 256; i++)
+        dst[i] = ColorComposite(above[i], below[i], windowmask[i], params);
+}
+
+static void BrightnessUp_Generic(u32* line, u32 factor)
+{
+    for (int i = 0; i < 256; i++)
+        line[i] = ColorBrightnessUp(line[i], factor, 0x0);
+}
+
+static void BrightnessDown_Generic(u32* line, u32 factor)
+{
+    for (int i = 0; i < 256; i++)
+        line[i] = ColorBrightnessDown(line[i], factor, 0xF);
+}
+
+static void Expand555_Generic(u32* dst, const u16* src)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        u16 color = src[i];
+        u8 r = (color & 0x001F) << 1;
+        u8 g = (color & 0x03E0) >> 4;
+        u8 b = (color & 0x7C00) >> 9;
+
+        dst[i] = r | (g << 8) | (b << 16);
+    }
+}
+
+static void ConvertBGRA_Generic(u32* line)
+{
+    // note: 32-bit RGBA would be more straightforward, but
+    // BGRA seems to be more compatible (Direct2D soft, cairo...)
+    for (int i = 0; i < 256; i+=2)
+    {
+        u64 c;
+        memcpy(&c, &line[i], 8);
+
+        u64 r = (c << 18) & 0xFC000000FC0000;
+        u64 g = (c << 2) & 0xFC000000FC00;
+        u64 b = (c >> 14) & 0xFC000000FC;
+        c = r | g | b;
+
+        c = c | ((c & 0x00C0C0C000C0C0C0) >> 6) | 0xFF000000FF000000;
+        memcpy(&line[i], &c, 8);
+    }
+}
+
+static void CaptureA_Generic(u16* dst, const u32* srcA, u32 num)
+{
+    for (u32 i = 0; i < num; i++)
+    {
+        u32 val = srcA[i];
+
+        // TODO: check what happens when alpha=0
+
+        u32 r = (val >> 1) & 0x1F;
+        u32 g = (val >> 9) & 0x1F;
+        u32 b = (val >> 17) & 0x1F;
+        u32 a = ((val >> 24) != 0) ? 0x8000 : 0;
+
+        dst[i] = r | (g << 5) | (b << 10) | a;
+    }
+}
+
+static void CaptureAB_Generic(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb)
+{
+    for (u32 i = 0; i < num; i++)
+    {
+        u32 val = srcA[i];
+
+        // TODO: check what happens when alpha=0
+
+        u32 rA = (val >> 1) & 0x1F;
+        u32 gA = (val >> 9) & 0x1F;
+        u32 bA = (val >> 17) & 0x1F;
+        u32 aA = ((val >> 24) != 0) ? 1 : 0;
+
+        val = srcB[i];
+
+        u32 rB = val & 0x1F;
+        u32 gB = (val >> 5) & 0x1F;
+        u32 bB = (val >> 10) & 0x1F;
+        u32 aB = val >> 15;
+
+        u32 rD = ((rA * aA * eva) + (rB * aB * evb) + 8) >> 4;
+        u32 gD = ((gA * aA * eva) + (gB * aB * evb) + 8) >> 4;
+        u32 bD = ((bA * aA * eva) + (bB * aB * evb) + 8) >> 4;
+        u32 aD = (eva>0 ? aA : 0) | (evb>0 ? aB : 0);
+
+        if (rD > 0x1F) rD = 0x1F;
+        if (gD > 0x1F) gD = 0x1F;
+        if (bD > 0x1F) bD = 0x1F;
+
+        dst[i] = rD | (gD << 5) | (bD << 10) | (aD << 15);
+    }
+}
+
+// The SIMD versions all work the same way: the color channels are widened
+// to 16 bits for the multiplies, and the per-pixel branches of
+// ColorComposite are turned into lane masks.
+
+#ifdef GPU2D_X86
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+SSE2_TARGET static inline __m128i Select_SSE2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// sets the 32-bit lanes where val has any of the bits in mask
+SSE2_TARGET static inline __m128i TestAny_SSE2(__m128i val, __m128i mask)
+{
+    __m128i zero = _mm_cmpeq_epi32(_mm_and_si128(val, mask), _mm_setzero_si128());
+    return _mm_xor_si128(zero, _mm_set1_epi32(-1));
+}
+
+// per channel: ((c1 * eva) + (c2 * evb) + rounding) >> shift, clamped to 0x3F
+template<int shift>
+SSE2_TARGET static inline __m128i Mix_SSE2(__m128i val1, __m128i val2, __m128i eva, __m128i evb)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i chanmask = _mm_set1_epi32(0x003F3F3F);
+    const __m128i bias = _mm_set1_epi16(1 << (shift-1));
+    const __m128i max = _mm_set1_epi16(0x3F);
+
+    val1 = _mm_and_si128(val1, chanmask);
+    val2 = _mm_and_si128(val2, chanmask);
+
+    // spread the factors of each pixel over its four 16-bit lanes
+    eva = _mm_or_si128(eva, _mm_slli_epi32(eva, 16));
+    evb = _mm_or_si128(evb, _mm_slli_epi32(evb, 16));
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(val1, zero), _mm_unpacklo_epi32(eva, eva)),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(val2, zero), _mm_unpacklo_epi32(evb, evb)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(val1, zero), _mm_unpackhi_epi32(eva, eva)),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(val2, zero), _mm_unpackhi_epi32(evb, evb)));
+
+    lo = _mm_min_epi16(_mm_srli_epi16(_mm_add_epi16(lo, bias), shift), max);
+    hi = _mm_min_epi16(_mm_srli_epi16(_mm_add_epi16(hi, bias), shift), max);
+
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xFF000000));
+}
+
+// factor and bias are 16-bit
+template<bool up>
+SSE2_TARGET static inline __m128i Brightness_SSE2(__m128i val, __m128i factor, __m128i bias)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(0x3F);
+
+    val = _mm_and_si128(val, _mm_set1_epi32(0x003F3F3F));
+    __m128i lo = _mm_unpacklo_epi8(val, zero);
+    __m128i hi = _mm_unpackhi_epi8(val, zero);
+
+    if (up)
+    {
+        lo = _mm_add_epi16(lo, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, lo), factor), bias), 4));
+        hi = _mm_add_epi16(hi, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, hi), factor), bias), 4));
+    }
+    else
+    {
+        lo = _mm_sub_epi16(lo, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, factor), bias), 4));
+        hi = _mm_sub_epi16(hi, _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, factor), bias), 4));
+    }
+
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xFF000000));
+}
+
+template<u32 effect>
+SSE2_TARGET static void Composite_SSE2(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i blend1 = _mm_set1_epi32(params.BlendCnt & 0x3F);
+    const __m128i blend2 = _mm_set1_epi32((params.BlendCnt >> 8) & 0x3F);
+    const __m128i eva = _mm_set1_epi32(params.EVA);
+    const __m128i evb = _mm_set1_epi32(params.EVB);
+    const __m128i evy = _mm_set1_epi16(params.EVY);
+    const __m128i bias = _mm_set1_epi16((effect == 2) ? 0x8 : 0x7);
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        __m128i val1 = _mm_loadu_si128((const __m128i*)&above[i]);
+        __m128i val2 = _mm_loadu_si128((const __m128i*)&below[i]);
+        __m128i flag1 = _mm_srli_epi32(val1, 24);
+        __m128i flag2 = _mm_srli_epi32(val2, 24);
+
+        u32 wm;
+        memcpy(&wm, &windowmask[i], 4);
+        __m128i win = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(wm), zero), zero);
+        win = TestAny_SSE2(win, _mm_set1_epi32(0x20));
+
+        __m128i obj1 = TestAny_SSE2(flag1, _mm_set1_epi32(0x80));
+        __m128i is3d1 = TestAny_SSE2(flag1, _mm_set1_epi32(0x40));
+        __m128i obj2 = TestAny_SSE2(flag2, _mm_set1_epi32(0x80));
+        __m128i is3d2 = TestAny_SSE2(flag2, _mm_set1_epi32(0x40));
+
+        // layer bits as laid out in BLDCNT
+        __m128i layer1 = Select_SSE2(obj1, _mm_set1_epi32(0x10), Select_SSE2(is3d1, _mm_set1_epi32(0x01), flag1));
+        __m128i layer2 = Select_SSE2(obj2, _mm_set1_epi32(0x10), Select_SSE2(is3d2, _mm_set1_epi32(0x01), flag2));
+        __m128i target1 = TestAny_SSE2(layer1, blend1);
+        __m128i target2 = TestAny_SSE2(layer2, blend2);
+
+        __m128i sprblend = _mm_and_si128(obj1, target2);
+        __m128i blend3d = _mm_andnot_si128(obj1, _mm_and_si128(is3d1, target2));
+        __m128i others = _mm_andnot_si128(_mm_or_si128(sprblend, blend3d), _mm_and_si128(target1, win));
+
+        __m128i ret = val1;
+
+        __m128i blend4 = sprblend;
+        if (effect == 1)
+            blend4 = _mm_or_si128(blend4, _mm_and_si128(others, target2));
+
+        if (_mm_movemask_epi8(blend4))
+        {
+            // bitmap sprites come with their own alpha
+            __m128i spralpha = _mm_and_si128(sprblend, is3d1);
+            __m128i alpha = _mm_and_si128(flag1, _mm_set1_epi32(0x1F));
+            __m128i a = Select_SSE2(spralpha, alpha, eva);
+            __m128i b = Select_SSE2(spralpha, _mm_sub_epi32(_mm_set1_epi32(16), alpha), evb);
+
+            ret = Select_SSE2(blend4, Mix_SSE2<4>(val1, val2, a, b), ret);
+        }
+
+        if (effect >= 2 && _mm_movemask_epi8(others))
+            ret = Select_SSE2(others, Brightness_SSE2<effect == 2>(val1, evy, bias), ret);
+
+        if (_mm_movemask_epi8(blend3d))
+        {
+            __m128i a = _mm_add_epi32(_mm_and_si128(flag1, _mm_set1_epi32(0x1F)), _mm_set1_epi32(1));
+            __m128i b = _mm_sub_epi32(_mm_set1_epi32(32), a);
+
+            // fully opaque 3D pixels are left untouched
+            blend3d = _mm_andnot_si128(_mm_cmpeq_epi32(b, zero), blend3d);
+            ret = Select_SSE2(blend3d, Mix_SSE2<5>(val1, val2, a, b), ret);
+        }
+
+        _mm_storeu_si128((__m128i*)&dst[i], ret);
+    }
+}
+
+SSE2_TARGET static void Composite_SSE2(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    switch ((params.BlendCnt >> 6) & 0x3)
+    {
+    case 0: Composite_SSE2<0>(dst, above, below, windowmask, params); break;
+    case 1: Composite_SSE2<1>(dst, above, below, windowmask, params); break;
+    case 2: Composite_SSE2<2>(dst, above, below, windowmask, params); break;
+    case 3: Composite_SSE2<3>(dst, above, below, windowmask, params); break;
+    }
+}
+
+SSE2_TARGET static void BrightnessUp_SSE2(u32* line, u32 factor)
+{
+    const __m128i f = _mm_set1_epi16(factor);
+    const __m128i bias = _mm_setzero_si128();
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        __m128i val = _mm_loadu_si128((const __m128i*)&line[i]);
+        _mm_storeu_si128((__m128i*)&line[i], Brightness_SSE2<true>(val, f, bias));
+    }
+}
+
+SSE2_TARGET static void BrightnessDown_SSE2(u32* line, u32 factor)
+{
+    const __m128i f = _mm_set1_epi16(factor);
+    const __m128i bias = _mm_set1_epi16(0xF);
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        __m128i val = _mm_loadu_si128((const __m128i*)&line[i]);
+        _mm_storeu_si128((__m128i*)&line[i], Brightness_SSE2<false>(val, f, bias));
+    }
+}
+
+SSE2_TARGET static inline __m128i Expand555_SSE2(__m128i c)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x001F)), 1);
+    __m128i g = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x03E0)), 4);
+    __m128i b = _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x7C00)), 7);
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+SSE2_TARGET static void Expand555_SSE2(u32* dst, const u16* src)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_si128((__m128i*)&dst[i],   Expand555_SSE2(_mm_unpacklo_epi16(c, zero)));
+        _mm_storeu_si128((__m128i*)&dst[i+4], Expand555_SSE2(_mm_unpackhi_epi16(c, zero)));
+    }
+}
+
+SSE2_TARGET static void ConvertBGRA_SSE2(u32* line)
+{
+    const __m128i chanmask = _mm_set1_epi32(0x003F3F3F);
+    const __m128i bytemask = _mm_set1_epi32(0xFF);
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)&line[i]), chanmask);
+
+        // 6 bits to 8 bits, per byte
+        c = _mm_or_si128(_mm_slli_epi32(c, 2), _mm_and_si128(_mm_srli_epi32(c, 4), _mm_set1_epi32(0x00030303)));
+
+        // swap red and blue
+        __m128i r = _mm_slli_epi32(_mm_and_si128(c, bytemask), 16);
+        __m128i g = _mm_and_si128(c, _mm_set1_epi32(0xFF00));
+        __m128i b = _mm_and_si128(_mm_srli_epi32(c, 16), bytemask);
+        c = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32(0xFF000000)));
+
+        _mm_storeu_si128((__m128i*)&line[i], c);
+    }
+}
+
+// 18-bit colors to BGR555 with the alpha bit, still in 32-bit lanes
+SSE2_TARGET static inline __m128i CaptureConvert_SSE2(__m128i val)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(val, 1), _mm_set1_epi32(0x001F));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(val, 4), _mm_set1_epi32(0x03E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(val, 7), _mm_set1_epi32(0x7C00));
+    __m128i a = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_srli_epi32(val, 24), _mm_setzero_si128()), _mm_set1_epi32(0x8000));
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+SSE2_TARGET static inline __m128i CaptureLoadA_SSE2(const u32* srcA)
+{
+    __m128i lo = CaptureConvert_SSE2(_mm_loadu_si128((const __m128i*)&srcA[0]));
+    __m128i hi = CaptureConvert_SSE2(_mm_loadu_si128((const __m128i*)&srcA[4]));
+
+    // the pack saturates as signed, so sign-extend the values first
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+SSE2_TARGET static void CaptureA_SSE2(u16* dst, const u32* srcA, u32 num)
+{
+    u32 i = 0;
+    for (; i + 8 <= num; i += 8)
+        _mm_storeu_si128((__m128i*)&dst[i], CaptureLoadA_SSE2(&srcA[i]));
+
+    CaptureA_Generic(&dst[i], &srcA[i], num - i);
+}
+
+SSE2_TARGET static inline __m128i CaptureChannel_SSE2(__m128i a, __m128i b, __m128i fa, __m128i fb, int shift)
+{
+    const __m128i chanmask = _mm_set1_epi16(0x1F);
+
+    a = _mm_and_si128(_mm_srli_epi16(a, shift), chanmask);
+    b = _mm_and_si128(_mm_srli_epi16(b, shift), chanmask);
+
+    __m128i ret = _mm_add_epi16(_mm_mullo_epi16(a, fa), _mm_mullo_epi16(b, fb));
+    ret = _mm_srli_epi16(_mm_add_epi16(ret, _mm_set1_epi16(8)), 4);
+    return _mm_slli_epi16(_mm_min_epi16(ret, chanmask), shift);
+}
+
+SSE2_TARGET static void CaptureAB_SSE2(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb)
+{
+    const __m128i fa = _mm_set1_epi16(eva);
+    const __m128i fb = _mm_set1_epi16(evb);
+    const __m128i alphaA = _mm_set1_epi16(eva ? (s16)0x8000 : 0);
+    const __m128i alphaB = _mm_set1_epi16(evb ? (s16)0x8000 : 0);
+
+    u32 i = 0;
+    for (; i + 8 <= num; i += 8)
+    {
+        __m128i a = CaptureLoadA_SSE2(&srcA[i]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&srcB[i]);
+
+        // only take each source into account if its alpha bit is set
+        __m128i curfa = _mm_and_si128(_mm_srai_epi16(a, 15), fa);
+        __m128i curfb = _mm_and_si128(_mm_srai_epi16(b, 15), fb);
+
+        __m128i ret = _mm_or_si128(CaptureChannel_SSE2(a, b, curfa, curfb, 0),
+                      _mm_or_si128(CaptureChannel_SSE2(a, b, curfa, curfb, 5),
+                                   CaptureChannel_SSE2(a, b, curfa, curfb, 10)));
+
+        __m128i alpha = _mm_or_si128(_mm_and_si128(a, alphaA), _mm_and_si128(b, alphaB));
+        ret = _mm_or_si128(ret, alpha);
+
+        _mm_storeu_si128((__m128i*)&dst[i], ret);
+    }
+
+    CaptureAB_Generic(&dst[i], &srcA[i], &srcB[i], num - i, eva, evb);
+}
+
+// the AVX2 versions process twice as many pixels at once. The unpacks and
+// packs they rely on work within each 128-bit half, which keeps the pixels
+// in order, except for the 32-to-16-bit pack in the capture functions.
+
+AVX2_TARGET static inline __m256i Select_AVX2(__m256i mask, __m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+AVX2_TARGET static inline __m256i TestAny_AVX2(__m256i val, __m256i mask)
+{
+    __m256i zero = _mm256_cmpeq_epi32(_mm256_and_si256(val, mask), _mm256_setzero_si256());
+    return _mm256_xor_si256(zero, _mm256_set1_epi32(-1));
+}
+
+template<int shift>
+AVX2_TARGET static inline __m256i Mix_AVX2(__m256i val1, __m256i val2, __m256i eva, __m256i evb)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i chanmask = _mm256_set1_epi32(0x003F3F3F);
+    const __m256i bias = _mm256_set1_epi16(1 << (shift-1));
+    const __m256i max = _mm256_set1_epi16(0x3F);
+
+    val1 = _mm256_and_si256(val1, chanmask);
+    val2 = _mm256_and_si256(val2, chanmask);
+
+    eva = _mm256_or_si256(eva, _mm256_slli_epi32(eva, 16));
+    evb = _mm256_or_si256(evb, _mm256_slli_epi32(evb, 16));
+
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(val1, zero), _mm256_unpacklo_epi32(eva, eva)),
+                                  _mm256_mullo_epi16(_mm256_unpacklo_epi8(val2, zero), _mm256_unpacklo_epi32(evb, evb)));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(val1, zero), _mm256_unpackhi_epi32(eva, eva)),
+                                  _mm256_mullo_epi16(_mm256_unpackhi_epi8(val2, zero), _mm256_unpackhi_epi32(evb, evb)));
+
+    lo = _mm256_min_epi16(_mm256_srli_epi16(_mm256_add_epi16(lo, bias), shift), max);
+    hi = _mm256_min_epi16(_mm256_srli_epi16(_mm256_add_epi16(hi, bias), shift), max);
+
+    return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(0xFF000000));
+}
+
+template<bool up>
+AVX2_TARGET static inline __m256i Brightness_AVX2(__m256i val, __m256i factor, __m256i bias)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(0x3F);
+
+    val = _mm256_and_si256(val, _mm256_set1_epi32(0x003F3F3F));
+    __m256i lo = _mm256_unpacklo_epi8(val, zero);
+    __m256i hi = _mm256_unpackhi_epi8(val, zero);
+
+    if (up)
+    {
+        lo = _mm256_add_epi16(lo, _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(max, lo), factor), bias), 4));
+        hi = _mm256_add_epi16(hi, _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(max, hi), factor), bias), 4));
+    }
+    else
+    {
+        lo = _mm256_sub_epi16(lo, _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(lo, factor), bias), 4));
+        hi = _mm256_sub_epi16(hi, _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(hi, factor), bias), 4));
+    }
+
+    return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(0xFF000000));
+}
+
+template<u32 effect>
+AVX2_TARGET static void Composite_AVX2(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i blend1 = _mm256_set1_epi32(params.BlendCnt & 0x3F);
+    const __m256i blend2 = _mm256_set1_epi32((params.BlendCnt >> 8) & 0x3F);
+    const __m256i eva = _mm256_set1_epi32(params.EVA);
+    const __m256i evb = _mm256_set1_epi32(params.EVB);
+    const __m256i evy = _mm256_set1_epi16(params.EVY);
+    const __m256i bias = _mm256_set1_epi16((effect == 2) ? 0x8 : 0x7);
+
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m256i val1 = _mm256_loadu_si256((const __m256i*)&above[i]);
+        __m256i val2 = _mm256_loadu_si256((const __m256i*)&below[i]);
+        __m256i flag1 = _mm256_srli_epi32(val1, 24);
+        __m256i flag2 = _mm256_srli_epi32(val2, 24);
+
+        __m256i win = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&windowmask[i]));
+        win = TestAny_AVX2(win, _mm256_set1_epi32(0x20));
+
+        __m256i obj1 = TestAny_AVX2(flag1, _mm256_set1_epi32(0x80));
+        __m256i is3d1 = TestAny_AVX2(flag1, _mm256_set1_epi32(0x40));
+        __m256i obj2 = TestAny_AVX2(flag2, _mm256_set1_epi32(0x80));
+        __m256i is3d2 = TestAny_AVX2(flag2, _mm256_set1_epi32(0x40));
+
+        __m256i layer1 = Select_AVX2(obj1, _mm256_set1_epi32(0x10), Select_AVX2(is3d1, _mm256_set1_epi32(0x01), flag1));
+        __m256i layer2 = Select_AVX2(obj2, _mm256_set1_epi32(0x10), Select_AVX2(is3d2, _mm256_set1_epi32(0x01), flag2));
+        __m256i target1 = TestAny_AVX2(layer1, blend1);
+        __m256i target2 = TestAny_AVX2(layer2, blend2);
+
+        __m256i sprblend = _mm256_and_si256(obj1, target2);
+        __m256i blend3d = _mm256_andnot_si256(obj1, _mm256_and_si256(is3d1, target2));
+        __m256i others = _mm256_andnot_si256(_mm256_or_si256(sprblend, blend3d), _mm256_and_si256(target1, win));
+
+        __m256i ret = val1;
+
+        __m256i blend4 = sprblend;
+        if (effect == 1)
+            blend4 = _mm256_or_si256(blend4, _mm256_and_si256(others, target2));
+
+        if (!_mm256_testz_si256(blend4, blend4))
+        {
+            __m256i spralpha = _mm256_and_si256(sprblend, is3d1);
+            __m256i alpha = _mm256_and_si256(flag1, _mm256_set1_epi32(0x1F));
+            __m256i a = Select_AVX2(spralpha, alpha, eva);
+            __m256i b = Select_AVX2(spralpha, _mm256_sub_epi32(_mm256_set1_epi32(16), alpha), evb);
+
+            ret = Select_AVX2(blend4, Mix_AVX2<4>(val1, val2, a, b), ret);
+        }
+
+        if (effect >= 2 && !_mm256_testz_si256(others, others))
+            ret = Select_AVX2(others, Brightness_AVX2<effect == 2>(val1, evy, bias), ret);
+
+        if (!_mm256_testz_si256(blend3d, blend3d))
+        {
+            __m256i a = _mm256_add_epi32(_mm256_and_si256(flag1, _mm256_set1_epi32(0x1F)), _mm256_set1_epi32(1));
+            __m256i b = _mm256_sub_epi32(_mm256_set1_epi32(32), a);
+
+            blend3d = _mm256_andnot_si256(_mm256_cmpeq_epi32(b, zero), blend3d);
+            ret = Select_AVX2(blend3d, Mix_AVX2<5>(val1, val2, a, b), ret);
+        }
+
+        _mm256_storeu_si256((__m256i*)&dst[i], ret);
+    }
+}
+
+AVX2_TARGET static void Composite_AVX2(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    switch ((params.BlendCnt >> 6) & 0x3)
+    {
+    case 0: Composite_AVX2<0>(dst, above, below, windowmask, params); break;
+    case 1: Composite_AVX2<1>(dst, above, below, windowmask, params); break;
+    case 2: Composite_AVX2<2>(dst, above, below, windowmask, params); break;
+    case 3: Composite_AVX2<3>(dst, above, below, windowmask, params); break;
+    }
+}
+
+AVX2_TARGET static void BrightnessUp_AVX2(u32* line, u32 factor)
+{
+    const __m256i f = _mm256_set1_epi16(factor);
+    const __m256i bias = _mm256_setzero_si256();
+
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m256i val = _mm256_loadu_si256((const __m256i*)&line[i]);
+        _mm256_storeu_si256((__m256i*)&line[i], Brightness_AVX2<true>(val, f, bias));
+    }
+}
+
+AVX2_TARGET static void BrightnessDown_AVX2(u32* line, u32 factor)
+{
+    const __m256i f = _mm256_set1_epi16(factor);
+    const __m256i bias = _mm256_set1_epi16(0xF);
+
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m256i val = _mm256_loadu_si256((const __m256i*)&line[i]);
+        _mm256_storeu_si256((__m256i*)&line[i], Brightness_AVX2<false>(val, f, bias));
+    }
+}
+
+AVX2_TARGET static void Expand555_AVX2(u32* dst, const u16* src)
+{
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m256i c = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)&src[i]));
+
+        __m256i r = _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x001F)), 1);
+        __m256i g = _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x03E0)), 4);
+        __m256i b = _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x7C00)), 7);
+
+        _mm256_storeu_si256((__m256i*)&dst[i], _mm256_or_si256(_mm256_or_si256(r, g), b));
+    }
+}
+
+AVX2_TARGET static void ConvertBGRA_AVX2(u32* line)
+{
+    const __m256i chanmask = _mm256_set1_epi32(0x003F3F3F);
+    const __m256i swaprb = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    for (int i = 0; i < 256; i += 8)
+    {
+        __m256i c = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&line[i]), chanmask);
+
+        c = _mm256_or_si256(_mm256_slli_epi32(c, 2), _mm256_and_si256(_mm256_srli_epi32(c, 4), _mm256_set1_epi32(0x00030303)));
+        c = _mm256_or_si256(_mm256_shuffle_epi8(c, swaprb), _mm256_set1_epi32(0xFF000000));
+
+        _mm256_storeu_si256((__m256i*)&line[i], c);
+    }
+}
+
+AVX2_TARGET static inline __m256i CaptureConvert_AVX2(__m256i val)
+{
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(val, 1), _mm256_set1_epi32(0x001F));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(val, 4), _mm256_set1_epi32(0x03E0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(val, 7), _mm256_set1_epi32(0x7C00));
+    __m256i a = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_srli_epi32(val, 24), _mm256_setzero_si256()), _mm256_set1_epi32(0x8000));
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+}
+
+AVX2_TARGET static inline __m256i CaptureLoadA_AVX2(const u32* srcA)
+{
+    __m256i lo = CaptureConvert_AVX2(_mm256_loadu_si256((const __m256i*)&srcA[0]));
+    __m256i hi = CaptureConvert_AVX2(_mm256_loadu_si256((const __m256i*)&srcA[8]));
+
+    // the pack works on each half separately, so it has to be put back in order
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+}
+
+AVX2_TARGET static void CaptureA_AVX2(u16* dst, const u32* srcA, u32 num)
+{
+    u32 i = 0;
+    for (; i + 16 <= num; i += 16)
+        _mm256_storeu_si256((__m256i*)&dst[i], CaptureLoadA_AVX2(&srcA[i]));
+
+    CaptureA_Generic(&dst[i], &srcA[i], num - i);
+}
+
+AVX2_TARGET static inline __m256i CaptureChannel_AVX2(__m256i a, __m256i b, __m256i fa, __m256i fb, int shift)
+{
+    const __m256i chanmask = _mm256_set1_epi16(0x1F);
+
+    a = _mm256_and_si256(_mm256_srli_epi16(a, shift), chanmask);
+    b = _mm256_and_si256(_mm256_srli_epi16(b, shift), chanmask);
+
+    __m256i ret = _mm256_add_epi16(_mm256_mullo_epi16(a, fa), _mm256_mullo_epi16(b, fb));
+    ret = _mm256_srli_epi16(_mm256_add_epi16(ret, _mm256_set1_epi16(8)), 4);
+    return _mm256_slli_epi16(_mm256_min_epi16(ret, chanmask), shift);
+}
+
+AVX2_TARGET static void CaptureAB_AVX2(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb)
+{
+    const __m256i fa = _mm256_set1_epi16(eva);
+    const __m256i fb = _mm256_set1_epi16(evb);
+    const __m256i alphaA = _mm256_set1_epi16(eva ? (s16)0x8000 : 0);
+    const __m256i alphaB = _mm256_set1_epi16(evb ? (s16)0x8000 : 0);
+
+    u32 i = 0;
+    for (; i + 16 <= num; i += 16)
+    {
+        __m256i a = CaptureLoadA_AVX2(&srcA[i]);
+        __m256i b = _mm256_loadu_si256((const __m256i*)&srcB[i]);
+
+        __m256i curfa = _mm256_and_si256(_mm256_srai_epi16(a, 15), fa);
+        __m256i curfb = _mm256_and_si256(_mm256_srai_epi16(b, 15), fb);
+
+        __m256i ret = _mm256_or_si256(CaptureChannel_AVX2(a, b, curfa, curfb, 0),
+                      _mm256_or_si256(CaptureChannel_AVX2(a, b, curfa, curfb, 5),
+                                      CaptureChannel_AVX2(a, b, curfa, curfb, 10)));
+
+        __m256i alpha = _mm256_or_si256(_mm256_and_si256(a, alphaA), _mm256_and_si256(b, alphaB));
+        ret = _mm256_or_si256(ret, alpha);
+
+        _mm256_storeu_si256((__m256i*)&dst[i], ret);
+    }
+
+    CaptureAB_Generic(&dst[i], &srcA[i], &srcB[i], num - i, eva, evb);
+}
+
+#endif // GPU2D_X86
+
+#ifdef GPU2D_NEON
+
+// per channel: ((c1 * eva) + (c2 * evb) + rounding) >> shift, clamped to 0x3F
+template<int shift>
+static inline uint32x4_t Mix_NEON(uint32x4_t val1, uint32x4_t val2, uint32x4_t eva, uint32x4_t evb)
+{
+    const uint32x4_t chanmask = vdupq_n_u32(0x003F3F3F);
+    const uint16x8_t max = vdupq_n_u16(0x3F);
+
+    uint8x16_t c1 = vreinterpretq_u8_u32(vandq_u32(val1, chanmask));
+    uint8x16_t c2 = vreinterpretq_u8_u32(vandq_u32(val2, chanmask));
+
+    // spread the factors of each pixel over its four bytes
+    uint8x16_t fa = vreinterpretq_u8_u32(vmulq_n_u32(eva, 0x01010101));
+    uint8x16_t fb = vreinterpretq_u8_u32(vmulq_n_u32(evb, 0x01010101));
+
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(c1), vget_low_u8(fa)), vget_low_u8(c2), vget_low_u8(fb));
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(c1), vget_high_u8(fa)), vget_high_u8(c2), vget_high_u8(fb));
+
+    lo = vminq_u16(vrshrq_n_u16(lo, shift), max);
+    hi = vminq_u16(vrshrq_n_u16(hi, shift), max);
+
+    uint8x16_t ret = vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+    return vorrq_u32(vreinterpretq_u32_u8(ret), vdupq_n_u32(0xFF000000));
+}
+
+template<bool up>
+static inline uint32x4_t Brightness_NEON(uint32x4_t val, uint8x8_t factor, uint16x8_t bias)
+{
+    const uint8x8_t max = vdup_n_u8(0x3F);
+
+    uint8x16_t c = vreinterpretq_u8_u32(vandq_u32(val, vdupq_n_u32(0x003F3F3F)));
+    uint8x8_t clo = vget_low_u8(c);
+    uint8x8_t chi = vget_high_u8(c);
+    uint16x8_t lo, hi;
+
+    if (up)
+    {
+        lo = vaddw_u8(vshrq_n_u16(vaddq_u16(vmull_u8(vsub_u8(max, clo), factor), bias), 4), clo);
+        hi = vaddw_u8(vshrq_n_u16(vaddq_u16(vmull_u8(vsub_u8(max, chi), factor), bias), 4), chi);
+    }
+    else
+    {
+        lo = vsubq_u16(vmovl_u8(clo), vshrq_n_u16(vaddq_u16(vmull_u8(clo, factor), bias), 4));
+        hi = vsubq_u16(vmovl_u8(chi), vshrq_n_u16(vaddq_u16(vmull_u8(chi, factor), bias), 4));
+    }
+
+    uint8x16_t ret = vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+    return vorrq_u32(vreinterpretq_u32_u8(ret), vdupq_n_u32(0xFF000000));
+}
+
+template<u32 effect>
+static void Composite_NEON(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    const uint32x4_t blend1 = vdupq_n_u32(params.BlendCnt & 0x3F);
+    const uint32x4_t blend2 = vdupq_n_u32((params.BlendCnt >> 8) & 0x3F);
+    const uint32x4_t eva = vdupq_n_u32(params.EVA);
+    const uint32x4_t evb = vdupq_n_u32(params.EVB);
+    const uint8x8_t evy = vdup_n_u8(params.EVY);
+    const uint16x8_t bias = vdupq_n_u16((effect == 2) ? 0x8 : 0x7);
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        uint32x4_t val1 = vld1q_u32(&above[i]);
+        uint32x4_t val2 = vld1q_u32(&below[i]);
+        uint32x4_t flag1 = vshrq_n_u32(val1, 24);
+        uint32x4_t flag2 = vshrq_n_u32(val2, 24);
+
+        u32 wm;
+        memcpy(&wm, &windowmask[i], 4);
+        uint32x4_t win = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(wm)))));
+        win = vtstq_u32(win, vdupq_n_u32(0x20));
+
+        uint32x4_t obj1 = vtstq_u32(flag1, vdupq_n_u32(0x80));
+        uint32x4_t is3d1 = vtstq_u32(flag1, vdupq_n_u32(0x40));
+        uint32x4_t obj2 = vtstq_u32(flag2, vdupq_n_u32(0x80));
+        uint32x4_t is3d2 = vtstq_u32(flag2, vdupq_n_u32(0x40));
+
+        // layer bits as laid out in BLDCNT
+        uint32x4_t layer1 = vbslq_u32(obj1, vdupq_n_u32(0x10), vbslq_u32(is3d1, vdupq_n_u32(0x01), flag1));
+        uint32x4_t layer2 = vbslq_u32(obj2, vdupq_n_u32(0x10), vbslq_u32(is3d2, vdupq_n_u32(0x01), flag2));
+        uint32x4_t target1 = vtstq_u32(layer1, blend1);
+        uint32x4_t target2 = vtstq_u32(layer2, blend2);
+
+        uint32x4_t sprblend = vandq_u32(obj1, target2);
+        uint32x4_t blend3d = vbicq_u32(vandq_u32(is3d1, target2), obj1);
+        uint32x4_t others = vbicq_u32(vandq_u32(target1, win), vorrq_u32(sprblend, blend3d));
+
+        uint32x4_t ret = val1;
+
+        uint32x4_t blend4 = sprblend;
+        if (effect == 1)
+            blend4 = vorrq_u32(blend4, vandq_u32(others, target2));
+
+        if (vmaxvq_u32(blend4))
+        {
+            // bitmap sprites come with their own alpha
+            uint32x4_t spralpha = vandq_u32(sprblend, is3d1);
+            uint32x4_t alpha = vandq_u32(flag1, vdupq_n_u32(0x1F));
+            uint32x4_t a = vbslq_u32(spralpha, alpha, eva);
+            uint32x4_t b = vbslq_u32(spralpha, vsubq_u32(vdupq_n_u32(16), alpha), evb);
+
+            ret = vbslq_u32(blend4, Mix_NEON<4>(val1, val2, a, b), ret);
+        }
+
+        if (effect >= 2 && vmaxvq_u32(others))
+            ret = vbslq_u32(others, Brightness_NEON<effect == 2>(val1, evy, bias), ret);
+
+        if (vmaxvq_u32(blend3d))
+        {
+            uint32x4_t a = vaddq_u32(vandq_u32(flag1, vdupq_n_u32(0x1F)), vdupq_n_u32(1));
+            uint32x4_t b = vsubq_u32(vdupq_n_u32(32), a);
+
+            // fully opaque 3D pixels are left untouched
+            blend3d = vandq_u32(blend3d, vtstq_u32(b, b));
+            ret = vbslq_u32(blend3d, Mix_NEON<5>(val1, val2, a, b), ret);
+        }
+
+        vst1q_u32(&dst[i], ret);
+    }
+}
+
+static void Composite_NEON(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params)
+{
+    switch ((params.BlendCnt >> 6) & 0x3)
+    {
+    case 0: Composite_NEON<0>(dst, above, below, windowmask, params); break;
+    case 1: Composite_NEON<1>(dst, above, below, windowmask, params); break;
+    case 2: Composite_NEON<2>(dst, above, below, windowmask, params); break;
+    case 3: Composite_NEON<3>(dst, above, below, windowmask, params); break;
+    }
+}
+
+static void BrightnessUp_NEON(u32* line, u32 factor)
+{
+    const uint8x8_t f = vdup_n_u8(factor);
+    const uint16x8_t bias = vdupq_n_u16(0);
+
+    for (int i = 0; i < 256; i += 4)
+        vst1q_u32(&line[i], Brightness_NEON<true>(vld1q_u32(&line[i]), f, bias));
+}
+
+static void BrightnessDown_NEON(u32* line, u32 factor)
+{
+    const uint8x8_t f = vdup_n_u8(factor);
+    const uint16x8_t bias = vdupq_n_u16(0xF);
+
+    for (int i = 0; i < 256; i += 4)
+        vst1q_u32(&line[i], Brightness_NEON<false>(vld1q_u32(&line[i]), f, bias));
+}
+
+static inline uint32x4_t Expand555_NEON(uint32x4_t c)
+{
+    uint32x4_t r = vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x001F)), 1);
+    uint32x4_t g = vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x03E0)), 4);
+    uint32x4_t b = vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x7C00)), 7);
+    return vorrq_u32(vorrq_u32(r, g), b);
+}
+
+static void Expand555_NEON(u32* dst, const u16* src)
+{
+    for (int i = 0; i < 256; i += 8)
+    {
+        uint16x8_t c = vld1q_u16(&src[i]);
+        vst1q_u32(&dst[i],   Expand555_NEON(vmovl_u16(vget_low_u16(c))));
+        vst1q_u32(&dst[i+4], Expand555_NEON(vmovl_u16(vget_high_u16(c))));
+    }
+}
+
+static void ConvertBGRA_NEON(u32* line)
+{
+    static const u8 swaprb[16] = {2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15};
+    const uint8x16_t shuffle = vld1q_u8(swaprb);
+    const uint8x16_t alpha = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000));
+
+    for (int i = 0; i < 256; i += 4)
+    {
+        uint8x16_t c = vandq_u8(vreinterpretq_u8_u32(vld1q_u32(&line[i])), vdupq_n_u8(0x3F));
+
+        // 6 bits to 8 bits, per byte
+        c = vorrq_u8(vshlq_n_u8(c, 2), vshrq_n_u8(c, 4));
+        c = vorrq_u8(vqtbl1q_u8(c, shuffle), alpha);
+
+        vst1q_u32(&line[i], vreinterpretq_u32_u8(c));
+    }
+}
+
+static inline uint16x8_t CaptureLoadA_NEON(const u32* srcA)
+{
+    uint16x4_t half[2];
+    for (int j = 0; j < 2; j++)
+    {
+        uint32x4_t val = vld1q_u32(&srcA[j*4]);
+
+        uint32x4_t r = vandq_u32(vshrq_n_u32(val, 1), vdupq_n_u32(0x001F));
+        uint32x4_t g = vandq_u32(vshrq_n_u32(val, 4), vdupq_n_u32(0x03E0));
+        uint32x4_t b = vandq_u32(vshrq_n_u32(val, 7), vdupq_n_u32(0x7C00));
+        uint32x4_t a = vandq_u32(vtstq_u32(val, vdupq_n_u32(0xFF000000)), vdupq_n_u32(0x8000));
+
+        half[j] = vmovn_u32(vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, a)));
+    }
+
+    return vcombine_u16(half[0], half[1]);
+}
+
+static void CaptureA_NEON(u16* dst, const u32* srcA, u32 num)
+{
+    u32 i = 0;
+    for (; i + 8 <= num; i += 8)
+        vst1q_u16(&dst[i], CaptureLoadA_NEON(&srcA[i]));
+
+    CaptureA_Generic(&dst[i], &srcA[i], num - i);
+}
+
+template<int shift>
+static inline uint16x8_t CaptureChannel_NEON(uint16x8_t a, uint16x8_t b, uint16x8_t fa, uint16x8_t fb)
+{
+    const uint16x8_t chanmask = vdupq_n_u16(0x1F);
+
+    a = vandq_u16(vshrq_n_u16(a, shift), chanmask);
+    b = vandq_u16(vshrq_n_u16(b, shift), chanmask);
+
+    uint16x8_t ret = vrshrq_n_u16(vmlaq_u16(vmulq_u16(a, fa), b, fb), 4);
+    return vshlq_n_u16(vminq_u16(ret, chanmask), shift);
+}
+
+static void CaptureAB_NEON(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb)
+{
+    const uint16x8_t fa = vdupq_n_u16(eva);
+    const uint16x8_t fb = vdupq_n_u16(evb);
+    const uint16x8_t alphaA = vdupq_n_u16(eva ? 0x8000 : 0);
+    const uint16x8_t alphaB = vdupq_n_u16(evb ? 0x8000 : 0);
+
+    u32 i = 0;
+    for (; i + 8 <= num; i += 8)
+    {
+        uint16x8_t a = CaptureLoadA_NEON(&srcA[i]);
+        uint16x8_t b = vld1q_u16(&srcB[i]);
+
+        uint16x8_t curfa = vandq_u16(vtstq_u16(a, vdupq_n_u16(0x8000)), fa);
+        uint16x8_t curfb = vandq_u16(vtstq_u16(b, vdupq_n_u16(0x8000)), fb);
+
+        uint16x8_t ret = vorrq_u16(CaptureChannel_NEON<0>(a, b, curfa, curfb),
+                         vorrq_u16(CaptureChannel_NEON<5>(a, b, curfa, curfb),
+                                   CaptureChannel_NEON<10>(a, b, curfa, curfb)));
+
+        ret = vorrq_u16(ret, vorrq_u16(vandq_u16(a, alphaA), vandq_u16(b, alphaB)));
+
+        vst1q_u16(&dst[i], ret);
+    }
+
+    CaptureAB_Generic(&dst[i], &srcA[i], &srcB[i], num - i, eva, evb);
+}
+
+#endif // GPU2D_NEON
+
+struct LineKernels
+{
+    const char* Name;
+    void (*Composite)(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params);
+    void (*BrightnessUp)(u32* line, u32 factor);
+    void (*BrightnessDown)(u32* line, u32 factor);
+    void (*Expand555)(u32* dst, const u16* src);
+    void (*ConvertBGRA)(u32* line);
+    void (*CaptureA)(u16* dst, const u32* srcA, u32 num);
+    void (*CaptureAB)(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb);
+};
+
+static const LineKernels Kernels_Generic =
+{
+    "generic",
+    Composite_Generic, BrightnessUp_Generic, BrightnessDown_Generic,
+    Expand555_Generic, ConvertBGRA_Generic, CaptureA_Generic, CaptureAB_Generic,
+};
+
+#ifdef GPU2D_X86
+static const LineKernels Kernels_SSE2 =
+{
+    "SSE2",
+    Composite_SSE2, BrightnessUp_SSE2, BrightnessDown_SSE2,
+    Expand555_SSE2, ConvertBGRA_SSE2, CaptureA_SSE2, CaptureAB_SSE2,
+};
+
+static const LineKernels Kernels_AVX2 =
+{
+    "AVX2",
+    Composite_AVX2, BrightnessUp_AVX2, BrightnessDown_AVX2,
+    Expand555_AVX2, ConvertBGRA_AVX2, CaptureA_AVX2, CaptureAB_AVX2,
+};
+#endif
+
+#ifdef GPU2D_NEON
+static const LineKernels Kernels_NEON =
+{
+    "NEON",
+    Composite_NEON, BrightnessUp_NEON, BrightnessDown_NEON,
+    Expand555_NEON, ConvertBGRA_NEON, CaptureA_NEON, CaptureAB_NEON,
+};
+#endif
+
+static const LineKernels& SelectKernels()
+{
+#if defined(GPU2D_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Kernels_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return Kernels_SSE2;
+#elif defined(GPU2D_NEON)
+    return Kernels_NEON;
+#endif
+
+    return Kernels_Generic;
+}
+
+// set by SetLineKernels, overrides the automatic choice
+static const LineKernels* ForcedKernels = nullptr;
+
+static const LineKernels& GetKernels()
+{
+    static const LineKernels& kernels = SelectKernels();
+    if (ForcedKernels)
+        return *ForcedKernels;
+    return kernels;
+}
+
+bool SetLineKernels(const char* name) noexcept
+{
+    if (!name)
+    {
+        ForcedKernels = nullptr;
+        return true;
+    }
+
+    const LineKernels* kernels = nullptr;
+    if (!strcmp(name, Kernels_Generic.Name))
+        kernels = &Kernels_Generic;
+#if defined(GPU2D_X86)
+    __builtin_cpu_init();
+    if (!strcmp(name, Kernels_SSE2.Name) && __builtin_cpu_supports("sse2"))
+        kernels = &Kernels_SSE2;
+    if (!strcmp(name, Kernels_AVX2.Name) && __builtin_cpu_supports("avx2"))
+        kernels = &Kernels_AVX2;
+#elif defined(GPU2D_NEON)
+    if (!strcmp(name, Kernels_NEON.Name))
+        kernels = &Kernels_NEON;
+#endif
+
+    if (!kernels)
+        return false;
+
+    ForcedKernels = kernels;
+    return true;
+}
+
+const char* GetLineKernelsName() noexcept
+{
+    return GetKernels().Name;
+}
+
+void CompositeLine(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params) noexcept
+{
+    GetKernels().Composite(dst, above, below, windowmask, params);
+}
+
+void BrightnessUpLine(u32* line, u32 factor) noexcept
+{
+    GetKernels().BrightnessUp(line, factor);
+}
+
+void BrightnessDownLine(u32* line, u32 factor) noexcept
+{
+    GetKernels().BrightnessDown(line, factor);
+}
+
+void ExpandLine555(u32* dst, const u16* src) noexcept
+{
+    GetKernels().Expand555(dst, src);
+}
+
+void ConvertLineBGRA(u32* line) noexcept
+{
+    GetKernels().ConvertBGRA(line);
+}
+
+void CaptureLineA(u16* dst, const u32* srcA, u32 num) noexcept
+{
+    GetKernels().CaptureA(dst, srcA, num);
+}
+
+void CaptureLineAB(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb) noexcept
+{
+    GetKernels().CaptureAB(dst, srcA, srcB, num, eva, evb);
+}
+
+}
+}
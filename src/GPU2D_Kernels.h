@@ -0,0 +1,212 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef GPU2D_KERNELS_H
+#define GPU2D_KERNELS_H
+
+#include "types.h"
+
+// Color math used by the software 2D renderer.
+// Colors are 18-bit, with 6 bits per channel at bits 0, 8 and 16;
+// the top byte holds the layer flags.
+//
+// The per-line kernels do the same thing as the per-pixel functions over
+// a whole scanline. They use SSE2/AVX2 or NEON when the CPU has them,
+// which is checked once at runtime; the per-pixel functions double as
+// the reference implementation.
+
+namespace melonDS
+{
+namespace GPU2D
+{
+
+constexpr u32 ColorBlend4(u32 val1, u32 val2, u32 eva, u32 evb) noexcept
+{
+    u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000008) >> 4;
+    u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x000800) >> 4) & 0x007F00;
+    u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x080000) >> 4) & 0x7F0000;
+
+    if (r > 0x00003F) r = 0x00003F;
+    if (g > 0x003F00) g = 0x003F00;
+    if (b > 0x3F0000) b = 0x3F0000;
+
+    return r | g | b | 0xFF000000;
+}
+
+constexpr u32 ColorBlend5(u32 val1, u32 val2) noexcept
+{
+    u32 eva = ((val1 >> 24) & 0x1F) + 1;
+    u32 evb = 32 - eva;
+
+    if (eva == 32) return val1;
+
+    u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000010) >> 5;
+    u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x001000) >> 5) & 0x007F00;
+    u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x100000) >> 5) & 0x7F0000;
+
+    if (r > 0x00003F) r = 0x00003F;
+    if (g > 0x003F00) g = 0x003F00;
+    if (b > 0x3F0000) b = 0x3F0000;
+
+    return r | g | b | 0xFF000000;
+}
+
+constexpr u32 ColorBrightnessUp(u32 val, u32 factor, u32 bias) noexcept
+{
+    u32 rb = val & 0x3F003F;
+    u32 g = val & 0x003F00;
+
+    rb += (((((0x3F003F - rb) * factor) + (bias*0x010001)) >> 4) & 0x3F003F);
+    g +=  (((((0x003F00 - g ) * factor) + (bias*0x000100)) >> 4) & 0x003F00);
+
+    return rb | g | 0xFF000000;
+}
+
+constexpr u32 ColorBrightnessDown(u32 val, u32 factor, u32 bias) noexcept
+{
+    u32 rb = val & 0x3F003F;
+    u32 g = val & 0x003F00;
+
+    rb -= ((((rb * factor) + (bias*0x010001)) >> 4) & 0x3F003F);
+    g -=  ((((g  * factor) + (bias*0x000100)) >> 4) & 0x003F00);
+
+    return rb | g | 0xFF000000;
+}
+
+/// Color special effect settings of a 2D unit.
+/// EVA, EVB and EVY are expected to be clamped to 16, like the unit does.
+struct CompositeParams
+{
+    u32 BlendCnt;
+    u32 EVA, EVB;
+    u32 EVY;
+};
+
+/// Applies the color special effects to one pixel.
+/// @param val1 Topmost pixel.
+/// @param val2 Pixel right below it.
+/// @param windowmask Window mask for this pixel.
+inline u32 ColorComposite(u32 val1, u32 val2, u8 windowmask, const CompositeParams& params) noexcept
+{
+    u32 coloreffect = 0;
+    u32 eva, evb;
+
+    u32 flag1 = val1 >> 24;
+    u32 flag2 = val2 >> 24;
+
+    u32 blendCnt = params.BlendCnt;
+
+    u32 target2;
+    if      (flag2 & 0x80) target2 = 0x1000;
+    else if (flag2 & 0x40) target2 = 0x0100;
+    else                   target2 = flag2 << 8;
+
+    if ((flag1 & 0x80) && (blendCnt & target2))
+    {
+        // sprite blending
+
+        coloreffect = 1;
+
+        if (flag1 & 0x40)
+        {
+            eva = flag1 & 0x1F;
+            evb = 16 - eva;
+        }
+        else
+        {
+            eva = params.EVA;
+            evb = params.EVB;
+        }
+    }
+    else if ((flag1 & 0x40) && (blendCnt & target2))
+    {
+        // 3D layer blending
+
+        coloreffect = 4;
+    }
+    else
+    {
+        if      (flag1 & 0x80) flag1 = 0x10;
+        else if (flag1 & 0x40) flag1 = 0x01;
+
+        if ((blendCnt & flag1) && (windowmask & 0x20))
+        {
+            coloreffect = (blendCnt >> 6) & 0x3;
+
+            if (coloreffect == 1)
+            {
+                if (blendCnt & target2)
+                {
+                    eva = params.EVA;
+                    evb = params.EVB;
+                }
+                else
+                    coloreffect = 0;
+            }
+        }
+    }
+
+    switch (coloreffect)
+    {
+    case 0: return val1;
+    case 1: return ColorBlend4(val1, val2, eva, evb);
+    case 2: return ColorBrightnessUp(val1, params.EVY, 0x8);
+    case 3: return ColorBrightnessDown(val1, params.EVY, 0x7);
+    case 4: return ColorBlend5(val1, val2);
+    }
+
+    return val1;
+}
+
+/// @return The name of the instruction set used by the line kernels.
+const char* GetLineKernelsName() noexcept;
+
+/// Makes the line kernels use the given instruction set ("generic", "SSE2",
+/// "AVX2" or "NEON"), so they can be checked against each other.
+/// \c nullptr goes back to picking the best one for the CPU.
+/// Must not be called while anything is rendering.
+/// @return \c false if the instruction set isn't available here.
+bool SetLineKernels(const char* name) noexcept;
+
+/// ColorComposite over a 256-pixel line.
+/// \c dst may be the same as \c above.
+void CompositeLine(u32* dst, const u32* above, const u32* below, const u8* windowmask, const CompositeParams& params) noexcept;
+
+/// Master brightness over a 256-pixel line, in place.
+/// @param factor Brightness factor, up to 16.
+void BrightnessUpLine(u32* line, u32 factor) noexcept;
+void BrightnessDownLine(u32* line, u32 factor) noexcept;
+
+/// Converts 256 BGR555 pixels to 18-bit colors, with no layer flags.
+void ExpandLine555(u32* dst, const u16* src) noexcept;
+
+/// Converts a 256-pixel line of 18-bit colors to BGRA8888, in place.
+void ConvertLineBGRA(u32* line) noexcept;
+
+/// Display capture of source A only: converts 18-bit colors to BGR555,
+/// with the alpha bit set when the layer flags are nonzero.
+void CaptureLineA(u16* dst, const u32* srcA, u32 num) noexcept;
+
+/// Display capture blending source A (18-bit colors) with source B (BGR555).
+/// @param eva, evb Blending factors, up to 16.
+void CaptureLineAB(u16* dst, const u32* srcA, const u16* srcB, u32 num, u32 eva, u32 evb) noexcept;
+
+}
+}
+
+#endif // GPU2D_KERNELS_H
@@ -16,9 +16,13 @@
     with melonDS. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <algorithm>
+#include <string.h>
+
 #include "GPU2D_Soft.h"
 #include "GPU.h"
 #include "GPU3D.h"
+#include "Platform.h"
 
 namespace melonDS
 {
@@ -30,76 +34,19 @@ SoftRenderer::SoftRenderer(melonDS::GPU& gpu)
     // mosaic table is initialized at compile-time
 }
 
-u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
+CompositeParams SoftRenderer::GetCompositeParams() const
 {
-    u32 coloreffect = 0;
-    u32 eva, evb;
-
-    u32 flag1 = val1 >> 24;
-    u32 flag2 = val2 >> 24;
-
-    u32 blendCnt = CurUnit->BlendCnt;
-
-    u32 target2;
-    if      (flag2 & 0x80) target2 = 0x1000;
-    else if (flag2 & 0x40) target2 = 0x0100;
-    else                   target2 = flag2 << 8;
-
-    if ((flag1 & 0x80) && (blendCnt & target2))
-    {
-        // sprite blending
-
-        coloreffect = 1;
-
-        if (flag1 & 0x40)
-        {
-            eva = flag1 & 0x1F;
-            evb = 16 - eva;
-        }
-        else
-        {
-            eva = CurUnit->EVA;
-            evb = CurUnit->EVB;
-        }
-    }
-    else if ((flag1 & 0x40) && (blendCnt & target2))
-    {
-        // 3D layer blending
-
-        coloreffect = 4;
-    }
-    else
-    {
-        if      (flag1 & 0x80) flag1 = 0x10;
-        else if (flag1 & 0x40) flag1 = 0x01;
-
-        if ((blendCnt & flag1) && (WindowMask[i] & 0x20))
-        {
-            coloreffect = (blendCnt >> 6) & 0x3;
-
-            if (coloreffect == 1)
-            {
-                if (blendCnt & target2)
-                {
-                    eva = CurUnit->EVA;
-                    evb = CurUnit->EVB;
-                }
-                else
-                    coloreffect = 0;
-            }
-        }
-    }
-
-    switch (coloreffect)
-    {
-    case 0: return val1;
-    case 1: return ColorBlend4(val1, val2, eva, evb);
-    case 2: return ColorBrightnessUp(val1, CurUnit->EVY, 0x8);
-    case 3: return ColorBrightnessDown(val1, CurUnit->EVY, 0x7);
-    case 4: return ColorBlend5(val1, val2);
-    }
+    CompositeParams params;
+    params.BlendCnt = CurUnit->BlendCnt;
+    params.EVA = CurUnit->EVA;
+    params.EVB = CurUnit->EVB;
+    params.EVY = CurUnit->EVY;
+    return params;
+}
 
-    return val1;
+u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
+{
+    return GPU2D::ColorComposite(val1, val2, WindowMask[i], GetCompositeParams());
 }
 
 void SoftRenderer::DrawScanline(u32 line, Unit* unit)
@@ -112,25 +59,32 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
     int n3dline = line;
     line = GPU.VCount;
 
+    NumLinesDrawn++;
+
+    bool memChanged;
     if (CurUnit->Num == 0)
     {
         auto bgDirty = GPU.VRAMDirty_ABG.DeriveState(GPU.VRAMMap_ABG, GPU);
-        GPU.MakeVRAMFlat_ABGCoherent(bgDirty);
+        memChanged = GPU.MakeVRAMFlat_ABGCoherent(bgDirty);
         auto bgExtPalDirty = GPU.VRAMDirty_ABGExtPal.DeriveState(GPU.VRAMMap_ABGExtPal, GPU);
-        GPU.MakeVRAMFlat_ABGExtPalCoherent(bgExtPalDirty);
+        memChanged |= GPU.MakeVRAMFlat_ABGExtPalCoherent(bgExtPalDirty);
         auto objExtPalDirty = GPU.VRAMDirty_AOBJExtPal.DeriveState(&GPU.VRAMMap_AOBJExtPal, GPU);
-        GPU.MakeVRAMFlat_AOBJExtPalCoherent(objExtPalDirty);
+        memChanged |= GPU.MakeVRAMFlat_AOBJExtPalCoherent(objExtPalDirty);
     }
     else
     {
         auto bgDirty = GPU.VRAMDirty_BBG.DeriveState(GPU.VRAMMap_BBG, GPU);
-        GPU.MakeVRAMFlat_BBGCoherent(bgDirty);
+        memChanged = GPU.MakeVRAMFlat_BBGCoherent(bgDirty);
         auto bgExtPalDirty = GPU.VRAMDirty_BBGExtPal.DeriveState(GPU.VRAMMap_BBGExtPal, GPU);
-        GPU.MakeVRAMFlat_BBGExtPalCoherent(bgExtPalDirty);
+        memChanged |= GPU.MakeVRAMFlat_BBGExtPalCoherent(bgExtPalDirty);
         auto objExtPalDirty = GPU.VRAMDirty_BOBJExtPal.DeriveState(&GPU.VRAMMap_BOBJExtPal, GPU);
-        GPU.MakeVRAMFlat_BOBJExtPalCoherent(objExtPalDirty);
+        memChanged |= GPU.MakeVRAMFlat_BOBJExtPalCoherent(objExtPalDirty);
     }
 
+    memChanged |= GPU.CheckPaletteDirty(CurUnit->Num);
+    if (memChanged)
+        MemStamp[CurUnit->Num]++;
+
     bool forceblank = false;
 
     // scanlines that end up outside of the GPU drawing range
@@ -157,6 +111,9 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
 
     if (forceblank)
     {
+        // the line isn't what we cached for it anymore
+        LineCache[CurUnit->Num][n3dline].Valid = false;
+
         for (int i = 0; i < 256; i++)
             dst[i] = 0xFFFFFFFF;
 
@@ -170,10 +127,36 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
     u32 dispmode = CurUnit->DispCnt >> 16;
     dispmode &= (CurUnit->Num ? 0x1 : 0x3);
 
+    // if nothing the line depends on changed since the previous frame,
+    // the line we drew back then can be copied over.
+    // VRAM and FIFO display, as well as capture, are left out
+    bool cacheable = (dispmode < 2) && OBJStateValid[CurUnit->Num] &&
+                     !((CurUnit->Num == 0) && CurUnit->CaptureLatch);
+    OBJStateValid[CurUnit->Num] = false;
+
+    LineState state;
+    if (cacheable)
+    {
+        GetLineState(state, line);
+
+        if (ReuseLine(state, n3dline, dst, stride))
+        {
+            if (!(CurUnit->DispCnt & (1<<7)))
+                ApplySpriteMosaicX();
+            CurUnit->UpdateMosaicCounters(line);
+            return;
+        }
+    }
+
     // always render regular graphics
     DrawScanline_BGOBJ(line);
     CurUnit->UpdateMosaicCounters(line);
 
+    if (cacheable)
+        CacheLine(state, n3dline, dst);
+    else
+        LineCache[CurUnit->Num][n3dline].Valid = false;
+
     switch (dispmode)
     {
     case 0: // screen off
@@ -197,17 +180,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
             if (GPU.VRAMMap_LCDC & (1<<vrambank))
             {
                 u16* vram = (u16*)GPU.VRAM[vrambank];
-                vram = &vram[line * 256];
-
-                for (int i = 0; i < 256; i++)
-                {
-                    u16 color = vram[i];
-                    u8 r = (color & 0x001F) << 1;
-                    u8 g = (color & 0x03E0) >> 4;
-                    u8 b = (color & 0x7C00) >> 9;
-
-                    dst[i] = r | (g << 8) | (b << 16);
-                }
+                ExpandLine555(dst, &vram[line * 256]);
             }
             else
             {
@@ -220,17 +193,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
         break;
 
     case 3: // FIFO display
-        {
-            for (int i = 0; i < 256; i++)
-            {
-                u16 color = CurUnit->DispFIFOBuffer[i];
-                u8 r = (color & 0x001F) << 1;
-                u8 g = (color & 0x03E0) >> 4;
-                u8 b = (color & 0x7C00) >> 9;
-
-                dst[i] = r | (g << 8) | (b << 16);
-            }
-        }
+        ExpandLine555(dst, CurUnit->DispFIFOBuffer);
         break;
     }
 
@@ -271,10 +234,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
             u32 factor = masterBrightness & 0x1F;
             if (factor > 16) factor = 16;
 
-            for (int i = 0; i < 256; i++)
-            {
-                dst[i] = ColorBrightnessUp(dst[i], factor, 0x0);
-            }
+            BrightnessUpLine(dst, factor);
         }
         else if ((masterBrightness >> 14) == 2)
         {
@@ -282,31 +242,122 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
             u32 factor = masterBrightness & 0x1F;
             if (factor > 16) factor = 16;
 
-            for (int i = 0; i < 256; i++)
-            {
-                dst[i] = ColorBrightnessDown(dst[i], factor, 0xF);
-            }
+            BrightnessDownLine(dst, factor);
         }
     }
 
     // convert to 32-bit BGRA
-    // note: 32-bit RGBA would be more straightforward, but
-    // BGRA seems to be more compatible (Direct2D soft, cairo...)
-    for (int i = 0; i < 256; i+=2)
+    ConvertLineBGRA(dst);
+}
+
+void SoftRenderer::GetLineState(LineState& state, u32 line) const
+{
+    memset(&state, 0, sizeof(state));
+
+    state.VCount = line;
+    state.MemStamp = MemStamp[CurUnit->Num];
+    state.OBJ = OBJState[CurUnit->Num];
+
+    state.DispCnt = CurUnit->DispCnt;
+    memcpy(state.BGCnt, CurUnit->BGCnt, sizeof(state.BGCnt));
+    memcpy(state.BGXPos, CurUnit->BGXPos, sizeof(state.BGXPos));
+    memcpy(state.BGYPos, CurUnit->BGYPos, sizeof(state.BGYPos));
+    memcpy(state.BGXRefInternal, CurUnit->BGXRefInternal, sizeof(state.BGXRefInternal));
+    memcpy(state.BGYRefInternal, CurUnit->BGYRefInternal, sizeof(state.BGYRefInternal));
+    memcpy(state.BGRotA, CurUnit->BGRotA, sizeof(state.BGRotA));
+    memcpy(state.BGRotB, CurUnit->BGRotB, sizeof(state.BGRotB));
+    memcpy(state.BGRotC, CurUnit->BGRotC, sizeof(state.BGRotC));
+    memcpy(state.BGRotD, CurUnit->BGRotD, sizeof(state.BGRotD));
+
+    memcpy(state.Win0Coords, CurUnit->Win0Coords, sizeof(state.Win0Coords));
+    memcpy(state.Win1Coords, CurUnit->Win1Coords, sizeof(state.Win1Coords));
+    memcpy(state.WinCnt, CurUnit->WinCnt, sizeof(state.WinCnt));
+    state.Win0Active = CurUnit->Win0Active;
+    state.Win1Active = CurUnit->Win1Active;
+
+    memcpy(state.BGMosaicSize, CurUnit->BGMosaicSize, sizeof(state.BGMosaicSize));
+    memcpy(state.OBJMosaicSize, CurUnit->OBJMosaicSize, sizeof(state.OBJMosaicSize));
+    state.BGMosaicY = CurUnit->BGMosaicY;
+    state.BGMosaicYMax = CurUnit->BGMosaicYMax;
+
+    state.BlendCnt = CurUnit->BlendCnt;
+    state.EVA = CurUnit->EVA;
+    state.EVB = CurUnit->EVB;
+    state.EVY = CurUnit->EVY;
+    state.MasterBrightness = CurUnit->MasterBrightness;
+
+    state.RenderXPos = GPU.GPU3D.GetRenderXPos();
+    state.AbortFrame = GPU.GPU3D.AbortFrame;
+}
+
+bool SoftRenderer::ReuseLine(const LineState& state, u32 line, u32* dst, int stride)
+{
+    CachedLine& cached = LineCache[CurUnit->Num][line];
+
+    if (!cached.Valid) return false;
+    if (memcmp(&state, &cached.State, sizeof(LineState)) != 0) return false;
+
+    // the 3D layer also needs to be the same as when the line was drawn,
+    // which we can only tell from one frame to the next
+    if ((CurUnit->Num == 0) && ((CurUnit->DispCnt & 0x108) == 0x108) && !GPU.GPU3D.IsRendererAccelerated())
+    {
+        if (cached.Frame != FrameCount-1) return false;
+        if (!GPU.GPU3D.IsRendererFrameIdentical()) return false;
+    }
+
+    if (cached.Dst != dst)
     {
-        u64 c = *(u64*)&dst[i];
+        memcpy(dst, cached.Dst, stride * 4);
+        cached.Dst = dst;
+    }
+    cached.Frame = FrameCount;
+
+    // leave the unit in the state drawing the line would have
+    memcpy(CurUnit->BGXRefInternal, cached.BGXRefInternal, sizeof(cached.BGXRefInternal));
+    memcpy(CurUnit->BGYRefInternal, cached.BGYRefInternal, sizeof(cached.BGYRefInternal));
+    CurUnit->BGMosaicY = cached.BGMosaicY;
+    CurUnit->BGMosaicYMax = cached.BGMosaicYMax;
+
+    NumLinesReused++;
+    return true;
+}
+
+void SoftRenderer::CacheLine(const LineState& state, u32 line, u32* dst)
+{
+    CachedLine& cached = LineCache[CurUnit->Num][line];
 
-        u64 r = (c << 18) & 0xFC000000FC0000;
-        u64 g = (c << 2) & 0xFC000000FC00;
-        u64 b = (c >> 14) & 0xFC000000FC;
-        c = r | g | b;
+    cached.Valid = true;
+    memcpy(&cached.State, &state, sizeof(LineState));
+    cached.Frame = FrameCount;
+    cached.Dst = dst;
 
-        *(u64*)&dst[i] = c | ((c & 0x00C0C0C000C0C0C0) >> 6) | 0xFF000000FF000000;
+    memcpy(cached.BGXRefInternal, CurUnit->BGXRefInternal, sizeof(cached.BGXRefInternal));
+    memcpy(cached.BGYRefInternal, CurUnit->BGYRefInternal, sizeof(cached.BGYRefInternal));
+    cached.BGMosaicY = CurUnit->BGMosaicY;
+    cached.BGMosaicYMax = CurUnit->BGMosaicYMax;
+}
+
+void SoftRenderer::ResetLineCache()
+{
+    if (NumLinesDrawn)
+    {
+        Platform::Log(Platform::LogLevel::Debug, "2D line cache: %llu lines drawn, %llu reused\n",
+            (unsigned long long)NumLinesDrawn, (unsigned long long)NumLinesReused);
+        NumLinesDrawn = 0;
+        NumLinesReused = 0;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 192; j++)
+            LineCache[i][j].Valid = false;
     }
 }
 
 void SoftRenderer::VBlankEnd(Unit* unitA, Unit* unitB)
 {
+    FrameCount++;
+
 #ifdef OGLRENDERER_ENABLED
     if (Renderer3D& renderer3d = GPU.GPU3D.GetCurrentRenderer(); renderer3d.Accelerated)
     {
@@ -402,7 +453,7 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
         }
     }
 
-    u16* srcB = NULL;
+    const u16* srcB = NULL;
     u32 srcBaddr = line * 256;
 
     if (captureCnt & (1<<25))
@@ -426,117 +477,47 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
     static_assert(VRAMDirtyGranularity == 512);
     GPU.VRAMDirty[dstvram][(dstaddr * 2) / VRAMDirtyGranularity] = true;
 
-    switch ((captureCnt >> 29) & 0x3)
-    {
-    case 0: // source A
-        {
-            for (u32 i = 0; i < width; i++)
-            {
-                u32 val = srcA[i];
-
-                // TODO: check what happens when alpha=0
+    u32 eva = captureCnt & 0x1F;
+    u32 evb = (captureCnt >> 8) & 0x1F;
 
-                u32 r = (val >> 1) & 0x1F;
-                u32 g = (val >> 9) & 0x1F;
-                u32 b = (val >> 17) & 0x1F;
-                u32 a = ((val >> 24) != 0) ? 0x8000 : 0;
+    // checkme
+    if (eva > 16) eva = 16;
+    if (evb > 16) evb = 16;
 
-                dst[dstaddr] = r | (g << 5) | (b << 10) | a;
-                dstaddr = (dstaddr + 1) & 0xFFFF;
-            }
-        }
-        break;
+    // unmapped source B reads as zero
+    static const u16 blankB[256] = {};
+    if (!srcB)
+    {
+        srcB = blankB;
+        srcBaddr = 0;
+    }
 
-    case 1: // source B
-        {
-            if (srcB)
-            {
-                for (u32 i = 0; i < width; i++)
-                {
-                    dst[dstaddr] = srcB[srcBaddr];
-                    srcBaddr = (srcBaddr + 1) & 0xFFFF;
-                    dstaddr = (dstaddr + 1) & 0xFFFF;
-                }
-            }
-            else
-            {
-                for (u32 i = 0; i < width; i++)
-                {
-                    dst[dstaddr] = 0;
-                    dstaddr = (dstaddr + 1) & 0xFFFF;
-                }
-            }
-        }
-        break;
+    // the addresses wrap around within the VRAM banks, so the line is
+    // processed in chunks that stop at the end of either bank
+    for (u32 i = 0; i < width;)
+    {
+        u32 num = std::min(width - i, 0x10000 - dstaddr);
+        num = std::min(num, 0x10000 - srcBaddr);
 
-    case 2: // sources A+B
-    case 3:
+        switch ((captureCnt >> 29) & 0x3)
         {
-            u32 eva = captureCnt & 0x1F;
-            u32 evb = (captureCnt >> 8) & 0x1F;
-
-            // checkme
-            if (eva > 16) eva = 16;
-            if (evb > 16) evb = 16;
-
-            if (srcB)
-            {
-                for (u32 i = 0; i < width; i++)
-                {
-                    u32 val = srcA[i];
-
-                    // TODO: check what happens when alpha=0
+        case 0: // source A
+            CaptureLineA(&dst[dstaddr], &srcA[i], num);
+            break;
 
-                    u32 rA = (val >> 1) & 0x1F;
-                    u32 gA = (val >> 9) & 0x1F;
-                    u32 bA = (val >> 17) & 0x1F;
-                    u32 aA = ((val >> 24) != 0) ? 1 : 0;
+        case 1: // source B
+            memcpy(&dst[dstaddr], &srcB[srcBaddr], num * 2);
+            break;
 
-                    val = srcB[srcBaddr];
-
-                    u32 rB = val & 0x1F;
-                    u32 gB = (val >> 5) & 0x1F;
-                    u32 bB = (val >> 10) & 0x1F;
-                    u32 aB = val >> 15;
-
-                    u32 rD = ((rA * aA * eva) + (rB * aB * evb) + 8) >> 4;
-                    u32 gD = ((gA * aA * eva) + (gB * aB * evb) + 8) >> 4;
-                    u32 bD = ((bA * aA * eva) + (bB * aB * evb) + 8) >> 4;
-                    u32 aD = (eva>0 ? aA : 0) | (evb>0 ? aB : 0);
-
-                    if (rD > 0x1F) rD = 0x1F;
-                    if (gD > 0x1F) gD = 0x1F;
-                    if (bD > 0x1F) bD = 0x1F;
-
-                    dst[dstaddr] = rD | (gD << 5) | (bD << 10) | (aD << 15);
-                    srcBaddr = (srcBaddr + 1) & 0xFFFF;
-                    dstaddr = (dstaddr + 1) & 0xFFFF;
-                }
-            }
-            else
-            {
-                for (u32 i = 0; i < width; i++)
-                {
-                    u32 val = srcA[i];
-
-                    // TODO: check what happens when alpha=0
-
-                    u32 rA = (val >> 1) & 0x1F;
-                    u32 gA = (val >> 9) & 0x1F;
-                    u32 bA = (val >> 17) & 0x1F;
-                    u32 aA = ((val >> 24) != 0) ? 1 : 0;
-
-                    u32 rD = ((rA * aA * eva) + 8) >> 4;
-                    u32 gD = ((gA * aA * eva) + 8) >> 4;
-                    u32 bD = ((bA * aA * eva) + 8) >> 4;
-                    u32 aD = (eva>0 ? aA : 0);
-
-                    dst[dstaddr] = rD | (gD << 5) | (bD << 10) | (aD << 15);
-                    dstaddr = (dstaddr + 1) & 0xFFFF;
-                }
-            }
+        case 2: // sources A+B
+        case 3:
+            CaptureLineAB(&dst[dstaddr], &srcA[i], &srcB[srcBaddr], num, eva, evb);
+            break;
         }
-        break;
+
+        i += num;
+        dstaddr = (dstaddr + num) & 0xFFFF;
+        srcBaddr = (srcBaddr + num) & 0xFFFF;
     }
 }
 
@@ -716,6 +697,13 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
             *(u64*)&BGOBJLine[i] = backdrop;
     }
 
+    // there is nothing below the backdrop: pixels where no layer gets drawn
+    // must not be blended with what the previous scanline left in there
+    if (GPU.GPU3D.IsRendererAccelerated())
+        memset(&BGOBJLine[256], 0, 256*2*4);
+    else
+        memset(&BGOBJLine[256], 0, 256*4);
+
     if (CurUnit->DispCnt & 0xE000)
         CurUnit->CalculateWindowMask(line, WindowMask, OBJWindow[CurUnit->Num]);
     else
@@ -741,13 +729,7 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
 
     if (!GPU.GPU3D.IsRendererAccelerated())
     {
-        for (int i = 0; i < 256; i++)
-        {
-            u32 val1 = BGOBJLine[i];
-            u32 val2 = BGOBJLine[256+i];
-
-            BGOBJLine[i] = ColorComposite(i, val1, val2);
-        }
+        CompositeLine(BGOBJLine, BGOBJLine, &BGOBJLine[256], WindowMask, GetCompositeParams());
     }
     else
     {
@@ -829,12 +811,10 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
         }
         else
         {
+            CompositeLine(BGOBJLine, BGOBJLine, &BGOBJLine[256], WindowMask, GetCompositeParams());
+
             for (int i = 0; i < 256; i++)
             {
-                u32 val1 = BGOBJLine[i];
-                u32 val2 = BGOBJLine[256+i];
-
-                BGOBJLine[i]     = ColorComposite(i, val1, val2);
                 BGOBJLine[256+i] = 0;
                 BGOBJLine[512+i] = 0x07000000;
             }
@@ -911,6 +891,33 @@ void SoftRenderer::DrawBG_3D()
     }
 }
 
+// reads the 8 pixels of a tile row as palette indices, leftmost one in the low byte
+static inline u64 ReadTileRow(const u8* bgvram, u32 bgvrammask, u32 addr, bool bpp8, bool hflip)
+{
+    u64 row;
+    if (bpp8)
+    {
+        // rows are 8-byte aligned, so this never crosses the end of BG VRAM
+        memcpy(&row, &bgvram[addr & bgvrammask], 8);
+    }
+    else
+    {
+        u32 packed;
+        memcpy(&packed, &bgvram[addr & bgvrammask], 4);
+
+        // spread the bytes over 16-bit lanes, then split their nibbles
+        row = packed;
+        row = (row | (row << 16)) & 0x0000FFFF0000FFFF;
+        row = (row | (row << 8))  & 0x00FF00FF00FF00FF;
+        row = (row & 0x000F000F000F000F) | ((row << 4) & 0x0F000F000F000F00);
+    }
+
+    if (hflip)
+        row = __builtin_bswap64(row);
+
+    return row;
+}
+
 template<bool mosaic, SoftRenderer::DrawPixel drawPixel>
 void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
 {
@@ -968,7 +975,49 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
     u8 color;
     u32 lastxpos;
 
-    if (bgcnt & 0x0080)
+    if (!mosaic)
+    {
+        // go through the line one tile at a time
+        bool bpp8 = bgcnt & 0x0080;
+        u32 tilerow = yoff & 0x7;
+
+        for (int i = 0; i < 256;)
+        {
+            curtile = *(u16*)&bgvram[(tilemapaddr + ((xoff & 0xF8) >> 2) + ((xoff & widexmask) << 3)) & bgvrammask];
+
+            u32 row = (curtile & 0x0800) ? (7-tilerow) : tilerow;
+            if (bpp8)
+            {
+                if (extpal) curpal = CurUnit->GetBGExtPal(extpalslot, curtile>>12);
+                else        curpal = pal;
+
+                pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 6) + (row << 3);
+            }
+            else
+            {
+                curpal = pal + ((curtile & 0xF000) >> 8);
+                pixelsaddr = tilesetaddr + ((curtile & 0x03FF) << 5) + (row << 2);
+            }
+
+            u32 start = xoff & 0x7;
+            u32 end = std::min(8u, start + (256 - i));
+
+            u64 pixels = ReadTileRow(bgvram, bgvrammask, pixelsaddr, bpp8, curtile & 0x0400);
+            if (pixels)
+            {
+                for (u32 x = start; x < end; x++)
+                {
+                    color = (pixels >> (x << 3)) & 0xFF;
+                    if (color && (WindowMask[i + x - start] & (1<<bgnum)))
+                        drawPixel(&BGOBJLine[i + x - start], curpal[color], 0x01000000<<bgnum);
+                }
+            }
+
+            i += end - start;
+            xoff += end - start;
+        }
+    }
+    else if (bgcnt & 0x0080)
     {
         // 256-color
 
@@ -1598,23 +1647,80 @@ void SoftRenderer::DrawSprites(u32 line, Unit* unit)
         CurUnit->OBJMosaicYCount = 0;
     }
 
+    bool memChanged;
     if (CurUnit->Num == 0)
     {
         auto objDirty = GPU.VRAMDirty_AOBJ.DeriveState(GPU.VRAMMap_AOBJ, GPU);
-        GPU.MakeVRAMFlat_AOBJCoherent(objDirty);
+        memChanged = GPU.MakeVRAMFlat_AOBJCoherent(objDirty);
     }
     else
     {
         auto objDirty = GPU.VRAMDirty_BOBJ.DeriveState(GPU.VRAMMap_BOBJ, GPU);
-        GPU.MakeVRAMFlat_BOBJCoherent(objDirty);
+        memChanged = GPU.MakeVRAMFlat_BOBJCoherent(objDirty);
     }
 
+    if (memChanged)
+        MemStamp[CurUnit->Num]++;
+
+    OBJLineState& objstate = OBJState[CurUnit->Num];
+    objstate.Line = line;
+    objstate.DispCnt = CurUnit->DispCnt;
+    objstate.MosaicY = CurUnit->OBJMosaicY;
+    objstate.MemStamp = MemStamp[CurUnit->Num];
+    OBJStateValid[CurUnit->Num] = true;
+
     NumSprites[CurUnit->Num] = 0;
     memset(OBJLine[CurUnit->Num], 0, 256*4);
     memset(OBJWindow[CurUnit->Num], 0, 256);
     if (!(CurUnit->DispCnt & 0x1000)) return;
 
-    u16* oam = (u16*)&GPU.OAM[CurUnit->Num ? 0x400 : 0];
+    SpriteBins& bins = OBJBins[CurUnit->Num];
+    if (GPU.CheckOAMDirty(CurUnit->Num) || !bins.Valid)
+    {
+        BinSprites(CurUnit->Num);
+        objstate.MemStamp = ++MemStamp[CurUnit->Num];
+    }
+
+    const u64* linemask = bins.LineMask[line & 0xFF];
+    for (int i = 0; i < 2; i++)
+    {
+        u64 mask = linemask[i];
+        while (mask)
+        {
+            const SpriteInfo& spr = bins.Sprites[(i << 6) | __builtin_ctzll(mask)];
+            mask &= (mask - 1);
+
+            bool iswin = spr.Window;
+
+            u32 sprline;
+            if (spr.Mosaic)
+            {
+                // apply Y mosaic
+                sprline = CurUnit->OBJMosaicY;
+            }
+            else
+                sprline = line;
+
+            u32 ypos = (sprline - spr.YPos) & 0xFF;
+
+            if (spr.Rotscale)
+            {
+                DoDrawSprite(Rotscale, spr.Num, spr.BoundWidth, spr.BoundHeight, spr.Width, spr.Height, spr.XPos, ypos);
+            }
+            else
+            {
+                DoDrawSprite(Normal, spr.Num, spr.Width, spr.Height, spr.XPos, ypos);
+            }
+
+            NumSprites[CurUnit->Num]++;
+        }
+    }
+}
+
+void SoftRenderer::BinSprites(u32 num)
+{
+    SpriteBins& bins = OBJBins[num];
+    u16* oam = (u16*)&GPU.OAM[num ? 0x400 : 0];
 
     const s32 spritewidth[16] =
     {
@@ -1631,6 +1737,9 @@ void SoftRenderer::DrawSprites(u32 line, Unit* unit)
         64, 32, 64, 8
     };
 
+    bins.Count = 0;
+    memset(bins.LineMask, 0, sizeof(bins.LineMask));
+
     for (int bgnum = 0x0C00; bgnum >= 0x0000; bgnum -= 0x0400)
     {
         for (int sprnum = 127; sprnum >= 0; sprnum--)
@@ -1640,70 +1749,50 @@ void SoftRenderer::DrawSprites(u32 line, Unit* unit)
             if ((attrib[2] & 0x0C00) != bgnum)
                 continue;
 
-            bool iswin = (((attrib[0] >> 10) & 0x3) == 2);
-
-            u32 sprline;
-            if ((attrib[0] & 0x1000) && !iswin)
-            {
-                // apply Y mosaic
-                sprline = CurUnit->OBJMosaicY;
-            }
-            else
-                sprline = line;
+            u32 sizeparam = (attrib[0] >> 14) | ((attrib[1] & 0xC000) >> 12);
+            s32 width = spritewidth[sizeparam];
+            s32 height = spriteheight[sizeparam];
+            s32 boundwidth = width;
+            s32 boundheight = height;
 
             if (attrib[0] & 0x0100)
             {
-                u32 sizeparam = (attrib[0] >> 14) | ((attrib[1] & 0xC000) >> 12);
-                s32 width = spritewidth[sizeparam];
-                s32 height = spriteheight[sizeparam];
-                s32 boundwidth = width;
-                s32 boundheight = height;
-
                 if (attrib[0] & 0x0200)
                 {
                     boundwidth <<= 1;
                     boundheight <<= 1;
                 }
-
-                u32 ypos = attrib[0] & 0xFF;
-                if (((line - ypos) & 0xFF) >= (u32)boundheight)
-                    continue;
-                ypos = (sprline - ypos) & 0xFF;
-
-                s32 xpos = (s32)(attrib[1] << 23) >> 23;
-                if (xpos <= -boundwidth)
-                    continue;
-
-                u32 rotparamgroup = (attrib[1] >> 9) & 0x1F;
-
-                DoDrawSprite(Rotscale, sprnum, boundwidth, boundheight, width, height, xpos, ypos);
-
-                NumSprites[CurUnit->Num]++;
             }
-            else
-            {
-                if (attrib[0] & 0x0200)
-                    continue;
-
-                u32 sizeparam = (attrib[0] >> 14) | ((attrib[1] & 0xC000) >> 12);
-                s32 width = spritewidth[sizeparam];
-                s32 height = spriteheight[sizeparam];
-
-                u32 ypos = attrib[0] & 0xFF;
-                if (((line - ypos) & 0xFF) >= (u32)height)
-                    continue;
-                ypos = (sprline - ypos) & 0xFF;
-
-                s32 xpos = (s32)(attrib[1] << 23) >> 23;
-                if (xpos <= -width)
-                    continue;
+            else if (attrib[0] & 0x0200)
+                continue;
 
-                DoDrawSprite(Normal, sprnum, width, height, xpos, ypos);
+            s32 xpos = (s32)(attrib[1] << 23) >> 23;
+            if (xpos <= -boundwidth)
+                continue;
 
-                NumSprites[CurUnit->Num]++;
+            u32 idx = bins.Count++;
+            SpriteInfo& spr = bins.Sprites[idx];
+
+            spr.Num = sprnum;
+            spr.Rotscale = attrib[0] & 0x0100;
+            spr.Window = (((attrib[0] >> 10) & 0x3) == 2);
+            spr.Mosaic = (attrib[0] & 0x1000) && !spr.Window;
+            spr.XPos = xpos;
+            spr.YPos = attrib[0] & 0xFF;
+            spr.Width = width;
+            spr.Height = height;
+            spr.BoundWidth = boundwidth;
+            spr.BoundHeight = boundheight;
+
+            for (s32 y = 0; y < boundheight; y++)
+            {
+                u32 sprline = (spr.YPos + y) & 0xFF;
+                bins.LineMask[sprline][idx >> 6] |= (1ULL << (idx & 0x3F));
             }
         }
     }
+
+    bins.Valid = true;
 }
 
 template<bool window>
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "GPU2D.h"
+#include "GPU2D_Kernels.h"
 
 namespace melonDS
 {
@@ -36,6 +37,7 @@ public:
     void DrawScanline(u32 line, Unit* unit) override;
     void DrawSprites(u32 line, Unit* unit) override;
     void VBlankEnd(Unit* unitA, Unit* unitB) override;
+    void ResetLineCache() override;
 private:
     melonDS::GPU& GPU;
     alignas(8) u32 BGOBJLine[256*3];
@@ -48,6 +50,104 @@ private:
 
     u32 NumSprites[2];
 
+    // sprites that may show up on screen, in drawing order, with their
+    // position and size decoded. Rebuilt whenever OAM is written to.
+    struct SpriteInfo
+    {
+        u8 Num;
+        bool Rotscale;
+        bool Window;
+        bool Mosaic;
+        s16 XPos;
+        u8 YPos;
+        u8 Width, Height;
+        u8 BoundWidth, BoundHeight;
+    };
+
+    struct SpriteBins
+    {
+        bool Valid = false;
+        u32 Count;
+        SpriteInfo Sprites[128];
+        // for each scanline, which of the sprites above cover it
+        u64 LineMask[256][2];
+    };
+
+    SpriteBins OBJBins[2];
+
+    // what the sprites in OBJLine were drawn from
+    struct OBJLineState
+    {
+        u32 Line;
+        u32 DispCnt;
+        u32 MosaicY;
+        u32 MemStamp;
+    };
+
+    // everything a scanline is drawn from, besides memory contents.
+    // compared with memcmp, so it must be zero-filled before being set up
+    struct LineState
+    {
+        u32 VCount;
+        u32 MemStamp;
+        OBJLineState OBJ;
+
+        u32 DispCnt;
+        u16 BGCnt[4];
+        u16 BGXPos[4];
+        u16 BGYPos[4];
+        s32 BGXRefInternal[2];
+        s32 BGYRefInternal[2];
+        s16 BGRotA[2];
+        s16 BGRotB[2];
+        s16 BGRotC[2];
+        s16 BGRotD[2];
+
+        u8 Win0Coords[4];
+        u8 Win1Coords[4];
+        u8 WinCnt[4];
+        u32 Win0Active;
+        u32 Win1Active;
+
+        u8 BGMosaicSize[2];
+        u8 OBJMosaicSize[2];
+        u8 BGMosaicY, BGMosaicYMax;
+
+        u16 BlendCnt;
+        u8 EVA, EVB;
+        u8 EVY;
+        u16 MasterBrightness;
+
+        u16 RenderXPos;
+        bool AbortFrame;
+    };
+
+    // a scanline from a previous frame, which can be copied over
+    // as long as the state it was drawn from is still the same
+    struct CachedLine
+    {
+        bool Valid = false;
+        LineState State;
+        u32 Frame;
+        u32* Dst;
+
+        // unit state as left by drawing the line
+        s32 BGXRefInternal[2];
+        s32 BGYRefInternal[2];
+        u8 BGMosaicY, BGMosaicYMax;
+    };
+
+    // bumped whenever a change to the VRAM, palette or OAM of a unit is seen
+    u32 MemStamp[2] {};
+    OBJLineState OBJState[2] {};
+    bool OBJStateValid[2] {};
+
+    u32 FrameCount = 0;
+    CachedLine LineCache[2][192];
+    // logged whenever the cache is reset
+    u64 NumLinesDrawn = 0;
+    u64 NumLinesReused = 0;
+
     u8* CurBGXMosaicTable;
     array2d<u8, 16, 256> MosaicTable = []() constexpr
     {
@@ -65,58 +165,7 @@ private:
         return table;
     }();
 
-    static constexpr u32 ColorBlend4(u32 val1, u32 val2, u32 eva, u32 evb) noexcept
-    {
-        u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000008) >> 4;
-        u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x000800) >> 4) & 0x007F00;
-        u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x080000) >> 4) & 0x7F0000;
-
-        if (r > 0x00003F) r = 0x00003F;
-        if (g > 0x003F00) g = 0x003F00;
-        if (b > 0x3F0000) b = 0x3F0000;
-
-        return r | g | b | 0xFF000000;
-    }
-
-    static constexpr u32 ColorBlend5(u32 val1, u32 val2) noexcept
-    {
-        u32 eva = ((val1 >> 24) & 0x1F) + 1;
-        u32 evb = 32 - eva;
-
-        if (eva == 32) return val1;
-
-        u32 r =  (((val1 & 0x00003F) * eva) + ((val2 & 0x00003F) * evb) + 0x000010) >> 5;
-        u32 g = ((((val1 & 0x003F00) * eva) + ((val2 & 0x003F00) * evb) + 0x001000) >> 5) & 0x007F00;
-        u32 b = ((((val1 & 0x3F0000) * eva) + ((val2 & 0x3F0000) * evb) + 0x100000) >> 5) & 0x7F0000;
-
-        if (r > 0x00003F) r = 0x00003F;
-        if (g > 0x003F00) g = 0x003F00;
-        if (b > 0x3F0000) b = 0x3F0000;
-
-        return r | g | b | 0xFF000000;
-    }
-
-    static constexpr u32 ColorBrightnessUp(u32 val, u32 factor, u32 bias) noexcept
-    {
-        u32 rb = val & 0x3F003F;
-        u32 g = val & 0x003F00;
-
-        rb += (((((0x3F003F - rb) * factor) + (bias*0x010001)) >> 4) & 0x3F003F);
-        g +=  (((((0x003F00 - g ) * factor) + (bias*0x000100)) >> 4) & 0x003F00);
-
-        return rb | g | 0xFF000000;
-    }
-
-    static constexpr u32 ColorBrightnessDown(u32 val, u32 factor, u32 bias) noexcept
-    {
-        u32 rb = val & 0x3F003F;
-        u32 g = val & 0x003F00;
-
-        rb -= ((((rb * factor) + (bias*0x010001)) >> 4) & 0x3F003F);
-        g -=  ((((g  * factor) + (bias*0x000100)) >> 4) & 0x003F00);
-
-        return rb | g | 0xFF000000;
-    }
+    CompositeParams GetCompositeParams() const;
     u32 ColorComposite(int i, u32 val1, u32 val2) const;
 
     template<u32 bgmode> void DrawScanlineBGMode(u32 line);
@@ -136,12 +185,17 @@ private:
     template<bool mosaic, DrawPixel drawPixel> void DrawBG_Large(u32 line);
 
     void ApplySpriteMosaicX();
+    void BinSprites(u32 num);
     template<DrawPixel drawPixel>
     void InterleaveSprites(u32 prio);
     template<bool window> void DrawSprite_Rotscale(u32 num, u32 boundwidth, u32 boundheight, u32 width, u32 height, s32 xpos, s32 ypos);
     template<bool window> void DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s32 ypos);
 
     void DoCapture(u32 line, u32 width);
+
+    void GetLineState(LineState& state, u32 line) const;
+    bool ReuseLine(const LineState& state, u32 line, u32* dst, int stride);
+    void CacheLine(const LineState& state, u32 line, u32* dst);
 };
 
 }
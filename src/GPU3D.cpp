@@ -23,6 +23,7 @@
 #include "GPU.h"
 #include "FIFO.h"
 #include "GPU3D_Soft.h"
+#include "GPU3D_Kernels.h"
 #include "Platform.h"
 #include "GPU3D.h"
 
@@ -529,6 +530,8 @@ void GPU3D::DoSavestate(Savestate* file) noexcept
 
             RenderPolygonRAM[i] = index == UINT32_MAX ? nullptr : &PolygonRAM[index];
         }
+
+        UpdateRenderGeometry();
     }
 
     file->VarArray(CurVertex, sizeof(s16)*3);
@@ -595,82 +598,6 @@ void MatrixLoad4x3(s32* m, s32* s)
     m[12] = s[9]; m[13] = s[10]; m[14] = s[11]; m[15] = 0x1000;
 }
 
-void MatrixMult4x4(s32* m, s32* s)
-{
-    s32 tmp[16];
-    memcpy(tmp, m, 16*4);
-
-    // m = s*m
-    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8] + (s64)s[3]*tmp[12]) >> 12;
-    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9] + (s64)s[3]*tmp[13]) >> 12;
-    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10] + (s64)s[3]*tmp[14]) >> 12;
-    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11] + (s64)s[3]*tmp[15]) >> 12;
-
-    m[4] = ((s64)s[4]*tmp[0] + (s64)s[5]*tmp[4] + (s64)s[6]*tmp[8] + (s64)s[7]*tmp[12]) >> 12;
-    m[5] = ((s64)s[4]*tmp[1] + (s64)s[5]*tmp[5] + (s64)s[6]*tmp[9] + (s64)s[7]*tmp[13]) >> 12;
-    m[6] = ((s64)s[4]*tmp[2] + (s64)s[5]*tmp[6] + (s64)s[6]*tmp[10] + (s64)s[7]*tmp[14]) >> 12;
-    m[7] = ((s64)s[4]*tmp[3] + (s64)s[5]*tmp[7] + (s64)s[6]*tmp[11] + (s64)s[7]*tmp[15]) >> 12;
-
-    m[8] = ((s64)s[8]*tmp[0] + (s64)s[9]*tmp[4] + (s64)s[10]*tmp[8] + (s64)s[11]*tmp[12]) >> 12;
-    m[9] = ((s64)s[8]*tmp[1] + (s64)s[9]*tmp[5] + (s64)s[10]*tmp[9] + (s64)s[11]*tmp[13]) >> 12;
-    m[10] = ((s64)s[8]*tmp[2] + (s64)s[9]*tmp[6] + (s64)s[10]*tmp[10] + (s64)s[11]*tmp[14]) >> 12;
-    m[11] = ((s64)s[8]*tmp[3] + (s64)s[9]*tmp[7] + (s64)s[10]*tmp[11] + (s64)s[11]*tmp[15]) >> 12;
-
-    m[12] = ((s64)s[12]*tmp[0] + (s64)s[13]*tmp[4] + (s64)s[14]*tmp[8] + (s64)s[15]*tmp[12]) >> 12;
-    m[13] = ((s64)s[12]*tmp[1] + (s64)s[13]*tmp[5] + (s64)s[14]*tmp[9] + (s64)s[15]*tmp[13]) >> 12;
-    m[14] = ((s64)s[12]*tmp[2] + (s64)s[13]*tmp[6] + (s64)s[14]*tmp[10] + (s64)s[15]*tmp[14]) >> 12;
-    m[15] = ((s64)s[12]*tmp[3] + (s64)s[13]*tmp[7] + (s64)s[14]*tmp[11] + (s64)s[15]*tmp[15]) >> 12;
-}
-
-void MatrixMult4x3(s32* m, s32* s)
-{
-    s32 tmp[16];
-    memcpy(tmp, m, 16*4);
-
-    // m = s*m
-    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8]) >> 12;
-    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9]) >> 12;
-    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10]) >> 12;
-    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11]) >> 12;
-
-    m[4] = ((s64)s[3]*tmp[0] + (s64)s[4]*tmp[4] + (s64)s[5]*tmp[8]) >> 12;
-    m[5] = ((s64)s[3]*tmp[1] + (s64)s[4]*tmp[5] + (s64)s[5]*tmp[9]) >> 12;
-    m[6] = ((s64)s[3]*tmp[2] + (s64)s[4]*tmp[6] + (s64)s[5]*tmp[10]) >> 12;
-    m[7] = ((s64)s[3]*tmp[3] + (s64)s[4]*tmp[7] + (s64)s[5]*tmp[11]) >> 12;
-
-    m[8] = ((s64)s[6]*tmp[0] + (s64)s[7]*tmp[4] + (s64)s[8]*tmp[8]) >> 12;
-    m[9] = ((s64)s[6]*tmp[1] + (s64)s[7]*tmp[5] + (s64)s[8]*tmp[9]) >> 12;
-    m[10] = ((s64)s[6]*tmp[2] + (s64)s[7]*tmp[6] + (s64)s[8]*tmp[10]) >> 12;
-    m[11] = ((s64)s[6]*tmp[3] + (s64)s[7]*tmp[7] + (s64)s[8]*tmp[11]) >> 12;
-
-    m[12] = ((s64)s[9]*tmp[0] + (s64)s[10]*tmp[4] + (s64)s[11]*tmp[8] + (s64)0x1000*tmp[12]) >> 12;
-    m[13] = ((s64)s[9]*tmp[1] + (s64)s[10]*tmp[5] + (s64)s[11]*tmp[9] + (s64)0x1000*tmp[13]) >> 12;
-    m[14] = ((s64)s[9]*tmp[2] + (s64)s[10]*tmp[6] + (s64)s[11]*tmp[10] + (s64)0x1000*tmp[14]) >> 12;
-    m[15] = ((s64)s[9]*tmp[3] + (s64)s[10]*tmp[7] + (s64)s[11]*tmp[11] + (s64)0x1000*tmp[15]) >> 12;
-}
-
-void MatrixMult3x3(s32* m, s32* s)
-{
-    s32 tmp[12];
-    memcpy(tmp, m, 12*4);
-
-    // m = s*m
-    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8]) >> 12;
-    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9]) >> 12;
-    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10]) >> 12;
-    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11]) >> 12;
-
-    m[4] = ((s64)s[3]*tmp[0] + (s64)s[4]*tmp[4] + (s64)s[5]*tmp[8]) >> 12;
-    m[5] = ((s64)s[3]*tmp[1] + (s64)s[4]*tmp[5] + (s64)s[5]*tmp[9]) >> 12;
-    m[6] = ((s64)s[3]*tmp[2] + (s64)s[4]*tmp[6] + (s64)s[5]*tmp[10]) >> 12;
-    m[7] = ((s64)s[3]*tmp[3] + (s64)s[4]*tmp[7] + (s64)s[5]*tmp[11]) >> 12;
-
-    m[8] = ((s64)s[6]*tmp[0] + (s64)s[7]*tmp[4] + (s64)s[8]*tmp[8]) >> 12;
-    m[9] = ((s64)s[6]*tmp[1] + (s64)s[7]*tmp[5] + (s64)s[8]*tmp[9]) >> 12;
-    m[10] = ((s64)s[6]*tmp[2] + (s64)s[7]*tmp[6] + (s64)s[8]*tmp[10]) >> 12;
-    m[11] = ((s64)s[6]*tmp[3] + (s64)s[7]*tmp[7] + (s64)s[8]*tmp[11]) >> 12;
-}
-
 void MatrixScale(s32* m, s32* s)
 {
     m[0] = ((s64)s[0]*m[0]) >> 12;
@@ -813,32 +740,36 @@ void ClipSegment(Vertex* outbuf, Vertex* vin, Vertex* vout)
     s64 factor_num = vin->Position[3] - (plane*vin->Position[comp]);
     s32 factor_den = factor_num - (vout->Position[3] - (plane*vout->Position[comp]));
 
-#define INTERPOLATE(var)  { outbuf->var = (vin->var + ((vout->var - vin->var) * factor_num) / factor_den); }
-
-    if (comp != 0) INTERPOLATE(Position[0]);
-    if (comp != 1) INTERPOLATE(Position[1]);
-    if (comp != 2) INTERPOLATE(Position[2]);
-    INTERPOLATE(Position[3]);
+    InterpolateClipVertex(outbuf, vin, vout, factor_num, factor_den, attribs);
     outbuf->Position[comp] = plane*outbuf->Position[3];
 
-    if (attribs)
+    outbuf->Clipped = true;
+}
+
+void RoundClippedColors(Vertex* vertices, int nverts)
+{
+    // checkme
+    for (int i = 0; i < nverts; i++)
     {
-        INTERPOLATE(Color[0]);
-        INTERPOLATE(Color[1]);
-        INTERPOLATE(Color[2]);
+        Vertex* vtx = &vertices[i];
 
-        INTERPOLATE(TexCoords[0]);
-        INTERPOLATE(TexCoords[1]);
+        vtx->Color[0] &= ~0xFFF; vtx->Color[0] += 0xFFF;
+        vtx->Color[1] &= ~0xFFF; vtx->Color[1] += 0xFFF;
+        vtx->Color[2] &= ~0xFFF; vtx->Color[2] += 0xFFF;
     }
-
-    outbuf->Clipped = true;
-
-#undef INTERPOLATE
 }
 
 template<int comp, bool attribs>
-int ClipAgainstPlane(const GPU3D& gpu, Vertex* vertices, int nverts, int clipstart)
+int ClipAgainstPlane(const GPU3D& gpu, Vertex* vertices, int nverts, int clipstart, u32& outside)
 {
+    // nothing to do if no vertex is outside of this plane
+    // (if the polygon was rejected already, the loops below bring back the reused vertices)
+    if (nverts >= clipstart && !(outside & (1<<comp)))
+    {
+        RoundClippedColors(vertices, nverts);
+        return nverts;
+    }
+
     Vertex temp[10];
     int prev, next;
     int c = clipstart;
@@ -904,16 +835,8 @@ int ClipAgainstPlane(const GPU3D& gpu, Vertex* vertices, int nverts, int clipsta
             vertices[c++] = vtx;
     }
 
-    // checkme
-    for (int i = 0; i < c; i++)
-    {
-        Vertex* vtx = &vertices[i];
-
-        vtx->Color[0] &= ~0xFFF; vtx->Color[0] += 0xFFF;
-        vtx->Color[1] &= ~0xFFF; vtx->Color[1] += 0xFFF;
-        vtx->Color[2] &= ~0xFFF; vtx->Color[2] += 0xFFF;
-    }
-
+    RoundClippedColors(vertices, c);
+    outside = GetClipOutcodes(vertices, clipstart, c);
     return c;
 }
 
@@ -930,14 +853,23 @@ int ClipPolygon(GPU3D& gpu, Vertex* vertices, int nverts, int clipstart)
     // some vertices that should get Y=-0x1000 get Y=0x1000 for some reason on hardware. it doesn't make sense.
     // clipping seems to process the Y plane before the X plane.
 
+    // most polygons are entirely inside the view volume, in which case
+    // clipping leaves them as they are, save for the color rounding
+    u32 outside = GetClipOutcodes(vertices, clipstart, nverts);
+    if (!outside)
+    {
+        RoundClippedColors(vertices, nverts);
+        return nverts;
+    }
+
     // Z clipping
-    nverts = ClipAgainstPlane<2, attribs>(gpu, vertices, nverts, clipstart);
+    nverts = ClipAgainstPlane<2, attribs>(gpu, vertices, nverts, clipstart, outside);
 
     // Y clipping
-    nverts = ClipAgainstPlane<1, attribs>(gpu, vertices, nverts, clipstart);
+    nverts = ClipAgainstPlane<1, attribs>(gpu, vertices, nverts, clipstart, outside);
 
     // X clipping
-    nverts = ClipAgainstPlane<0, attribs>(gpu, vertices, nverts, clipstart);
+    nverts = ClipAgainstPlane<0, attribs>(gpu, vertices, nverts, clipstart, outside);
 
     return nverts;
 }
@@ -1361,10 +1293,8 @@ void GPU3D::SubmitVertex() noexcept
     Vertex* vertextrans = &TempVertexBuffer[VertexNumInPoly];
 
     UpdateClipMatrix();
-    vertextrans->Position[0] = (vertex[0]*ClipMatrix[0] + vertex[1]*ClipMatrix[4] + vertex[2]*ClipMatrix[8] + vertex[3]*ClipMatrix[12]) >> 12;
-    vertextrans->Position[1] = (vertex[0]*ClipMatrix[1] + vertex[1]*ClipMatrix[5] + vertex[2]*ClipMatrix[9] + vertex[3]*ClipMatrix[13]) >> 12;
-    vertextrans->Position[2] = (vertex[0]*ClipMatrix[2] + vertex[1]*ClipMatrix[6] + vertex[2]*ClipMatrix[10] + vertex[3]*ClipMatrix[14]) >> 12;
-    vertextrans->Position[3] = (vertex[0]*ClipMatrix[3] + vertex[1]*ClipMatrix[7] + vertex[2]*ClipMatrix[11] + vertex[3]*ClipMatrix[15]) >> 12;
+    s32 pos[4] = {CurVertex[0], CurVertex[1], CurVertex[2], 0x1000};
+    TransformVector4(vertextrans->Position, pos, ClipMatrix);
 
     // this probably shouldn't be.
     // the way color is handled during clipping needs investigation. TODO
@@ -1462,9 +1392,10 @@ void GPU3D::CalculateLighting() noexcept
     }
 
     s32 normaltrans[3]; // should be 1 bit sign 10 bits frac
-    normaltrans[0] = ((Normal[0]*VecMatrix[0] + Normal[1]*VecMatrix[4] + Normal[2]*VecMatrix[8]) << 9) >> 21;
-    normaltrans[1] = ((Normal[0]*VecMatrix[1] + Normal[1]*VecMatrix[5] + Normal[2]*VecMatrix[9]) << 9) >> 21;
-    normaltrans[2] = ((Normal[0]*VecMatrix[2] + Normal[1]*VecMatrix[6] + Normal[2]*VecMatrix[10]) << 9) >> 21;
+    TransformNormal(normaltrans, Normal, VecMatrix);
+    normaltrans[0] = (normaltrans[0] << 9) >> 21;
+    normaltrans[1] = (normaltrans[1] << 9) >> 21;
+    normaltrans[2] = (normaltrans[2] << 9) >> 21;
 
     s32 c = 0;
     u32 vtxbuff[3] =
@@ -1579,14 +1510,15 @@ void GPU3D::BoxTest(const u32* params) noexcept
     UpdateClipMatrix();
     for (int i = 0; i < 8; i++)
     {
-        s32 x = cube[i].Position[0];
-        s32 y = cube[i].Position[1];
-        s32 z = cube[i].Position[2];
+        s32 pos[4] = {cube[i].Position[0], cube[i].Position[1], cube[i].Position[2], 0x1000};
+        TransformVector4(cube[i].Position, pos, ClipMatrix);
+    }
 
-        cube[i].Position[0] = ((s64)x*ClipMatrix[0] + (s64)y*ClipMatrix[4] + (s64)z*ClipMatrix[8] + (s64)0x1000*ClipMatrix[12]) >> 12;
-        cube[i].Position[1] = ((s64)x*ClipMatrix[1] + (s64)y*ClipMatrix[5] + (s64)z*ClipMatrix[9] + (s64)0x1000*ClipMatrix[13]) >> 12;
-        cube[i].Position[2] = ((s64)x*ClipMatrix[2] + (s64)y*ClipMatrix[6] + (s64)z*ClipMatrix[10] + (s64)0x1000*ClipMatrix[14]) >> 12;
-        cube[i].Position[3] = ((s64)x*ClipMatrix[3] + (s64)y*ClipMatrix[7] + (s64)z*ClipMatrix[11] + (s64)0x1000*ClipMatrix[15]) >> 12;
+    // if the whole box is inside the view volume, so are all its faces
+    if (!GetClipOutcodes(cube, 0, 8))
+    {
+        GXStat |= (1<<1);
+        return;
     }
 
     // front face (-Z)
@@ -1646,13 +1578,10 @@ void GPU3D::BoxTest(const u32* params) noexcept
 
 void GPU3D::PosTest() noexcept
 {
-    s64 vertex[4] = {(s64)CurVertex[0], (s64)CurVertex[1], (s64)CurVertex[2], 0x1000};
+    s32 vertex[4] = {CurVertex[0], CurVertex[1], CurVertex[2], 0x1000};
 
     UpdateClipMatrix();
-    PosTestResult[0] = (vertex[0]*ClipMatrix[0] + vertex[1]*ClipMatrix[4] + vertex[2]*ClipMatrix[8] + vertex[3]*ClipMatrix[12]) >> 12;
-    PosTestResult[1] = (vertex[0]*ClipMatrix[1] + vertex[1]*ClipMatrix[5] + vertex[2]*ClipMatrix[9] + vertex[3]*ClipMatrix[13]) >> 12;
-    PosTestResult[2] = (vertex[0]*ClipMatrix[2] + vertex[1]*ClipMatrix[6] + vertex[2]*ClipMatrix[10] + vertex[3]*ClipMatrix[14]) >> 12;
-    PosTestResult[3] = (vertex[0]*ClipMatrix[3] + vertex[1]*ClipMatrix[7] + vertex[2]*ClipMatrix[11] + vertex[3]*ClipMatrix[15]) >> 12;
+    TransformVector4(PosTestResult, vertex, ClipMatrix);
 
     AddCycles(5);
 }
@@ -1667,9 +1596,11 @@ void GPU3D::VecTest(u32 param) noexcept
     normal[1] = (s16)((param & 0x000FFC00) >> 4) >> 6;
     normal[2] = (s16)((param & 0x3FF00000) >> 14) >> 6;
 
-    VecTestResult[0] = (normal[0]*VecMatrix[0] + normal[1]*VecMatrix[4] + normal[2]*VecMatrix[8]) >> 9;
-    VecTestResult[1] = (normal[0]*VecMatrix[1] + normal[1]*VecMatrix[5] + normal[2]*VecMatrix[9]) >> 9;
-    VecTestResult[2] = (normal[0]*VecMatrix[2] + normal[1]*VecMatrix[6] + normal[2]*VecMatrix[10]) >> 9;
+    s32 normaltrans[3];
+    TransformNormal(normaltrans, normal, VecMatrix);
+    VecTestResult[0] = normaltrans[0] >> 9;
+    VecTestResult[1] = normaltrans[1] >> 9;
+    VecTestResult[2] = normaltrans[2] >> 9;
 
     if (VecTestResult[0] & 0x1000) VecTestResult[0] |= 0xF000;
     if (VecTestResult[1] & 0x1000) VecTestResult[1] |= 0xF000;
@@ -1749,16 +1680,130 @@ GPU3D::CmdFIFOEntry GPU3D::CmdFIFORead() noexcept
     return ret;
 }
 
+static bool IsVertexDataCommand(u8 cmd)
+{
+    // vertex color, normal, texcoord and all the vertex commands
+    return cmd >= 0x20 && cmd <= 0x28;
+}
+
+inline void GPU3D::ExecuteVertexDataCommand(const CmdFIFOEntry& entry) noexcept
+{
+    switch (entry.Command)
+    {
+    case 0x20: // vertex color
+        VertexPipelineCmdDelayed6();
+        {
+            u32 c = entry.Param;
+            u32 r = c & 0x1F;
+            u32 g = (c >> 5) & 0x1F;
+            u32 b = (c >> 10) & 0x1F;
+            VertexColor[0] = r;
+            VertexColor[1] = g;
+            VertexColor[2] = b;
+        }
+        break;
+
+    case 0x21: // normal
+        VertexPipelineCmdDelayed4();
+        Normal[0] = (s16)((entry.Param & 0x000003FF) << 6) >> 6;
+        Normal[1] = (s16)((entry.Param & 0x000FFC00) >> 4) >> 6;
+        Normal[2] = (s16)((entry.Param & 0x3FF00000) >> 14) >> 6;
+        CalculateLighting();
+        break;
+
+    case 0x22: // texcoord
+        VertexPipelineCmdDelayed4();
+        RawTexCoords[0] = entry.Param & 0xFFFF;
+        RawTexCoords[1] = entry.Param >> 16;
+        if ((TexParam >> 30) == 1)
+        {
+            TexCoords[0] = (RawTexCoords[0]*TexMatrix[0] + RawTexCoords[1]*TexMatrix[4] + TexMatrix[8] + TexMatrix[12]) >> 12;
+            TexCoords[1] = (RawTexCoords[0]*TexMatrix[1] + RawTexCoords[1]*TexMatrix[5] + TexMatrix[9] + TexMatrix[13]) >> 12;
+        }
+        else
+        {
+            TexCoords[0] = RawTexCoords[0];
+            TexCoords[1] = RawTexCoords[1];
+        }
+        break;
+
+    case 0x23: // full vertex
+        ExecParams[ExecParamCount] = entry.Param;
+        ExecParamCount++;
+        if (ExecParamCount == 1)
+        {
+            VertexPipelineSubmitCmd();
+        }
+        else
+        {
+            AddCycles(1);
+            ExecParamCount = 0;
+
+            CurVertex[0] = ExecParams[0] & 0xFFFF;
+            CurVertex[1] = ExecParams[0] >> 16;
+            CurVertex[2] = ExecParams[1] & 0xFFFF;
+            SubmitVertex();
+        }
+        break;
+
+    case 0x24: // 10-bit vertex
+        VertexPipelineSubmitCmd();
+        CurVertex[0] = (entry.Param & 0x000003FF) << 6;
+        CurVertex[1] = (entry.Param & 0x000FFC00) >> 4;
+        CurVertex[2] = (entry.Param & 0x3FF00000) >> 14;
+        SubmitVertex();
+        break;
+
+    case 0x25: // vertex XY
+        VertexPipelineSubmitCmd();
+        CurVertex[0] = entry.Param & 0xFFFF;
+        CurVertex[1] = entry.Param >> 16;
+        SubmitVertex();
+        break;
+
+    case 0x26: // vertex XZ
+        VertexPipelineSubmitCmd();
+        CurVertex[0] = entry.Param & 0xFFFF;
+        CurVertex[2] = entry.Param >> 16;
+        SubmitVertex();
+        break;
+
+    case 0x27: // vertex YZ
+        VertexPipelineSubmitCmd();
+        CurVertex[1] = entry.Param & 0xFFFF;
+        CurVertex[2] = entry.Param >> 16;
+        SubmitVertex();
+        break;
+
+    case 0x28: // 10-bit delta vertex
+        VertexPipelineSubmitCmd();
+        CurVertex[0] += (s16)((entry.Param & 0x000003FF) << 6) >> 6;
+        CurVertex[1] += (s16)((entry.Param & 0x000FFC00) >> 4) >> 6;
+        CurVertex[2] += (s16)((entry.Param & 0x3FF00000) >> 14) >> 6;
+        SubmitVertex();
+        break;
+    }
+}
+
 void GPU3D::ExecuteCommand() noexcept
 {
-    CmdFIFOEntry entry = CmdFIFORead();
+    ExecuteCommand(CmdFIFORead());
+}
 
+void GPU3D::ExecuteCommand(const CmdFIFOEntry& entry) noexcept
+{
     //printf("FIFO: processing %02X %08X. Levels: FIFO=%d, PIPE=%d\n", entry.Command, entry.Param, CmdFIFO->Level(), CmdPIPE->Level());
 
     // each FIFO entry takes 1 cycle to be processed
     // commands (presumably) run when all the needed parameters have been read
     // which is where we add the remaining cycles if any
 
+    if (IsVertexDataCommand(entry.Command))
+    {
+        ExecuteVertexDataCommand(entry);
+        return;
+    }
+
     u32 paramsRequiredCount = CmdNumParams[entry.Command];
     if (paramsRequiredCount <= 1)
     {
@@ -1907,80 +1952,6 @@ void GPU3D::ExecuteCommand() noexcept
             }
             break;
 
-        case 0x20: // vertex color
-            VertexPipelineCmdDelayed6();
-            {
-                u32 c = entry.Param;
-                u32 r = c & 0x1F;
-                u32 g = (c >> 5) & 0x1F;
-                u32 b = (c >> 10) & 0x1F;
-                VertexColor[0] = r;
-                VertexColor[1] = g;
-                VertexColor[2] = b;
-            }
-            break;
-
-        case 0x21: // normal
-            VertexPipelineCmdDelayed4();
-            Normal[0] = (s16)((entry.Param & 0x000003FF) << 6) >> 6;
-            Normal[1] = (s16)((entry.Param & 0x000FFC00) >> 4) >> 6;
-            Normal[2] = (s16)((entry.Param & 0x3FF00000) >> 14) >> 6;
-            CalculateLighting();
-            break;
-
-        case 0x22: // texcoord
-            VertexPipelineCmdDelayed4();
-            RawTexCoords[0] = entry.Param & 0xFFFF;
-            RawTexCoords[1] = entry.Param >> 16;
-            if ((TexParam >> 30) == 1)
-            {
-                TexCoords[0] = (RawTexCoords[0]*TexMatrix[0] + RawTexCoords[1]*TexMatrix[4] + TexMatrix[8] + TexMatrix[12]) >> 12;
-                TexCoords[1] = (RawTexCoords[0]*TexMatrix[1] + RawTexCoords[1]*TexMatrix[5] + TexMatrix[9] + TexMatrix[13]) >> 12;
-            }
-            else
-            {
-                TexCoords[0] = RawTexCoords[0];
-                TexCoords[1] = RawTexCoords[1];
-            }
-            break;
-
-        case 0x24: // 10-bit vertex
-            VertexPipelineSubmitCmd();
-            CurVertex[0] = (entry.Param & 0x000003FF) << 6;
-            CurVertex[1] = (entry.Param & 0x000FFC00) >> 4;
-            CurVertex[2] = (entry.Param & 0x3FF00000) >> 14;
-            SubmitVertex();
-            break;
-
-        case 0x25: // vertex XY
-            VertexPipelineSubmitCmd();
-            CurVertex[0] = entry.Param & 0xFFFF;
-            CurVertex[1] = entry.Param >> 16;
-            SubmitVertex();
-            break;
-
-        case 0x26: // vertex XZ
-            VertexPipelineSubmitCmd();
-            CurVertex[0] = entry.Param & 0xFFFF;
-            CurVertex[2] = entry.Param >> 16;
-            SubmitVertex();
-            break;
-
-        case 0x27: // vertex YZ
-            VertexPipelineSubmitCmd();
-            CurVertex[1] = entry.Param & 0xFFFF;
-            CurVertex[2] = entry.Param >> 16;
-            SubmitVertex();
-            break;
-
-        case 0x28: // 10-bit delta vertex
-            VertexPipelineSubmitCmd();
-            CurVertex[0] += (s16)((entry.Param & 0x000003FF) << 6) >> 6;
-            CurVertex[1] += (s16)((entry.Param & 0x000FFC00) >> 4) >> 6;
-            CurVertex[2] += (s16)((entry.Param & 0x3FF00000) >> 14) >> 6;
-            SubmitVertex();
-            break;
-
         case 0x29: // polygon attributes
             VertexPipelineCmdDelayed8();
             PolygonAttr = entry.Param;
@@ -2035,10 +2006,12 @@ void GPU3D::ExecuteCommand() noexcept
                 dir[2] = (s16)((entry.Param & 0x3FF00000) >> 14) >> 6;
                 // the order of operations here is very specific: discard bottom 12 bits -> negate -> then sign extend to convert to 11 bit signed int
                 // except for when used to calculate the specular reciprocal; then it's: sign extend -> discard lsb -> negate.
-                LightDirection[l][0] = (-((dir[0]*VecMatrix[0] + dir[1]*VecMatrix[4] + dir[2]*VecMatrix[8] ) >> 12) << 21) >> 21;
-                LightDirection[l][1] = (-((dir[0]*VecMatrix[1] + dir[1]*VecMatrix[5] + dir[2]*VecMatrix[9] ) >> 12) << 21) >> 21;
-                LightDirection[l][2] = (-((dir[0]*VecMatrix[2] + dir[1]*VecMatrix[6] + dir[2]*VecMatrix[10]) >> 12) << 21) >> 21;
-                s32 den =              -(((dir[0]*VecMatrix[2] + dir[1]*VecMatrix[6] + dir[2]*VecMatrix[10]) << 9) >> 21) + (1<<9);
+                s32 dirtrans[3];
+                TransformNormal(dirtrans, dir, VecMatrix);
+                LightDirection[l][0] = (-(dirtrans[0] >> 12) << 21) >> 21;
+                LightDirection[l][1] = (-(dirtrans[1] >> 12) << 21) >> 21;
+                LightDirection[l][2] = (-(dirtrans[2] >> 12) << 21) >> 21;
+                s32 den =              -((dirtrans[2] << 9) >> 21) + (1<<9);
 
                 if (den == 0) SpecRecip[l] = 0;
                 else SpecRecip[l] = (1<<18) / den;
@@ -2125,7 +2098,6 @@ void GPU3D::ExecuteCommand() noexcept
             switch (entry.Command)
             {
             // commands that stall the polygon pipeline
-            case 0x23: VertexPipelineSubmitCmd(); break;
             case 0x34:
             case 0x71:
                 VertexPipelineCmdDelayed8();
@@ -2312,13 +2284,6 @@ void GPU3D::ExecuteCommand() noexcept
                     }
                     break;
 
-                case 0x23: // full vertex
-                    CurVertex[0] = ExecParams[0] & 0xFFFF;
-                    CurVertex[1] = ExecParams[0] >> 16;
-                    CurVertex[2] = ExecParams[1] & 0xFFFF;
-                    SubmitVertex();
-                    break;
-
                 case 0x34: // shininess table
                     {
                         for (int i = 0; i < 128; i += 4)
@@ -2353,6 +2318,41 @@ void GPU3D::ExecuteCommand() noexcept
     }
 }
 
+void GPU3D::ExecuteCommandBatch() noexcept
+{
+    // vertex data usually comes in long runs, which we can get through
+    // without going through CmdFIFORead for every entry.
+    // nothing else runs while we're at it, so the FIFO DMA and IRQ only
+    // need to be checked once at the end, where the FIFO level is the same
+    // as at the last point CmdFIFORead would have checked them.
+    // this isn't used when commands are waiting in the stall queue.
+    bool checkfifo = false;
+
+    do
+    {
+        CmdFIFOEntry entry = CmdPIPE.Read();
+
+        if (CmdPIPE.Level() <= 2)
+        {
+            if (!CmdFIFO.IsEmpty())
+                CmdPIPE.Write(CmdFIFO.Read());
+            if (!CmdFIFO.IsEmpty())
+                CmdPIPE.Write(CmdFIFO.Read());
+
+            checkfifo = true;
+        }
+
+        ExecuteVertexDataCommand(entry);
+    }
+    while (CycleCount <= 0 && !CmdPIPE.IsEmpty() && IsVertexDataCommand(CmdPIPE.Peek().Command));
+
+    if (checkfifo)
+    {
+        CheckFIFODMA();
+        CheckFIFOIRQ();
+    }
+}
+
 s32 GPU3D::CyclesToRunFor() const noexcept
 {
     if (CycleCount < 0) return 0;
@@ -2393,7 +2393,10 @@ void GPU3D::Run() noexcept
             if (NumPushPopCommands == 0) GXStat &= ~(1<<14);
             if (NumTestCommands == 0)    GXStat &= ~(1<<0);
 
-            ExecuteCommand();
+            if (BatchVertexData && CmdStallQueue.IsEmpty() && IsVertexDataCommand(CmdPIPE.Peek().Command))
+                ExecuteCommandBatch();
+            else
+                ExecuteCommand();
         }
     }
 
@@ -2444,6 +2447,33 @@ void GPU3D::Stop(const GPU& gpu) noexcept
 }
 
 
+void GPU3D::UpdateRenderGeometry() noexcept
+{
+    u32 v = 0;
+    for (u32 i = 0; i < RenderNumPolygons; i++)
+    {
+        const Polygon* poly = RenderPolygonRAM[i];
+        RenderVertexRAM.FirstVertex[i] = v;
+
+        for (u32 j = 0; j < poly->NumVertices; j++, v++)
+        {
+            const Vertex* vtx = poly->Vertices[j];
+
+            RenderVertexRAM.FinalPosition[v][0] = vtx->FinalPosition[0];
+            RenderVertexRAM.FinalPosition[v][1] = vtx->FinalPosition[1];
+            RenderVertexRAM.HiresPosition[v][0] = vtx->HiresPosition[0];
+            RenderVertexRAM.HiresPosition[v][1] = vtx->HiresPosition[1];
+            RenderVertexRAM.FinalColor[v][0] = vtx->FinalColor[0];
+            RenderVertexRAM.FinalColor[v][1] = vtx->FinalColor[1];
+            RenderVertexRAM.FinalColor[v][2] = vtx->FinalColor[2];
+            RenderVertexRAM.TexCoords[v][0] = vtx->TexCoords[0];
+            RenderVertexRAM.TexCoords[v][1] = vtx->TexCoords[1];
+        }
+    }
+
+    RenderVertexRAM.NumVertices = v;
+}
+
 bool YSort(Polygon* a, Polygon* b)
 {
     // polygon sorting rules:
@@ -2486,6 +2516,7 @@ void GPU3D::VBlank() noexcept
                 }
 
                 RenderNumPolygons = NumPolygons;
+                UpdateRenderGeometry();
                 RenderFrameIdentical = false;
             }
             else
@@ -2586,6 +2617,11 @@ bool GPU3D::IsRendererAccelerated() const noexcept
     return CurrentRenderer && CurrentRenderer->Accelerated;
 }
 
+bool GPU3D::IsRendererFrameIdentical() const noexcept
+{
+    return CurrentRenderer && CurrentRenderer->IsFrameIdentical();
+}
+
 void GPU3D::WriteToGXFIFO(u32 val) noexcept
 {
     if (NumCommands == 0)
@@ -82,6 +82,31 @@ struct Polygon
     void DoSavestate(Savestate* file) noexcept;
 };
 
+// Vertex attributes of the polygons being rendered, copied out of vertex RAM
+// once per frame. Each polygon's vertices are stored one after the other,
+// starting at FirstVertex (indexed like RenderPolygonRAM), and each attribute
+// has its own array. This way renderers don't need the Polygon::Vertices
+// pointers, and walking polygon edges only touches the positions.
+struct RenderGeometry
+{
+    u32 FirstVertex[2048];
+    u32 NumVertices;
+
+    s32 FinalPosition[2048*10][2];
+    s32 HiresPosition[2048*10][2];
+    s32 FinalColor[2048*10][3];
+    s16 TexCoords[2048*10][2];
+};
+
+// the vertices of one polygon within RenderGeometry
+struct RenderPolygonVertices
+{
+    const s32 (*FinalPosition)[2];
+    const s32 (*HiresPosition)[2];
+    const s32 (*FinalColor)[3];
+    const s16 (*TexCoords)[2];
+};
+
 class Renderer3D;
 class NDS;
 
@@ -110,6 +135,13 @@ public:
     void RestartFrame(GPU& gpu) noexcept;
     void Stop(const GPU& gpu) noexcept;
 
+    [[nodiscard]] RenderPolygonVertices GetRenderPolygonVertices(u32 index) const noexcept
+    {
+        u32 first = RenderVertexRAM.FirstVertex[index];
+        return {&RenderVertexRAM.FinalPosition[first], &RenderVertexRAM.HiresPosition[first],
+                &RenderVertexRAM.FinalColor[first], &RenderVertexRAM.TexCoords[first]};
+    }
+
     void SetRenderXPos(u16 xpos) noexcept;
     [[nodiscard]] u16 GetRenderXPos() const noexcept { return RenderXPos; }
     u32* GetLine(int line) noexcept;
@@ -117,6 +149,7 @@ public:
     void WriteToGXFIFO(u32 val) noexcept;
 
     [[nodiscard]] bool IsRendererAccelerated() const noexcept;
+    [[nodiscard]] bool IsRendererFrameIdentical() const noexcept;
     [[nodiscard]] Renderer3D& GetCurrentRenderer() noexcept { return *CurrentRenderer; }
     [[nodiscard]] const Renderer3D& GetCurrentRenderer() const noexcept { return *CurrentRenderer; }
     void SetCurrentRenderer(std::unique_ptr<Renderer3D>&& renderer) noexcept;
@@ -142,6 +175,7 @@ private:
     } CmdFIFOEntry;
 
     void UpdateClipMatrix() noexcept;
+    void UpdateRenderGeometry() noexcept;
     void ResetRenderingState() noexcept;
     void AddCycles(s32 num) noexcept;
     void NextVertexSlot() noexcept;
@@ -154,6 +188,9 @@ private:
     void VecTest(u32 param) noexcept;
     void CmdFIFOWrite(const CmdFIFOEntry& entry) noexcept;
     CmdFIFOEntry CmdFIFORead() noexcept;
+    void ExecuteCommand(const CmdFIFOEntry& entry) noexcept;
+    void ExecuteVertexDataCommand(const CmdFIFOEntry& entry) noexcept;
+    void ExecuteCommandBatch() noexcept;
     void FinishWork(s32 cycles) noexcept;
     void VertexPipelineSubmitCmd() noexcept
     {
@@ -273,6 +310,10 @@ public:
 
     bool RenderFrameIdentical = false; // not part of the hardware state, don't serialize
 
+    // whether Run executes runs of vertex data commands in one go,
+    // turning it off gives the same results one command at a time
+    bool BatchVertexData = true; // not part of the hardware state, don't serialize
+
     bool AbortFrame = false;
 
     u64 Timestamp = 0;
@@ -323,6 +364,7 @@ public:
 
     std::array<Polygon*,2048> RenderPolygonRAM {};
     u32 RenderNumPolygons = 0;
+    RenderGeometry RenderVertexRAM {}; // not part of the hardware state, don't serialize
 
     u32 FlushRequest = 0;
     u32 FlushAttributes = 0;
@@ -351,6 +393,10 @@ public:
     virtual u32* GetLine(int line) = 0;
     virtual void Blit(const GPU& gpu) {};
 
+    // whether the last frame rendered came out the same as the one before,
+    // in which case the 2D renderer may reuse scanlines that include it
+    virtual bool IsFrameIdentical() const { return false; }
+
     virtual void SetupAccelFrame() {}
     virtual void PrepareCaptureFrame() {}
     virtual void BindOutputTexture(int buffer) {}
@@ -295,6 +295,11 @@ void ComputeRenderer::Reset(GPU& gpu)
     Texcache.Reset();
 }
 
+void ComputeRenderer::SetTextureCacheSize(int megabytes)
+{
+    Texcache.SetMemoryBudget((u64)megabytes * 1024 * 1024);
+}
+
 void ComputeRenderer::SetRenderSettings(int scale, bool highResolutionCoordinates)
 {
     CurGLCompositor.SetScaleFactor(scale);
@@ -362,25 +367,25 @@ void ComputeRenderer::VCount144(GPU& gpu)
 
 }
 
-void ComputeRenderer::SetupAttrs(SpanSetupY* span, Polygon* poly, int from, int to)
+void ComputeRenderer::SetupAttrs(SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int from, int to)
 {
     span->Z0 = poly->FinalZ[from];
     span->W0 = poly->FinalW[from];
     span->Z1 = poly->FinalZ[to];
     span->W1 = poly->FinalW[to];
-    span->ColorR0 = poly->Vertices[from]->FinalColor[0];
-    span->ColorG0 = poly->Vertices[from]->FinalColor[1];
-    span->ColorB0 = poly->Vertices[from]->FinalColor[2];
-    span->ColorR1 = poly->Vertices[to]->FinalColor[0];
-    span->ColorG1 = poly->Vertices[to]->FinalColor[1];
-    span->ColorB1 = poly->Vertices[to]->FinalColor[2];
-    span->TexcoordU0 = poly->Vertices[from]->TexCoords[0];
-    span->TexcoordV0 = poly->Vertices[from]->TexCoords[1];
-    span->TexcoordU1 = poly->Vertices[to]->TexCoords[0];
-    span->TexcoordV1 = poly->Vertices[to]->TexCoords[1];
+    span->ColorR0 = vertices.FinalColor[from][0];
+    span->ColorG0 = vertices.FinalColor[from][1];
+    span->ColorB0 = vertices.FinalColor[from][2];
+    span->ColorR1 = vertices.FinalColor[to][0];
+    span->ColorG1 = vertices.FinalColor[to][1];
+    span->ColorB1 = vertices.FinalColor[to][2];
+    span->TexcoordU0 = vertices.TexCoords[from][0];
+    span->TexcoordV0 = vertices.TexCoords[from][1];
+    span->TexcoordU1 = vertices.TexCoords[to][0];
+    span->TexcoordV1 = vertices.TexCoords[to][1];
 }
 
-void ComputeRenderer::SetupYSpanDummy(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, int vertex, int side, s32 positions[10][2])
+void ComputeRenderer::SetupYSpanDummy(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int vertex, int side, s32 positions[10][2])
 {
     s32 x0 = positions[vertex][0];
     if (side)
@@ -418,17 +423,17 @@ void ComputeRenderer::SetupYSpanDummy(RenderPolygon* rp, SpanSetupY* span, Polyg
 
     span->IsDummy = true;
 
-    SetupAttrs(span, poly, vertex, vertex);
+    SetupAttrs(span, poly, vertices, vertex, vertex);
 }
 
-void ComputeRenderer::SetupYSpan(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, int from, int to, int side, s32 positions[10][2])
+void ComputeRenderer::SetupYSpan(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int from, int to, int side, s32 positions[10][2])
 {
     span->X0 = positions[from][0];
     span->X1 = positions[to][0];
     span->Y0 = positions[from][1];
     span->Y1 = positions[to][1];
 
-    SetupAttrs(span, poly, from, to);
+    SetupAttrs(span, poly, vertices, from, to);
 
     s32 minXY, maxXY;
     bool negative = false;
@@ -620,6 +625,7 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
     for (int i = 0; i < gpu.GPU3D.RenderNumPolygons; i++)
     {
         Polygon* polygon = gpu.GPU3D.RenderPolygonRAM[i];
+        RenderPolygonVertices vertices = gpu.GPU3D.GetRenderPolygonVertices(i);
 
         u32 nverts = polygon->NumVertices;
         u32 vtop = polygon->VTop, vbot = polygon->VBottom;
@@ -714,13 +720,13 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
         {
             if (HiresCoordinates)
             {
-                scaledPositions[i][0] = (polygon->Vertices[i]->HiresPosition[0] * ScaleFactor) >> 4;
-                scaledPositions[i][1] = (polygon->Vertices[i]->HiresPosition[1] * ScaleFactor) >> 4;
+                scaledPositions[i][0] = (vertices.HiresPosition[i][0] * ScaleFactor) >> 4;
+                scaledPositions[i][1] = (vertices.HiresPosition[i][1] * ScaleFactor) >> 4;
             }
             else
             {
-                scaledPositions[i][0] = polygon->Vertices[i]->FinalPosition[0] * ScaleFactor;
-                scaledPositions[i][1] = polygon->Vertices[i]->FinalPosition[1] * ScaleFactor;
+                scaledPositions[i][0] = vertices.FinalPosition[i][0] * ScaleFactor;
+                scaledPositions[i][1] = vertices.FinalPosition[i][1] * ScaleFactor;
             }
             ytop = std::min(scaledPositions[i][1], ytop);
             ybot = std::max(scaledPositions[i][1], ybot);
@@ -746,10 +752,10 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
 
             assert(numYSpans < MaxYSpanSetups);
             u32 curSpanL = numYSpans;
-            SetupYSpanDummy(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vtop, 0, scaledPositions);
+            SetupYSpanDummy(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vertices, vtop, 0, scaledPositions);
             assert(numYSpans < MaxYSpanSetups);
             u32 curSpanR = numYSpans;
-            SetupYSpanDummy(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vbot, 1, scaledPositions);
+            SetupYSpanDummy(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vertices, vbot, 1, scaledPositions);
 
             YSpanIndices[numSetupIndices].PolyIdx = i;
             YSpanIndices[numSetupIndices].SpanIdxL = curSpanL;
@@ -761,10 +767,10 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
         {
             u32 curSpanL = numYSpans;
             assert(numYSpans < MaxYSpanSetups);
-            SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, curVL, nextVL, 0, scaledPositions);
+            SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vertices, curVL, nextVL, 0, scaledPositions);
             u32 curSpanR = numYSpans;
             assert(numYSpans < MaxYSpanSetups);
-            SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, curVR, nextVR, 1, scaledPositions);
+            SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vertices, curVR, nextVR, 1, scaledPositions);
 
             for (u32 y = ytop; y < ybot; y++)
             {
@@ -790,7 +796,7 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
 
                     assert(numYSpans < MaxYSpanSetups);
                     curSpanL = numYSpans;
-                    SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, curVL, nextVL, 0, scaledPositions);
+                    SetupYSpan(&RenderPolygons[i], &YSpanSetups[numYSpans++], polygon, vertices, curVL, nextVL, 0, scaledPositions);
                 }
                 if (y >= scaledPositions[nextVR][1] && curVR != polygon->VBottom)
                 {
@@ -813,7 +819,7 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
 
                     assert(numYSpans < MaxYSpanSetups);
                     curSpanR = numYSpans;
-                    SetupYSpan(&RenderPolygons[i] ,&YSpanSetups[numYSpans++], polygon, curVR, nextVR, 1, scaledPositions);
+                    SetupYSpan(&RenderPolygons[i] ,&YSpanSetups[numYSpans++], polygon, vertices, curVR, nextVR, 1, scaledPositions);
                 }
 
                 YSpanIndices[numSetupIndices].PolyIdx = i;
@@ -44,6 +44,8 @@ public:
     void Reset(GPU& gpu) override;
 
     void SetRenderSettings(int scale, bool highResolutionCoordinates);
+    void SetTextureCacheSize(int megabytes);
+    const TexcacheStats& GetTextureCacheStats() { return Texcache.GetStats(); }
 
     void VCount144(GPU& gpu) override;
 
@@ -230,9 +232,9 @@ private:
 
     void DeleteShaders();
 
-    void SetupAttrs(SpanSetupY* span, Polygon* poly, int from, int to);
-    void SetupYSpan(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, int from, int to, int side, s32 positions[10][2]);
-    void SetupYSpanDummy(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, int vertex, int side, s32 positions[10][2]);
+    void SetupAttrs(SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int from, int to);
+    void SetupYSpan(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int from, int to, int side, s32 positions[10][2]);
+    void SetupYSpanDummy(RenderPolygon* rp, SpanSetupY* span, Polygon* poly, const RenderPolygonVertices& vertices, int vertex, int side, s32 positions[10][2]);
 
     bool CompileShader(GLuint& shader, const std::string& source, const std::initializer_list<const char*>& defines);
 };
@@ -0,0 +1,648 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include "GPU3D_Kernels.h"
+#include "GPU3D.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GPU3D_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+// NEON is always there on AArch64
+#define GPU3D_NEON
+#include <arm_neon.h>
+#endif
+
+namespace melonDS
+{
+
+// reference implementations
+
+static void MatrixMult4x4_Generic(s32* m, const s32* s)
+{
+    s32 tmp[16];
+    memcpy(tmp, m, 16*4);
+
+    // m = s*m
+    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8] + (s64)s[3]*tmp[12]) >> 12;
+    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9] + (s64)s[3]*tmp[13]) >> 12;
+    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10] + (s64)s[3]*tmp[14]) >> 12;
+    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11] + (s64)s[3]*tmp[15]) >> 12;
+
+    m[4] = ((s64)s[4]*tmp[0] + (s64)s[5]*tmp[4] + (s64)s[6]*tmp[8] + (s64)s[7]*tmp[12]) >> 12;
+    m[5] = ((s64)s[4]*tmp[1] + (s64)s[5]*tmp[5] + (s64)s[6]*tmp[9] + (s64)s[7]*tmp[13]) >> 12;
+    m[6] = ((s64)s[4]*tmp[2] + (s64)s[5]*tmp[6] + (s64)s[6]*tmp[10] + (s64)s[7]*tmp[14]) >> 12;
+    m[7] = ((s64)s[4]*tmp[3] + (s64)s[5]*tmp[7] + (s64)s[6]*tmp[11] + (s64)s[7]*tmp[15]) >> 12;
+
+    m[8] = ((s64)s[8]*tmp[0] + (s64)s[9]*tmp[4] + (s64)s[10]*tmp[8] + (s64)s[11]*tmp[12]) >> 12;
+    m[9] = ((s64)s[8]*tmp[1] + (s64)s[9]*tmp[5] + (s64)s[10]*tmp[9] + (s64)s[11]*tmp[13]) >> 12;
+    m[10] = ((s64)s[8]*tmp[2] + (s64)s[9]*tmp[6] + (s64)s[10]*tmp[10] + (s64)s[11]*tmp[14]) >> 12;
+    m[11] = ((s64)s[8]*tmp[3] + (s64)s[9]*tmp[7] + (s64)s[10]*tmp[11] + (s64)s[11]*tmp[15]) >> 12;
+
+    m[12] = ((s64)s[12]*tmp[0] + (s64)s[13]*tmp[4] + (s64)s[14]*tmp[8] + (s64)s[15]*tmp[12]) >> 12;
+    m[13] = ((s64)s[12]*tmp[1] + (s64)s[13]*tmp[5] + (s64)s[14]*tmp[9] + (s64)s[15]*tmp[13]) >> 12;
+    m[14] = ((s64)s[12]*tmp[2] + (s64)s[13]*tmp[6] + (s64)s[14]*tmp[10] + (s64)s[15]*tmp[14]) >> 12;
+    m[15] = ((s64)s[12]*tmp[3] + (s64)s[13]*tmp[7] + (s64)s[14]*tmp[11] + (s64)s[15]*tmp[15]) >> 12;
+}
+
+static void MatrixMult4x3_Generic(s32* m, const s32* s)
+{
+    s32 tmp[16];
+    memcpy(tmp, m, 16*4);
+
+    // m = s*m
+    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8]) >> 12;
+    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9]) >> 12;
+    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10]) >> 12;
+    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11]) >> 12;
+
+    m[4] = ((s64)s[3]*tmp[0] + (s64)s[4]*tmp[4] + (s64)s[5]*tmp[8]) >> 12;
+    m[5] = ((s64)s[3]*tmp[1] + (s64)s[4]*tmp[5] + (s64)s[5]*tmp[9]) >> 12;
+    m[6] = ((s64)s[3]*tmp[2] + (s64)s[4]*tmp[6] + (s64)s[5]*tmp[10]) >> 12;
+    m[7] = ((s64)s[3]*tmp[3] + (s64)s[4]*tmp[7] + (s64)s[5]*tmp[11]) >> 12;
+
+    m[8] = ((s64)s[6]*tmp[0] + (s64)s[7]*tmp[4] + (s64)s[8]*tmp[8]) >> 12;
+    m[9] = ((s64)s[6]*tmp[1] + (s64)s[7]*tmp[5] + (s64)s[8]*tmp[9]) >> 12;
+    m[10] = ((s64)s[6]*tmp[2] + (s64)s[7]*tmp[6] + (s64)s[8]*tmp[10]) >> 12;
+    m[11] = ((s64)s[6]*tmp[3] + (s64)s[7]*tmp[7] + (s64)s[8]*tmp[11]) >> 12;
+
+    m[12] = ((s64)s[9]*tmp[0] + (s64)s[10]*tmp[4] + (s64)s[11]*tmp[8] + (s64)0x1000*tmp[12]) >> 12;
+    m[13] = ((s64)s[9]*tmp[1] + (s64)s[10]*tmp[5] + (s64)s[11]*tmp[9] + (s64)0x1000*tmp[13]) >> 12;
+    m[14] = ((s64)s[9]*tmp[2] + (s64)s[10]*tmp[6] + (s64)s[11]*tmp[10] + (s64)0x1000*tmp[14]) >> 12;
+    m[15] = ((s64)s[9]*tmp[3] + (s64)s[10]*tmp[7] + (s64)s[11]*tmp[11] + (s64)0x1000*tmp[15]) >> 12;
+}
+
+static void MatrixMult3x3_Generic(s32* m, const s32* s)
+{
+    s32 tmp[12];
+    memcpy(tmp, m, 12*4);
+
+    // m = s*m
+    m[0] = ((s64)s[0]*tmp[0] + (s64)s[1]*tmp[4] + (s64)s[2]*tmp[8]) >> 12;
+    m[1] = ((s64)s[0]*tmp[1] + (s64)s[1]*tmp[5] + (s64)s[2]*tmp[9]) >> 12;
+    m[2] = ((s64)s[0]*tmp[2] + (s64)s[1]*tmp[6] + (s64)s[2]*tmp[10]) >> 12;
+    m[3] = ((s64)s[0]*tmp[3] + (s64)s[1]*tmp[7] + (s64)s[2]*tmp[11]) >> 12;
+
+    m[4] = ((s64)s[3]*tmp[0] + (s64)s[4]*tmp[4] + (s64)s[5]*tmp[8]) >> 12;
+    m[5] = ((s64)s[3]*tmp[1] + (s64)s[4]*tmp[5] + (s64)s[5]*tmp[9]) >> 12;
+    m[6] = ((s64)s[3]*tmp[2] + (s64)s[4]*tmp[6] + (s64)s[5]*tmp[10]) >> 12;
+    m[7] = ((s64)s[3]*tmp[3] + (s64)s[4]*tmp[7] + (s64)s[5]*tmp[11]) >> 12;
+
+    m[8] = ((s64)s[6]*tmp[0] + (s64)s[7]*tmp[4] + (s64)s[8]*tmp[8]) >> 12;
+    m[9] = ((s64)s[6]*tmp[1] + (s64)s[7]*tmp[5] + (s64)s[8]*tmp[9]) >> 12;
+    m[10] = ((s64)s[6]*tmp[2] + (s64)s[7]*tmp[6] + (s64)s[8]*tmp[10]) >> 12;
+    m[11] = ((s64)s[6]*tmp[3] + (s64)s[7]*tmp[7] + (s64)s[8]*tmp[11]) >> 12;
+}
+
+static void TransformVector4_Generic(s32* dst, const s32* v, const s32* m)
+{
+    dst[0] = ((s64)v[0]*m[0] + (s64)v[1]*m[4] + (s64)v[2]*m[8] + (s64)v[3]*m[12]) >> 12;
+    dst[1] = ((s64)v[0]*m[1] + (s64)v[1]*m[5] + (s64)v[2]*m[9] + (s64)v[3]*m[13]) >> 12;
+    dst[2] = ((s64)v[0]*m[2] + (s64)v[1]*m[6] + (s64)v[2]*m[10] + (s64)v[3]*m[14]) >> 12;
+    dst[3] = ((s64)v[0]*m[3] + (s64)v[1]*m[7] + (s64)v[2]*m[11] + (s64)v[3]*m[15]) >> 12;
+}
+
+static void TransformNormal_Generic(s32* dst, const s16* n, const s32* m)
+{
+    dst[0] = (s32)((u32)n[0]*(u32)m[0] + (u32)n[1]*(u32)m[4] + (u32)n[2]*(u32)m[8]);
+    dst[1] = (s32)((u32)n[0]*(u32)m[1] + (u32)n[1]*(u32)m[5] + (u32)n[2]*(u32)m[9]);
+    dst[2] = (s32)((u32)n[0]*(u32)m[2] + (u32)n[1]*(u32)m[6] + (u32)n[2]*(u32)m[10]);
+}
+
+static u32 GetClipOutcodes_Generic(const Vertex* vertices, int start, int end)
+{
+    u32 outside = 0;
+    for (int i = start; i < end; i++)
+    {
+        const s32* pos = vertices[i].Position;
+        for (int n = 0; n < 3; n++)
+        {
+            if (pos[n] > pos[3] || pos[n] < -pos[3])
+                outside |= (1 << n);
+        }
+    }
+
+    return outside;
+}
+
+static void InterpolateClipVertex_Generic(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs)
+{
+#define INTERPOLATE(var)  { out->var = (vin->var + ((vout->var - vin->var) * (s64)num) / den); }
+
+    INTERPOLATE(Position[0]);
+    INTERPOLATE(Position[1]);
+    INTERPOLATE(Position[2]);
+    INTERPOLATE(Position[3]);
+
+    if (attribs)
+    {
+        INTERPOLATE(Color[0]);
+        INTERPOLATE(Color[1]);
+        INTERPOLATE(Color[2]);
+
+        INTERPOLATE(TexCoords[0]);
+        INTERPOLATE(TexCoords[1]);
+    }
+
+#undef INTERPOLATE
+}
+
+// The SIMD versions of InterpolateClipVertex do the divisions in double
+// precision, which gives the same results as integer division as long as
+// num/den is between 0 and 1 and the differences are within 2^21:
+// * the products fit in 53 bits, so they are exact
+// * a quotient that isn't an integer is at least 1/|den| (>= 2^-31) away
+//   from the nearest one, while the rounding error of the division is at
+//   most 2^-32, so truncating it gives the right integer
+// This is always the case when clipping polygons of a sane size.
+// Anything else goes through the generic version.
+
+static inline bool ClipFactorInRange(s32 num, s32 den)
+{
+    if (num < 0) return den <= num;
+    return den > 0 && den >= num;
+}
+
+// The SIMD versions compute one row of results at a time: every element
+// of the row vector is broadcast and multiplied with a row of the matrix,
+// with the products widened to 64 bits. The matrix rows are all loaded
+// before anything is stored, so m = s*m can be done in place.
+// Only the low 32 bits of each sum are kept, which are the same whether
+// the shift is arithmetic or logical.
+// There is no AVX2 version: with 64-bit products, a row of results takes
+// up a whole 256-bit register, and it measured no faster than SSE4.1.
+
+#ifdef GPU3D_X86
+
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+
+SSE41_TARGET static inline __m128i MulRow_SSE41(const __m128i* rows, s32 v0, s32 v1, s32 v2, s32 v3)
+{
+    // _mm_mul_epi32 multiplies the even 32-bit lanes
+    __m128i c = _mm_set1_epi32(v0);
+    __m128i lo = _mm_mul_epi32(c, _mm_unpacklo_epi32(rows[0], rows[0]));
+    __m128i hi = _mm_mul_epi32(c, _mm_unpackhi_epi32(rows[0], rows[0]));
+
+    c = _mm_set1_epi32(v1);
+    lo = _mm_add_epi64(lo, _mm_mul_epi32(c, _mm_unpacklo_epi32(rows[1], rows[1])));
+    hi = _mm_add_epi64(hi, _mm_mul_epi32(c, _mm_unpackhi_epi32(rows[1], rows[1])));
+
+    c = _mm_set1_epi32(v2);
+    lo = _mm_add_epi64(lo, _mm_mul_epi32(c, _mm_unpacklo_epi32(rows[2], rows[2])));
+    hi = _mm_add_epi64(hi, _mm_mul_epi32(c, _mm_unpackhi_epi32(rows[2], rows[2])));
+
+    c = _mm_set1_epi32(v3);
+    lo = _mm_add_epi64(lo, _mm_mul_epi32(c, _mm_unpacklo_epi32(rows[3], rows[3])));
+    hi = _mm_add_epi64(hi, _mm_mul_epi32(c, _mm_unpackhi_epi32(rows[3], rows[3])));
+
+    lo = _mm_srli_epi64(lo, 12);
+    hi = _mm_srli_epi64(hi, 12);
+    return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+SSE41_TARGET static inline void LoadRows_SSE41(__m128i* rows, const s32* m)
+{
+    for (int i = 0; i < 4; i++)
+        rows[i] = _mm_loadu_si128((const __m128i*)&m[i*4]);
+}
+
+SSE41_TARGET static void MatrixMult4x4_SSE41(s32* m, const s32* s)
+{
+    __m128i rows[4];
+    LoadRows_SSE41(rows, m);
+
+    for (int i = 0; i < 4; i++)
+        _mm_storeu_si128((__m128i*)&m[i*4], MulRow_SSE41(rows, s[i*4], s[i*4+1], s[i*4+2], s[i*4+3]));
+}
+
+SSE41_TARGET static void MatrixMult4x3_SSE41(s32* m, const s32* s)
+{
+    __m128i rows[4];
+    LoadRows_SSE41(rows, m);
+
+    for (int i = 0; i < 3; i++)
+        _mm_storeu_si128((__m128i*)&m[i*4], MulRow_SSE41(rows, s[i*3], s[i*3+1], s[i*3+2], 0));
+    _mm_storeu_si128((__m128i*)&m[12], MulRow_SSE41(rows, s[9], s[10], s[11], 0x1000));
+}
+
+SSE41_TARGET static void MatrixMult3x3_SSE41(s32* m, const s32* s)
+{
+    __m128i rows[4];
+    LoadRows_SSE41(rows, m);
+
+    for (int i = 0; i < 3; i++)
+        _mm_storeu_si128((__m128i*)&m[i*4], MulRow_SSE41(rows, s[i*3], s[i*3+1], s[i*3+2], 0));
+}
+
+SSE41_TARGET static void TransformVector4_SSE41(s32* dst, const s32* v, const s32* m)
+{
+    __m128i rows[4];
+    LoadRows_SSE41(rows, m);
+
+    _mm_storeu_si128((__m128i*)dst, MulRow_SSE41(rows, v[0], v[1], v[2], v[3]));
+}
+
+SSE41_TARGET static void TransformNormal_SSE41(s32* dst, const s16* n, const s32* m)
+{
+    __m128i res = _mm_mullo_epi32(_mm_set1_epi32(n[0]), _mm_loadu_si128((const __m128i*)&m[0]));
+    res = _mm_add_epi32(res, _mm_mullo_epi32(_mm_set1_epi32(n[1]), _mm_loadu_si128((const __m128i*)&m[4])));
+    res = _mm_add_epi32(res, _mm_mullo_epi32(_mm_set1_epi32(n[2]), _mm_loadu_si128((const __m128i*)&m[8])));
+
+    s32 tmp[4];
+    _mm_storeu_si128((__m128i*)tmp, res);
+    memcpy(dst, tmp, 3*4);
+}
+
+SSE41_TARGET static u32 GetClipOutcodes_SSE41(const Vertex* vertices, int start, int end)
+{
+    __m128i outside = _mm_setzero_si128();
+    for (int i = start; i < end; i++)
+    {
+        __m128i pos = _mm_loadu_si128((const __m128i*)vertices[i].Position);
+        __m128i w = _mm_shuffle_epi32(pos, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i negw = _mm_sub_epi32(_mm_setzero_si128(), w);
+
+        outside = _mm_or_si128(outside, _mm_cmpgt_epi32(pos, w));
+        outside = _mm_or_si128(outside, _mm_cmpgt_epi32(negw, pos));
+    }
+
+    // the W lane isn't relevant
+    return _mm_movemask_ps(_mm_castsi128_ps(outside)) & 0x7;
+}
+
+SSE41_TARGET static inline bool DiffInRange_SSE41(__m128i diff)
+{
+    __m128i biased = _mm_add_epi32(diff, _mm_set1_epi32(1 << 21));
+    return _mm_testz_si128(biased, _mm_set1_epi32(~((1 << 22) - 1)));
+}
+
+SSE41_TARGET static inline __m128i Interpolate_SSE41(__m128i in, __m128i diff, __m128d num, __m128d den)
+{
+    __m128d lo = _mm_cvtepi32_pd(diff);
+    __m128d hi = _mm_cvtepi32_pd(_mm_unpackhi_epi64(diff, diff));
+
+    lo = _mm_div_pd(_mm_mul_pd(lo, num), den);
+    hi = _mm_div_pd(_mm_mul_pd(hi, num), den);
+
+    __m128i quot = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+    return _mm_add_epi32(in, quot);
+}
+
+SSE41_TARGET static void InterpolateClipVertex_SSE41(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs)
+{
+    if (!ClipFactorInRange(num, den))
+    {
+        InterpolateClipVertex_Generic(out, vin, vout, num, den, attribs);
+        return;
+    }
+
+    __m128i pos = _mm_loadu_si128((const __m128i*)vin->Position);
+    __m128i posdiff = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)vout->Position), pos);
+    bool inrange = DiffInRange_SSE41(posdiff);
+
+    __m128i col, coldiff, tex, texdiff;
+    if (attribs)
+    {
+        col = _mm_setr_epi32(vin->Color[0], vin->Color[1], vin->Color[2], 0);
+        coldiff = _mm_sub_epi32(_mm_setr_epi32(vout->Color[0], vout->Color[1], vout->Color[2], 0), col);
+        tex = _mm_setr_epi32(vin->TexCoords[0], vin->TexCoords[1], 0, 0);
+        texdiff = _mm_sub_epi32(_mm_setr_epi32(vout->TexCoords[0], vout->TexCoords[1], 0, 0), tex);
+        inrange = inrange && DiffInRange_SSE41(_mm_or_si128(coldiff, texdiff));
+    }
+
+    if (!inrange)
+    {
+        InterpolateClipVertex_Generic(out, vin, vout, num, den, attribs);
+        return;
+    }
+
+    __m128d dnum = _mm_set1_pd(num);
+    __m128d dden = _mm_set1_pd(den);
+
+    _mm_storeu_si128((__m128i*)out->Position, Interpolate_SSE41(pos, posdiff, dnum, dden));
+
+    if (attribs)
+    {
+        col = Interpolate_SSE41(col, coldiff, dnum, dden);
+        out->Color[0] = _mm_extract_epi32(col, 0);
+        out->Color[1] = _mm_extract_epi32(col, 1);
+        out->Color[2] = _mm_extract_epi32(col, 2);
+
+        tex = Interpolate_SSE41(tex, texdiff, dnum, dden);
+        out->TexCoords[0] = _mm_extract_epi32(tex, 0);
+        out->TexCoords[1] = _mm_extract_epi32(tex, 1);
+    }
+}
+
+#endif // GPU3D_X86
+
+#ifdef GPU3D_NEON
+
+static inline int32x4_t MulRow_NEON(const int32x4_t* rows, s32 v0, s32 v1, s32 v2, s32 v3)
+{
+    int64x2_t lo = vmull_n_s32(vget_low_s32(rows[0]), v0);
+    int64x2_t hi = vmull_n_s32(vget_high_s32(rows[0]), v0);
+
+    lo = vmlal_n_s32(lo, vget_low_s32(rows[1]), v1);
+    hi = vmlal_n_s32(hi, vget_high_s32(rows[1]), v1);
+
+    lo = vmlal_n_s32(lo, vget_low_s32(rows[2]), v2);
+    hi = vmlal_n_s32(hi, vget_high_s32(rows[2]), v2);
+
+    lo = vmlal_n_s32(lo, vget_low_s32(rows[3]), v3);
+    hi = vmlal_n_s32(hi, vget_high_s32(rows[3]), v3);
+
+    return vcombine_s32(vmovn_s64(vshrq_n_s64(lo, 12)), vmovn_s64(vshrq_n_s64(hi, 12)));
+}
+
+static inline void LoadRows_NEON(int32x4_t* rows, const s32* m)
+{
+    for (int i = 0; i < 4; i++)
+        rows[i] = vld1q_s32(&m[i*4]);
+}
+
+static void MatrixMult4x4_NEON(s32* m, const s32* s)
+{
+    int32x4_t rows[4];
+    LoadRows_NEON(rows, m);
+
+    for (int i = 0; i < 4; i++)
+        vst1q_s32(&m[i*4], MulRow_NEON(rows, s[i*4], s[i*4+1], s[i*4+2], s[i*4+3]));
+}
+
+static void MatrixMult4x3_NEON(s32* m, const s32* s)
+{
+    int32x4_t rows[4];
+    LoadRows_NEON(rows, m);
+
+    for (int i = 0; i < 3; i++)
+        vst1q_s32(&m[i*4], MulRow_NEON(rows, s[i*3], s[i*3+1], s[i*3+2], 0));
+    vst1q_s32(&m[12], MulRow_NEON(rows, s[9], s[10], s[11], 0x1000));
+}
+
+static void MatrixMult3x3_NEON(s32* m, const s32* s)
+{
+    int32x4_t rows[4];
+    LoadRows_NEON(rows, m);
+
+    for (int i = 0; i < 3; i++)
+        vst1q_s32(&m[i*4], MulRow_NEON(rows, s[i*3], s[i*3+1], s[i*3+2], 0));
+}
+
+static void TransformVector4_NEON(s32* dst, const s32* v, const s32* m)
+{
+    int32x4_t rows[4];
+    LoadRows_NEON(rows, m);
+
+    vst1q_s32(dst, MulRow_NEON(rows, v[0], v[1], v[2], v[3]));
+}
+
+static void TransformNormal_NEON(s32* dst, const s16* n, const s32* m)
+{
+    int32x4_t res = vmulq_n_s32(vld1q_s32(&m[0]), n[0]);
+    res = vmlaq_n_s32(res, vld1q_s32(&m[4]), n[1]);
+    res = vmlaq_n_s32(res, vld1q_s32(&m[8]), n[2]);
+
+    s32 tmp[4];
+    vst1q_s32(tmp, res);
+    memcpy(dst, tmp, 3*4);
+}
+
+static u32 GetClipOutcodes_NEON(const Vertex* vertices, int start, int end)
+{
+    uint32x4_t outside = vdupq_n_u32(0);
+    for (int i = start; i < end; i++)
+    {
+        int32x4_t pos = vld1q_s32(vertices[i].Position);
+        int32x4_t w = vdupq_laneq_s32(pos, 3);
+
+        outside = vorrq_u32(outside, vcgtq_s32(pos, w));
+        outside = vorrq_u32(outside, vcltq_s32(pos, vnegq_s32(w)));
+    }
+
+    return (vgetq_lane_u32(outside, 0) & 0x1) |
+           (vgetq_lane_u32(outside, 1) & 0x2) |
+           (vgetq_lane_u32(outside, 2) & 0x4);
+}
+
+static inline bool DiffInRange_NEON(int32x4_t diff)
+{
+    uint32x4_t biased = vreinterpretq_u32_s32(vaddq_s32(diff, vdupq_n_s32(1 << 21)));
+    return vmaxvq_u32(biased) < (1 << 22);
+}
+
+static inline int32x4_t Interpolate_NEON(int32x4_t in, int32x4_t diff, float64x2_t num, float64x2_t den)
+{
+    float64x2_t lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(diff)));
+    float64x2_t hi = vcvtq_f64_s64(vmovl_s32(vget_high_s32(diff)));
+
+    lo = vdivq_f64(vmulq_f64(lo, num), den);
+    hi = vdivq_f64(vmulq_f64(hi, num), den);
+
+    // vcvtq_s64_f64 rounds towards zero
+    int32x4_t quot = vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)), vmovn_s64(vcvtq_s64_f64(hi)));
+    return vaddq_s32(in, quot);
+}
+
+static void InterpolateClipVertex_NEON(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs)
+{
+    if (!ClipFactorInRange(num, den))
+    {
+        InterpolateClipVertex_Generic(out, vin, vout, num, den, attribs);
+        return;
+    }
+
+    int32x4_t pos = vld1q_s32(vin->Position);
+    int32x4_t posdiff = vsubq_s32(vld1q_s32(vout->Position), pos);
+    bool inrange = DiffInRange_NEON(posdiff);
+
+    int32x4_t col, coldiff, tex, texdiff;
+    if (attribs)
+    {
+        const s32 colin[4] = {vin->Color[0], vin->Color[1], vin->Color[2], 0};
+        const s32 colout[4] = {vout->Color[0], vout->Color[1], vout->Color[2], 0};
+        const s32 texin[4] = {vin->TexCoords[0], vin->TexCoords[1], 0, 0};
+        const s32 texout[4] = {vout->TexCoords[0], vout->TexCoords[1], 0, 0};
+
+        col = vld1q_s32(colin);
+        coldiff = vsubq_s32(vld1q_s32(colout), col);
+        tex = vld1q_s32(texin);
+        texdiff = vsubq_s32(vld1q_s32(texout), tex);
+        inrange = inrange && DiffInRange_NEON(vorrq_s32(coldiff, texdiff));
+    }
+
+    if (!inrange)
+    {
+        InterpolateClipVertex_Generic(out, vin, vout, num, den, attribs);
+        return;
+    }
+
+    float64x2_t dnum = vdupq_n_f64(num);
+    float64x2_t dden = vdupq_n_f64(den);
+
+    vst1q_s32(out->Position, Interpolate_NEON(pos, posdiff, dnum, dden));
+
+    if (attribs)
+    {
+        col = Interpolate_NEON(col, coldiff, dnum, dden);
+        out->Color[0] = vgetq_lane_s32(col, 0);
+        out->Color[1] = vgetq_lane_s32(col, 1);
+        out->Color[2] = vgetq_lane_s32(col, 2);
+
+        tex = Interpolate_NEON(tex, texdiff, dnum, dden);
+        out->TexCoords[0] = vgetq_lane_s32(tex, 0);
+        out->TexCoords[1] = vgetq_lane_s32(tex, 1);
+    }
+}
+
+#endif // GPU3D_NEON
+
+struct GeometryKernels
+{
+    const char* Name;
+    void (*MatrixMult4x4)(s32* m, const s32* s);
+    void (*MatrixMult4x3)(s32* m, const s32* s);
+    void (*MatrixMult3x3)(s32* m, const s32* s);
+    void (*TransformVector4)(s32* dst, const s32* v, const s32* m);
+    void (*TransformNormal)(s32* dst, const s16* n, const s32* m);
+    u32 (*GetClipOutcodes)(const Vertex* vertices, int start, int end);
+    void (*InterpolateClipVertex)(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs);
+};
+
+static const GeometryKernels Kernels_Generic =
+{
+    "generic",
+    MatrixMult4x4_Generic, MatrixMult4x3_Generic, MatrixMult3x3_Generic,
+    TransformVector4_Generic, TransformNormal_Generic,
+    GetClipOutcodes_Generic, InterpolateClipVertex_Generic,
+};
+
+#ifdef GPU3D_X86
+static const GeometryKernels Kernels_SSE41 =
+{
+    "SSE4.1",
+    MatrixMult4x4_SSE41, MatrixMult4x3_SSE41, MatrixMult3x3_SSE41,
+    TransformVector4_SSE41, TransformNormal_SSE41,
+    GetClipOutcodes_SSE41, InterpolateClipVertex_SSE41,
+};
+#endif
+
+#ifdef GPU3D_NEON
+static const GeometryKernels Kernels_NEON =
+{
+    "NEON",
+    MatrixMult4x4_NEON, MatrixMult4x3_NEON, MatrixMult3x3_NEON,
+    TransformVector4_NEON, TransformNormal_NEON,
+    GetClipOutcodes_NEON, InterpolateClipVertex_NEON,
+};
+#endif
+
+static const GeometryKernels& SelectKernels()
+{
+#if defined(GPU3D_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+        return Kernels_SSE41;
+#elif defined(GPU3D_NEON)
+    return Kernels_NEON;
+#endif
+
+    return Kernels_Generic;
+}
+
+// set by SetGeometryKernels, overrides the automatic choice
+static const GeometryKernels* ForcedKernels = nullptr;
+
+static const GeometryKernels& GetKernels()
+{
+    static const GeometryKernels& kernels = SelectKernels();
+    if (ForcedKernels)
+        return *ForcedKernels;
+    return kernels;
+}
+
+bool SetGeometryKernels(const char* name) noexcept
+{
+    if (!name)
+    {
+        ForcedKernels = nullptr;
+        return true;
+    }
+
+    const GeometryKernels* kernels = nullptr;
+    if (!strcmp(name, Kernels_Generic.Name))
+        kernels = &Kernels_Generic;
+#if defined(GPU3D_X86)
+    __builtin_cpu_init();
+    if (!strcmp(name, Kernels_SSE41.Name) && __builtin_cpu_supports("sse4.1"))
+        kernels = &Kernels_SSE41;
+#elif defined(GPU3D_NEON)
+    if (!strcmp(name, Kernels_NEON.Name))
+        kernels = &Kernels_NEON;
+#endif
+
+    if (!kernels)
+        return false;
+
+    ForcedKernels = kernels;
+    return true;
+}
+
+const char* GetGeometryKernelsName() noexcept
+{
+    return GetKernels().Name;
+}
+
+void MatrixMult4x4(s32* m, const s32* s) noexcept
+{
+    GetKernels().MatrixMult4x4(m, s);
+}
+
+void MatrixMult4x3(s32* m, const s32* s) noexcept
+{
+    GetKernels().MatrixMult4x3(m, s);
+}
+
+void MatrixMult3x3(s32* m, const s32* s) noexcept
+{
+    GetKernels().MatrixMult3x3(m, s);
+}
+
+void TransformVector4(s32* dst, const s32* v, const s32* m) noexcept
+{
+    GetKernels().TransformVector4(dst, v, m);
+}
+
+void TransformNormal(s32* dst, const s16* n, const s32* m) noexcept
+{
+    GetKernels().TransformNormal(dst, n, m);
+}
+
+u32 GetClipOutcodes(const Vertex* vertices, int start, int end) noexcept
+{
+    return GetKernels().GetClipOutcodes(vertices, start, end);
+}
+
+void InterpolateClipVertex(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs) noexcept
+{
+    GetKernels().InterpolateClipVertex(out, vin, vout, num, den, attribs);
+}
+
+}
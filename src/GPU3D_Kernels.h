@@ -0,0 +1,72 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef GPU3D_KERNELS_H
+#define GPU3D_KERNELS_H
+
+#include "types.h"
+
+// Fixed-point matrix math and polygon clipping used by the geometry engine.
+// Matrices are 4x4, row-major, with 12 fractional bits.
+//
+// These use SSE4.1 or NEON when the CPU has them, which is checked
+// once at runtime. All versions give the same results as the plain C ones:
+// products are done in 64 bits (32 bits for normals) and wrap around
+// the same way.
+
+namespace melonDS
+{
+
+struct Vertex;
+
+/// @return The name of the instruction set used by the geometry kernels.
+const char* GetGeometryKernelsName() noexcept;
+
+/// Makes the geometry kernels use the given instruction set ("generic",
+/// "SSE4.1" or "NEON"), so they can be checked against each other.
+/// \c nullptr goes back to picking the best one for the CPU.
+/// Must not be called while the geometry engine is running.
+/// @return \c false if the instruction set isn't available here.
+bool SetGeometryKernels(const char* name) noexcept;
+
+/// m = s*m, with s a 4x4 matrix.
+void MatrixMult4x4(s32* m, const s32* s) noexcept;
+/// m = s*m, with s a 4x3 matrix (the last column being 0,0,0,1).
+void MatrixMult4x3(s32* m, const s32* s) noexcept;
+/// m = s*m, with s a 3x3 matrix. Only the first three rows of m are affected.
+void MatrixMult3x3(s32* m, const s32* s) noexcept;
+
+/// dst = v*m, each component being shifted right by 12.
+void TransformVector4(s32* dst, const s32* v, const s32* m) noexcept;
+
+/// dst = n*m for the upper 3x3 part of m, in 32-bit precision,
+/// without any shift. The caller is in charge of truncating the results.
+void TransformNormal(s32* dst, const s16* n, const s32* m) noexcept;
+
+/// @return A mask where bit n (0=X, 1=Y, 2=Z) is set if any of the vertices
+/// from start to end-1 has Position[n] > W or Position[n] < -W.
+u32 GetClipOutcodes(const Vertex* vertices, int start, int end) noexcept;
+
+/// Sets the position of out to vin + (vout-vin)*num/den, as well as the color
+/// and texture coordinates if attribs is set. The quotients are truncated
+/// like with 64-bit integer division.
+void InterpolateClipVertex(Vertex* out, const Vertex* vin, const Vertex* vout, s32 num, s32 den, bool attribs) noexcept;
+
+}
+
+#endif // GPU3D_KERNELS_H
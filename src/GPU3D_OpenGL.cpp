@@ -369,9 +369,10 @@ void GLRenderer::SetRenderSettings(bool betterpolygons, int scale) noexcept
 }
 
 
-void GLRenderer::SetupPolygon(GLRenderer::RendererPolygon* rp, Polygon* polygon) const
+void GLRenderer::SetupPolygon(GLRenderer::RendererPolygon* rp, Polygon* polygon, const RenderPolygonVertices& vertices) const
 {
     rp->PolyData = polygon;
+    rp->Vertices = vertices;
 
     // render key: depending on what we're drawing
     // opaque polygons:
@@ -415,7 +416,7 @@ void GLRenderer::SetupPolygon(GLRenderer::RendererPolygon* rp, Polygon* polygon)
     }
 }
 
-u32* GLRenderer::SetupVertex(const Polygon* poly, int vid, const Vertex* vtx, u32 vtxattr, u32* vptr) const
+u32* GLRenderer::SetupVertex(const Polygon* poly, const RenderPolygonVertices& vertices, int vid, u32 vtxattr, u32* vptr) const
 {
     u32 z = poly->FinalZ[vid];
     u32 w = poly->FinalW[vid];
@@ -429,45 +430,43 @@ u32* GLRenderer::SetupVertex(const Polygon* poly, int vid, const Vertex* vtx, u3
     u32 x, y;
     if (ScaleFactor > 1)
     {
-        x = (vtx->HiresPosition[0] * ScaleFactor) >> 4;
-        y = (vtx->HiresPosition[1] * ScaleFactor) >> 4;
+        x = (vertices.HiresPosition[vid][0] * ScaleFactor) >> 4;
+        y = (vertices.HiresPosition[vid][1] * ScaleFactor) >> 4;
     }
     else
     {
-        x = vtx->FinalPosition[0];
-        y = vtx->FinalPosition[1];
+        x = vertices.FinalPosition[vid][0];
+        y = vertices.FinalPosition[vid][1];
     }
 
     // correct nearly-vertical edges that would look vertical on the DS
     /*{
         int vtopid = vid - 1;
         if (vtopid < 0) vtopid = poly->NumVertices-1;
-        Vertex* vtop = poly->Vertices[vtopid];
-        if (vtop->FinalPosition[1] >= vtx->FinalPosition[1])
+        if (vertices.FinalPosition[vtopid][1] >= vertices.FinalPosition[vid][1])
         {
             vtopid = vid + 1;
             if (vtopid >= poly->NumVertices) vtopid = 0;
-            vtop = poly->Vertices[vtopid];
         }
-        if ((vtop->FinalPosition[1] < vtx->FinalPosition[1]) &&
-            (vtx->FinalPosition[0] == vtop->FinalPosition[0]-1))
+        if ((vertices.FinalPosition[vtopid][1] < vertices.FinalPosition[vid][1]) &&
+            (vertices.FinalPosition[vid][0] == vertices.FinalPosition[vtopid][0]-1))
         {
             if (ScaleFactor > 1)
-                x = (vtop->HiresPosition[0] * ScaleFactor) >> 4;
+                x = (vertices.HiresPosition[vtopid][0] * ScaleFactor) >> 4;
             else
-                x = vtop->FinalPosition[0];
+                x = vertices.FinalPosition[vtopid][0];
         }
     }*/
 
     *vptr++ = x | (y << 16);
     *vptr++ = z | (w << 16);
 
-    *vptr++ =  (vtx->FinalColor[0] >> 1) |
-              ((vtx->FinalColor[1] >> 1) << 8) |
-              ((vtx->FinalColor[2] >> 1) << 16) |
+    *vptr++ =  (vertices.FinalColor[vid][0] >> 1) |
+              ((vertices.FinalColor[vid][1] >> 1) << 8) |
+              ((vertices.FinalColor[vid][2] >> 1) << 16) |
               (alpha << 24);
 
-    *vptr++ = (u16)vtx->TexCoords[0] | ((u16)vtx->TexCoords[1] << 16);
+    *vptr++ = (u16)vertices.TexCoords[vid][0] | ((u16)vertices.TexCoords[vid][1] << 16);
 
     *vptr++ = vtxattr | (zshift << 16);
     *vptr++ = poly->TexParam;
@@ -511,18 +510,16 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
             int nout = 0;
             for (u32 j = 0; j < poly->NumVertices; j++)
             {
-                Vertex* vtx = poly->Vertices[j];
-
                 if (j > 0)
                 {
-                    if (lastx == vtx->FinalPosition[0] &&
-                        lasty == vtx->FinalPosition[1]) continue;
+                    if (lastx == rp->Vertices.FinalPosition[j][0] &&
+                        lasty == rp->Vertices.FinalPosition[j][1]) continue;
                 }
 
-                lastx = vtx->FinalPosition[0];
-                lasty = vtx->FinalPosition[1];
+                lastx = rp->Vertices.FinalPosition[j][0];
+                lasty = rp->Vertices.FinalPosition[j][1];
 
-                vptr = SetupVertex(poly, j, vtx, vtxattr, vptr);
+                vptr = SetupVertex(poly, rp->Vertices, j, vtxattr, vptr);
 
                 IndexBuffer[iidx++] = vidx;
                 rp->NumIndices++;
@@ -538,9 +535,7 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
 
             for (int j = 0; j < 3; j++)
             {
-                Vertex* vtx = poly->Vertices[j];
-
-                vptr = SetupVertex(poly, j, vtx, vtxattr, vptr);
+                vptr = SetupVertex(poly, rp->Vertices, j, vtxattr, vptr);
                 vidx++;
             }
 
@@ -560,9 +555,7 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
 
                 for (u32 j = 0; j < poly->NumVertices; j++)
                 {
-                    Vertex* vtx = poly->Vertices[j];
-
-                    vptr = SetupVertex(poly, j, vtx, vtxattr, vptr);
+                    vptr = SetupVertex(poly, rp->Vertices, j, vtxattr, vptr);
 
                     if (j >= 2)
                     {
@@ -591,10 +584,8 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
 
                 for (u32 j = 0; j < poly->NumVertices; j++)
                 {
-                    Vertex* vtx = poly->Vertices[j];
-
-                    cX += vtx->HiresPosition[0];
-                    cY += vtx->HiresPosition[1];
+                    cX += rp->Vertices.HiresPosition[j][0];
+                    cY += rp->Vertices.HiresPosition[j][1];
 
                     float fw = (float)poly->FinalW[j] * poly->NumVertices;
                     cW += 1.0f / fw;
@@ -602,12 +593,12 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
                     if (poly->WBuffer) cZ += poly->FinalZ[j] / fw;
                     else               cZ += poly->FinalZ[j];
 
-                    cR += (vtx->FinalColor[0] >> 1) / fw;
-                    cG += (vtx->FinalColor[1] >> 1) / fw;
-                    cB += (vtx->FinalColor[2] >> 1) / fw;
+                    cR += (rp->Vertices.FinalColor[j][0] >> 1) / fw;
+                    cG += (rp->Vertices.FinalColor[j][1] >> 1) / fw;
+                    cB += (rp->Vertices.FinalColor[j][2] >> 1) / fw;
 
-                    cS += vtx->TexCoords[0] / fw;
-                    cT += vtx->TexCoords[1] / fw;
+                    cS += rp->Vertices.TexCoords[j][0] / fw;
+                    cT += rp->Vertices.TexCoords[j][1] / fw;
                 }
 
                 cX /= poly->NumVertices;
@@ -654,9 +645,7 @@ void GLRenderer::BuildPolygons(GLRenderer::RendererPolygon* polygons, int npolys
                 // build the final polygon
                 for (u32 j = 0; j < poly->NumVertices; j++)
                 {
-                    Vertex* vtx = poly->Vertices[j];
-
-                    vptr = SetupVertex(poly, j, vtx, vtxattr, vptr);
+                    vptr = SetupVertex(poly, rp->Vertices, j, vtxattr, vptr);
 
                     if (j >= 1)
                     {
@@ -1264,7 +1253,7 @@ void GLRenderer::RenderFrame(GPU& gpu)
         {
             if (gpu.GPU3D.RenderPolygonRAM[i]->Degenerate) continue;
 
-            SetupPolygon(&PolygonList[npolys], gpu.GPU3D.RenderPolygonRAM[i]);
+            SetupPolygon(&PolygonList[npolys], gpu.GPU3D.RenderPolygonRAM[i], gpu.GPU3D.GetRenderPolygonVertices(i));
             if (firsttrans < 0 && gpu.GPU3D.RenderPolygonRAM[i]->Translucent)
                 firsttrans = npolys;
 
@@ -62,6 +62,7 @@ private:
     struct RendererPolygon
     {
         Polygon* PolyData;
+        RenderPolygonVertices Vertices;
 
         u32 NumIndices;
         u32 IndicesOffset;
@@ -78,8 +79,8 @@ private:
 
     bool BuildRenderShader(u32 flags, const std::string& vs, const std::string& fs);
     void UseRenderShader(u32 flags);
-    void SetupPolygon(RendererPolygon* rp, Polygon* polygon) const;
-    u32* SetupVertex(const Polygon* poly, int vid, const Vertex* vtx, u32 vtxattr, u32* vptr) const;
+    void SetupPolygon(RendererPolygon* rp, Polygon* polygon, const RenderPolygonVertices& vertices) const;
+    u32* SetupVertex(const Polygon* poly, const RenderPolygonVertices& vertices, int vid, u32 vtxattr, u32* vptr) const;
     void BuildPolygons(RendererPolygon* polygons, int npolys);
     int RenderSinglePolygon(int i) const;
     int RenderPolygonBatch(int i) const;
@@ -602,7 +602,7 @@ void SoftRenderer::SetupPolygonLeftEdge(SoftRenderer::RendererPolygon* rp, s32 y
 {
     Polygon* polygon = rp->PolyData;
 
-    while (y >= polygon->Vertices[rp->NextVL]->FinalPosition[1] && rp->CurVL != polygon->VBottom)
+    while (y >= rp->Vertices.FinalPosition[rp->NextVL][1] && rp->CurVL != polygon->VBottom)
     {
         rp->CurVL = rp->NextVL;
 
@@ -620,8 +620,8 @@ void SoftRenderer::SetupPolygonLeftEdge(SoftRenderer::RendererPolygon* rp, s32 y
         }
     }
 
-    rp->XL = rp->SlopeL.Setup(polygon->Vertices[rp->CurVL]->FinalPosition[0], polygon->Vertices[rp->NextVL]->FinalPosition[0],
-                              polygon->Vertices[rp->CurVL]->FinalPosition[1], polygon->Vertices[rp->NextVL]->FinalPosition[1],
+    rp->XL = rp->SlopeL.Setup(rp->Vertices.FinalPosition[rp->CurVL][0], rp->Vertices.FinalPosition[rp->NextVL][0],
+                              rp->Vertices.FinalPosition[rp->CurVL][1], rp->Vertices.FinalPosition[rp->NextVL][1],
                               polygon->FinalW[rp->CurVL], polygon->FinalW[rp->NextVL], y);
 }
 
@@ -629,7 +629,7 @@ void SoftRenderer::SetupPolygonRightEdge(SoftRenderer::RendererPolygon* rp, s32
 {
     Polygon* polygon = rp->PolyData;
 
-    while (y >= polygon->Vertices[rp->NextVR]->FinalPosition[1] && rp->CurVR != polygon->VBottom)
+    while (y >= rp->Vertices.FinalPosition[rp->NextVR][1] && rp->CurVR != polygon->VBottom)
     {
         rp->CurVR = rp->NextVR;
 
@@ -647,12 +647,12 @@ void SoftRenderer::SetupPolygonRightEdge(SoftRenderer::RendererPolygon* rp, s32
         }
     }
 
-    rp->XR = rp->SlopeR.Setup(polygon->Vertices[rp->CurVR]->FinalPosition[0], polygon->Vertices[rp->NextVR]->FinalPosition[0],
-                              polygon->Vertices[rp->CurVR]->FinalPosition[1], polygon->Vertices[rp->NextVR]->FinalPosition[1],
+    rp->XR = rp->SlopeR.Setup(rp->Vertices.FinalPosition[rp->CurVR][0], rp->Vertices.FinalPosition[rp->NextVR][0],
+                              rp->Vertices.FinalPosition[rp->CurVR][1], rp->Vertices.FinalPosition[rp->NextVR][1],
                               polygon->FinalW[rp->CurVR], polygon->FinalW[rp->NextVR], y);
 }
 
-void SoftRenderer::SetupPolygon(SoftRenderer::RendererPolygon* rp, Polygon* polygon) const
+void SoftRenderer::SetupPolygon(SoftRenderer::RendererPolygon* rp, Polygon* polygon, const RenderPolygonVertices& vertices) const
 {
     u32 nverts = polygon->NumVertices;
 
@@ -660,6 +660,7 @@ void SoftRenderer::SetupPolygon(SoftRenderer::RendererPolygon* rp, Polygon* poly
     s32 ytop = polygon->YTop, ybot = polygon->YBottom;
 
     rp->PolyData = polygon;
+    rp->Vertices = vertices;
 
     rp->CurVL = vtop;
     rp->CurVR = vtop;
@@ -685,18 +686,18 @@ void SoftRenderer::SetupPolygon(SoftRenderer::RendererPolygon* rp, Polygon* poly
         int i;
 
         i = 1;
-        if (polygon->Vertices[i]->FinalPosition[0] < polygon->Vertices[vtop]->FinalPosition[0]) vtop = i;
-        if (polygon->Vertices[i]->FinalPosition[0] > polygon->Vertices[vbot]->FinalPosition[0]) vbot = i;
+        if (rp->Vertices.FinalPosition[i][0] < rp->Vertices.FinalPosition[vtop][0]) vtop = i;
+        if (rp->Vertices.FinalPosition[i][0] > rp->Vertices.FinalPosition[vbot][0]) vbot = i;
 
         i = nverts - 1;
-        if (polygon->Vertices[i]->FinalPosition[0] < polygon->Vertices[vtop]->FinalPosition[0]) vtop = i;
-        if (polygon->Vertices[i]->FinalPosition[0] > polygon->Vertices[vbot]->FinalPosition[0]) vbot = i;
+        if (rp->Vertices.FinalPosition[i][0] < rp->Vertices.FinalPosition[vtop][0]) vtop = i;
+        if (rp->Vertices.FinalPosition[i][0] > rp->Vertices.FinalPosition[vbot][0]) vbot = i;
 
         rp->CurVL = vtop; rp->NextVL = vtop;
         rp->CurVR = vbot; rp->NextVR = vbot;
 
-        rp->XL = rp->SlopeL.SetupDummy(polygon->Vertices[rp->CurVL]->FinalPosition[0]);
-        rp->XR = rp->SlopeR.SetupDummy(polygon->Vertices[rp->CurVR]->FinalPosition[0]);
+        rp->XL = rp->SlopeL.SetupDummy(rp->Vertices.FinalPosition[rp->CurVL][0]);
+        rp->XR = rp->SlopeR.SetupDummy(rp->Vertices.FinalPosition[rp->CurVR][0]);
     }
     else
     {
@@ -730,18 +731,18 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
 
     if (polygon->YTop != polygon->YBottom)
     {
-        if (y >= polygon->Vertices[rp->NextVL]->FinalPosition[1] && rp->CurVL != polygon->VBottom)
+        if (y >= rp->Vertices.FinalPosition[rp->NextVL][1] && rp->CurVL != polygon->VBottom)
         {
             SetupPolygonLeftEdge(rp, y);
         }
 
-        if (y >= polygon->Vertices[rp->NextVR]->FinalPosition[1] && rp->CurVR != polygon->VBottom)
+        if (y >= rp->Vertices.FinalPosition[rp->NextVR][1] && rp->CurVR != polygon->VBottom)
         {
             SetupPolygonRightEdge(rp, y);
         }
     }
 
-    Vertex *vlcur, *vlnext, *vrcur, *vrnext;
+    u32 vlcur, vlnext, vrcur, vrnext;
     s32 xstart, xend;
     bool l_filledge, r_filledge;
     s32 l_edgelen, r_edgelen;
@@ -766,10 +767,10 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
     // if the left and right edges are swapped, render backwards.
     if (xstart > xend)
     {
-        vlcur = polygon->Vertices[rp->CurVR];
-        vlnext = polygon->Vertices[rp->NextVR];
-        vrcur = polygon->Vertices[rp->CurVL];
-        vrnext = polygon->Vertices[rp->NextVL];
+        vlcur = rp->CurVR;
+        vlnext = rp->NextVR;
+        vrcur = rp->CurVL;
+        vrnext = rp->NextVL;
 
         interp_start = &rp->SlopeR.Interp;
         interp_end = &rp->SlopeL.Interp;
@@ -790,18 +791,18 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
         else
         {
             l_filledge = (rp->SlopeR.Negative || !rp->SlopeR.XMajor)
-                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
             r_filledge = (!rp->SlopeL.Negative && rp->SlopeL.XMajor)
                 || (!(rp->SlopeL.Negative && rp->SlopeL.XMajor) && rp->SlopeR.Increment==0)
-                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
         }
     }
     else
     {
-        vlcur = polygon->Vertices[rp->CurVL];
-        vlnext = polygon->Vertices[rp->NextVL];
-        vrcur = polygon->Vertices[rp->CurVR];
-        vrnext = polygon->Vertices[rp->NextVR];
+        vlcur = rp->CurVL;
+        vlnext = rp->NextVL;
+        vrcur = rp->CurVR;
+        vrnext = rp->NextVR;
 
         interp_start = &rp->SlopeL.Interp;
         interp_end = &rp->SlopeR.Interp;
@@ -818,10 +819,10 @@ void SoftRenderer::RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon*
         else
         {
             l_filledge = ((rp->SlopeL.Negative || !rp->SlopeL.XMajor)
-                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]))
+                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]))
                 || (rp->SlopeL.Increment == rp->SlopeR.Increment) && (xstart+l_edgelen == xend+1);
             r_filledge = (!rp->SlopeR.Negative && rp->SlopeR.XMajor) || (rp->SlopeR.Increment==0)
-                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
         }
     }
 
@@ -955,18 +956,18 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
 
     if (polygon->YTop != polygon->YBottom)
     {
-        if (y >= polygon->Vertices[rp->NextVL]->FinalPosition[1] && rp->CurVL != polygon->VBottom)
+        if (y >= rp->Vertices.FinalPosition[rp->NextVL][1] && rp->CurVL != polygon->VBottom)
         {
             SetupPolygonLeftEdge(rp, y);
         }
 
-        if (y >= polygon->Vertices[rp->NextVR]->FinalPosition[1] && rp->CurVR != polygon->VBottom)
+        if (y >= rp->Vertices.FinalPosition[rp->NextVR][1] && rp->CurVR != polygon->VBottom)
         {
             SetupPolygonRightEdge(rp, y);
         }
     }
 
-    Vertex *vlcur, *vlnext, *vrcur, *vrnext;
+    u32 vlcur, vlnext, vrcur, vrnext;
     s32 xstart, xend;
     bool l_filledge, r_filledge;
     s32 l_edgelen, r_edgelen;
@@ -995,10 +996,10 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
 
     if (xstart > xend)
     {
-        vlcur = polygon->Vertices[rp->CurVR];
-        vlnext = polygon->Vertices[rp->NextVR];
-        vrcur = polygon->Vertices[rp->CurVL];
-        vrnext = polygon->Vertices[rp->NextVL];
+        vlcur = rp->CurVR;
+        vlnext = rp->NextVR;
+        vrcur = rp->CurVL;
+        vrnext = rp->NextVL;
 
         interp_start = &rp->SlopeR.Interp;
         interp_end = &rp->SlopeL.Interp;
@@ -1025,18 +1026,18 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         else
         {
             l_filledge = (rp->SlopeR.Negative || !rp->SlopeR.XMajor)
-                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
             r_filledge = (!rp->SlopeL.Negative && rp->SlopeL.XMajor)
                 || (!(rp->SlopeL.Negative && rp->SlopeL.XMajor) && rp->SlopeR.Increment==0)
-                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
         }
     }
     else
     {
-        vlcur = polygon->Vertices[rp->CurVL];
-        vlnext = polygon->Vertices[rp->NextVL];
-        vrcur = polygon->Vertices[rp->CurVR];
-        vrnext = polygon->Vertices[rp->NextVR];
+        vlcur = rp->CurVL;
+        vlnext = rp->NextVL;
+        vrcur = rp->CurVR;
+        vrnext = rp->NextVR;
 
         interp_start = &rp->SlopeL.Interp;
         interp_end = &rp->SlopeR.Interp;
@@ -1060,28 +1061,28 @@ void SoftRenderer::RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s3
         else
         {
             l_filledge = ((rp->SlopeL.Negative || !rp->SlopeL.XMajor)
-                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]))
+                || (y == polygon->YBottom-1) && rp->SlopeL.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]))
                 || (rp->SlopeL.Increment == rp->SlopeR.Increment) && (xstart+l_edgelen == xend+1);
             r_filledge = (!rp->SlopeR.Negative && rp->SlopeR.XMajor) || (rp->SlopeR.Increment==0)
-                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (vlnext->FinalPosition[0] != vrnext->FinalPosition[0]);
+                || (y == polygon->YBottom-1) && rp->SlopeR.XMajor && (rp->Vertices.FinalPosition[vlnext][0] != rp->Vertices.FinalPosition[vrnext][0]);
         }
     }
 
     // interpolate attributes along Y
 
-    s32 rl = interp_start->Interpolate(vlcur->FinalColor[0], vlnext->FinalColor[0]);
-    s32 gl = interp_start->Interpolate(vlcur->FinalColor[1], vlnext->FinalColor[1]);
-    s32 bl = interp_start->Interpolate(vlcur->FinalColor[2], vlnext->FinalColor[2]);
+    s32 rl = interp_start->Interpolate(rp->Vertices.FinalColor[vlcur][0], rp->Vertices.FinalColor[vlnext][0]);
+    s32 gl = interp_start->Interpolate(rp->Vertices.FinalColor[vlcur][1], rp->Vertices.FinalColor[vlnext][1]);
+    s32 bl = interp_start->Interpolate(rp->Vertices.FinalColor[vlcur][2], rp->Vertices.FinalColor[vlnext][2]);
 
-    s32 sl = interp_start->Interpolate(vlcur->TexCoords[0], vlnext->TexCoords[0]);
-    s32 tl = interp_start->Interpolate(vlcur->TexCoords[1], vlnext->TexCoords[1]);
+    s32 sl = interp_start->Interpolate(rp->Vertices.TexCoords[vlcur][0], rp->Vertices.TexCoords[vlnext][0]);
+    s32 tl = interp_start->Interpolate(rp->Vertices.TexCoords[vlcur][1], rp->Vertices.TexCoords[vlnext][1]);
 
-    s32 rr = interp_end->Interpolate(vrcur->FinalColor[0], vrnext->FinalColor[0]);
-    s32 gr = interp_end->Interpolate(vrcur->FinalColor[1], vrnext->FinalColor[1]);
-    s32 br = interp_end->Interpolate(vrcur->FinalColor[2], vrnext->FinalColor[2]);
+    s32 rr = interp_end->Interpolate(rp->Vertices.FinalColor[vrcur][0], rp->Vertices.FinalColor[vrnext][0]);
+    s32 gr = interp_end->Interpolate(rp->Vertices.FinalColor[vrcur][1], rp->Vertices.FinalColor[vrnext][1]);
+    s32 br = interp_end->Interpolate(rp->Vertices.FinalColor[vrcur][2], rp->Vertices.FinalColor[vrnext][2]);
 
-    s32 sr = interp_end->Interpolate(vrcur->TexCoords[0], vrnext->TexCoords[0]);
-    s32 tr = interp_end->Interpolate(vrcur->TexCoords[1], vrnext->TexCoords[1]);
+    s32 sr = interp_end->Interpolate(rp->Vertices.TexCoords[vrcur][0], rp->Vertices.TexCoords[vrnext][0]);
+    s32 tr = interp_end->Interpolate(rp->Vertices.TexCoords[vrcur][1], rp->Vertices.TexCoords[vrnext][1]);
 
     // in wireframe mode, there are special rules for equal Z (TODO)
 
@@ -1706,13 +1707,16 @@ void SoftRenderer::ClearBuffers(const GPU& gpu)
     }
 }
 
-void SoftRenderer::RenderPolygons(const GPU& gpu, bool threaded, Polygon** polygons, int npolys)
+void SoftRenderer::RenderPolygons(const GPU& gpu, bool threaded)
 {
+    const GPU3D& gpu3d = gpu.GPU3D;
+
     int j = 0;
-    for (int i = 0; i < npolys; i++)
+    for (u32 i = 0; i < gpu3d.RenderNumPolygons; i++)
     {
-        if (polygons[i]->Degenerate) continue;
-        SetupPolygon(&PolygonList[j++], polygons[i]);
+        Polygon* polygon = gpu3d.RenderPolygonRAM[i];
+        if (polygon->Degenerate) continue;
+        SetupPolygon(&PolygonList[j++], polygon, gpu3d.GetRenderPolygonVertices(i));
     }
 
     RenderScanline(gpu, 0, j);
@@ -1758,7 +1762,7 @@ void SoftRenderer::RenderFrame(GPU& gpu)
     else if (!FrameIdentical)
     {
         ClearBuffers(gpu);
-        RenderPolygons(gpu, false, &gpu.GPU3D.RenderPolygonRAM[0], gpu.GPU3D.RenderNumPolygons);
+        RenderPolygons(gpu, false);
     }
 }
 
@@ -1790,7 +1794,7 @@ void SoftRenderer::RenderThreadFunc(GPU& gpu)
         else
         {
             ClearBuffers(gpu);
-            RenderPolygons(gpu, true, &gpu.GPU3D.RenderPolygonRAM[0], gpu.GPU3D.RenderNumPolygons);
+            RenderPolygons(gpu, true);
         }
 
         // Tell the main thread that we're done rendering
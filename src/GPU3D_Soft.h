@@ -40,6 +40,7 @@ public:
     void RenderFrame(GPU& gpu) override;
     void RestartFrame(GPU& gpu) override;
     u32* GetLine(int line) override;
+    bool IsFrameIdentical() const override { return FrameIdentical; }
 
     void SetupRenderThread(GPU& gpu);
     void EnableRenderThread();
@@ -445,6 +446,7 @@ private:
     struct RendererPolygon
     {
         Polygon* PolyData;
+        RenderPolygonVertices Vertices;
 
         Slope<0> SlopeL;
         Slope<1> SlopeR;
@@ -460,14 +462,14 @@ private:
     void PlotTranslucentPixel(const GPU3D& gpu3d, u32 pixeladdr, u32 color, u32 z, u32 polyattr, u32 shadow);
     void SetupPolygonLeftEdge(RendererPolygon* rp, s32 y) const;
     void SetupPolygonRightEdge(RendererPolygon* rp, s32 y) const;
-    void SetupPolygon(RendererPolygon* rp, Polygon* polygon) const;
+    void SetupPolygon(RendererPolygon* rp, Polygon* polygon, const RenderPolygonVertices& vertices) const;
     void RenderShadowMaskScanline(const GPU3D& gpu3d, RendererPolygon* rp, s32 y);
     void RenderPolygonScanline(const GPU& gpu, RendererPolygon* rp, s32 y);
     void RenderScanline(const GPU& gpu, s32 y, int npolys);
     u32 CalculateFogDensity(const GPU3D& gpu3d, u32 pixeladdr) const;
     void ScanlineFinalPass(const GPU3D& gpu3d, s32 y);
     void ClearBuffers(const GPU& gpu);
-    void RenderPolygons(const GPU& gpu, bool threaded, Polygon** polygons, int npolys);
+    void RenderPolygons(const GPU& gpu, bool threaded);
 
     void RenderThreadFunc(GPU& gpu);
 
@@ -500,7 +502,7 @@ private:
 
     bool Enabled;
 
-    bool FrameIdentical;
+    bool FrameIdentical = false;
 
     // threading
 
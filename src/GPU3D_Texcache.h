@@ -3,8 +3,10 @@
 
 #include "types.h"
 #include "GPU.h"
+#include "Platform.h"
 
 #include <assert.h>
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -40,6 +42,18 @@ void ConvertAXIYTexture(u32 width, u32 height, u32* output, u8* texData, u16* pa
 template <int outputFmt, int colorBits>
 void ConvertNColorsTexture(u32 width, u32 height, u32* output, u8* texData, u16* palData, bool color0Transparent);
 
+struct TexcacheStats
+{
+    u64 Hits;           // lookups served by an existing entry
+    u64 Misses;         // lookups which needed a new entry
+    u64 SharedHits;     // misses whose texture data was already decoded for another entry
+    u64 Evictions;      // entries dropped to stay within the memory budget
+    u64 Invalidations;  // entries dropped because their VRAM contents changed
+    u64 MemoryUsed;     // size of all allocated texture arrays, in bytes
+    u32 NumEntries;
+    u32 NumTextures;
+};
+
 template <typename TexLoaderT, typename TexHandleT>
 class Texcache
 {
@@ -48,8 +62,25 @@ public:
         : TexLoader(texloader) // probably better if this would be a move constructor???
     {}
 
+    // The budget is a soft limit: once it's reached, new textures reuse
+    // the layers of the least recently used ones of the same size, but
+    // textures used by the current frame are never evicted.
+    void SetMemoryBudget(u64 bytes)
+    {
+        MemoryBudget = bytes;
+    }
+
+    const TexcacheStats& GetStats()
+    {
+        Stats.NumEntries = Cache.size();
+        Stats.NumTextures = Contents.size();
+        return Stats;
+    }
+
     bool Update(GPU& gpu)
     {
+        CurFrame++;
+
         auto textureDirty = gpu.VRAMDirty_Texture.DeriveState(gpu.VRAMMap_Texture, gpu);
         auto texPalDirty = gpu.VRAMDirty_TexPal.DeriveState(gpu.VRAMMap_TexPal, gpu);
 
@@ -105,11 +136,10 @@ public:
                 it++;
                 continue;
             invalidate:
-                FreeTextures[entry.WidthLog2][entry.HeightLog2].push_back(entry.Texture);
-
                 //printf("invalidating texture %d\n", entry.ImageDescriptor);
 
-                it = Cache.erase(it);
+                Stats.Invalidations++;
+                it = RemoveEntry(it);
             }
 
             return true;
@@ -139,12 +169,23 @@ public:
 
         if (it != Cache.end())
         {
-            textureHandle = it->second.Texture.TextureID;
-            layer = it->second.Texture.Layer;
-            helper = &it->second.LastVariant;
+            TexCacheEntry& entry = it->second;
+            if (entry.LastUsedFrame != CurFrame)
+            {
+                auto& lru = LRU[entry.WidthLog2][entry.HeightLog2];
+                lru.splice(lru.begin(), lru, entry.LRUPos);
+                entry.LastUsedFrame = CurFrame;
+            }
+
+            Stats.Hits++;
+            textureHandle = entry.Texture.TextureID;
+            layer = entry.Texture.Layer;
+            helper = &entry.LastVariant;
             return;
         }
 
+        Stats.Misses++;
+
         u32 widthLog2 = (texParam >> 20) & 0x7;
         u32 heightLog2 = (texParam >> 23) & 0x7;
         u32 width = 8 << widthLog2;
@@ -152,7 +193,7 @@ public:
 
         u32 addr = (texParam & 0xFFFF) * 8;
 
-        TexCacheEntry entry = {0};
+        TexCacheEntry entry {};
 
         entry.TextureRAMStart[0] = addr;
         entry.WidthLog2 = widthLog2;
@@ -162,26 +203,18 @@ public:
         if (fmt == 7)
         {
             entry.TextureRAMSize[0] = width*height*2;
-
-            ConvertBitmapTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, &gpu.VRAMFlat_Texture[addr]);
         }
         else if (fmt == 5)
         {
-            u8* texData = &gpu.VRAMFlat_Texture[addr];
             u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
             if (addr >= 0x40000)
                 slot1addr += 0x10000;
-            u8* texAuxData = &gpu.VRAMFlat_Texture[slot1addr];
-
-            u16* palData = (u16*)(gpu.VRAMFlat_TexPal + palBase*16);
 
             entry.TextureRAMSize[0] = width*height/16*4;
             entry.TextureRAMStart[1] = slot1addr;
             entry.TextureRAMSize[1] = width*height/16*2;
             entry.TexPalStart = palBase*16;
             entry.TexPalSize = 0x10000;
-
-            ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, texData, texAuxData, palData);
         }
         else
         {
@@ -197,28 +230,11 @@ public:
 
             palAddr &= 0x1FFFF;
 
-            /*printf("creating texture | fmt: %d | %dx%d | %08x | %08x\n", fmt, width, height, addr, palAddr);
-            svcSleepThread(1000*1000);*/
-
             entry.TextureRAMSize[0] = texSize;
             entry.TexPalStart = palAddr;
             entry.TexPalSize = numPalEntries*2;
 
-            u8* texData = &gpu.VRAMFlat_Texture[addr];
-            u16* palData = (u16*)(gpu.VRAMFlat_TexPal + palAddr);
-
             //assert(entry.TexPalStart+entry.TexPalSize <= 128*1024*1024);
-
-            bool color0Transparent = texParam & (1 << 29);
-
-            switch (fmt)
-            {
-            case 1: ConvertAXIYTexture<outputFmt_RGB6A5, 3, 5>(width, height, DecodingBuffer, texData, palData); break;
-            case 6: ConvertAXIYTexture<outputFmt_RGB6A5, 5, 3>(width, height, DecodingBuffer, texData, palData); break;
-            case 2: ConvertNColorsTexture<outputFmt_RGB6A5, 2>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
-            case 3: ConvertNColorsTexture<outputFmt_RGB6A5, 4>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
-            case 4: ConvertNColorsTexture<outputFmt_RGB6A5, 8>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
-            }
         }
 
         for (int i = 0; i < 2; i++)
@@ -229,41 +245,56 @@ public:
         if (entry.TexPalSize)
             entry.TexPalHash = XXH3_64bits(&gpu.VRAMFlat_TexPal[entry.TexPalStart], entry.TexPalSize);
 
-        auto& texArrays = TexArrays[widthLog2][heightLog2];
-        auto& freeTextures = FreeTextures[widthLog2][heightLog2];
-
-        if (freeTextures.size() == 0)
+        // the same texture data is often found at several addresses,
+        // or used with different sampling parameters, so entries with
+        // the same contents share the decoded texture
+        u64 contentParam = texParam & 0x1FF00000; // size and format
+        if (fmt >= 2 && fmt <= 4)
+            contentParam |= texParam & (1 << 29);
+        u64 contentDesc[4] = {contentParam, entry.TextureHash[0], entry.TextureHash[1], entry.TexPalHash};
+        entry.ContentHash = XXH3_64bits(contentDesc, sizeof(contentDesc));
+
+        auto content = Contents.find(entry.ContentHash);
+        if (content != Contents.end())
         {
-            texArrays.resize(texArrays.size()+1);
-            TexHandleT& array = texArrays[texArrays.size()-1];
+            content->second.RefCount++;
+            Stats.SharedHits++;
+        }
+        else
+        {
+            DecodeTexture(gpu, texParam, width, height, entry);
 
-            u32 layers = std::min<u32>((8*1024*1024) / (width*height*4), 64);
+            TexArrayEntry storagePlace = AllocateLayer(widthLog2, heightLog2);
 
-            // allocate new array texture
-            //printf("allocating new layer set for %d %d %d %d\n", width, height, texArrays.size()-1, array.ImageDescriptor);
-            array = TexLoader.GenerateTexture(width, height, layers);
+            TexLoader.UploadTexture(storagePlace.TextureID, width, height, storagePlace.Layer, DecodingBuffer);
+            //printf("using storage place %d %d | %d %d (%d)\n", width, height, storagePlace.TexArrayIdx, storagePlace.LayerIdx, array.ImageDescriptor);
 
-            for (u32 i = 0; i < layers; i++)
-            {
-                freeTextures.push_back(TexArrayEntry{array, i});
-            }
+            content = Contents.emplace(entry.ContentHash, TexContentEntry{storagePlace, 1}).first;
         }
 
-        TexArrayEntry storagePlace = freeTextures[freeTextures.size()-1];
-        freeTextures.pop_back();
-
-        entry.Texture = storagePlace;
+        entry.Texture = content->second.Texture;
+        entry.LastUsedFrame = CurFrame;
 
-        TexLoader.UploadTexture(storagePlace.TextureID, width, height, storagePlace.Layer, DecodingBuffer);
-        //printf("using storage place %d %d | %d %d (%d)\n", width, height, storagePlace.TexArrayIdx, storagePlace.LayerIdx, array.ImageDescriptor);
+        auto& lru = LRU[widthLog2][heightLog2];
+        lru.push_front(key);
+        entry.LRUPos = lru.begin();
 
-        textureHandle = storagePlace.TextureID;
-        layer = storagePlace.Layer;
+        textureHandle = entry.Texture.TextureID;
+        layer = entry.Texture.Layer;
         helper = &Cache.emplace(std::make_pair(key, entry)).first->second.LastVariant;
     }
 
     void Reset()
     {
+        if (Stats.Hits || Stats.Misses)
+        {
+            Platform::Log(Platform::LogLevel::Debug,
+                "Texcache: %llu hits, %llu misses (%llu shared), %llu evictions, %llu invalidations, %llu KB allocated\n",
+                (unsigned long long)Stats.Hits, (unsigned long long)Stats.Misses, (unsigned long long)Stats.SharedHits,
+                (unsigned long long)Stats.Evictions, (unsigned long long)Stats.Invalidations,
+                (unsigned long long)(Stats.MemoryUsed / 1024));
+        }
+
         for (u32 i = 0; i < 8; i++)
         {
             for (u32 j = 0; j < 8; j++)
@@ -272,9 +303,12 @@ public:
                     TexLoader.DeleteTexture(TexArrays[i][j][k]);
                 TexArrays[i][j].clear();
                 FreeTextures[i][j].clear();
+                LRU[i][j].clear();
             }
         }
         Cache.clear();
+        Contents.clear();
+        Stats = {};
     }
 private:
     struct TexArrayEntry
@@ -286,6 +320,7 @@ private:
     struct TexCacheEntry
     {
         u32 LastVariant; // very cheap way to make variant lookup faster
+        u32 LastUsedFrame;
 
         u32 TextureRAMStart[2], TextureRAMSize[2];
         u32 TexPalStart, TexPalSize;
@@ -294,13 +329,136 @@ private:
 
         u64 TextureHash[2];
         u64 TexPalHash;
+        u64 ContentHash;
+
+        std::list<u64>::iterator LRUPos;
+    };
+
+    struct TexContentEntry
+    {
+        TexArrayEntry Texture;
+        u32 RefCount;
     };
+
+    using CacheIterator = typename std::unordered_map<u64, TexCacheEntry>::iterator;
+
+    CacheIterator RemoveEntry(CacheIterator it)
+    {
+        TexCacheEntry& entry = it->second;
+
+        LRU[entry.WidthLog2][entry.HeightLog2].erase(entry.LRUPos);
+
+        auto content = Contents.find(entry.ContentHash);
+        if (--content->second.RefCount == 0)
+        {
+            FreeTextures[entry.WidthLog2][entry.HeightLog2].push_back(content->second.Texture);
+            Contents.erase(content);
+        }
+
+        return Cache.erase(it);
+    }
+
+    // evicts the least recently used entries of the given size until
+    // a layer is freed. Fails if the remaining ones are used by the current frame.
+    bool EvictLRU(u32 widthLog2, u32 heightLog2)
+    {
+        auto& lru = LRU[widthLog2][heightLog2];
+        auto& freeTextures = FreeTextures[widthLog2][heightLog2];
+
+        while (freeTextures.size() == 0 && lru.size() > 0)
+        {
+            auto it = Cache.find(lru.back());
+            if (it->second.LastUsedFrame == CurFrame)
+                return false;
+
+            Stats.Evictions++;
+            RemoveEntry(it);
+        }
+
+        return freeTextures.size() > 0;
+    }
+
+    TexArrayEntry AllocateLayer(u32 widthLog2, u32 heightLog2)
+    {
+        u32 width = 8 << widthLog2;
+        u32 height = 8 << heightLog2;
+
+        auto& texArrays = TexArrays[widthLog2][heightLog2];
+        auto& freeTextures = FreeTextures[widthLog2][heightLog2];
+
+        u32 layers = std::min<u32>((8*1024*1024) / (width*height*4), 64);
+        u64 arraySize = (u64)width*height*4*layers;
+
+        if (freeTextures.size() == 0
+            && (Stats.MemoryUsed + arraySize <= MemoryBudget || !EvictLRU(widthLog2, heightLog2)))
+        {
+            texArrays.resize(texArrays.size()+1);
+            TexHandleT& array = texArrays[texArrays.size()-1];
+
+            // allocate new array texture
+            //printf("allocating new layer set for %d %d %d %d\n", width, height, texArrays.size()-1, array.ImageDescriptor);
+            array = TexLoader.GenerateTexture(width, height, layers);
+            Stats.MemoryUsed += arraySize;
+
+            for (u32 i = 0; i < layers; i++)
+            {
+                freeTextures.push_back(TexArrayEntry{array, i});
+            }
+        }
+
+        TexArrayEntry storagePlace = freeTextures[freeTextures.size()-1];
+        freeTextures.pop_back();
+        return storagePlace;
+    }
+
+    void DecodeTexture(GPU& gpu, u32 texParam, u32 width, u32 height, const TexCacheEntry& entry)
+    {
+        u32 fmt = (texParam >> 26) & 0x7;
+        u8* texData = &gpu.VRAMFlat_Texture[entry.TextureRAMStart[0]];
+        u16* palData = (u16*)(gpu.VRAMFlat_TexPal + entry.TexPalStart);
+
+        if (fmt == 7)
+        {
+            ConvertBitmapTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, texData);
+        }
+        else if (fmt == 5)
+        {
+            u8* texAuxData = &gpu.VRAMFlat_Texture[entry.TextureRAMStart[1]];
+
+            ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, texData, texAuxData, palData);
+        }
+        else
+        {
+            /*printf("creating texture | fmt: %d | %dx%d | %08x | %08x\n", fmt, width, height, entry.TextureRAMStart[0], entry.TexPalStart);
+            svcSleepThread(1000*1000);*/
+
+            bool color0Transparent = texParam & (1 << 29);
+
+            switch (fmt)
+            {
+            case 1: ConvertAXIYTexture<outputFmt_RGB6A5, 3, 5>(width, height, DecodingBuffer, texData, palData); break;
+            case 6: ConvertAXIYTexture<outputFmt_RGB6A5, 5, 3>(width, height, DecodingBuffer, texData, palData); break;
+            case 2: ConvertNColorsTexture<outputFmt_RGB6A5, 2>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
+            case 3: ConvertNColorsTexture<outputFmt_RGB6A5, 4>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
+            case 4: ConvertNColorsTexture<outputFmt_RGB6A5, 8>(width, height, DecodingBuffer, texData, palData, color0Transparent); break;
+            }
+        }
+    }
+
     std::unordered_map<u64, TexCacheEntry> Cache;
+    // decoded textures, by hash of their contents
+    std::unordered_map<u64, TexContentEntry> Contents;
 
     TexLoaderT TexLoader;
 
     std::vector<TexArrayEntry> FreeTextures[8][8];
     std::vector<TexHandleT> TexArrays[8][8];
+    // keys of the entries of each size, most recently used first
+    std::list<u64> LRU[8][8];
+
+    u32 CurFrame = 0;
+    u64 MemoryBudget = 256*1024*1024;
+    TexcacheStats Stats {};
 
     u32 DecodingBuffer[1024*1024];
 };
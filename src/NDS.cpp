@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <algorithm>
 #include "NDS.h"
 #include "ARM.h"
 #include "NDSCart.h"
@@ -74,8 +75,6 @@ const s32 kIterationCycleMargin = 8;
 //
 // timings for GBA slot and wifi are set up at runtime
 
-NDS* NDS::Current = nullptr;
-
 NDS::NDS() noexcept :
     NDS(
         NDSArgs {
@@ -140,6 +139,50 @@ NDS::~NDS() noexcept
 }
 
 
+template <int size>
+static u8 GetMemTimingSlot(u8 (&table)[NDS::MemTimingSlots][size], u32 (&regions)[NDS::MemTimingSlots], int& num,
+                           const u8* index, u32 indexlen, u32 rangestart, u32 rangeend, const u8* timings, u32 region)
+{
+    for (int i = 0; i < num; i++)
+    {
+        if (regions[i] == region && !memcmp(table[i], timings, size))
+            return i;
+    }
+
+    int slot = num;
+    if (num < NDS::MemTimingSlots)
+    {
+        num++;
+    }
+    else
+    {
+        // table is full, reuse a slot that is no longer referenced,
+        // not counting the range we're about to overwrite
+        u32 refs[NDS::MemTimingSlots] {};
+        for (u32 i = 0; i < indexlen; i++)
+        {
+            if (i < rangestart || i >= rangeend)
+                refs[index[i]]++;
+        }
+
+        slot = 0;
+        for (int i = 1; i < NDS::MemTimingSlots; i++)
+        {
+            if (refs[i] < refs[slot]) slot = i;
+        }
+
+        // every slot is still needed, there are more distinct timings than
+        // we can keep track of. Settle for the least used slot, whose pages
+        // will get the new timings too
+        if (refs[slot] != 0)
+            Log(LogLevel::Error, "memory timing table full, overwriting slot %d used by %u pages\n", slot, refs[slot]);
+    }
+
+    memcpy(table[slot], timings, size);
+    regions[slot] = region;
+    return slot;
+}
+
 void NDS::SetARM9RegionTimings(u32 addrstart, u32 addrend, u32 region, int buswidth, int nonseq, int seq)
 {
     addrstart >>= 2;
@@ -162,22 +205,23 @@ void NDS::SetARM9RegionTimings(u32 addrstart, u32 addrend, u32 region, int buswi
     // nonseq accesses on the CPU get a 3-cycle penalty for all regions except main RAM
     cpuN = (region == Mem9_MainRAM) ? 0 : 3;
 
-    for (u32 i = addrstart; i < addrend; i++)
-    {
-        // CPU timings
-        ARM9MemTimings[i][0] = N16 + cpuN;
-        ARM9MemTimings[i][1] = S16;
-        ARM9MemTimings[i][2] = N32 + cpuN;
-        ARM9MemTimings[i][3] = S32;
+    u8 timings[8];
 
-        // DMA timings
-        ARM9MemTimings[i][4] = N16;
-        ARM9MemTimings[i][5] = S16;
-        ARM9MemTimings[i][6] = N32;
-        ARM9MemTimings[i][7] = S32;
+    // CPU timings
+    timings[0] = N16 + cpuN;
+    timings[1] = S16;
+    timings[2] = N32 + cpuN;
+    timings[3] = S32;
 
-        ARM9Regions[i] = region;
-    }
+    // DMA timings
+    timings[4] = N16;
+    timings[5] = S16;
+    timings[6] = N32;
+    timings[7] = S32;
+
+    u8 slot = GetMemTimingSlot(ARM9MemTimingTable, ARM9RegionTable, NumARM9MemTimings,
+                               ARM9MemTimingIndex, sizeof(ARM9MemTimingIndex), addrstart, addrend, timings, region);
+    memset(&ARM9MemTimingIndex[addrstart], slot, addrend - addrstart);
 
     ARM9.UpdateRegionTimings(addrstart<<2, addrend<<2);
 }
@@ -201,16 +245,16 @@ void NDS::SetARM7RegionTimings(u32 addrstart, u32 addrend, u32 region, int buswi
         S32 = S16;
     }
 
-    for (u32 i = addrstart; i < addrend; i++)
-    {
-        // CPU and DMA timings are the same
-        ARM7MemTimings[i][0] = N16;
-        ARM7MemTimings[i][1] = S16;
-        ARM7MemTimings[i][2] = N32;
-        ARM7MemTimings[i][3] = S32;
+    // CPU and DMA timings are the same
+    u8 timings[4];
+    timings[0] = N16;
+    timings[1] = S16;
+    timings[2] = N32;
+    timings[3] = S32;
 
-        ARM7Regions[i] = region;
-    }
+    u8 slot = GetMemTimingSlot(ARM7MemTimingTable, ARM7RegionTable, NumARM7MemTimings,
+                               ARM7MemTimingIndex, sizeof(ARM7MemTimingIndex), addrstart, addrend, timings, region);
+    memset(&ARM7MemTimingIndex[addrstart], slot, addrend - addrstart);
 }
 
 #ifdef JIT_ENABLED
@@ -342,10 +386,15 @@ void NDS::SetupDirectBoot()
 
     // CHECKME: firmware seems to load this in 0x200 byte chunks
 
-    for (u32 i = arm9start; i < header.ARM9Size; i+=4)
+    // the ARM9 binary is read through the cart, as it may have been patched
+    for (u32 i = arm9start; i < header.ARM9Size; i+=0x200)
     {
-        u32 tmp = *(u32*)&cartrom[header.ARM9ROMOffset+i];
-        NDS::ARM9Write32(header.ARM9RAMAddress+i, tmp);
+        u32 tmp[0x200/4];
+        u32 len = std::min(header.ARM9Size - i + 3, 0x200u) & ~3;
+        NDSCartSlot.GetCart()->CopyROM(header.ARM9ROMOffset+i, len, (u8*)tmp);
+
+        for (u32 j = 0; j < len; j+=4)
+            NDS::ARM9Write32(header.ARM9RAMAddress+i+j, tmp[j>>2]);
     }
 
     for (u32 i = 0; i < header.ARM7Size; i+=4)
@@ -1703,6 +1752,23 @@ void NDS::StopDMAs(u32 cpu, u32 mode)
     DMAs[cpu+3].StopIfNeeded(mode);
 }
 
+// does the work of a series of DMA requests at once, see DMA::BulkTransferToRAM
+// only possible if a single DMA would respond to them
+bool NDS::BulkTransferDMAs(u32 cpu, u32 mode, u32 srcaddr, const u32* data, u32 num)
+{
+    cpu <<= 2;
+    DMA* dma = nullptr;
+    for (int i = 0; i < 4; i++)
+    {
+        if (!DMAs[cpu+i].IsInMode(mode)) continue;
+        if (dma) return false;
+        dma = &DMAs[cpu+i];
+    }
+
+    if (!dma) return false;
+    return dma->BulkTransferToRAM(srcaddr, data, num);
+}
+
 
 
 void NDS::DivDone(u32 param)
@@ -239,10 +239,25 @@ public: // TODO: Encapsulate the rest of these members
     int CurCPU;
 
     SchedEvent SchedList[Event_MAX] {};
-    u8 ARM9MemTimings[0x40000][8];
-    u32 ARM9Regions[0x40000];
-    u8 ARM7MemTimings[0x20000][4];
-    u32 ARM7Regions[0x20000];
+
+    // Bus timings and regions are looked up per 16K page on the ARM9 and
+    // per 32K page on the ARM7, but only a handful of distinct timing sets
+    // exist at any given time. Each page holds an index into a small table
+    // of them, which keeps the whole thing small enough to stay in cache.
+    static constexpr int MemTimingSlots = 256;
+    u8 ARM9MemTimingIndex[0x40000];
+    u8 ARM9MemTimingTable[MemTimingSlots][8];
+    u32 ARM9RegionTable[MemTimingSlots];
+    u8 ARM7MemTimingIndex[0x20000];
+    u8 ARM7MemTimingTable[MemTimingSlots][4];
+    u32 ARM7RegionTable[MemTimingSlots];
+    int NumARM9MemTimings = 0;
+    int NumARM7MemTimings = 0;
+
+    const u8* GetARM9MemTimings(u32 page) const { return ARM9MemTimingTable[ARM9MemTimingIndex[page]]; }
+    u32 GetARM9Region(u32 page) const { return ARM9RegionTable[ARM9MemTimingIndex[page]]; }
+    const u8* GetARM7MemTimings(u32 page) const { return ARM7MemTimingTable[ARM7MemTimingIndex[page]]; }
+    u32 GetARM7Region(u32 page) const { return ARM7RegionTable[ARM7MemTimingIndex[page]]; }
 
     u32 NumFrames;
     u32 NumLagFrames;
@@ -434,6 +449,7 @@ public: // TODO: Encapsulate the rest of these members
     virtual bool DMAsRunning(u32 cpu) const;
     virtual void CheckDMAs(u32 cpu, u32 mode);
     virtual void StopDMAs(u32 cpu, u32 mode);
+    virtual bool BulkTransferDMAs(u32 cpu, u32 mode, u32 srcaddr, const u32* data, u32 num);
 
     void RunTimers(u32 cpu);
 
@@ -536,8 +552,6 @@ public:
     NDS& operator=(const NDS&) = delete;
     NDS(NDS&&) = delete;
     NDS& operator=(NDS&&) = delete;
-    // The frontend should set and unset this manually after creating and destroying the NDS object.
-    [[deprecated("Temporary workaround until JIT code generation is revised to accommodate multiple NDS objects.")]] static NDS* Current;
 protected:
     explicit NDS(NDSArgs&& args, int type, void* userdata) noexcept;
     virtual void DoSavestateExtra(Savestate* file) {}
@@ -17,6 +17,7 @@
 */
 
 #include <string.h>
+#include <algorithm>
 #include "NDS.h"
 #include "DSi.h"
 #include "NDSCart.h"
@@ -178,7 +179,7 @@ CartCommon::CartCommon(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROML
 {
 }
 
-CartCommon::CartCommon(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, melonDS::NDSCart::CartType type, void* userdata) :
+CartCommon::CartCommon(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, melonDS::NDSCart::CartType type, void* userdata) :
     ROM(std::move(rom)),
     ROMLength(len),
     ChipID(chipid),
@@ -361,7 +362,64 @@ void CartCommon::ReadROM(u32 addr, u32 len, u8* data, u32 offset) const
     if ((addr+len) > ROMLength)
         len = ROMLength - addr;
 
-    memcpy(data+offset, ROM.get()+addr, len);
+    CopyROM(addr, len, data+offset);
+}
+
+void CartCommon::CopyROM(u32 addr, u32 len, u8* out) const
+{
+    if (ROMChunks)
+        ROMChunks->Read(addr, len, out);
+    else
+        memcpy(out, ROM.get()+addr, len);
+
+    for (const ROMPatch& patch : Patches)
+    {
+        u32 start = std::max(addr, patch.Addr);
+        u32 end = std::min(addr+len, patch.Addr+patch.Length);
+        if (start < end)
+            memcpy(&out[start-addr], &patch.Data[start-patch.Addr], end-start);
+    }
+}
+
+u8* CartCommon::PatchROM(u32 addr, u32 len)
+{
+    u32 start = addr;
+    u32 end = addr + len;
+
+    for (ROMPatch& patch : Patches)
+    {
+        if (start >= patch.Addr && end <= patch.Addr+patch.Length)
+            return &patch.Data[start-patch.Addr];
+    }
+
+    // grow the range to cover any patches it overlaps, so they can be merged
+    bool grown;
+    do
+    {
+        grown = false;
+        for (const ROMPatch& patch : Patches)
+        {
+            if (patch.Addr < end && start < patch.Addr+patch.Length &&
+                (patch.Addr < start || patch.Addr+patch.Length > end))
+            {
+                start = std::min(start, patch.Addr);
+                end = std::max(end, patch.Addr+patch.Length);
+                grown = true;
+            }
+        }
+    }
+    while (grown);
+
+    ROMPatch merged {start, end-start, std::make_unique<u8[]>(end-start)};
+    CopyROM(start, end-start, merged.Data.get());
+
+    Patches.erase(std::remove_if(Patches.begin(), Patches.end(), [=](const ROMPatch& patch)
+    {
+        return patch.Addr >= start && patch.Addr+patch.Length <= end;
+    }), Patches.end());
+    Patches.push_back(std::move(merged));
+
+    return &Patches.back().Data[addr-start];
 }
 
 const NDSBanner* CartCommon::Banner() const
@@ -381,7 +439,7 @@ CartRetail::CartRetail(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROML
 {
 }
 
-CartRetail::CartRetail(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, melonDS::NDSCart::CartType type) :
+CartRetail::CartRetail(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, melonDS::NDSCart::CartType type) :
     CartCommon(std::move(rom), len, chipid, badDSiDump, romparams, type, userdata)
 {
     u32 savememtype = ROMParams.SaveMemType <= 10 ? ROMParams.SaveMemType : 0;
@@ -559,7 +617,7 @@ void CartRetail::ReadROM_B7(u32 addr, u32 len, u8* data, u32 offset) const
             addr = 0x8000 + (addr & 0x1FF);
     }
 
-    memcpy(data+offset, ROM.get()+addr, len);
+    CopyROM(addr, len, data+offset);
 }
 
 u8 CartRetail::SRAMWrite_EEPROMTiny(u8 val, u32 pos, bool last)
@@ -844,7 +902,7 @@ CartRetailNAND::CartRetailNAND(const u8* rom, u32 len, u32 chipid, ROMListEntry
 {
 }
 
-CartRetailNAND::CartRetailNAND(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
+CartRetailNAND::CartRetailNAND(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
     CartRetail(std::move(rom), len, chipid, false, romparams, std::move(sram), sramlen, userdata, CartType::RetailNAND)
 {
     BuildSRAMID();
@@ -1077,7 +1135,7 @@ CartRetailIR::CartRetailIR(const u8* rom, u32 len, u32 chipid, u32 irversion, bo
 }
 
 CartRetailIR::CartRetailIR(
-    std::unique_ptr<u8[]>&& rom,
+    std::shared_ptr<const u8[]>&& rom,
     u32 len,
     u32 chipid,
     u32 irversion,
@@ -1135,7 +1193,7 @@ CartRetailBT::CartRetailBT(const u8* rom, u32 len, u32 chipid, ROMListEntry romp
 {
 }
 
-CartRetailBT::CartRetailBT(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
+CartRetailBT::CartRetailBT(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
     CartRetail(std::move(rom), len, chipid, false, romparams, std::move(sram), sramlen, userdata, CartType::RetailBT)
 {
     Log(LogLevel::Info,"POKETYPE CART\n");
@@ -1162,7 +1220,7 @@ CartSD::CartSD(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void*
     CartSD(CopyToUnique(rom, len), len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
-CartSD::CartSD(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
+CartSD::CartSD(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
     CartCommon(std::move(rom), len, chipid, false, romparams, CartType::Homebrew, userdata),
     SD(std::move(sdcard))
 {
@@ -1288,7 +1346,7 @@ void CartSD::ApplyDLDIPatch(const u8* patch, u32 patchlen, bool readonly)
     u32 offset = *(u32*)&ROM[0x20];
     u32 size = *(u32*)&ROM[0x2C];
 
-    u8* binary = &ROM[offset];
+    const u8* binary = &ROM[offset];
 
     for (u32 i = 0; i < size; )
     {
@@ -1297,7 +1355,16 @@ void CartSD::ApplyDLDIPatch(const u8* patch, u32 patchlen, bool readonly)
             *(u32*)&binary[i+8] == 0x006D6873)
         {
             Log(LogLevel::Debug, "DLDI structure found at %08X (%08X)\n", i, offset+i);
-            ApplyDLDIPatchAt(binary, i, patch, patchlen, readonly);
+
+            // patch the space reserved for the driver
+            u32 drvsize = std::min(1u << (binary[i+0x0F] & 0x1F), ROMLength - (offset+i));
+            if (drvsize < patchlen)
+            {
+                Log(LogLevel::Error, "DLDI driver ain't gonna fit, sorry\n");
+                return;
+            }
+
+            ApplyDLDIPatchAt(PatchROM(offset+i, drvsize), 0, patch, patchlen, readonly);
             i += patchlen;
         }
         else
@@ -1311,14 +1378,14 @@ void CartSD::ReadROM_B7(u32 addr, u32 len, u8* data, u32 offset) const
 
     addr &= (ROMLength-1);
 
-    memcpy(data+offset, ROM.get()+addr, len);
+    CopyROM(addr, len, data+offset);
 }
 
 CartHomebrew::CartHomebrew(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
     CartSD(rom, len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
-CartHomebrew::CartHomebrew(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
+CartHomebrew::CartHomebrew(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
     CartSD(std::move(rom), len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
@@ -1340,6 +1407,9 @@ void CartHomebrew::SetupDirectBoot(const std::string& romname, NDS& nds)
     {
         // add the ROM to the SD volume
 
+        if (ROMChunks)
+            ROMChunks->Pin(0, ROMLength);
+
         if (!SD->InjectFile(romname, ROM.get(), ROMLength))
             return;
 
@@ -1545,12 +1615,11 @@ bool ReadROMParams(u32 gamecode, ROMListEntry* params)
 void NDSCartSlot::DecryptSecureArea(u8* out) noexcept
 {
     const NDSHeader& header = Cart->GetHeader();
-    const u8* cartrom = Cart->GetROM();
 
     u32 gamecode = header.GameCodeAsU32();
     u32 arm9base = header.ARM9ROMOffset;
 
-    memcpy(out, &cartrom[arm9base], 0x800);
+    Cart->CopyROM(arm9base, 0x800, out);
 
     Key1_InitKeycode(false, gamecode, 2, 2, NDS.GetARM7BIOS().data(), ARM7BIOSSize);
     Key1_Decrypt((u32*)&out[0]);
@@ -1578,6 +1647,8 @@ std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, void* userda
     return ParseROM(CopyToUnique(romdata, romlen), romlen, userdata, std::move(args));
 }
 
+static std::unique_ptr<CartCommon> CreateCart(std::shared_ptr<const u8[]>&& cartrom, u32 cartromsize, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args);
+
 std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args)
 {
     if (romdata == nullptr)
@@ -1593,7 +1664,74 @@ std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen
     }
 
     auto [cartrom, cartromsize] = PadToPowerOf2(std::move(romdata), romlen);
+    return CreateCart(std::move(cartrom), cartromsize, romlen, userdata, std::move(args));
+}
 
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args)
+{
+    return ParseROM(std::move(romdata), romlen, romlen, userdata, std::move(args));
+}
+
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, u32 padlen, void* userdata, std::optional<NDSCartArgs>&& args)
+{
+    if (romdata == nullptr)
+    {
+        Log(LogLevel::Error, "NDSCart: romdata is null\n");
+        return nullptr;
+    }
+
+    if (romlen == 0)
+    {
+        Log(LogLevel::Error, "NDSCart: romlen is zero\n");
+        return nullptr;
+    }
+
+    // the data can be used as is if it's padded up to the next power of 2
+    if ((padlen & (padlen - 1)) == 0 && padlen >= romlen && (padlen >> 1) < romlen)
+        return CreateCart(std::move(romdata), padlen, romlen, userdata, std::move(args));
+
+    auto [cartrom, cartromsize] = PadToPowerOf2(romdata.get(), romlen);
+    return CreateCart(std::move(cartrom), cartromsize, romlen, userdata, std::move(args));
+}
+
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<ChunkedROM> romdata, void* userdata, std::optional<NDSCartArgs>&& args)
+{
+    if (romdata == nullptr || !romdata->IsValid())
+    {
+        Log(LogLevel::Error, "NDSCart: romdata is null\n");
+        return nullptr;
+    }
+
+    // header and secure area
+    romdata->Pin(0, 0x8000);
+
+    NDSHeader header {};
+    memcpy(&header, romdata->GetData(), sizeof(header));
+
+    // anything that's accessed directly through GetROM()
+    // needs to stay in memory
+    romdata->Pin(header.ARM9ROMOffset, header.ARM9Size);
+    romdata->Pin(header.ARM7ROMOffset, header.ARM7Size);
+    if (header.BannerOffset)
+        romdata->Pin(header.BannerOffset, sizeof(NDSBanner));
+    if (header.IsDSi())
+    {
+        romdata->Pin(header.DSiARM9iROMOffset, header.DSiARM9iSize);
+        romdata->Pin(header.DSiARM7iROMOffset, header.DSiARM7iSize);
+    }
+
+    // the cart's ROM pointer keeps the chunk cache alive
+    ChunkedROM* chunks = romdata.get();
+    std::shared_ptr<const u8[]> cartrom(std::move(romdata), chunks->GetData());
+    auto cart = CreateCart(std::move(cartrom), chunks->GetLength(), chunks->GetDataLength(), userdata, std::move(args));
+    if (cart)
+        cart->ROMChunks = chunks;
+
+    return cart;
+}
+
+static std::unique_ptr<CartCommon> CreateCart(std::shared_ptr<const u8[]>&& cartrom, u32 cartromsize, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args)
+{
     NDSHeader header {};
     memcpy(&header, cartrom.get(), sizeof(header));
 
@@ -1704,22 +1842,25 @@ void NDSCartSlot::SetCart(std::unique_ptr<CartCommon>&& cart) noexcept
 
     const NDSHeader& header = Cart->GetHeader();
     const ROMListEntry romparams = Cart->GetROMParams();
-    const u8* cartrom = Cart->GetROM();
     if (header.ARM9ROMOffset >= 0x4000 && header.ARM9ROMOffset < 0x8000)
     {
         // reencrypt secure area if needed
-        if (*(u32*)&cartrom[header.ARM9ROMOffset] == 0xE7FFDEFF && *(u32*)&cartrom[header.ARM9ROMOffset + 0x10] != 0xE7FFDEFF)
+        u8 securearea[0x800];
+        Cart->CopyROM(header.ARM9ROMOffset, sizeof(securearea), securearea);
+        if (*(u32*)&securearea[0] == 0xE7FFDEFF && *(u32*)&securearea[0x10] != 0xE7FFDEFF)
         {
             Log(LogLevel::Debug, "Re-encrypting cart secure area\n");
 
-            strncpy((char*)&cartrom[header.ARM9ROMOffset], "encryObj", 8);
+            u8* cartrom = Cart->PatchROM(header.ARM9ROMOffset, sizeof(securearea));
+
+            strncpy((char*)&cartrom[0], "encryObj", 8);
 
             Key1_InitKeycode(false, romparams.GameCode, 3, 2, NDS.GetARM7BIOS().data(), ARM7BIOSSize);
             for (u32 i = 0; i < 0x800; i += 8)
-                Key1_Encrypt((u32*)&cartrom[header.ARM9ROMOffset + i]);
+                Key1_Encrypt((u32*)&cartrom[i]);
 
             Key1_InitKeycode(false, romparams.GameCode, 2, 2, NDS.GetARM7BIOS().data(), ARM7BIOSSize);
-            Key1_Encrypt((u32*)&cartrom[header.ARM9ROMOffset]);
+            Key1_Encrypt((u32*)&cartrom[0]);
 
             Log(LogLevel::Debug, "Re-encrypted cart secure area\n");
         }
@@ -1800,6 +1941,34 @@ void NDSCartSlot::ROMEndTransfer(u32 param) noexcept
 
 void NDSCartSlot::ROMPrepareData(u32 param) noexcept
 {
+    if (TransferDir == 0 && TransferPos == 0 && TransferLen > 4)
+    {
+        // the whole transfer is already in TransferData. If it's going
+        // straight to RAM through a DMA, copy it all at once rather than
+        // going through one DMA request per word.
+        u32 cpu = (NDS.ExMemCnt[0] >> 11) & 0x1;
+        u32 mode = cpu ? 0x12 : 0x05;
+        if (NDS.BulkTransferDMAs(cpu, mode, 0x04100010, (const u32*)TransferData.data(), TransferLen >> 2))
+        {
+            ROMData = *(u32*)&TransferData[TransferLen - 4];
+            TransferPos = TransferLen;
+
+            // end the transfer when the last word would have been read,
+            // see AdvanceROMTransfer()
+            u32 xfercycle = (ROMCnt & (1<<27)) ? 8 : 5;
+            u32 delay = 0;
+            for (u32 pos = 4; pos < TransferLen; pos += 4)
+            {
+                delay += 4;
+                if (!(ROMCnt & (1<<30)) && !(pos & 0x1FF))
+                    delay += ((ROMCnt >> 16) & 0x3F);
+            }
+
+            NDS.ScheduleEvent(Event_ROMTransfer, false, xfercycle*delay, ROMTransfer_End, 0);
+            return;
+        }
+    }
+
     if (TransferDir == 0)
     {
         if (TransferPos >= TransferLen)
@@ -23,12 +23,14 @@
 #include <string>
 #include <memory>
 #include <variant>
+#include <vector>
 
 #include "types.h"
 #include "Savestate.h"
 #include "NDS_Header.h"
 #include "FATStorage.h"
 #include "ROMList.h"
+#include "ChunkedROM.h"
 
 namespace melonDS
 {
@@ -77,7 +79,7 @@ class CartCommon
 {
 public:
     CartCommon(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
-    CartCommon(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
+    CartCommon(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
     virtual ~CartCommon();
 
     [[nodiscard]] u32 Type() const { return CartType; };
@@ -108,13 +110,41 @@ public:
     [[nodiscard]] u32 ID() const { return ChipID; }
     [[nodiscard]] const u8* GetROM() const { return ROM.get(); }
     [[nodiscard]] u32 GetROMLength() const { return ROMLength; }
+
+    /// @return The cartridge's ROM data, for passing to ParseROM
+    /// to create more carts that share it instead of holding their own copy.
+    [[nodiscard]] std::shared_ptr<const u8[]> GetSharedROM() const { return ROM; }
+
+    /// Copies a range of the ROM to \c out, as the console sees it.
+    /// Unlike GetROM(), this includes any changes made through PatchROM().
+    void CopyROM(u32 addr, u32 len, u8* out) const;
+
+    /// @return A writable pointer to \c len bytes of the ROM at \c addr.
+    /// Changes only apply to this cart: they're kept separately from the
+    /// ROM data, which may be shared, and are seen through CopyROM().
+    u8* PatchROM(u32 addr, u32 len);
+
+    friend std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<ChunkedROM> romdata, void* userdata, std::optional<NDSCartArgs>&& args);
 protected:
     void ReadROM(u32 addr, u32 len, u8* data, u32 offset) const;
 
     void* UserData;
 
-    std::unique_ptr<u8[]> ROM = nullptr;
+    // can be shared between multiple carts, so it's never modified
+    std::shared_ptr<const u8[]> ROM = nullptr;
     u32 ROMLength = 0;
+    // set if the ROM is decompressed on demand, in which case ROM points into it
+    // and anything outside the pinned ranges must be read through it
+    ChunkedROM* ROMChunks = nullptr;
+    // this cart's changes to the ROM (re-encrypted secure area, DLDI driver),
+    // which are copied over the ROM data when reading it
+    struct ROMPatch
+    {
+        u32 Addr;
+        u32 Length;
+        std::unique_ptr<u8[]> Data;
+    };
+    std::vector<ROMPatch> Patches;
     u32 ChipID = 0;
     bool IsDSi = false;
     bool DSiMode = false;
@@ -145,7 +175,7 @@ public:
         melonDS::NDSCart::CartType type = CartType::Retail
     );
     CartRetail(
-        std::unique_ptr<u8[]>&& rom,
+        std::shared_ptr<const u8[]>&& rom,
         u32 len, u32 chipid,
         bool badDSiDump,
         ROMListEntry romparams,
@@ -192,7 +222,7 @@ class CartRetailNAND : public CartRetail
 {
 public:
     CartRetailNAND(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailNAND(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailNAND(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailNAND() override;
 
     void Reset() override;
@@ -221,7 +251,7 @@ class CartRetailIR : public CartRetail
 {
 public:
     CartRetailIR(const u8* rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailIR(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailIR(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailIR() override;
 
     void Reset() override;
@@ -240,7 +270,7 @@ class CartRetailBT : public CartRetail
 {
 public:
     CartRetailBT(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailBT(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailBT(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailBT() override;
 
     u8 SPIWrite(u8 val, u32 pos, bool last) override;
@@ -251,7 +281,7 @@ class CartSD : public CartCommon
 {
 public:
     CartSD(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
-    CartSD(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
+    CartSD(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartSD() override;
 
     [[nodiscard]] const std::optional<FATStorage>& GetSDCard() const noexcept { return SD; }
@@ -293,7 +323,7 @@ class CartHomebrew : public CartSD
 {
 public:
     CartHomebrew(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
-    CartHomebrew(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
+    CartHomebrew(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartHomebrew() override;
 
     void Reset() override;
@@ -326,7 +356,7 @@ enum CartR4Language
 class CartR4 : public CartSD
 {
 public:
-    CartR4(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, CartR4Type ctype, CartR4Language clanguage, void* userdata,
+    CartR4(std::shared_ptr<const u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, CartR4Type ctype, CartR4Language clanguage, void* userdata,
         std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartR4() override;
 
@@ -467,6 +497,33 @@ private:
 /// or \c nullptr if the ROM data couldn't be parsed.
 std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
 std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
+
+/// Parses the given ROM data and constructs a \c NDSCart::CartCommon subclass
+/// that shares it with any other carts created from the same data.
+/// Useful for running many instances of the same game.
+///
+/// @param romdata The ROM data to parse. It is never modified;
+/// carts that need to patch their ROM keep the changes to themselves.
+/// If \c romlen is not a power of two, a padded copy is made as well.
+/// @see ParseROM(const u8*, u32, void*, std::optional<NDSCartArgs>&&)
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
+
+/// Like the above, for ROM data that's already zero-padded to a power of 2,
+/// so that carts can use it without making a padded copy.
+///
+/// @param romlen The length of the ROM itself.
+/// @param padlen The length of \c romdata, which should be
+/// \c romlen rounded up to a power of 2. If it isn't, a padded copy is made.
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<const u8[]> romdata, u32 romlen, u32 padlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
+
+/// Parses ROM data that's decompressed on demand and constructs
+/// a \c NDSCart::CartCommon subclass that reads it through the chunk cache.
+/// The header, banner and boot binaries are decompressed right away and kept
+/// in memory, the rest is only decompressed as the game reads it.
+///
+/// @param romdata The ROM data to parse. Can be shared between multiple carts.
+/// @see ParseROM(const u8*, u32, void*, std::optional<NDSCartArgs>&&)
+std::unique_ptr<CartCommon> ParseROM(std::shared_ptr<ChunkedROM> romdata, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
 }
 
 #endif
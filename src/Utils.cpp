@@ -20,6 +20,15 @@
 
 #include <string.h>
 
+#include <stdlib.h>
+
+#if defined(__SWITCH__)
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 namespace melonDS
 {
 std::pair<std::unique_ptr<u8[]>, u32> PadToPowerOf2(std::unique_ptr<u8[]>&& data, u32 len) noexcept
@@ -63,4 +72,53 @@ std::unique_ptr<u8[]> CopyToUnique(const u8* data, u32 len) noexcept
     memcpy(newdata.get(), data, len);
     return newdata;
 }
-}
\ No newline at end of file
+
+#if !defined(__SWITCH__) && !defined(_WIN32)
+#ifdef MAP_NORESERVE
+const int LazyMemoryFlags = MAP_NORESERVE;
+#else
+const int LazyMemoryFlags = 0;
+#endif
+#endif
+
+u8* AllocateLazyMemory(u32 size) noexcept
+{
+#if defined(__SWITCH__)
+    u8* mem = (u8*)calloc(1, size);
+#elif defined(_WIN32)
+    u8* mem = (u8*)VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    u8* mem = (u8*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | LazyMemoryFlags, -1, 0);
+    if (mem == MAP_FAILED)
+        mem = nullptr;
+#endif
+    return mem;
+}
+
+void ResetLazyMemory(u8* mem, u32 size) noexcept
+{
+#if defined(__SWITCH__)
+    memset(mem, 0, size);
+#elif defined(_WIN32)
+    VirtualFree(mem, size, MEM_DECOMMIT);
+    VirtualAlloc(mem, size, MEM_COMMIT, PAGE_READWRITE);
+#else
+    // mapping fresh pages over the old ones is the only
+    // portable way to both zero them and give them back
+    mmap(mem, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | LazyMemoryFlags, -1, 0);
+#endif
+}
+
+void FreeLazyMemory(u8* mem, u32 size) noexcept
+{
+    if (!mem)
+        return;
+#if defined(__SWITCH__)
+    free(mem);
+#elif defined(_WIN32)
+    VirtualFree(mem, 0, MEM_RELEASE);
+#else
+    munmap(mem, size);
+#endif
+}
+}
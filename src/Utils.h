@@ -38,6 +38,17 @@ std::pair<std::unique_ptr<u8[]>, u32> PadToPowerOf2(const u8* data, u32 len) noe
 
 std::unique_ptr<u8[]> CopyToUnique(const u8* data, u32 len) noexcept;
 
+/// Allocates zero-filled memory whose pages only take up
+/// physical memory once they're written to.
+/// @return The allocated memory, or \c nullptr on failure.
+u8* AllocateLazyMemory(u32 size) noexcept;
+
+/// Zeroes a page-aligned range of memory from AllocateLazyMemory,
+/// giving its pages back to the system.
+void ResetLazyMemory(u8* mem, u32 size) noexcept;
+
+void FreeLazyMemory(u8* mem, u32 size) noexcept;
+
 }
 
 #endif // MELONDS_UTILS_H
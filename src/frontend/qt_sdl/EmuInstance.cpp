@@ -47,6 +47,8 @@
 #include "RTC.h"
 #include "DSi_I2C.h"
 #include "FreeBIOS.h"
+#include "Utils.h"
+#include "FileMapping.h"
 #include "main.h"
 
 using std::make_unique;
@@ -155,7 +157,6 @@ EmuInstance::~EmuInstance()
     audioDeInit();
     inputDeInit();
 
-    NDS::Current = nullptr;
     if (nds)
     {
         saveRTCData();
@@ -947,6 +948,8 @@ std::optional<Firmware> EmuInstance::loadFirmware(int type) noexcept
 
     Log(Debug, "SPI firmware: loading from file %s\n", firmwarepath.c_str());
 
+    // relative paths are relative to the emulator directory, as for OpenLocalFile
+    SaveManager::RecoverJournal(GetLocalFilePath(firmwarepath));
     FileHandle* file = OpenLocalFile(firmwarepath, Read);
 
     if (!file)
@@ -1268,7 +1271,6 @@ bool EmuInstance::updateConsole(UpdateConsoleNDSArgs&& _ndsargs, UpdateConsoleGB
 
     if ((!nds) || (consoleType != nds->ConsoleType))
     {
-        NDS::Current = nullptr;
         if (nds)
         {
             saveRTCData();
@@ -1280,7 +1282,6 @@ bool EmuInstance::updateConsole(UpdateConsoleNDSArgs&& _ndsargs, UpdateConsoleGB
         else
             nds = new NDS(std::move(ndsargs), this);
 
-        NDS::Current = nds;
         nds->Reset();
         loadRTCData();
         //emuThread->updateVideoRenderer(); // not actually needed?
@@ -1484,6 +1485,107 @@ u32 EmuInstance::decompressROM(const u8* inContent, const u32 inSize, unique_ptr
     }
 }
 
+std::shared_ptr<ChunkedROM> EmuInstance::openSeekableROM(const std::string& filename)
+{
+    // zstd seekable format: the file ends with a skippable frame holding
+    // the compressed and decompressed size of every frame, followed by
+    // a footer giving the number of frames
+    constexpr u32 skippableMagic = 0x184D2A5E;
+    constexpr u32 seekableMagic = 0x8F92EAB1;
+    constexpr u32 footerSize = 9;
+
+    struct SeekableFile
+    {
+        Platform::FileHandle* file = nullptr;
+        ZSTD_DCtx* dctx = nullptr;
+        std::vector<u64> offsets;
+        std::vector<u32> sizes;
+        std::unique_ptr<u8[]> buffer;
+
+        ~SeekableFile()
+        {
+            if (dctx) ZSTD_freeDCtx(dctx);
+            if (file) Platform::CloseFile(file);
+        }
+    };
+
+    auto src = std::make_shared<SeekableFile>();
+    src->file = Platform::OpenFile(filename, FileMode::Read);
+    if (!src->file) return nullptr;
+
+    u64 filelen = Platform::FileLength(src->file);
+    if (filelen < footerSize + 8) return nullptr;
+
+    u8 footer[footerSize];
+    Platform::FileSeek(src->file, filelen - footerSize, FileSeekOrigin::Start);
+    if (Platform::FileRead(footer, footerSize, 1, src->file) != 1)
+        return nullptr;
+
+    u32 numframes = *(u32*)&footer[0];
+    u8 descriptor = footer[4];
+    if (*(u32*)&footer[5] != seekableMagic || (descriptor & 0x7C) || numframes == 0)
+        return nullptr;
+
+    u32 entrysize = (descriptor & 0x80) ? 12 : 8;
+    u64 tablesize = (u64)numframes * entrysize;
+    if (filelen < tablesize + footerSize + 8) return nullptr;
+
+    auto table = std::make_unique<u8[]>(tablesize + 8);
+    Platform::FileSeek(src->file, filelen - footerSize - tablesize - 8, FileSeekOrigin::Start);
+    if (Platform::FileRead(table.get(), tablesize + 8, 1, src->file) != 1)
+        return nullptr;
+
+    if (*(u32*)&table[0] != skippableMagic || *(u32*)&table[4] != tablesize + footerSize)
+        return nullptr;
+
+    // only frames of a fixed decompressed size can be located without
+    // decompressing everything before them
+    u32 chunksize = *(u32*)&table[8 + 4];
+    u64 romlen = 0;
+    u64 offset = 0;
+    u64 dataend = filelen - footerSize - tablesize - 8;
+    u32 maxcompressed = 0;
+    for (u32 i = 0; i < numframes; i++)
+    {
+        u32 csize = *(u32*)&table[8 + i*entrysize];
+        u32 dsize = *(u32*)&table[8 + i*entrysize + 4];
+        if (dsize > chunksize || (dsize != chunksize && i != numframes-1))
+            return nullptr;
+
+        // every frame must come after the previous one and end before the seek table
+        if (csize == 0 || csize > dataend - offset)
+            return nullptr;
+
+        src->offsets.push_back(offset);
+        src->sizes.push_back(csize);
+        offset += csize;
+        romlen += dsize;
+        maxcompressed = std::max(maxcompressed, csize);
+    }
+
+    if (chunksize == 0 || (chunksize % ChunkedROM::ChunkAlign) || romlen > 0x40000000)
+        return nullptr;
+
+    src->dctx = ZSTD_createDCtx();
+    src->buffer = std::make_unique<u8[]>(maxcompressed);
+
+    auto reader = [src](u32 chunk, u8* out, u32 len) -> bool
+    {
+        Platform::FileSeek(src->file, src->offsets[chunk], FileSeekOrigin::Start);
+        if (Platform::FileRead(src->buffer.get(), src->sizes[chunk], 1, src->file) != 1)
+            return false;
+
+        size_t res = ZSTD_decompressDCtx(src->dctx, out, len, src->buffer.get(), src->sizes[chunk]);
+        return !ZSTD_isError(res) && res == len;
+    };
+
+    auto rom = std::make_shared<ChunkedROM>((u32)romlen, chunksize, std::move(reader));
+    if (!rom->IsValid()) return nullptr;
+
+    Log(LogLevel::Info, "Opened seekable ROM %s: %d frames of %d bytes\n", filename.c_str(), numframes, chunksize);
+    return rom;
+}
+
 void EmuInstance::clearBackupState()
 {
     if (backupState != nullptr)
@@ -1673,7 +1775,8 @@ void EmuInstance::customizeFirmware(Firmware& firmware, bool overridesettings) n
 }
 
 // Loads ROM data without parsing it. Works for GBA and NDS ROMs.
-bool EmuInstance::loadROMData(const QStringList& filepath, std::unique_ptr<u8[]>& filedata, u32& filelen, string& basepath, string& romname) noexcept
+// filedata may be zero-padded past filelen, up to paddedlen.
+bool EmuInstance::loadROMData(const QStringList& filepath, std::shared_ptr<const u8[]>& filedata, u32& filelen, u32& paddedlen, string& basepath, string& romname, std::shared_ptr<ChunkedROM>* chunkeddata) noexcept
 {
     if (filepath.empty()) return false;
 
@@ -1682,44 +1785,73 @@ bool EmuInstance::loadROMData(const QStringList& filepath, std::unique_ptr<u8[]>
         // regular file
 
         std::string filename = filepath.at(0).toStdString();
-        Platform::FileHandle* f = Platform::OpenFile(filename, FileMode::Read);
-        if (!f) return false;
+        bool compressed = filename.length() > 4 && filename.substr(filename.length() - 4) == ".zst";
 
-        long len = Platform::FileLength(f);
-        if (len > 0x40000000)
+        // map uncompressed ROMs instead of reading them in whole,
+        // so only the parts the game actually uses get loaded from disk
+        if (!compressed)
         {
-            Platform::CloseFile(f);
-            return false;
+            tie(filedata, filelen) = FileMapping::MapFileToPowerOf2(filename);
+
+            // the mapping comes with its own zero padding
+            paddedlen = 1;
+            while (paddedlen < filelen)
+                paddedlen <<= 1;
         }
 
-        Platform::FileRewind(f);
-        filedata = make_unique<u8[]>(len);
-        size_t nread = Platform::FileRead(filedata.get(), (size_t)len, 1, f);
-        Platform::CloseFile(f);
-        if (nread != 1)
+        // likewise, ROMs compressed in seekable form can be decompressed
+        // a chunk at a time as they're read
+        if (compressed && chunkeddata)
         {
-            filedata = nullptr;
-            return false;
+            *chunkeddata = openSeekableROM(filename);
+            if (*chunkeddata)
+            {
+                filelen = (*chunkeddata)->GetDataLength();
+                paddedlen = (*chunkeddata)->GetLength();
+                filename = filename.substr(0, filename.length() - 4);
+            }
         }
 
-        filelen = (u32)len;
-
-        if (filename.length() > 4 && filename.substr(filename.length() - 4) == ".zst")
+        if (!filedata && !(chunkeddata && *chunkeddata))
         {
-            filelen = decompressROM(filedata.get(), len, filedata);
+            Platform::FileHandle* f = Platform::OpenFile(filename, FileMode::Read);
+            if (!f) return false;
 
-            if (filelen > 0)
+            long len = Platform::FileLength(f);
+            if (len > 0x40000000)
             {
-                filename = filename.substr(0, filename.length() - 4);
+                Platform::CloseFile(f);
+                return false;
             }
-            else
-            {
-                filedata = nullptr;
-                filelen = 0;
-                basepath = "";
-                romname = "";
+
+            Platform::FileRewind(f);
+            unique_ptr<u8[]> data = make_unique<u8[]>(len);
+            size_t nread = Platform::FileRead(data.get(), (size_t)len, 1, f);
+            Platform::CloseFile(f);
+            if (nread != 1)
                 return false;
+
+            filelen = (u32)len;
+
+            if (compressed)
+            {
+                filelen = decompressROM(data.get(), len, data);
+
+                if (filelen > 0)
+                {
+                    filename = filename.substr(0, filename.length() - 4);
+                }
+                else
+                {
+                    filelen = 0;
+                    basepath = "";
+                    romname = "";
+                    return false;
+                }
             }
+
+            filedata = std::move(data);
+            paddedlen = filelen;
         }
 
         int pos = lastSep(filename);
@@ -1734,14 +1866,15 @@ bool EmuInstance::loadROMData(const QStringList& filepath, std::unique_ptr<u8[]>
     {
         // file inside archive
 
-        s32 lenread = Archive::ExtractFileFromArchive(filepath.at(0), filepath.at(1), filedata, &filelen);
+        unique_ptr<u8[]> data = nullptr;
+        s32 lenread = Archive::ExtractFileFromArchive(filepath.at(0), filepath.at(1), data, &filelen);
         if (lenread < 0) return false;
-        if (!filedata) return false;
+        if (!data) return false;
         if (lenread != filelen)
-        {
-            filedata = nullptr;
             return false;
-        }
+
+        filedata = std::move(data);
+        paddedlen = filelen;
 
         std::string std_archivepath = filepath.at(0).toStdString();
         basepath = std_archivepath.substr(0, lastSep(std_archivepath));
@@ -1768,12 +1901,13 @@ QString EmuInstance::getSavErrorString(std::string& filepath, bool gba)
 
 bool EmuInstance::loadROM(QStringList filepath, bool reset)
 {
-    unique_ptr<u8[]> filedata = nullptr;
-    u32 filelen;
+    std::shared_ptr<const u8[]> filedata = nullptr;
+    std::shared_ptr<ChunkedROM> chunkeddata = nullptr;
+    u32 filelen, paddedlen;
     std::string basepath;
     std::string romname;
 
-    if (!loadROMData(filepath, filedata, filelen, basepath, romname))
+    if (!loadROMData(filepath, filedata, filelen, paddedlen, basepath, romname, &chunkeddata))
     {
         QMessageBox::critical(mainWindow, "melonDS", "Failed to load the DS ROM.");
         return false;
@@ -1792,6 +1926,10 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset)
     std::string origsav = savname;
     savname += instanceFileSuffix();
 
+    // finish any save write that was interrupted last time
+    SaveManager::RecoverJournal(savname);
+    SaveManager::RecoverJournal(origsav);
+
     FileHandle* sav = Platform::OpenFile(savname, FileMode::Read);
     if (!sav)
     {
@@ -1828,7 +1966,11 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset)
             .SRAMLength = savelen,
     };
 
-    auto cart = NDSCart::ParseROM(std::move(filedata), filelen, this, std::move(cartargs));
+    std::unique_ptr<NDSCart::CartCommon> cart;
+    if (chunkeddata)
+        cart = NDSCart::ParseROM(std::move(chunkeddata), this, std::move(cartargs));
+    else
+        cart = NDSCart::ParseROM(std::move(filedata), filelen, paddedlen, this, std::move(cartargs));
     if (!cart)
     {
         // If we couldn't parse the ROM...
@@ -1910,12 +2052,12 @@ bool EmuInstance::loadGBAROM(QStringList filepath)
         return false;
     }
 
-    unique_ptr<u8[]> filedata = nullptr;
-    u32 filelen;
+    std::shared_ptr<const u8[]> filedata = nullptr;
+    u32 filelen, paddedlen;
     std::string basepath;
     std::string romname;
 
-    if (!loadROMData(filepath, filedata, filelen, basepath, romname))
+    if (!loadROMData(filepath, filedata, filelen, paddedlen, basepath, romname))
     {
         QMessageBox::critical(mainWindow, "melonDS", "Failed to load the GBA ROM.");
         return false;
@@ -1934,6 +2076,10 @@ bool EmuInstance::loadGBAROM(QStringList filepath)
     std::string origsav = savname;
     savname += instanceFileSuffix();
 
+    // finish any save write that was interrupted last time
+    SaveManager::RecoverJournal(savname);
+    SaveManager::RecoverJournal(origsav);
+
     FileHandle* sav = Platform::OpenFile(savname, FileMode::Read);
     if (!sav)
     {
@@ -1964,7 +2110,9 @@ bool EmuInstance::loadGBAROM(QStringList filepath)
         CloseFile(sav);
     }
 
-    auto cart = GBACart::ParseROM(std::move(filedata), filelen, std::move(savedata), savelen, this);
+    // GBA carts are padded to a power of 2 anyway,
+    // so a mapping that already is can be used as is
+    auto cart = GBACart::ParseROM(std::move(filedata), paddedlen, std::move(savedata), savelen, this);
     if (!cart)
     {
         QMessageBox::critical(mainWindow, "melonDS", "Failed to load the GBA ROM.");
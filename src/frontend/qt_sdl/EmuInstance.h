@@ -175,7 +175,8 @@ private:
     std::pair<std::unique_ptr<melonDS::Firmware>, std::string> generateDefaultFirmware();
     bool parseMacAddress(void* data);
     void customizeFirmware(melonDS::Firmware& firmware, bool overridesettings) noexcept;
-    bool loadROMData(const QStringList& filepath, std::unique_ptr<melonDS::u8[]>& filedata, melonDS::u32& filelen, std::string& basepath, std::string& romname) noexcept;
+    std::shared_ptr<melonDS::ChunkedROM> openSeekableROM(const std::string& filename);
+    bool loadROMData(const QStringList& filepath, std::shared_ptr<const melonDS::u8[]>& filedata, melonDS::u32& filelen, melonDS::u32& paddedlen, std::string& basepath, std::string& romname, std::shared_ptr<melonDS::ChunkedROM>* chunkeddata = nullptr) noexcept;
     QString getSavErrorString(std::string& filepath, bool gba);
     bool loadROM(QStringList filepath, bool reset);
     void ejectCart();
@@ -836,6 +836,8 @@ void EmuThread::updateRenderer()
             static_cast<ComputeRenderer&>(emuInstance->nds->GPU.GetRenderer3D()).SetRenderSettings(
                     cfg.GetInt("3D.GL.ScaleFactor"),
                     cfg.GetBool("3D.GL.HiresCoordinates"));
+            static_cast<ComputeRenderer&>(emuInstance->nds->GPU.GetRenderer3D()).SetTextureCacheSize(
+                    cfg.GetInt("3D.GL.TextureCacheSize"));
             break;
         default: __builtin_unreachable();
     }
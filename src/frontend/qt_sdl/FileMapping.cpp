@@ -0,0 +1,109 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "FileMapping.h"
+
+#if defined(__SWITCH__)
+#elif defined(_WIN32)
+#include <filesystem>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace FileMapping
+{
+
+std::pair<std::shared_ptr<const u8[]>, u32> MapFileToPowerOf2(const std::string& path) noexcept
+{
+#if defined(__SWITCH__)
+    return {nullptr, 0};
+#elif defined(_WIN32)
+    HANDLE file = CreateFileW(std::filesystem::u8path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return {nullptr, 0};
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > 0x40000000)
+    {
+        CloseHandle(file);
+        return {nullptr, 0};
+    }
+
+    // a view can't be followed by zeroed memory of our own,
+    // so files that would need padding are read the normal way
+    u32 len = (u32)size.QuadPart;
+    if (len & (len - 1))
+    {
+        CloseHandle(file);
+        return {nullptr, 0};
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return {nullptr, 0};
+
+    u8* mem = (u8*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, len);
+    CloseHandle(mapping);
+    if (!mem)
+        return {nullptr, 0};
+
+    return {std::shared_ptr<const u8[]>(mem, [](const u8* mem) { UnmapViewOfFile(mem); }), len};
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {nullptr, 0};
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size > 0x40000000)
+    {
+        close(fd);
+        return {nullptr, 0};
+    }
+
+    u32 len = (u32)st.st_size;
+    u32 paddedlen = 1;
+    while (paddedlen < len)
+        paddedlen <<= 1;
+
+    // reserve zeroed memory for the whole padded length,
+    // then map the file over the start of it
+    u8* mem = (u8*)mmap(nullptr, paddedlen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        close(fd);
+        return {nullptr, 0};
+    }
+
+    void* filemem = mmap(mem, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    if (filemem == MAP_FAILED)
+    {
+        munmap(mem, paddedlen);
+        return {nullptr, 0};
+    }
+
+    return {std::shared_ptr<const u8[]>(mem, [paddedlen](const u8* mem) { munmap((void*)mem, paddedlen); }), len};
+#endif
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef FILEMAPPING_H
+#define FILEMAPPING_H
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "types.h"
+
+namespace FileMapping
+{
+
+using namespace melonDS;
+
+/// Maps the file at the given path into memory, zero-padded to a power of 2 in length.
+/// Pages are only read from disk when first touched, and are shared with
+/// anything else mapping the same file until they're written to.
+/// Writing to the mapping never modifies the file.
+///
+/// @return The mapped data and the length of the file,
+/// or <tt>{nullptr, 0}</tt> if the file can't be mapped,
+/// in which case the caller should read it into memory instead.
+std::pair<std::shared_ptr<const u8[]>, u32> MapFileToPowerOf2(const std::string& path) noexcept;
+
+}
+
+#endif // FILEMAPPING_H
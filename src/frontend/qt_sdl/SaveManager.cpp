@@ -18,18 +18,56 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+
+#include <QFile>
+#include <QSaveFile>
+
+#ifdef __WIN32__
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "SaveManager.h"
 #include "Platform.h"
+#include "CRC32.h"
 
 using namespace melonDS;
 using namespace melonDS::Platform;
 
+// Writes that touch less than half of the save go through a journal:
+// the changed ranges are first written to a separate file, and only
+// then patched into the save itself. If we're interrupted while patching,
+// the journal is still there to be replayed next time the save is loaded.
+// Bigger writes just replace the whole file.
+//
+// Journal layout: magic, save length, number of ranges,
+// then (offset, length, data) for each range, then a CRC32 of all the above.
+constexpr u32 kJournalMagic = 0x314A534D; // MSJ1
+
+static std::string JournalPath(const std::string& path)
+{
+    return path + ".journal";
+}
+
+// flushes the file all the way to the disk, not just to the OS
+static bool SyncFile(QFile& file)
+{
+    if (!file.flush()) return false;
+#ifdef __WIN32__
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
 SaveManager::SaveManager(const std::string& path) : QThread()
 {
     SecondaryBuffer = nullptr;
     SecondaryBufferLength = 0;
     SecondaryBufferLock = new QMutex();
+    FlushCondition = new QWaitCondition();
 
     Running = false;
 
@@ -41,10 +79,11 @@ SaveManager::SaveManager(const std::string& path) : QThread()
 
     FlushVersion = 0;
     PreviousFlushVersion = 0;
-    TimeAtLastFlushRequest = 0;
 
     if (!path.empty())
     {
+        RecoverJournal(path);
+
         Running = true;
         start();
     }
@@ -54,13 +93,18 @@ SaveManager::~SaveManager()
 {
     if (Running)
     {
+        SecondaryBufferLock->lock();
         Running = false;
+        FlushCondition->wakeAll();
+        SecondaryBufferLock->unlock();
+
         wait();
         FlushSecondaryBuffer();
     }
 
     SecondaryBuffer = nullptr;
 
+    delete FlushCondition;
     delete SecondaryBufferLock;
 
     Buffer = nullptr;
@@ -78,6 +122,8 @@ void SaveManager::SetPath(const std::string& path, bool reload)
     if (reload)
     { // If we should load whatever file is at the new path...
 
+        RecoverJournal(Path);
+
         if (FileHandle* f = Platform::OpenFile(Path, FileMode::Read))
         {
             if (u32 length = Platform::FileLength(f); length != Length)
@@ -91,7 +137,33 @@ void SaveManager::SetPath(const std::string& path, bool reload)
         }
     }
     else
+    {
+        // the new file needs all of the save, not just what changed
+        AddDirtyRange(DirtyRanges, 0, Length);
         FlushRequested = true;
+    }
+}
+
+void SaveManager::AddDirtyRange(RangeList& ranges, u32 start, u32 len)
+{
+    if (len == 0) return;
+
+    u32 end = start + len;
+
+    // ranges are sorted and never overlap or touch,
+    // so merge with every range we overlap or touch
+    auto first = std::lower_bound(ranges.begin(), ranges.end(), start,
+                                  [](const std::pair<u32, u32>& r, u32 v) { return r.second < v; });
+    auto last = first;
+    while (last != ranges.end() && last->first <= end)
+    {
+        start = std::min(start, last->first);
+        end = std::max(end, last->second);
+        last++;
+    }
+
+    first = ranges.erase(first, last);
+    ranges.insert(first, {start, end});
 }
 
 void SaveManager::RequestFlush(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen)
@@ -102,6 +174,9 @@ void SaveManager::RequestFlush(const u8* savedata, u32 savelen, u32 writeoffset,
         Buffer = std::make_unique<u8[]>(Length);
 
         memcpy(Buffer.get(), savedata, Length);
+
+        DirtyRanges.clear();
+        AddDirtyRange(DirtyRanges, 0, Length);
     }
     else
     {
@@ -109,13 +184,16 @@ void SaveManager::RequestFlush(const u8* savedata, u32 savelen, u32 writeoffset,
         {
             u32 len = savelen - writeoffset;
             memcpy(&Buffer[writeoffset], &savedata[writeoffset], len);
+            AddDirtyRange(DirtyRanges, writeoffset, len);
             len = writelen - len;
             if (len > savelen) len = savelen;
             memcpy(&Buffer[0], &savedata[0], len);
+            AddDirtyRange(DirtyRanges, 0, len);
         }
         else
         {
             memcpy(&Buffer[writeoffset], &savedata[writeoffset], writelen);
+            AddDirtyRange(DirtyRanges, writeoffset, writelen);
         }
     }
 
@@ -134,33 +212,56 @@ void SaveManager::CheckFlush()
     {
         SecondaryBufferLength = Length;
         SecondaryBuffer = std::make_unique<u8[]>(SecondaryBufferLength);
-    }
+        memcpy(SecondaryBuffer.get(), Buffer.get(), Length);
 
-    memcpy(SecondaryBuffer.get(), Buffer.get(), Length);
+        SecondaryDirtyRanges.clear();
+        AddDirtyRange(SecondaryDirtyRanges, 0, Length);
+    }
+    else
+    {
+        for (auto [start, end] : DirtyRanges)
+        {
+            memcpy(&SecondaryBuffer[start], &Buffer[start], end - start);
+            AddDirtyRange(SecondaryDirtyRanges, start, end - start);
+        }
+    }
 
+    DirtyRanges.clear();
     FlushRequested = false;
     FlushVersion++;
-    TimeAtLastFlushRequest = time(nullptr);
+    TimeAtLastFlushRequest = std::chrono::steady_clock::now();
 
+    FlushCondition->wakeOne();
     SecondaryBufferLock->unlock();
 }
 
 void SaveManager::run()
 {
-    for (;;)
-    {
-        QThread::msleep(100);
+    // We debounce for two seconds after last flush request to ensure that writing has finished.
+    constexpr auto debounce = std::chrono::seconds(2);
 
-        if (!Running) return;
+    SecondaryBufferLock->lock();
+    while (Running)
+    {
+        if (!NeedsFlush())
+        {
+            FlushCondition->wait(SecondaryBufferLock);
+            continue;
+        }
 
-        // We debounce for two seconds after last flush request to ensure that writing has finished.
-        if (TimeAtLastFlushRequest == 0 || difftime(time(nullptr), TimeAtLastFlushRequest) < 2)
+        auto elapsed = std::chrono::steady_clock::now() - TimeAtLastFlushRequest;
+        if (elapsed < debounce)
         {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(debounce - elapsed);
+            FlushCondition->wait(SecondaryBufferLock, remaining.count() + 1);
             continue;
         }
 
+        SecondaryBufferLock->unlock();
         FlushSecondaryBuffer();
+        SecondaryBufferLock->lock();
     }
+    SecondaryBufferLock->unlock();
 }
 
 void SaveManager::FlushSecondaryBuffer(u8* dst, u32 dstLength)
@@ -173,25 +274,185 @@ void SaveManager::FlushSecondaryBuffer(u8* dst, u32 dstLength)
     if (dst && dstLength < SecondaryBufferLength) return;
 
     SecondaryBufferLock->lock();
+    u32 version = FlushVersion;
     if (dst)
     {
         memcpy(dst, SecondaryBuffer.get(), SecondaryBufferLength);
+        PreviousFlushVersion = version;
+        SecondaryBufferLock->unlock();
+        return;
+    }
+
+    RangeList ranges = std::move(SecondaryDirtyRanges);
+    SecondaryDirtyRanges.clear();
+
+    u32 dirtylen = 0;
+    for (auto [start, end] : ranges)
+        dirtylen += end - start;
+
+    u32 filelen = 0;
+    if (FileHandle* f = Platform::OpenFile(Path, FileMode::Read))
+    {
+        filelen = Platform::FileLength(f);
+        CloseFile(f);
+    }
+
+    bool ok;
+    if (filelen != SecondaryBufferLength || dirtylen >= (SecondaryBufferLength / 2))
+    {
+        ok = WriteFullFile();
+        if (ok)
+            Log(LogLevel::Info, "SaveManager: Wrote %u bytes to %s\n", SecondaryBufferLength, Path.c_str());
     }
     else
     {
-        FileHandle* f = Platform::OpenFile(Path, FileMode::Write);
-        if (f)
+        // copy out the changed data so the emulator isn't held up
+        // while we write it
+        std::vector<u8> journal;
+        journal.reserve(16 + ranges.size() * 8 + dirtylen);
+
+        auto put32 = [&journal](u32 val)
         {
-            FileWrite(SecondaryBuffer.get(), SecondaryBufferLength, 1, f);
-            Log(LogLevel::Info, "SaveManager: Wrote %u bytes to %s\n", SecondaryBufferLength, Path.c_str());
-            CloseFile(f);
+            for (int i = 0; i < 4; i++)
+                journal.push_back((val >> (i * 8)) & 0xFF);
+        };
+
+        put32(kJournalMagic);
+        put32(SecondaryBufferLength);
+        put32((u32)ranges.size());
+        for (auto [start, end] : ranges)
+        {
+            put32(start);
+            put32(end - start);
+            journal.insert(journal.end(), &SecondaryBuffer[start], &SecondaryBuffer[end]);
         }
+        put32(CRC32(journal.data(), (int)journal.size()));
+
+        SecondaryBufferLock->unlock();
+        ok = WriteJournal(journal);
+        SecondaryBufferLock->lock();
+
+        if (ok)
+            Log(LogLevel::Info, "SaveManager: Wrote %u bytes in %u ranges to %s\n", dirtylen, (u32)ranges.size(), Path.c_str());
     }
-    PreviousFlushVersion = FlushVersion;
-    TimeAtLastFlushRequest = 0;
+
+    if (!ok)
+    {
+        // try again with the next flush
+        Log(LogLevel::Error, "SaveManager: Failed to write %s\n", Path.c_str());
+        for (auto [start, end] : ranges)
+            AddDirtyRange(SecondaryDirtyRanges, start, end - start);
+    }
+
+    PreviousFlushVersion = version;
     SecondaryBufferLock->unlock();
 }
 
+bool SaveManager::WriteFullFile()
+{
+    // written to a temporary file which then replaces the save,
+    // so a crash halfway through leaves the old save intact
+    QSaveFile file(QString::fromStdString(Path));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write((const char*)SecondaryBuffer.get(), SecondaryBufferLength);
+    if (!file.commit())
+        return false;
+
+    // a journal left behind would only undo this write
+    QFile::remove(QString::fromStdString(JournalPath(Path)));
+    return true;
+}
+
+bool SaveManager::WriteJournal(const std::vector<u8>& journal)
+{
+    QFile f(QString::fromStdString(JournalPath(Path)));
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    bool ok = f.write((const char*)journal.data(), journal.size()) == (qint64)journal.size();
+    ok = SyncFile(f) && ok;
+    f.close();
+    if (!ok) return false;
+
+    // the journal is complete and on the disk, so it's now safe to patch the save itself
+    return RecoverJournal(Path);
+}
+
+bool SaveManager::RecoverJournal(const std::string& path)
+{
+    std::string journalpath = JournalPath(path);
+
+    FileHandle* f = Platform::OpenFile(journalpath, FileMode::Read);
+    if (!f) return true;
+
+    u32 len = (u32)Platform::FileLength(f);
+    std::vector<u8> journal(len);
+    bool ok = len >= 16 && FileRead(journal.data(), len, 1, f) == 1;
+    CloseFile(f);
+
+    u32 pos = 0;
+    auto get32 = [&journal, &pos]()
+    {
+        u32 val = journal[pos] | (journal[pos+1] << 8) | (journal[pos+2] << 16) | (journal[pos+3] << 24);
+        pos += 4;
+        return val;
+    };
+
+    // a journal that's incomplete was interrupted before
+    // the save was touched, so it can just be dropped
+    if (ok)
+    {
+        pos = len - 4;
+        ok = get32() == CRC32(journal.data(), (int)(len - 4));
+        pos = 0;
+    }
+    if (ok)
+        ok = get32() == kJournalMagic;
+
+    QFile save(QString::fromStdString(path));
+    if (ok)
+    {
+        u32 savelen = get32();
+        ok = save.exists() && save.open(QIODevice::ReadWrite) && save.size() == savelen;
+    }
+
+    if (!ok)
+    {
+        save.close();
+
+        Log(LogLevel::Warn, "SaveManager: Discarding invalid journal for %s\n", path.c_str());
+        QFile::remove(QString::fromStdString(journalpath));
+        return false;
+    }
+
+    bool applied = true;
+    u32 numranges = get32();
+    for (u32 i = 0; i < numranges; i++)
+    {
+        if (pos + 8 > len - 4) break;
+
+        u32 offset = get32();
+        u32 rangelen = get32();
+        if (rangelen > len - 4 - pos) break;
+
+        applied = save.seek(offset) &&
+                  save.write((const char*)&journal[pos], rangelen) == rangelen && applied;
+        pos += rangelen;
+    }
+
+    // the save has to be on the disk before the journal can go
+    applied = SyncFile(save) && applied;
+    save.close();
+
+    // if patching failed, keep the journal around to try again later
+    if (applied)
+        QFile::remove(QString::fromStdString(journalpath));
+
+    return applied;
+}
+
 bool SaveManager::NeedsFlush()
 {
     return FlushVersion != PreviousFlushVersion;
@@ -23,9 +23,13 @@
 #include <unistd.h>
 #include <time.h>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
 
 #include "types.h"
 
@@ -47,7 +51,18 @@ public:
     bool NeedsFlush();
     void FlushSecondaryBuffer(melonDS::u8* dst = nullptr, melonDS::u32 dstLength = 0);
 
+    /// Finishes applying the journal left behind for the given save file,
+    /// if a flush was interrupted. Call before reading the save file.
+    /// @return \c false if the journal couldn't be applied.
+    static bool RecoverJournal(const std::string& path);
+
 private:
+    using RangeList = std::vector<std::pair<melonDS::u32, melonDS::u32>>;
+
+    static void AddDirtyRange(RangeList& ranges, melonDS::u32 start, melonDS::u32 len);
+    bool WriteFullFile();
+    bool WriteJournal(const std::vector<melonDS::u8>& journal);
+
     std::string Path;
 
     std::atomic_bool Running;
@@ -55,12 +70,17 @@ private:
     std::unique_ptr<melonDS::u8[]> Buffer;
     melonDS::u32 Length;
     bool FlushRequested;
+    // ranges of Buffer written since the last CheckFlush, as (start, end)
+    RangeList DirtyRanges;
 
     QMutex* SecondaryBufferLock;
+    QWaitCondition* FlushCondition;
     std::unique_ptr<melonDS::u8[]> SecondaryBuffer;
     melonDS::u32 SecondaryBufferLength;
+    // ranges of SecondaryBuffer that haven't been written to the file yet
+    RangeList SecondaryDirtyRanges;
 
-    time_t TimeAtLastFlushRequest;
+    std::chrono::steady_clock::time_point TimeAtLastFlushRequest;
 
     // We keep versions in case the user closes the application before
     // a flush cycle is finished.
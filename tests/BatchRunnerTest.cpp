@@ -0,0 +1,121 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Runs consoles through the batch runner and checks that they end up
+// in the same state as when run one after the other.
+
+#include <atomic>
+#include <mutex>
+
+#include "TestUtil.h"
+#include "BatchRunner.h"
+#include "NDS.h"
+
+using namespace melonDS;
+
+constexpr int NumInstances = 4;
+constexpr u32 NumFrames = 10;
+
+// every console starts a few frames apart, so that they're all in a different state
+static std::unique_ptr<NDS> CreateConsole(int index)
+{
+    auto nds = Test::CreateTestNDS();
+    for (int f = 0; f < index; f++)
+        nds->RunFrame();
+    return nds;
+}
+
+static u64 StateHash(NDS& nds)
+{
+    u64 ret = Test::Hash(nds.MainRAM, nds.MainRAMMask + 1);
+    int frontbuf = nds.GPU.FrontBuffer;
+    ret ^= Test::Hash(nds.GPU.Framebuffer[frontbuf][0].get(), 256*192*4) * 3;
+    return ret;
+}
+
+static void TestRunner(int numthreads, bool lockstep, const std::vector<u64>& expected)
+{
+    std::vector<std::unique_ptr<NDS>> consoles;
+    BatchRunner runner(numthreads);
+    runner.SetLockstep(lockstep);
+
+    for (int i = 0; i < NumInstances; i++)
+    {
+        consoles.push_back(CreateConsole(i));
+        TEST_CHECK(runner.AddInstance(consoles[i].get()) == i);
+    }
+
+    std::mutex lock;
+    std::vector<u64> lastframe(NumInstances, 0);
+    std::atomic<int> badframes = 0;
+    runner.SetFrameCallback([&](NDS& nds, const BatchFrameOutput& output)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (output.FrameNum != lastframe[output.Instance] + 1 || &nds != consoles[output.Instance].get())
+            badframes++;
+        lastframe[output.Instance] = output.FrameNum;
+    });
+
+    // split in two runs to check that instances carry on where they left off
+    runner.RunFrames(NumFrames / 2);
+    runner.RunFrames(NumFrames - NumFrames / 2);
+
+    TEST_CHECK(badframes == 0);
+    for (int i = 0; i < NumInstances; i++)
+    {
+        TEST_CHECK(lastframe[i] == NumFrames);
+        TEST_CHECK(StateHash(*consoles[i]) == expected[i]);
+    }
+
+    BatchStats stats = runner.GetStats();
+    TEST_CHECK(stats.Frames == NumInstances * NumFrames);
+    TEST_CHECK(stats.Instances.size() == NumInstances);
+
+    // removed instances are left out of the stats, and their slot is reused
+    runner.RemoveInstance(1);
+    TEST_CHECK(runner.GetNumInstances() == NumInstances - 1);
+    stats = runner.GetStats();
+    TEST_CHECK(stats.Instances.size() == NumInstances - 1);
+    for (const BatchInstanceStats& inst : stats.Instances)
+        TEST_CHECK(inst.Instance != 1 && inst.Frames == NumFrames);
+
+    runner.SetFrameCallback(nullptr);
+    runner.RunFrames(1);
+    TEST_CHECK(runner.GetStats().Frames == (NumInstances - 1) * (NumFrames + 1));
+    TEST_CHECK(runner.AddInstance(consoles[1].get()) == 1);
+}
+
+int main()
+{
+    // reference: each console run on its own, one after the other
+    std::vector<u64> expected;
+    for (int i = 0; i < NumInstances; i++)
+    {
+        auto nds = CreateConsole(i);
+        for (u32 f = 0; f < NumFrames; f++)
+            nds->RunFrame();
+
+        expected.push_back(StateHash(*nds));
+    }
+
+    TestRunner(1, false, expected);
+    TestRunner(3, false, expected);
+    TestRunner(2, true, expected);
+
+    return Test::Finish("BatchRunnerTest");
+}
@@ -0,0 +1,210 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Runs every 2D line kernel set this CPU supports on fixed inputs,
+// and checks that they all give the same output as the generic one.
+
+#include <string.h>
+
+#include "TestUtil.h"
+#include "GPU2D_Kernels.h"
+
+using namespace melonDS;
+using namespace melonDS::GPU2D;
+
+static u32 Seed;
+
+static u32 Random()
+{
+    Seed = Seed * 1664525 + 1013904223;
+    return Seed >> 8;
+}
+
+// layer flags as the renderer sets them: BG0-3, OBJ, backdrop,
+// 3D (with its alpha), semi-transparent sprites (with their alpha)
+static u32 RandomFlags()
+{
+    static const u8 flags[] = {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    u32 ret = flags[Random() % sizeof(flags)];
+    if (ret & 0xC0)
+        ret |= Random() & 0x1F;
+    return ret;
+}
+
+static u32 RandomColor()
+{
+    return (Random() & 0x3F3F3F) | (RandomFlags() << 24);
+}
+
+struct Line
+{
+    u32 Above[256], Below[256];
+    u8 WindowMask[256];
+    u16 Line555[256];
+};
+
+static void MakeLine(Line& line)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        line.Above[i] = RandomColor();
+        line.Below[i] = RandomColor();
+        line.WindowMask[i] = (Random() & 1) ? 0xFF : 0x00;
+        line.Line555[i] = Random() & 0xFFFF;
+    }
+
+    // saturated channels, where rounding and clamping matter
+    line.Above[0] = 0x3F3F3F | (0x01 << 24);
+    line.Below[0] = 0x3F3F3F | (0x02 << 24);
+    line.Line555[0] = 0xFFFF;
+    line.Line555[1] = 0x0000;
+}
+
+static void TestKernels(const char* name)
+{
+    Seed = 1;
+    const u32 factors[] = {0, 1, 7, 8, 15, 16};
+
+    for (int l = 0; l < 64; l++)
+    {
+        Line line;
+        MakeLine(line);
+
+        // every blend mode and target combination comes up over the lines
+        CompositeParams params;
+        params.BlendCnt = Random() & 0x3FFF;
+        params.EVA = factors[Random() % 6];
+        params.EVB = factors[Random() % 6];
+        params.EVY = factors[Random() % 6];
+
+        u32 expected[256], result[256];
+        SetLineKernels("generic");
+        CompositeLine(expected, line.Above, line.Below, line.WindowMask, params);
+        SetLineKernels(name);
+        CompositeLine(result, line.Above, line.Below, line.WindowMask, params);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        // in place, as the renderer does it
+        memcpy(result, line.Above, sizeof(result));
+        CompositeLine(result, result, line.Below, line.WindowMask, params);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        u32 factor = factors[l % 6];
+        memcpy(expected, line.Above, sizeof(expected));
+        memcpy(result, line.Above, sizeof(result));
+        SetLineKernels("generic");
+        BrightnessUpLine(expected, factor);
+        SetLineKernels(name);
+        BrightnessUpLine(result, factor);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        memcpy(expected, line.Above, sizeof(expected));
+        memcpy(result, line.Above, sizeof(result));
+        SetLineKernels("generic");
+        BrightnessDownLine(expected, factor);
+        SetLineKernels(name);
+        BrightnessDownLine(result, factor);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        SetLineKernels("generic");
+        ExpandLine555(expected, line.Line555);
+        SetLineKernels(name);
+        ExpandLine555(result, line.Line555);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        memcpy(expected, line.Above, sizeof(expected));
+        memcpy(result, line.Above, sizeof(result));
+        SetLineKernels("generic");
+        ConvertLineBGRA(expected);
+        SetLineKernels(name);
+        ConvertLineBGRA(result);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        // captures can be 128 pixels wide, and the tail is done separately
+        const u32 widths[] = {256, 128, 13};
+        u32 num = widths[l % 3];
+        u16 expected555[256], result555[256];
+
+        memset(expected555, 0, sizeof(expected555));
+        memset(result555, 0, sizeof(result555));
+        SetLineKernels("generic");
+        CaptureLineA(expected555, line.Above, num);
+        SetLineKernels(name);
+        CaptureLineA(result555, line.Above, num);
+        TEST_CHECK(!memcmp(expected555, result555, sizeof(result555)));
+
+        u32 eva = factors[Random() % 6];
+        u32 evb = factors[Random() % 6];
+        memset(expected555, 0, sizeof(expected555));
+        memset(result555, 0, sizeof(result555));
+        SetLineKernels("generic");
+        CaptureLineAB(expected555, line.Above, line.Line555, num, eva, evb);
+        SetLineKernels(name);
+        CaptureLineAB(result555, line.Above, line.Line555, num, eva, evb);
+        TEST_CHECK(!memcmp(expected555, result555, sizeof(result555)));
+    }
+}
+
+// the generic kernels are checked against the per-pixel functions
+static void TestGeneric()
+{
+    Seed = 2;
+    SetLineKernels("generic");
+
+    Line line;
+    MakeLine(line);
+    CompositeParams params {0x3FFF & ~0x00C0, 8, 8, 8};
+    params.BlendCnt |= 0x40; // alpha blending
+
+    u32 result[256];
+    CompositeLine(result, line.Above, line.Below, line.WindowMask, params);
+    for (int i = 0; i < 256; i++)
+        TEST_CHECK(result[i] == ColorComposite(line.Above[i], line.Below[i], line.WindowMask[i], params));
+
+    memcpy(result, line.Above, sizeof(result));
+    BrightnessUpLine(result, 9);
+    for (int i = 0; i < 256; i++)
+        TEST_CHECK(result[i] == ColorBrightnessUp(line.Above[i], 9, 0x0));
+
+    memcpy(result, line.Above, sizeof(result));
+    BrightnessDownLine(result, 9);
+    for (int i = 0; i < 256; i++)
+        TEST_CHECK(result[i] == ColorBrightnessDown(line.Above[i], 9, 0xF));
+}
+
+int main()
+{
+    TestGeneric();
+
+    int numsets = 0;
+    for (const char* name : {"SSE2", "AVX2", "NEON"})
+    {
+        if (!SetLineKernels(name))
+            continue;
+
+        printf("checking %s line kernels\n", name);
+        TestKernels(name);
+        numsets++;
+    }
+
+    if (!numsets)
+        printf("no SIMD line kernels on this CPU, only checked the generic ones\n");
+
+    SetLineKernels(nullptr);
+    return Test::Finish("GPU2DKernelsTest");
+}
@@ -0,0 +1,182 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Runs every geometry kernel set this CPU supports on random inputs,
+// and checks that they all give the same output as the generic one.
+
+#include <string.h>
+
+#include "TestUtil.h"
+#include "GPU3D.h"
+#include "GPU3D_Kernels.h"
+
+using namespace melonDS;
+
+static u32 Seed;
+
+static u32 Random()
+{
+    Seed = Seed * 1664525 + 1013904223;
+    return Seed >> 8;
+}
+
+static s32 RandomS32()
+{
+    return (s32)((Random() << 16) ^ Random());
+}
+
+// mostly values games use (a few units in 20.12 fixed point), but also
+// large ones, so the 64-bit sums don't fit in 32 bits after the shift.
+// Those stay within 2^30 so the sums of four products can't overflow.
+static s32 RandomFixed()
+{
+    switch (Random() % 4)
+    {
+    case 0: return RandomS32() >> 2;
+    case 1: return RandomS32() >> 12;
+    default: return RandomS32() >> 16;
+    }
+}
+
+static void RandomMatrix(s32* m)
+{
+    for (int i = 0; i < 16; i++)
+        m[i] = RandomFixed();
+}
+
+// differences big enough to go through the generic fallback come up now and then
+static void RandomVertex(Vertex& v)
+{
+    memset(&v, 0, sizeof(v));
+    int shift = (Random() % 8) ? 12 : 0;
+    for (int i = 0; i < 4; i++)
+        v.Position[i] = RandomS32() >> shift;
+    for (int i = 0; i < 3; i++)
+        v.Color[i] = (Random() & 0x1FF) << 3;
+    for (int i = 0; i < 2; i++)
+        v.TexCoords[i] = (s16)Random();
+}
+
+static bool SameVertex(const Vertex& a, const Vertex& b)
+{
+    return !memcmp(a.Position, b.Position, sizeof(a.Position)) &&
+           !memcmp(a.Color, b.Color, sizeof(a.Color)) &&
+           !memcmp(a.TexCoords, b.TexCoords, sizeof(a.TexCoords));
+}
+
+static void TestKernels(const char* name)
+{
+    Seed = 1;
+
+    for (int i = 0; i < 10000; i++)
+    {
+        s32 m[16], s[16];
+        RandomMatrix(m);
+        RandomMatrix(s);
+
+        s32 expected[16], result[16];
+        memcpy(expected, m, sizeof(m));
+        memcpy(result, m, sizeof(m));
+        SetGeometryKernels("generic");
+        MatrixMult4x4(expected, s);
+        SetGeometryKernels(name);
+        MatrixMult4x4(result, s);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        memcpy(expected, m, sizeof(m));
+        memcpy(result, m, sizeof(m));
+        SetGeometryKernels("generic");
+        MatrixMult4x3(expected, s);
+        SetGeometryKernels(name);
+        MatrixMult4x3(result, s);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        // the last row is left alone
+        memcpy(expected, m, sizeof(m));
+        memcpy(result, m, sizeof(m));
+        SetGeometryKernels("generic");
+        MatrixMult3x3(expected, s);
+        SetGeometryKernels(name);
+        MatrixMult3x3(result, s);
+        TEST_CHECK(!memcmp(expected, result, sizeof(result)));
+
+        s32 v[4] = {RandomFixed(), RandomFixed(), RandomFixed(), RandomFixed()};
+        SetGeometryKernels("generic");
+        TransformVector4(expected, v, m);
+        SetGeometryKernels(name);
+        TransformVector4(result, v, m);
+        TEST_CHECK(!memcmp(expected, result, 4*4));
+
+        s16 n[3] = {(s16)Random(), (s16)Random(), (s16)Random()};
+        SetGeometryKernels("generic");
+        TransformNormal(expected, n, m);
+        SetGeometryKernels(name);
+        TransformNormal(result, n, m);
+        TEST_CHECK(!memcmp(expected, result, 3*4));
+
+        // W is sometimes small, so vertices end up on either side of the planes
+        Vertex vertices[10];
+        for (Vertex& vtx : vertices)
+        {
+            RandomVertex(vtx);
+            if (Random() & 1)
+                vtx.Position[3] >>= 8;
+        }
+        int start = Random() % 10;
+        int end = start + Random() % (11 - start);
+        SetGeometryKernels("generic");
+        u32 outcodes = GetClipOutcodes(vertices, start, end);
+        SetGeometryKernels(name);
+        TEST_CHECK(GetClipOutcodes(vertices, start, end) == outcodes);
+
+        // clipping factors are normally between 0 and 1,
+        // anything else has to go through the generic fallback
+        s32 den = RandomS32() >> (Random() % 24);
+        s32 num = (Random() % 8) ? (s32)((s64)den * (Random() & 0xFFF) >> 12) : RandomS32();
+        if (!den) den = 1;
+        bool attribs = Random() & 1;
+        Vertex vexpected, vresult;
+        memset(&vexpected, 0, sizeof(vexpected));
+        memset(&vresult, 0, sizeof(vresult));
+        SetGeometryKernels("generic");
+        InterpolateClipVertex(&vexpected, &vertices[0], &vertices[1], num, den, attribs);
+        SetGeometryKernels(name);
+        InterpolateClipVertex(&vresult, &vertices[0], &vertices[1], num, den, attribs);
+        TEST_CHECK(SameVertex(vexpected, vresult));
+    }
+}
+
+int main()
+{
+    int numsets = 0;
+    for (const char* name : {"SSE4.1", "NEON"})
+    {
+        if (!SetGeometryKernels(name))
+            continue;
+
+        printf("checking %s geometry kernels\n", name);
+        TestKernels(name);
+        numsets++;
+    }
+
+    if (!numsets)
+        printf("no SIMD geometry kernels on this CPU\n");
+
+    SetGeometryKernels(nullptr);
+    return Test::Finish("GPU3DKernelsTest");
+}
@@ -0,0 +1,214 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Feeds the same random GX command stream to two consoles, one of them
+// executing runs of vertex data commands in one batch and the other one
+// command at a time, and checks that the geometry engine stays in step.
+
+#include <string.h>
+
+#include "TestUtil.h"
+#include "NDS.h"
+
+using namespace melonDS;
+
+static u32 Seed;
+
+static u32 Random()
+{
+    Seed = Seed * 1664525 + 1013904223;
+    return Seed >> 8;
+}
+
+static u32 RandomParam()
+{
+    return (Random() << 16) ^ Random();
+}
+
+// a coordinate pair that stays around the view volume
+static u32 RandomXY()
+{
+    return (((Random() & 0x1FFF) - 0x1000) & 0xFFFF) | (((Random() & 0x1FFF) - 0x1000) << 16);
+}
+
+// mostly vertex data, broken up now and then by other commands
+static std::vector<std::vector<u32>> MakeStream(int numcmds)
+{
+    std::vector<std::vector<u32>> stream;
+
+    // a command, then its parameters
+    auto add = [&](u32 cmd, std::initializer_list<u32> params)
+    {
+        std::vector<u32> words {cmd};
+        words.insert(words.end(), params);
+        stream.push_back(words);
+    };
+
+    add(0x10, {0}); // projection matrix
+    add(0x15, {});
+    add(0x10, {2}); // position & vector matrix
+    add(0x15, {});
+    add(0x60, {0xBFFF0000}); // viewport
+    add(0x30, {0x80007FFF}); // diffuse/ambient, sets the vertex color
+    add(0x32, {0x1FF003FF}); // light vector
+    add(0x33, {0x7FFF}); // light color
+    add(0x29, {0x001F00CF}); // all lights, both sides, opaque
+    add(0x40, {0});
+
+    for (int i = 0; i < numcmds; i++)
+    {
+        u32 r = Random() % 64;
+        if (r < 6)      add(0x20, {Random() & 0x7FFF});
+        else if (r < 12) add(0x21, {RandomParam() & 0x3FFFFFFF});
+        else if (r < 18) add(0x22, {RandomParam()});
+        else if (r < 26) add(0x23, {RandomXY(), RandomXY() & 0xFFFF});
+        else if (r < 32) add(0x24, {RandomParam() & 0x3FFFFFFF});
+        else if (r < 38) add(0x25, {RandomXY()});
+        else if (r < 44) add(0x26, {RandomXY()});
+        else if (r < 50) add(0x27, {RandomXY()});
+        else if (r < 58) add(0x28, {RandomParam() & 0x3FFFFFFF});
+        else if (r == 58) add(0x29, {0x001F00C0 | (Random() & 0xF)});
+        else if (r == 59) add(0x2A, {(Random() & 1) << 30}); // texcoords through the texture matrix or not
+        else if (r == 60) add(0x1B, {0x1000 + (Random() & 0xFFF), 0x1000, 0x1000 - (Random() & 0x7FF)});
+        else if (r == 61) add(0x41, {});
+        else              add(0x40, {Random() & 3});
+    }
+
+    return stream;
+}
+
+static void Step(NDS& nds, u32 cycles)
+{
+    nds.ARM9Timestamp += (u64)cycles << nds.ARM9ClockShift;
+    nds.GPU.GPU3D.Run();
+}
+
+static bool SameState(const NDS& nds1, const NDS& nds2)
+{
+    const GPU3D& a = nds1.GPU.GPU3D;
+    const GPU3D& b = nds2.GPU.GPU3D;
+
+    return a.CycleCount == b.CycleCount &&
+           a.GXStat == b.GXStat &&
+           a.CmdFIFO.Level() == b.CmdFIFO.Level() &&
+           a.CmdPIPE.Level() == b.CmdPIPE.Level() &&
+           a.VertexPipeline == b.VertexPipeline &&
+           a.NormalPipeline == b.NormalPipeline &&
+           a.PolygonPipeline == b.PolygonPipeline &&
+           a.VertexSlotCounter == b.VertexSlotCounter &&
+           a.VertexSlotsFree == b.VertexSlotsFree &&
+           a.NumVertices == b.NumVertices &&
+           a.NumPolygons == b.NumPolygons &&
+           !memcmp(a.CurVertex, b.CurVertex, sizeof(a.CurVertex)) &&
+           !memcmp(a.VertexColor, b.VertexColor, sizeof(a.VertexColor)) &&
+           !memcmp(a.TexCoords, b.TexCoords, sizeof(a.TexCoords)) &&
+           nds1.IF[0] == nds2.IF[0];
+}
+
+static bool SameGeometry(const GPU3D& a, const GPU3D& b)
+{
+    for (u32 i = 0; i < a.NumVertices; i++)
+    {
+        const Vertex& va = a.CurVertexRAM[i];
+        const Vertex& vb = b.CurVertexRAM[i];
+        if (memcmp(va.Position, vb.Position, sizeof(va.Position)) ||
+            memcmp(va.Color, vb.Color, sizeof(va.Color)) ||
+            memcmp(va.TexCoords, vb.TexCoords, sizeof(va.TexCoords)) ||
+            memcmp(va.FinalPosition, vb.FinalPosition, sizeof(va.FinalPosition)) ||
+            memcmp(va.FinalColor, vb.FinalColor, sizeof(va.FinalColor)))
+            return false;
+    }
+
+    for (u32 i = 0; i < a.NumPolygons; i++)
+    {
+        const Polygon& pa = a.CurPolygonRAM[i];
+        const Polygon& pb = b.CurPolygonRAM[i];
+        if (pa.NumVertices != pb.NumVertices || pa.Attr != pb.Attr || pa.TexParam != pb.TexParam)
+            return false;
+
+        for (u32 v = 0; v < pa.NumVertices; v++)
+        {
+            if (pa.Vertices[v] - a.CurVertexRAM != pb.Vertices[v] - b.CurVertexRAM ||
+                pa.FinalZ[v] != pb.FinalZ[v] || pa.FinalW[v] != pb.FinalW[v])
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void TestBatching(int numcmds, u32 maxstep)
+{
+    auto batched = Test::CreateTestNDS();
+    auto single = Test::CreateTestNDS();
+    single->GPU.GPU3D.BatchVertexData = false;
+
+    NDS* consoles[] = {batched.get(), single.get()};
+    for (NDS* nds : consoles)
+    {
+        nds->ARM9Write16(0x04000304, 0x020F); // POWCNT1: geometry engine on
+        nds->ARM9Write32(0x04000600, 1u << 30); // GXFIFO IRQ below half full
+        Step(*nds, 0);
+    }
+
+    Seed = numcmds;
+    std::vector<std::vector<u32>> stream = MakeStream(numcmds);
+    int mismatches = 0;
+
+    auto step = [&](u32 cycles)
+    {
+        for (NDS* nds : consoles)
+            Step(*nds, cycles);
+
+        if (!SameState(*batched, *single))
+            mismatches++;
+    };
+
+    for (const std::vector<u32>& cmd : stream)
+    {
+        for (u32 word : cmd)
+        {
+            for (NDS* nds : consoles)
+                nds->ARM9Write32(0x04000400, word);
+        }
+
+        // let the FIFO fill up at times, and keep it from overflowing
+        if (!(Random() % 8))
+            step(1 + Random() % maxstep);
+        while (batched->GPU.GPU3D.CmdFIFO.Level() > 200)
+            step(1 + Random() % maxstep);
+    }
+
+    while (batched->GPU.GPU3D.GXStat & (1<<27))
+        step(maxstep);
+
+    if (mismatches)
+        printf("%d steps out of sync\n", mismatches);
+    TEST_CHECK(mismatches == 0);
+    TEST_CHECK(SameState(*batched, *single));
+    TEST_CHECK(SameGeometry(batched->GPU.GPU3D, single->GPU.GPU3D));
+    TEST_CHECK(batched->GPU.GPU3D.NumVertices > 0);
+}
+
+int main()
+{
+    TestBatching(2000, 16);
+    TestBatching(2000, 300);
+    TestBatching(4000, 5000);
+    return Test::Finish("GPU3DTest");
+}
@@ -0,0 +1,199 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Checks the flat VRAM copies against the per-address VRAM accessors,
+// and times flattening a frame where all of BG and texture VRAM is dirty.
+
+#include <string.h>
+#include <chrono>
+
+#include "TestUtil.h"
+#include "NDS.h"
+
+using namespace melonDS;
+
+static u32 Seed;
+
+static u32 Random()
+{
+    Seed = Seed * 1664525 + 1013904223;
+    return Seed >> 8;
+}
+
+// VRAMCNT_A-I, 0 leaves the bank unmapped
+struct Mapping
+{
+    const char* Name;
+    u8 Cnt[9];
+};
+
+static const Mapping Mappings[] =
+{
+    // one bank per block
+    {"single", {0x81, 0x89, 0x91, 0x83, 0, 0, 0, 0, 0}},
+    // A and B over each other, E and F over A, G over C, texture slot 2 empty
+    {"overlapping", {0x81, 0x81, 0x89, 0x83, 0x81, 0x81, 0x99, 0, 0}},
+    // all four texture slots filled, A and B also over each other
+    {"texture", {0x83, 0x83, 0x8B, 0x9B, 0x81, 0, 0, 0, 0}},
+};
+
+static void SetMapping(NDS& nds, const Mapping& mapping)
+{
+    // WRAMCNT sits between VRAMCNT_G and VRAMCNT_H
+    for (int i = 0; i < 9; i++)
+        nds.ARM9Write8(0x04000240 + i + (i >= 7), 0);
+    for (int i = 0; i < 9; i++)
+        nds.ARM9Write8(0x04000240 + i + (i >= 7), mapping.Cnt[i]);
+}
+
+static void FillVRAM(GPU& gpu)
+{
+    u8* banks[] = {gpu.VRAM_A, gpu.VRAM_B, gpu.VRAM_C, gpu.VRAM_D, gpu.VRAM_E, gpu.VRAM_F, gpu.VRAM_G, gpu.VRAM_H, gpu.VRAM_I};
+    u32 sizes[] = {sizeof(gpu.VRAM_A), sizeof(gpu.VRAM_B), sizeof(gpu.VRAM_C), sizeof(gpu.VRAM_D), sizeof(gpu.VRAM_E),
+                   sizeof(gpu.VRAM_F), sizeof(gpu.VRAM_G), sizeof(gpu.VRAM_H), sizeof(gpu.VRAM_I)};
+
+    // the low bits of the generator repeat every 64K,
+    // which would give the larger banks the same contents
+    for (int b = 0; b < 9; b++)
+    {
+        for (u32 i = 0; i < sizes[b]; i++)
+            banks[b][i] = Random() >> 16;
+    }
+}
+
+using DirtyBits = NonStupidBitField<512*1024/VRAMDirtyGranularity>;
+
+// scattered granules, and runs that cross mapping blocks and bitfield words
+static void MakeDirty(DirtyBits& dirty, int pattern)
+{
+    dirty.Clear();
+    switch (pattern)
+    {
+    case 0:
+        break;
+    case 1:
+        for (u32 i = 0; i < DirtyBits::DataLength; i++)
+            dirty.Data[i] = ((u64)Random() << 40) ^ ((u64)Random() << 16) ^ Random();
+        break;
+    case 2:
+        for (int r = 0; r < 16; r++)
+        {
+            u32 start = Random() % 1024;
+            u32 len = 1 + Random() % 160;
+            dirty.SetRange(start, std::min(len, 1024 - start));
+        }
+        break;
+    case 3:
+        dirty.SetRange(0, 1024);
+        break;
+    }
+}
+
+template <typename F>
+static void CheckFlat(const char* what, const u8* flat, const DirtyBits& dirty, bool change, F read)
+{
+    bool anydirty = false;
+    bool ok = true;
+    for (u32 g = 0; g < 1024; g++)
+    {
+        if (!(dirty.Data[g >> 6] & (1ULL << (g & 0x3F))))
+        {
+            // clean granules are left alone
+            for (u32 i = 0; i < VRAMDirtyGranularity; i++)
+                ok &= flat[g * VRAMDirtyGranularity + i] == 0xCD;
+            continue;
+        }
+
+        anydirty = true;
+        for (u32 i = 0; i < VRAMDirtyGranularity; i += 8)
+        {
+            u32 addr = g * VRAMDirtyGranularity + i;
+            u64 val;
+            memcpy(&val, &flat[addr], 8);
+            ok &= val == read(addr);
+        }
+    }
+
+    if (!ok)
+        printf("%s: flat copy doesn't match VRAM\n", what);
+    TEST_CHECK(ok);
+    TEST_CHECK(change == anydirty);
+}
+
+static void TestFlatten()
+{
+    auto nds = Test::CreateTestNDS();
+    GPU& gpu = nds->GPU;
+    DirtyBits dirty;
+
+    Seed = 1;
+    for (const Mapping& mapping : Mappings)
+    {
+        SetMapping(*nds, mapping);
+        FillVRAM(gpu);
+
+        for (int pattern = 0; pattern < 4; pattern++)
+        {
+            MakeDirty(dirty, pattern);
+            memset(gpu.VRAMFlat_ABG, 0xCD, sizeof(gpu.VRAMFlat_ABG));
+            bool change = gpu.MakeVRAMFlat_ABGCoherent(dirty);
+            CheckFlat(mapping.Name, gpu.VRAMFlat_ABG, dirty, change,
+                      [&](u32 addr) { return gpu.ReadVRAM_ABG<u64>(addr); });
+
+            MakeDirty(dirty, pattern);
+            memset(gpu.VRAMFlat_Texture, 0xCD, sizeof(gpu.VRAMFlat_Texture));
+            change = gpu.MakeVRAMFlat_TextureCoherent(dirty);
+            CheckFlat(mapping.Name, gpu.VRAMFlat_Texture, dirty, change,
+                      [&](u32 addr) { return gpu.ReadVRAM_Texture<u64>(addr); });
+        }
+    }
+}
+
+// worst case: a game re-uploading all of its BG and texture VRAM every frame
+static void BenchFlatten()
+{
+    auto nds = Test::CreateTestNDS();
+    GPU& gpu = nds->GPU;
+    DirtyBits dirty;
+    const int iterations = 200;
+
+    for (const Mapping& mapping : Mappings)
+    {
+        SetMapping(*nds, mapping);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            dirty.SetRange(0, 1024);
+            gpu.MakeVRAMFlat_ABGCoherent(dirty);
+            dirty.SetRange(0, 1024);
+            gpu.MakeVRAMFlat_TextureCoherent(dirty);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+        printf("flattening dirty ABG + texture VRAM, %s banks: %.1f us\n", mapping.Name, us);
+    }
+}
+
+int main()
+{
+    TestFlatten();
+    BenchFlatten();
+    return Test::Finish("GPUVRAMTest");
+}
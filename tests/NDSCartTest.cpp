@@ -0,0 +1,142 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Checks that carts sharing ROM data keep their patches to themselves.
+
+#include <string.h>
+
+#include "TestUtil.h"
+#include "NDS.h"
+#include "NDSCart.h"
+#include "Args.h"
+
+using namespace melonDS;
+
+static std::shared_ptr<const u8[]> MakeShared(const std::vector<u8>& rom)
+{
+    auto data = std::make_unique<u8[]>(rom.size());
+    memcpy(data.get(), rom.data(), rom.size());
+    return std::shared_ptr<const u8[]>(std::move(data));
+}
+
+static void TestPatchROM()
+{
+    std::vector<u8> rom = Test::MakeTestROM();
+    auto shared = MakeShared(rom);
+    auto cart = NDSCart::ParseROM(shared, (u32)rom.size());
+    auto other = NDSCart::ParseROM(shared, (u32)rom.size());
+    TEST_CHECK(cart && other);
+    if (!cart || !other) return;
+
+    u8* patch = cart->PatchROM(0x5000, 0x10);
+    memset(patch, 0xAA, 0x10);
+
+    // a range inside an existing patch reuses it
+    TEST_CHECK(cart->PatchROM(0x5008, 4) == patch + 8);
+
+    // an overlapping range is merged with it, keeping what was written
+    u8* merged = cart->PatchROM(0x4FF8, 0x10);
+    merged[0] = 0x55;
+    TEST_CHECK(merged[8] == 0xAA);
+
+    u8 buf[0x40];
+    cart->CopyROM(0x4FE0, sizeof(buf), buf);
+    TEST_CHECK(!memcmp(buf, &rom[0x4FE0], 0x18));
+    TEST_CHECK(buf[0x18] == 0x55);
+    TEST_CHECK(!memcmp(&buf[0x19], &rom[0x4FF9], 7));
+    for (int i = 0x20; i < 0x30; i++)
+        TEST_CHECK(buf[i] == 0xAA);
+    TEST_CHECK(!memcmp(&buf[0x30], &rom[0x5010], 0x10));
+
+    // the shared data and the other cart don't see any of it
+    TEST_CHECK(!memcmp(shared.get(), rom.data(), rom.size()));
+    other->CopyROM(0x4FE0, sizeof(buf), buf);
+    TEST_CHECK(!memcmp(buf, &rom[0x4FE0], sizeof(buf)));
+}
+
+static void TestSecureArea()
+{
+    // a retail ROM whose secure area is stored decrypted,
+    // so it's re-encrypted when the cart is inserted
+    std::vector<u8> rom = Test::MakeTestROM();
+    memcpy(&rom[0x0C], "MLNT", 4);
+    u32 arm9offset = 0x4000;
+    u32 arm9size = 0x1000;
+    memcpy(&rom[0x20], &arm9offset, 4);
+    memcpy(&rom[0x2C], &arm9size, 4);
+    u32 marker = 0xE7FFDEFF;
+    memcpy(&rom[0x4000], &marker, 4);
+    memcpy(&rom[0x4004], &marker, 4);
+
+    auto shared = MakeShared(rom);
+
+    NDSArgs args {};
+    args.JIT = std::nullopt;
+    auto console = std::make_unique<NDS>(std::move(args));
+    NDS& nds = *console;
+    nds.SetNDSCart(NDSCart::ParseROM(shared, (u32)rom.size()));
+    TEST_CHECK(nds.NDSCartSlot.GetCart() != nullptr);
+    if (!nds.NDSCartSlot.GetCart()) return;
+
+    u8 securearea[0x800];
+    nds.NDSCartSlot.GetCart()->CopyROM(0x4000, sizeof(securearea), securearea);
+    TEST_CHECK(memcmp(securearea, &rom[0x4000], sizeof(securearea)) != 0);
+    TEST_CHECK(!memcmp(shared.get(), rom.data(), rom.size()));
+
+    // direct boot decrypts it again, and loads the rest of the binary as is
+    nds.Reset();
+    nds.SetupDirectBoot("test.nds");
+    TEST_CHECK(!memcmp(nds.MainRAM, &rom[0x4000], arm9size));
+
+    // inserting the same cart again doesn't encrypt it twice
+    nds.SetNDSCart(nds.EjectCart());
+    u8 again[0x800];
+    nds.NDSCartSlot.GetCart()->CopyROM(0x4000, sizeof(again), again);
+    TEST_CHECK(!memcmp(again, securearea, sizeof(again)));
+
+    auto other = NDSCart::ParseROM(shared, (u32)rom.size());
+    other->CopyROM(0x4000, sizeof(again), again);
+    TEST_CHECK(!memcmp(again, &rom[0x4000], sizeof(again)));
+}
+
+static void TestPaddedROM()
+{
+    // data that's already padded is used as is, keeping the real ROM length
+    std::vector<u8> rom = Test::MakeTestROM();
+    u32 romlen = 0x18000;
+    memset(&rom[romlen], 0, rom.size() - romlen);
+    auto shared = MakeShared(rom);
+
+    auto cart = NDSCart::ParseROM(shared, romlen, (u32)rom.size());
+    TEST_CHECK(cart && cart->GetROM() == shared.get());
+    TEST_CHECK(cart && cart->GetROMLength() == rom.size());
+
+    // too short to be padded, so it gets a padded copy
+    cart = NDSCart::ParseROM(shared, romlen, romlen);
+    TEST_CHECK(cart && cart->GetROM() != shared.get());
+    TEST_CHECK(cart && cart->GetROMLength() == rom.size());
+    TEST_CHECK(cart && !memcmp(cart->GetROM(), rom.data(), rom.size()));
+}
+
+int main()
+{
+    TestPatchROM();
+    TestPaddedROM();
+    TestSecureArea();
+    return Test::Finish("NDSCartTest");
+}
@@ -0,0 +1,312 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Minimal platform layer for the tests: plain stdio files,
+// standard library threads, and no networking, cameras or saves.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Platform.h"
+#include "SPI_Firmware.h"
+
+namespace melonDS::Platform
+{
+
+void SignalStop(StopReason reason, void* userdata)
+{
+}
+
+std::string GetLocalFilePath(const std::string& filename)
+{
+    return filename;
+}
+
+FileHandle* OpenFile(const std::string& path, FileMode mode)
+{
+    bool exists = FileExists(path);
+    if ((mode & FileMode::NoCreate) && !exists)
+        return nullptr;
+
+    std::string modestr;
+    if ((mode & FileMode::ReadWrite) == FileMode::ReadWrite)
+        modestr = ((mode & FileMode::Preserve) && exists) ? "r+" : "w+";
+    else if (mode & FileMode::Write)
+        modestr = (mode & FileMode::Append) ? "a" : "w";
+    else
+        modestr = "r";
+
+    if (!(mode & FileMode::Text))
+        modestr += "b";
+
+    return reinterpret_cast<FileHandle*>(fopen(path.c_str(), modestr.c_str()));
+}
+
+FileHandle* OpenLocalFile(const std::string& path, FileMode mode)
+{
+    return OpenFile(path, mode);
+}
+
+bool FileExists(const std::string& name)
+{
+    FILE* f = fopen(name.c_str(), "rb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+bool LocalFileExists(const std::string& name)
+{
+    return FileExists(name);
+}
+
+bool CheckFileWritable(const std::string& filepath)
+{
+    return true;
+}
+
+bool CheckLocalFileWritable(const std::string& filepath)
+{
+    return true;
+}
+
+bool CloseFile(FileHandle* file)
+{
+    return fclose(reinterpret_cast<FILE*>(file)) == 0;
+}
+
+bool IsEndOfFile(FileHandle* file)
+{
+    return feof(reinterpret_cast<FILE*>(file)) != 0;
+}
+
+bool FileReadLine(char* str, int count, FileHandle* file)
+{
+    return fgets(str, count, reinterpret_cast<FILE*>(file)) != nullptr;
+}
+
+bool FileSeek(FileHandle* file, s64 offset, FileSeekOrigin origin)
+{
+    int whence;
+    switch (origin)
+    {
+    case FileSeekOrigin::Start: whence = SEEK_SET; break;
+    case FileSeekOrigin::Current: whence = SEEK_CUR; break;
+    default: whence = SEEK_END; break;
+    }
+    return fseek(reinterpret_cast<FILE*>(file), (long)offset, whence) == 0;
+}
+
+void FileRewind(FileHandle* file)
+{
+    rewind(reinterpret_cast<FILE*>(file));
+}
+
+u64 FileRead(void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fread(data, size, count, reinterpret_cast<FILE*>(file));
+}
+
+bool FileFlush(FileHandle* file)
+{
+    return fflush(reinterpret_cast<FILE*>(file)) == 0;
+}
+
+u64 FileWrite(const void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fwrite(data, size, count, reinterpret_cast<FILE*>(file));
+}
+
+u64 FileWriteFormatted(FileHandle* file, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int ret = vfprintf(reinterpret_cast<FILE*>(file), fmt, args);
+    va_end(args);
+    return ret < 0 ? 0 : ret;
+}
+
+u64 FileLength(FileHandle* file)
+{
+    FILE* f = reinterpret_cast<FILE*>(file);
+    long pos = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, pos, SEEK_SET);
+    return len < 0 ? 0 : len;
+}
+
+void Log(LogLevel level, const char* fmt, ...)
+{
+    // only problems are worth showing in test output
+    if (level < LogLevel::Warn)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+Thread* Thread_Create(std::function<void()> func)
+{
+    return reinterpret_cast<Thread*>(new std::thread(std::move(func)));
+}
+
+void Thread_Free(Thread* thread)
+{
+    std::thread* t = reinterpret_cast<std::thread*>(thread);
+    if (t->joinable()) t->join();
+    delete t;
+}
+
+void Thread_Wait(Thread* thread)
+{
+    std::thread* t = reinterpret_cast<std::thread*>(thread);
+    if (t->joinable()) t->join();
+}
+
+struct TestSemaphore
+{
+    std::mutex Lock;
+    std::condition_variable Cond;
+    int Count = 0;
+};
+
+Semaphore* Semaphore_Create()
+{
+    return reinterpret_cast<Semaphore*>(new TestSemaphore);
+}
+
+void Semaphore_Free(Semaphore* sema)
+{
+    delete reinterpret_cast<TestSemaphore*>(sema);
+}
+
+void Semaphore_Reset(Semaphore* sema)
+{
+    TestSemaphore* s = reinterpret_cast<TestSemaphore*>(sema);
+    std::lock_guard<std::mutex> lock(s->Lock);
+    s->Count = 0;
+}
+
+void Semaphore_Wait(Semaphore* sema)
+{
+    TestSemaphore* s = reinterpret_cast<TestSemaphore*>(sema);
+    std::unique_lock<std::mutex> lock(s->Lock);
+    s->Cond.wait(lock, [s]() { return s->Count > 0; });
+    s->Count--;
+}
+
+bool Semaphore_TryWait(Semaphore* sema, int timeout_ms)
+{
+    TestSemaphore* s = reinterpret_cast<TestSemaphore*>(sema);
+    std::unique_lock<std::mutex> lock(s->Lock);
+    if (!s->Cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [s]() { return s->Count > 0; }))
+        return false;
+    s->Count--;
+    return true;
+}
+
+void Semaphore_Post(Semaphore* sema, int count)
+{
+    TestSemaphore* s = reinterpret_cast<TestSemaphore*>(sema);
+    {
+        std::lock_guard<std::mutex> lock(s->Lock);
+        s->Count += count;
+    }
+    s->Cond.notify_all();
+}
+
+Mutex* Mutex_Create()
+{
+    return reinterpret_cast<Mutex*>(new std::mutex);
+}
+
+void Mutex_Free(Mutex* mutex)
+{
+    delete reinterpret_cast<std::mutex*>(mutex);
+}
+
+void Mutex_Lock(Mutex* mutex)
+{
+    reinterpret_cast<std::mutex*>(mutex)->lock();
+}
+
+void Mutex_Unlock(Mutex* mutex)
+{
+    reinterpret_cast<std::mutex*>(mutex)->unlock();
+}
+
+bool Mutex_TryLock(Mutex* mutex)
+{
+    return reinterpret_cast<std::mutex*>(mutex)->try_lock();
+}
+
+void Sleep(u64 usecs)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(usecs));
+}
+
+u64 GetMSCount()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+u64 GetUSCount()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+void WriteNDSSave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata) {}
+void WriteGBASave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata) {}
+void WriteFirmware(const Firmware& firmware, u32 writeoffset, u32 writelen, void* userdata) {}
+void WriteDateTime(int year, int month, int day, int hour, int minute, int second, void* userdata) {}
+
+void MP_Begin(void* userdata) {}
+void MP_End(void* userdata) {}
+int MP_SendPacket(u8* data, int len, u64 timestamp, void* userdata) { return 0; }
+int MP_RecvPacket(u8* data, u64* timestamp, void* userdata) { return 0; }
+int MP_SendCmd(u8* data, int len, u64 timestamp, void* userdata) { return 0; }
+int MP_SendReply(u8* data, int len, u64 timestamp, u16 aid, void* userdata) { return 0; }
+int MP_SendAck(u8* data, int len, u64 timestamp, void* userdata) { return 0; }
+int MP_RecvHostPacket(u8* data, u64* timestamp, void* userdata) { return 0; }
+u16 MP_RecvReplies(u8* data, u64 timestamp, u16 aidmask, void* userdata) { return 0; }
+
+int Net_SendPacket(u8* data, int len, void* userdata) { return 0; }
+int Net_RecvPacket(u8* data, void* userdata) { return 0; }
+
+void Camera_Start(int num, void* userdata) {}
+void Camera_Stop(int num, void* userdata) {}
+void Camera_CaptureFrame(int num, u32* frame, int width, int height, bool yuv, void* userdata) {}
+
+void Addon_RumbleStart(u32 len, void* userdata) {}
+void Addon_RumbleStop(void* userdata) {}
+
+DynamicLibrary* DynamicLibrary_Load(const char* lib) { return nullptr; }
+void DynamicLibrary_Unload(DynamicLibrary* lib) {}
+void* DynamicLibrary_LoadFunction(DynamicLibrary* lib, const char* name) { return nullptr; }
+
+}
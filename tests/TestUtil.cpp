@@ -0,0 +1,114 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include "TestUtil.h"
+#include "NDS.h"
+#include "NDSCart.h"
+#include "Args.h"
+
+namespace melonDS::Test
+{
+
+int NumFailures = 0;
+
+const std::vector<u32> CounterLoop =
+{
+    0xE3A00622, // mov r0, #0x02200000
+    0xE5901000, // loop: ldr r1, [r0]
+    0xE2811001, // add r1, r1, #1
+    0xE5801000, // str r1, [r0]
+    0xEAFFFFFB, // b loop
+};
+
+static void Put32(std::vector<u8>& data, u32 offset, u32 val)
+{
+    memcpy(&data[offset], &val, 4);
+}
+
+std::vector<u8> MakeTestROM(const std::vector<u32>& arm9code, u32 romlen)
+{
+    constexpr u32 arm9offset = 0x1000;
+    constexpr u32 arm7offset = 0x2000;
+
+    std::vector<u8> rom(romlen);
+    for (u32 i = 0x4000; i < romlen; i += 4)
+        Put32(rom, i, i * 2654435761u);
+
+    memcpy(&rom[0], "MELONDSTEST", 11);
+    memcpy(&rom[0x0C], "####", 4);
+    memcpy(&rom[0x10], "00", 2);
+
+    u32 arm9size = (u32)arm9code.size() * 4;
+    Put32(rom, 0x20, arm9offset);
+    Put32(rom, 0x24, 0x02000000);
+    Put32(rom, 0x28, 0x02000000);
+    Put32(rom, 0x2C, arm9size);
+    memcpy(&rom[arm9offset], arm9code.data(), arm9size);
+
+    Put32(rom, 0x30, arm7offset);
+    Put32(rom, 0x34, 0x037F8000);
+    Put32(rom, 0x38, 0x037F8000);
+    Put32(rom, 0x3C, 4);
+    Put32(rom, arm7offset, 0xEAFFFFFE); // b .
+
+    return rom;
+}
+
+std::unique_ptr<NDS> CreateTestNDS(const std::vector<u8>& rom)
+{
+    NDSArgs args {};
+    args.JIT = std::nullopt;
+    auto nds = std::make_unique<NDS>(std::move(args));
+
+    auto romdata = std::make_unique<u8[]>(rom.size());
+    memcpy(romdata.get(), rom.data(), rom.size());
+    nds->SetNDSCart(NDSCart::ParseROM(std::move(romdata), (u32)rom.size(), nullptr, std::nullopt));
+
+    nds->Reset();
+    nds->SetupDirectBoot("test.nds");
+    nds->Start();
+    return nds;
+}
+
+u64 Hash(const void* data, size_t len)
+{
+    const u8* bytes = (const u8*)data;
+    u64 hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+int Finish(const char* name)
+{
+    if (NumFailures)
+    {
+        printf("%s: %d checks failed\n", name, NumFailures);
+        return 1;
+    }
+
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright 2016-2024 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+
+namespace melonDS
+{
+class NDS;
+
+namespace Test
+{
+
+extern int NumFailures;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            melonDS::Test::NumFailures++; \
+        } \
+    } while (0)
+
+/// ARM9 code that increments the word at 0x02200000 forever.
+extern const std::vector<u32> CounterLoop;
+
+/// Builds a small homebrew ROM: the ARM9 runs \c arm9code from 0x02000000,
+/// the ARM7 just spins. The rest of the ROM is filled with a fixed pattern.
+std::vector<u8> MakeTestROM(const std::vector<u32>& arm9code = CounterLoop, u32 romlen = 0x20000);
+
+/// Creates a console running the given ROM, direct-booted,
+/// with the JIT disabled so that runs are reproducible.
+std::unique_ptr<NDS> CreateTestNDS(const std::vector<u8>& rom = MakeTestROM());
+
+/// FNV-1a hash, to compare large buffers in test output.
+u64 Hash(const void* data, size_t len);
+
+/// Prints the test result.
+/// @return The exit code for the test program.
+int Finish(const char* name);
+
+}
+}
+
+#endif // TESTUTIL_H